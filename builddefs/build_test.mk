@@ -58,9 +58,19 @@ include $(BUILDDEFS_PATH)/common_features.mk
 include $(BUILDDEFS_PATH)/generic_features.mk
 include $(PLATFORM_PATH)/common.mk
 include $(TMK_PATH)/protocol.mk
+include $(QUANTUM_PATH)/backlight/tests/rules.mk
+include $(QUANTUM_PATH)/color_calibration/tests/rules.mk
 include $(QUANTUM_PATH)/debounce/tests/rules.mk
+include $(QUANTUM_PATH)/eeprom_schema/tests/rules.mk
 include $(QUANTUM_PATH)/encoder/tests/rules.mk
+include $(QUANTUM_PATH)/led_dither/tests/rules.mk
+include $(QUANTUM_PATH)/music/tests/rules.mk
+include $(QUANTUM_PATH)/rgblight/tests/rules.mk
 include $(QUANTUM_PATH)/sequencer/tests/rules.mk
+include $(TMK_PATH)/protocol/tests/rules.mk
+include $(DRIVER_PATH)/gpio/tests/rules.mk
+include $(DRIVER_PATH)/haptic/tests/rules.mk
+include $(DRIVER_PATH)/led/tests/rules.mk
 include $(PLATFORM_PATH)/test/rules.mk
 ifneq ($(filter $(FULL_TESTS),$(TEST)),)
 include $(BUILDDEFS_PATH)/build_full_test.mk
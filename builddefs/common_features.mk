@@ -89,6 +89,8 @@ endif
 
 MUSIC_ENABLE ?= no
 ifeq ($(MUSIC_ENABLE), yes)
+    COMMON_VPATH += $(QUANTUM_DIR)/music
+    SRC += $(QUANTUM_DIR)/music/music_recording.c
     SRC += $(QUANTUM_DIR)/process_keycode/process_music.c
 endif
 
@@ -290,9 +292,11 @@ endif
     COMMON_VPATH += $(QUANTUM_DIR)/led_matrix
     COMMON_VPATH += $(QUANTUM_DIR)/led_matrix/animations
     COMMON_VPATH += $(QUANTUM_DIR)/led_matrix/animations/runners
+    COMMON_VPATH += $(QUANTUM_DIR)/led_dither
     SRC += $(QUANTUM_DIR)/process_keycode/process_backlight.c
     SRC += $(QUANTUM_DIR)/led_matrix/led_matrix.c
     SRC += $(QUANTUM_DIR)/led_matrix/led_matrix_drivers.c
+    SRC += $(QUANTUM_DIR)/led_dither/led_dither.c
     SRC += $(LIB_PATH)/lib8tion/lib8tion.c
     CIE1931_CURVE := yes
 
@@ -335,7 +339,7 @@ endif
 
 RGB_MATRIX_ENABLE ?= no
 
-VALID_RGB_MATRIX_TYPES := AW20216 IS31FL3731 IS31FL3733 IS31FL3737 IS31FL3741 IS31FL3742A IS31FL3743A IS31FL3745 IS31FL3746A CKLED2001 WS2812 custom
+VALID_RGB_MATRIX_TYPES := APA102 AW20216 IS31FL3731 IS31FL3733 IS31FL3737 IS31FL3741 IS31FL3742A IS31FL3743A IS31FL3745 IS31FL3746A CKLED2001 WS2812 custom
 ifeq ($(strip $(RGB_MATRIX_ENABLE)), yes)
     ifeq ($(filter $(RGB_MATRIX_DRIVER),$(VALID_RGB_MATRIX_TYPES)),)
         $(call CATASTROPHIC_ERROR,Invalid RGB_MATRIX_DRIVER,RGB_MATRIX_DRIVER="$(RGB_MATRIX_DRIVER)" is not a valid matrix type)
@@ -348,9 +352,11 @@ endif
     COMMON_VPATH += $(QUANTUM_DIR)/rgb_matrix
     COMMON_VPATH += $(QUANTUM_DIR)/rgb_matrix/animations
     COMMON_VPATH += $(QUANTUM_DIR)/rgb_matrix/animations/runners
+    COMMON_VPATH += $(QUANTUM_DIR)/led_dither
     SRC += $(QUANTUM_DIR)/color.c
     SRC += $(QUANTUM_DIR)/rgb_matrix/rgb_matrix.c
     SRC += $(QUANTUM_DIR)/rgb_matrix/rgb_matrix_drivers.c
+    SRC += $(QUANTUM_DIR)/led_dither/led_dither.c
     SRC += $(LIB_PATH)/lib8tion/lib8tion.c
     CIE1931_CURVE := yes
     RGB_KEYCODES_ENABLE := yes
@@ -510,6 +516,9 @@ ifeq ($(strip $(WS2812_DRIVER_REQUIRED)), yes)
 
     OPT_DEFS += -DWS2812_DRIVER_$(strip $(shell echo $(WS2812_DRIVER) | tr '[:lower:]' '[:upper:]'))
 
+    COMMON_VPATH += $(DRIVER_PATH)/led
+    SRC += ws2812_encode.c
+
     ifeq ($(strip $(WS2812_DRIVER)), bitbang)
         SRC += ws2812.c
     else
@@ -528,9 +537,22 @@ ifeq ($(strip $(WS2812_DRIVER_REQUIRED)), yes)
     endif
 endif
 
+VALID_APA102_DRIVER_TYPES := bitbang spi
+
+APA102_DRIVER ?= bitbang
 ifeq ($(strip $(APA102_DRIVER_REQUIRED)), yes)
+    ifeq ($(filter $(APA102_DRIVER),$(VALID_APA102_DRIVER_TYPES)),)
+        $(call CATASTROPHIC_ERROR,Invalid APA102_DRIVER,APA102_DRIVER="$(APA102_DRIVER)" is not a valid APA102 driver)
+    endif
+
+    OPT_DEFS += -DAPA102_DRIVER_$(strip $(shell echo $(APA102_DRIVER) | tr '[:lower:]' '[:upper:]'))
+
     COMMON_VPATH += $(DRIVER_PATH)/led
     SRC += apa102.c
+
+    ifeq ($(strip $(APA102_DRIVER)), spi)
+        QUANTUM_LIB_SRC += spi_master.c
+    endif
 endif
 
 ifeq ($(strip $(CIE1931_CURVE)), yes)
@@ -542,6 +564,12 @@ ifeq ($(strip $(LED_TABLES)), yes)
     SRC += $(QUANTUM_DIR)/led_tables.c
 endif
 
+ifeq ($(strip $(COLOR_CALIBRATION_ENABLE)), yes)
+    OPT_DEFS += -DCOLOR_CALIBRATION_ENABLE
+    COMMON_VPATH += $(QUANTUM_DIR)/color_calibration
+    SRC += $(QUANTUM_DIR)/color_calibration/color_calibration.c
+endif
+
 ifeq ($(strip $(TERMINAL_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/process_keycode/process_terminal.c
     OPT_DEFS += -DTERMINAL_ENABLE
@@ -587,6 +615,8 @@ endif
 ifeq ($(strip $(DYNAMIC_KEYMAP_ENABLE)), yes)
     OPT_DEFS += -DDYNAMIC_KEYMAP_ENABLE
     SRC += $(QUANTUM_DIR)/dynamic_keymap.c
+    SRC += $(QUANTUM_DIR)/eeprom_schema/eeprom_schema.c
+    COMMON_VPATH += $(QUANTUM_DIR)/eeprom_schema
 endif
 
 ifeq ($(strip $(QMK_SETTINGS)), yes)
@@ -596,6 +626,9 @@ ifeq ($(strip $(QMK_SETTINGS)), yes)
         -DAUTO_SHIFT_NO_SETUP -DAUTO_SHIFT_REPEAT_PER_KEY -DAUTO_SHIFT_NO_AUTO_REPEAT_PER_KEY \
         -DTAPPING_TERM_PER_KEY -DPERMISSIVE_HOLD_PER_KEY -DIGNORE_MOD_TAP_INTERRUPT_PER_KEY -DTAPPING_FORCE_HOLD_PER_KEY -DRETRO_TAPPING_PER_KEY \
         -DCOMBO_TERM_PER_COMBO
+    ifeq ($(strip $(TAPPING_TERM_TABLE_ENABLE)), yes)
+        OPT_DEFS += -DTAPPING_TERM_TABLE_ENABLE -DHOLD_ON_OTHER_KEY_PRESS_PER_KEY
+    endif
 endif
 
 ifeq ($(strip $(DIP_SWITCH_ENABLE)), yes)
@@ -1,8 +1,18 @@
 TEST_LIST = $(sort $(patsubst %/test.mk,%, $(shell find $(ROOT_DIR)tests -type f -name test.mk)))
 FULL_TESTS := $(notdir $(TEST_LIST))
 
+include $(QUANTUM_PATH)/backlight/tests/testlist.mk
+include $(QUANTUM_PATH)/color_calibration/tests/testlist.mk
 include $(QUANTUM_PATH)/debounce/tests/testlist.mk
+include $(QUANTUM_PATH)/eeprom_schema/tests/testlist.mk
+include $(QUANTUM_PATH)/led_dither/tests/testlist.mk
+include $(QUANTUM_PATH)/music/tests/testlist.mk
+include $(QUANTUM_PATH)/rgblight/tests/testlist.mk
 include $(QUANTUM_PATH)/sequencer/tests/testlist.mk
+include $(TMK_PATH)/protocol/tests/testlist.mk
+include $(DRIVER_PATH)/gpio/tests/testlist.mk
+include $(DRIVER_PATH)/haptic/tests/testlist.mk
+include $(DRIVER_PATH)/led/tests/testlist.mk
 include $(PLATFORM_PATH)/test/testlist.mk
 
 define VALIDATE_TEST_LIST
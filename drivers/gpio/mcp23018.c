@@ -4,10 +4,13 @@
 #include "mcp23018.h"
 #include "i2c_master.h"
 #include "wait.h"
+#include "timer.h"
 #include "debug.h"
 
 #define SLAVE_TO_ADDR(n) (n << 1)
 #define TIMEOUT 100
+// Probing a missing expander should not hold up the matrix scan
+#define PROBE_TIMEOUT 10
 
 enum {
     CMD_IODIRA = 0x00, // i/o direction register
@@ -18,17 +21,48 @@ enum {
     CMD_GPIOB  = 0x13,
 };
 
-void mcp23018_init(uint8_t addr) {
-    static uint8_t s_init = 0;
-    if (!s_init) {
-        i2c_init();
-        wait_ms(1000);
+/* An expander that fails a transfer, such as the other half of a split keyboard while its cable
+ * is out, is marked as disconnected. Transfers to it then fail straight away, without waiting for
+ * the bus, and it is probed every MCP23018_RECOVERY_INTERVAL until it answers again. As it has
+ * been reset in the meantime, its port configuration is then written to it again.
+ */
+typedef struct {
+    uint8_t  slave_addr;
+    bool     connected;
+    uint8_t  configured; // bit per port with a configuration to restore
+    uint8_t  conf[2];
+    uint16_t last_probe;
+} mcp23018_device_t;
+
+static mcp23018_device_t devices[MCP23018_MAX_DEVICES];
+static uint8_t           device_count = 0;
+
+static mcp23018_device_t* mcp23018_find(uint8_t slave_addr) {
+    for (uint8_t i = 0; i < device_count; i++) {
+        if (devices[i].slave_addr == slave_addr) {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
 
-        s_init = 1;
+static mcp23018_device_t* mcp23018_track(uint8_t slave_addr) {
+    mcp23018_device_t* device = mcp23018_find(slave_addr);
+    if (!device && device_count < MCP23018_MAX_DEVICES) {
+        device             = &devices[device_count++];
+        device->slave_addr = slave_addr;
+        device->connected  = true;
+        device->configured = 0;
     }
+    return device;
 }
 
-bool mcp23018_set_config(uint8_t slave_addr, mcp23018_port_t port, uint8_t conf) {
+static bool mcp23018_probe(uint8_t slave_addr) {
+    uint8_t data;
+    return i2c_readReg(SLAVE_TO_ADDR(slave_addr), CMD_IODIRA, &data, sizeof(data), PROBE_TIMEOUT) == I2C_STATUS_SUCCESS;
+}
+
+static bool mcp23018_write_config(uint8_t slave_addr, mcp23018_port_t port, uint8_t conf) {
     uint8_t addr         = SLAVE_TO_ADDR(slave_addr);
     uint8_t cmdDirection = port ? CMD_IODIRB : CMD_IODIRA;
     uint8_t cmdPullup    = port ? CMD_GPPUB : CMD_GPPUA;
@@ -48,13 +82,98 @@ bool mcp23018_set_config(uint8_t slave_addr, mcp23018_port_t port, uint8_t conf)
     return true;
 }
 
+// Whether to go ahead with a transfer, trying to bring a disconnected expander back first
+static bool mcp23018_available(uint8_t slave_addr) {
+    mcp23018_device_t* device = mcp23018_find(slave_addr);
+    if (!device || device->connected) {
+        return true;
+    }
+
+    if (timer_elapsed(device->last_probe) < MCP23018_RECOVERY_INTERVAL) {
+        return false;
+    }
+    device->last_probe = timer_read();
+    if (!mcp23018_probe(slave_addr)) {
+        return false;
+    }
+
+    for (uint8_t port = mcp23018_PORTA; port <= mcp23018_PORTB; port++) {
+        if ((device->configured & (1 << port)) && !mcp23018_write_config(slave_addr, port, device->conf[port])) {
+            return false;
+        }
+    }
+
+    dprintf("mcp23018_available::RECONNECTED::%u\n", slave_addr);
+    device->connected = true;
+    return true;
+}
+
+static void mcp23018_lost(uint8_t slave_addr) {
+    mcp23018_device_t* device = mcp23018_find(slave_addr);
+    if (device && device->connected) {
+        device->connected  = false;
+        device->last_probe = timer_read();
+    }
+}
+
+bool mcp23018_init(uint8_t slave_addr) {
+    static uint8_t s_init = 0;
+    if (!s_init) {
+        i2c_init();
+
+        s_init = 1;
+    }
+
+    // The expander may still be powering up, so give it until it answers rather than the worst case
+    uint16_t start = timer_read();
+    bool     found = mcp23018_probe(slave_addr);
+    while (!found && timer_elapsed(start) < MCP23018_INIT_TIMEOUT) {
+        wait_ms(1);
+        found = mcp23018_probe(slave_addr);
+    }
+
+    mcp23018_device_t* device = mcp23018_track(slave_addr);
+    if (device) {
+        device->connected  = found;
+        device->last_probe = timer_read();
+    }
+    if (!found) {
+        dprintf("mcp23018_init::NOT_FOUND::%u\n", slave_addr);
+    }
+    return found;
+}
+
+bool mcp23018_set_config(uint8_t slave_addr, mcp23018_port_t port, uint8_t conf) {
+    mcp23018_device_t* device = mcp23018_track(slave_addr);
+    if (device) {
+        device->configured |= 1 << port;
+        device->conf[port] = conf;
+    }
+
+    if (!mcp23018_available(slave_addr)) {
+        return false;
+    }
+
+    if (!mcp23018_write_config(slave_addr, port, conf)) {
+        mcp23018_lost(slave_addr);
+        return false;
+    }
+
+    return true;
+}
+
 bool mcp23018_set_output(uint8_t slave_addr, mcp23018_port_t port, uint8_t conf) {
+    if (!mcp23018_available(slave_addr)) {
+        return false;
+    }
+
     uint8_t addr = SLAVE_TO_ADDR(slave_addr);
     uint8_t cmd  = port ? CMD_GPIOB : CMD_GPIOA;
 
     i2c_status_t ret = i2c_writeReg(addr, cmd, &conf, sizeof(conf), TIMEOUT);
     if (ret != I2C_STATUS_SUCCESS) {
         dprintf("mcp23018_set_output::FAILED::%u\n", ret);
+        mcp23018_lost(slave_addr);
         return false;
     }
 
@@ -62,12 +181,17 @@ bool mcp23018_set_output(uint8_t slave_addr, mcp23018_port_t port, uint8_t conf)
 }
 
 bool mcp23018_set_output_all(uint8_t slave_addr, uint8_t confA, uint8_t confB) {
+    if (!mcp23018_available(slave_addr)) {
+        return false;
+    }
+
     uint8_t addr    = SLAVE_TO_ADDR(slave_addr);
     uint8_t conf[2] = {confA, confB};
 
     i2c_status_t ret = i2c_writeReg(addr, CMD_GPIOA, &conf[0], sizeof(conf), TIMEOUT);
     if (ret != I2C_STATUS_SUCCESS) {
         dprintf("mcp23018_set_output::FAILED::%u\n", ret);
+        mcp23018_lost(slave_addr);
         return false;
     }
 
@@ -75,12 +199,17 @@ bool mcp23018_set_output_all(uint8_t slave_addr, uint8_t confA, uint8_t confB) {
 }
 
 bool mcp23018_readPins(uint8_t slave_addr, mcp23018_port_t port, uint8_t* out) {
+    if (!mcp23018_available(slave_addr)) {
+        return false;
+    }
+
     uint8_t addr = SLAVE_TO_ADDR(slave_addr);
     uint8_t cmd  = port ? CMD_GPIOB : CMD_GPIOA;
 
     i2c_status_t ret = i2c_readReg(addr, cmd, out, sizeof(uint8_t), TIMEOUT);
     if (ret != I2C_STATUS_SUCCESS) {
         dprintf("mcp23018_readPins::FAILED::%u\n", ret);
+        mcp23018_lost(slave_addr);
         return false;
     }
 
@@ -88,6 +217,10 @@ bool mcp23018_readPins(uint8_t slave_addr, mcp23018_port_t port, uint8_t* out) {
 }
 
 bool mcp23018_readPins_all(uint8_t slave_addr, uint16_t* out) {
+    if (!mcp23018_available(slave_addr)) {
+        return false;
+    }
+
     uint8_t addr = SLAVE_TO_ADDR(slave_addr);
 
     typedef union {
@@ -100,6 +233,7 @@ bool mcp23018_readPins_all(uint8_t slave_addr, uint16_t* out) {
     i2c_status_t ret = i2c_readReg(addr, CMD_GPIOA, &data.u8[0], sizeof(data), TIMEOUT);
     if (ret != I2C_STATUS_SUCCESS) {
         dprintf("mcp23018_readPins::FAILED::%u\n", ret);
+        mcp23018_lost(slave_addr);
         return false;
     }
 
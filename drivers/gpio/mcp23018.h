@@ -6,6 +6,21 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Longest time mcp23018_init() waits for the expander to answer after power up, in ms
+#ifndef MCP23018_INIT_TIMEOUT
+#    define MCP23018_INIT_TIMEOUT 1000
+#endif
+
+// How often an expander that stopped answering is probed for, in ms
+#ifndef MCP23018_RECOVERY_INTERVAL
+#    define MCP23018_RECOVERY_INTERVAL 500
+#endif
+
+// Expanders whose configuration is kept, to be restored when they come back
+#ifndef MCP23018_MAX_DEVICES
+#    define MCP23018_MAX_DEVICES 2
+#endif
+
 /**
  * Port ID
  */
@@ -32,11 +47,15 @@ enum {
 
 /**
  * Init expander and any other dependent drivers
+ *
+ *  - waits up to MCP23018_INIT_TIMEOUT for the expander to answer, returning whether it did
  */
-void mcp23018_init(uint8_t slave_addr);
+bool mcp23018_init(uint8_t slave_addr);
 
 /**
  * Configure input/output to a given port
+ *
+ *  - the configuration is written again whenever the expander comes back after being disconnected
  */
 bool mcp23018_set_config(uint8_t slave_addr, mcp23018_port_t port, uint8_t conf);
 
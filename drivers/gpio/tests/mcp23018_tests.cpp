@@ -0,0 +1,171 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+extern "C" {
+#include "mcp23018.h"
+#include "i2c_master.h"
+#include "timer.h"
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+#define ADDR 0x20
+
+enum {
+    IODIRA = 0x00,
+    IODIRB = 0x01,
+    GPPUA  = 0x0C,
+    GPPUB  = 0x0D,
+    GPIOA  = 0x12,
+    GPIOB  = 0x13,
+};
+
+// A single expander, which answers from ack_from on while plugged in
+static struct {
+    bool     plugged;
+    uint32_t ack_from;
+    uint8_t  regs[0x16];
+    int      transfers;
+} expander;
+
+static void power_on(void) {
+    memset(expander.regs, 0, sizeof(expander.regs));
+    expander.regs[IODIRA] = 0xFF;
+    expander.regs[IODIRB] = 0xFF;
+}
+
+static bool answers(uint8_t devaddr) {
+    expander.transfers++;
+    return devaddr == ADDR << 1 && expander.plugged && timer_read32() >= expander.ack_from;
+}
+
+extern "C" {
+void i2c_init(void) {}
+
+i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    if (!answers(devaddr)) {
+        return I2C_STATUS_ERROR;
+    }
+    memcpy(&expander.regs[regaddr], data, length);
+    return I2C_STATUS_SUCCESS;
+}
+
+i2c_status_t i2c_readReg(uint8_t devaddr, uint8_t regaddr, uint8_t *data, uint16_t length, uint16_t timeout) {
+    if (!answers(devaddr)) {
+        return I2C_STATUS_ERROR;
+    }
+    memcpy(data, &expander.regs[regaddr], length);
+    return I2C_STATUS_SUCCESS;
+}
+}
+
+class MCP23018 : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        set_time(0);
+        power_on();
+        expander.plugged   = true;
+        expander.ack_from  = 0;
+        expander.transfers = 0;
+    }
+};
+
+TEST_F(MCP23018, BootWaitFollowsAck) {
+    // the expander is tracked across tests, so it starts out connected in each of them
+    for (uint32_t ack_from : {0, 1, 5, 100, 700}) {
+        set_time(10000);
+        expander.ack_from = 10000 + ack_from;
+        EXPECT_TRUE(mcp23018_init(ADDR));
+        EXPECT_EQ(timer_read32() - 10000, ack_from) << "acked after " << ack_from << "ms";
+    }
+}
+
+TEST_F(MCP23018, MissingExpander) {
+    expander.plugged = false;
+    EXPECT_FALSE(mcp23018_init(ADDR));
+    EXPECT_EQ(timer_read32(), MCP23018_INIT_TIMEOUT);
+
+    // no more bus transfers until it is time to look for it again
+    expander.transfers = 0;
+    uint16_t pins;
+    EXPECT_FALSE(mcp23018_set_config(ADDR, mcp23018_PORTA, ALL_INPUT));
+    EXPECT_FALSE(mcp23018_readPins_all(ADDR, &pins));
+    EXPECT_EQ(expander.transfers, 0);
+
+    advance_time(MCP23018_RECOVERY_INTERVAL);
+    EXPECT_FALSE(mcp23018_readPins_all(ADDR, &pins));
+    EXPECT_EQ(expander.transfers, 1);
+
+    // plugged in late, it is found and configured
+    expander.plugged = true;
+    advance_time(MCP23018_RECOVERY_INTERVAL);
+    EXPECT_TRUE(mcp23018_readPins_all(ADDR, &pins));
+    EXPECT_EQ(expander.regs[IODIRA], ALL_INPUT);
+    EXPECT_EQ(expander.regs[GPPUA], ALL_INPUT);
+}
+
+TEST_F(MCP23018, DisconnectMidSession) {
+    ASSERT_TRUE(mcp23018_init(ADDR));
+    ASSERT_TRUE(mcp23018_set_config(ADDR, mcp23018_PORTA, ALL_INPUT));
+    ASSERT_TRUE(mcp23018_set_config(ADDR, mcp23018_PORTB, 0b01100000));
+
+    uint16_t pins;
+    expander.regs[GPIOA] = 0x5A;
+    ASSERT_TRUE(mcp23018_readPins_all(ADDR, &pins));
+    EXPECT_EQ(pins & 0xFF, 0x5A);
+
+    // unplugged: the first failure marks it, after which scanning does not wait for the bus
+    expander.plugged = false;
+    EXPECT_FALSE(mcp23018_readPins_all(ADDR, &pins));
+    expander.transfers = 0;
+    for (int i = 0; i < 100; i++) {
+        EXPECT_FALSE(mcp23018_set_output(ADDR, mcp23018_PORTB, ALL_HIGH));
+        EXPECT_FALSE(mcp23018_readPins_all(ADDR, &pins));
+        advance_time(1);
+    }
+    EXPECT_EQ(expander.transfers, 0);
+
+    // plugged back in, reset to its power on state
+    power_on();
+    expander.plugged = true;
+    advance_time(MCP23018_RECOVERY_INTERVAL);
+    EXPECT_TRUE(mcp23018_readPins_all(ADDR, &pins));
+    EXPECT_EQ(expander.regs[IODIRA], ALL_INPUT);
+    EXPECT_EQ(expander.regs[GPPUA], ALL_INPUT);
+    EXPECT_EQ(expander.regs[IODIRB], 0b01100000);
+    EXPECT_EQ(expander.regs[GPPUB], 0b01100000);
+
+    EXPECT_TRUE(mcp23018_set_output(ADDR, mcp23018_PORTB, 0x0F));
+    EXPECT_EQ(expander.regs[GPIOB], 0x0F);
+}
+
+TEST_F(MCP23018, OtherAddressesAreUnaffected) {
+    ASSERT_TRUE(mcp23018_init(ADDR));
+    expander.plugged = false;
+    uint8_t pins;
+    EXPECT_FALSE(mcp23018_readPins(ADDR, mcp23018_PORTA, &pins));
+
+    // an untracked expander is always tried
+    expander.transfers = 0;
+    EXPECT_FALSE(mcp23018_readPins(ADDR + 1, mcp23018_PORTA, &pins));
+    EXPECT_FALSE(mcp23018_readPins(ADDR + 1, mcp23018_PORTA, &pins));
+    EXPECT_EQ(expander.transfers, 2);
+}
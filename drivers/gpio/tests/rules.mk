@@ -0,0 +1,23 @@
+# Copyright 2022 QMK
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+mcp23018_DEFS := -DNO_DEBUG
+
+mcp23018_INC := $(DRIVER_PATH)/gpio/tests $(DRIVER_PATH)/gpio
+
+mcp23018_SRC := \
+	$(DRIVER_PATH)/gpio/tests/mcp23018_tests.cpp \
+	$(DRIVER_PATH)/gpio/mcp23018.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/timer.c
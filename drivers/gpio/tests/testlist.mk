@@ -0,0 +1 @@
+TEST_LIST += mcp23018
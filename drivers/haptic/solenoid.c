@@ -21,13 +21,39 @@
 #include "gpio.h"
 #include "usb_device_state.h"
 
-bool     solenoid_on      = false;
-bool     solenoid_buzzing = false;
-uint16_t solenoid_start   = 0;
-uint8_t  solenoid_dwell   = SOLENOID_DEFAULT_DWELL;
+static const pin_t solenoid_pads[] = SOLENOID_PINS;
+#define NUMBER_OF_SOLENOIDS (sizeof(solenoid_pads) / sizeof(pin_t))
+static const bool solenoid_active_low[NUMBER_OF_SOLENOIDS] = SOLENOID_PINS_ACTIVE_LOW;
+
+enum solenoid_phase {
+    SOLENOID_IDLE,
+    SOLENOID_ACTUATED,
+    SOLENOID_RELEASED, // between two buzz pulses
+    SOLENOID_GAP,      // between two queued patterns
+};
+
+/* Each solenoid plays its queue of patterns on its own. Every change of the pin is scheduled at a
+ * deadline, counted from the previous deadline rather than from when the change was made, so a
+ * late scan loop does not stretch a pattern, and the solenoid is always released on time.
+ */
+typedef struct {
+    solenoid_pattern_t queue[SOLENOID_QUEUE_SIZE];
+    uint8_t            head;
+    uint8_t            count;
+    uint8_t            phase;
+    uint16_t           deadline;  // of the next change of the pin
+    uint16_t           remaining; // ms of the pattern left after the deadline
+} solenoid_channel_t;
+
+static solenoid_channel_t solenoid_channels[NUMBER_OF_SOLENOIDS];
+static uint8_t            solenoid_dwell = SOLENOID_DEFAULT_DWELL;
 
 extern haptic_config_t haptic_config;
 
+static void solenoid_write(uint8_t channel, bool active) {
+    writePin(solenoid_pads[channel], active != solenoid_active_low[channel]);
+}
+
 void solenoid_buzz_on(void) {
     haptic_set_buzz(1);
 }
@@ -44,59 +70,137 @@ void solenoid_set_dwell(uint8_t dwell) {
     solenoid_dwell = dwell;
 }
 
-void solenoid_stop(void) {
-    SOLENOID_PIN_WRITE_INACTIVE();
-    solenoid_on      = false;
-    solenoid_buzzing = false;
+uint8_t solenoid_channel_count(void) {
+    return NUMBER_OF_SOLENOIDS;
 }
 
-void solenoid_fire(void) {
-    if (!haptic_config.buzz && solenoid_on) return;
-    if (haptic_config.buzz && solenoid_buzzing) return;
+bool solenoid_is_active(uint8_t channel) {
+    return channel < NUMBER_OF_SOLENOIDS && solenoid_channels[channel].phase != SOLENOID_IDLE;
+}
 
-    solenoid_on      = true;
-    solenoid_buzzing = true;
-    solenoid_start   = timer_read();
-    SOLENOID_PIN_WRITE_ACTIVE();
+// Moves the deadline on by up to `length` ms, without going past the end of the pattern
+static void solenoid_schedule(solenoid_channel_t *ch, uint8_t length) {
+    uint16_t step = length < ch->remaining ? length : ch->remaining;
+    ch->deadline += step;
+    ch->remaining -= step;
 }
 
-void solenoid_check(void) {
-    uint16_t elapsed = 0;
+static void solenoid_start(uint8_t channel, uint16_t time) {
+    solenoid_channel_t *ch      = &solenoid_channels[channel];
+    solenoid_pattern_t *pattern = &ch->queue[ch->head];
 
-    if (!solenoid_on) return;
+    ch->phase     = SOLENOID_ACTUATED;
+    ch->deadline  = time;
+    ch->remaining = pattern->dwell;
+    solenoid_schedule(ch, (pattern->on && pattern->off) ? pattern->on : pattern->dwell);
+}
 
-    elapsed = timer_elapsed(solenoid_start);
+// Moves on to the phase due at the deadline, and schedules the next one. The pin is left to the caller
+static void solenoid_step(uint8_t channel) {
+    solenoid_channel_t *ch      = &solenoid_channels[channel];
+    solenoid_pattern_t *pattern = &ch->queue[ch->head];
 
-    // Check if it's time to finish this solenoid click cycle
-    if (elapsed > solenoid_dwell) {
-        solenoid_stop();
+    if (ch->phase == SOLENOID_GAP) {
+        solenoid_start(channel, ch->deadline);
         return;
     }
 
-    // Check whether to buzz the solenoid on and off
-    if (haptic_config.buzz) {
-        if ((elapsed % (SOLENOID_BUZZ_ACTUATED + SOLENOID_BUZZ_NONACTUATED)) < SOLENOID_BUZZ_ACTUATED) {
-            if (!solenoid_buzzing) {
-                solenoid_buzzing = true;
-                SOLENOID_PIN_WRITE_ACTIVE();
-            }
+    if (ch->remaining == 0) {
+        ch->head = (ch->head + 1) % SOLENOID_QUEUE_SIZE;
+        ch->count--;
+        if (ch->count) {
+            ch->phase = SOLENOID_GAP;
+            ch->deadline += SOLENOID_QUEUE_GAP;
         } else {
-            if (solenoid_buzzing) {
-                solenoid_buzzing = false;
-                SOLENOID_PIN_WRITE_INACTIVE();
-            }
+            ch->phase = SOLENOID_IDLE;
         }
+        return;
+    }
+
+    if (ch->phase == SOLENOID_ACTUATED) {
+        ch->phase = SOLENOID_RELEASED;
+        solenoid_schedule(ch, pattern->off);
+    } else {
+        ch->phase = SOLENOID_ACTUATED;
+        solenoid_schedule(ch, pattern->on);
+    }
+}
+
+/** \brief Queue a pattern to play on a solenoid
+ *
+ * The pattern starts straight away if the solenoid is idle, or after the ones already queued.
+ * Returns false if the queue is full.
+ */
+bool solenoid_play(uint8_t channel, const solenoid_pattern_t *pattern) {
+    if (channel >= NUMBER_OF_SOLENOIDS) return false;
+
+    solenoid_channel_t *ch = &solenoid_channels[channel];
+    if (ch->count >= SOLENOID_QUEUE_SIZE) return false;
+
+    ch->queue[(ch->head + ch->count) % SOLENOID_QUEUE_SIZE] = *pattern;
+    ch->count++;
+    if (ch->phase == SOLENOID_IDLE) {
+        solenoid_start(channel, timer_read());
+        solenoid_write(channel, true);
+    }
+    return true;
+}
+
+void solenoid_stop(void) {
+    for (uint8_t i = 0; i < NUMBER_OF_SOLENOIDS; i++) {
+        solenoid_write(i, false);
+        solenoid_channels[i].phase = SOLENOID_IDLE;
+        solenoid_channels[i].count = 0;
+    }
+}
+
+/** \brief Click or buzz a solenoid with the dwell and buzz of the haptic settings
+ *
+ * Does nothing while the solenoid is still busy, so that fast typing does not pile up clicks.
+ */
+void solenoid_fire_channel(uint8_t channel) {
+    if (solenoid_is_active(channel)) return;
+
+    solenoid_pattern_t pattern = {.dwell = solenoid_dwell};
+    if (haptic_config.buzz) {
+        pattern.on  = SOLENOID_BUZZ_ACTUATED;
+        pattern.off = SOLENOID_BUZZ_NONACTUATED;
+    }
+    solenoid_play(channel, &pattern);
+}
+
+void solenoid_fire(void) {
+    solenoid_fire_channel(0);
+}
+
+void solenoid_check(void) {
+    uint16_t now = timer_read();
+
+    for (uint8_t i = 0; i < NUMBER_OF_SOLENOIDS; i++) {
+        solenoid_channel_t *ch = &solenoid_channels[i];
+        if (ch->phase == SOLENOID_IDLE || !timer_expired(now, ch->deadline)) continue;
+
+        // catch up on every change that came due since the last check, but only write the pin
+        // where they left it, so that missed pulses do not glitch it
+        do {
+            solenoid_step(i);
+        } while (ch->phase != SOLENOID_IDLE && timer_expired(now, ch->deadline));
+        solenoid_write(i, ch->phase == SOLENOID_ACTUATED);
     }
 }
 
 void solenoid_setup(void) {
-    SOLENOID_PIN_WRITE_INACTIVE();
-    setPinOutput(SOLENOID_PIN);
-    if ((!HAPTIC_OFF_IN_LOW_POWER) || (usb_device_state == USB_DEVICE_STATE_CONFIGURED)) {
-        solenoid_fire();
+    for (uint8_t i = 0; i < NUMBER_OF_SOLENOIDS; i++) {
+        solenoid_write(i, false);
+        setPinOutput(solenoid_pads[i]);
+        if ((!HAPTIC_OFF_IN_LOW_POWER) || (usb_device_state == USB_DEVICE_STATE_CONFIGURED)) {
+            solenoid_fire_channel(i);
+        }
     }
 }
 
 void solenoid_shutdown(void) {
-    SOLENOID_PIN_WRITE_INACTIVE();
+    for (uint8_t i = 0; i < NUMBER_OF_SOLENOIDS; i++) {
+        solenoid_write(i, false);
+    }
 }
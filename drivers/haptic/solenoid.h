@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifndef SOLENOID_DEFAULT_DWELL
 #    define SOLENOID_DEFAULT_DWELL 12
 #endif
@@ -45,26 +48,58 @@
 #    define SOLENOID_BUZZ_NONACTUATED SOLENOID_MIN_DWELL
 #endif
 
-#ifndef SOLENOID_PIN
-#    error SOLENOID_PIN not defined
+#ifndef SOLENOID_QUEUE_SIZE
+#    define SOLENOID_QUEUE_SIZE 4
+#endif
+
+// how long a solenoid is released between two queued patterns, so that the plunger can return
+#ifndef SOLENOID_QUEUE_GAP
+#    define SOLENOID_QUEUE_GAP SOLENOID_MIN_DWELL
 #endif
 
-#ifdef SOLENOID_PIN_ACTIVE_LOW
-#    define SOLENOID_PIN_WRITE_ACTIVE() writePinLow(SOLENOID_PIN)
-#    define SOLENOID_PIN_WRITE_INACTIVE() writePinHigh(SOLENOID_PIN)
-#else
-#    define SOLENOID_PIN_WRITE_ACTIVE() writePinHigh(SOLENOID_PIN)
-#    define SOLENOID_PIN_WRITE_INACTIVE() writePinLow(SOLENOID_PIN)
+#ifndef SOLENOID_PINS
+#    ifdef SOLENOID_PIN
+#        define SOLENOID_PINS \
+            { SOLENOID_PIN }
+#    else
+#        error SOLENOID_PIN or SOLENOID_PINS not defined
+#    endif
+#    if defined(SOLENOID_PIN_ACTIVE_LOW) && !defined(SOLENOID_PINS_ACTIVE_LOW)
+#        define SOLENOID_PINS_ACTIVE_LOW \
+            { true }
+#    endif
+#elif !defined(SOLENOID_PINS_ACTIVE_LOW)
+// SOLENOID_PIN_ACTIVE_LOW could only apply to the first of several pins
+#    error SOLENOID_PINS needs SOLENOID_PINS_ACTIVE_LOW, e.g. { false, false }
 #endif
 
+#ifndef SOLENOID_PINS_ACTIVE_LOW
+#    define SOLENOID_PINS_ACTIVE_LOW \
+        { false }
+#endif
+
+/* A click or buzz played on one solenoid: the solenoid is actuated for `dwell` ms, or, when both
+ * `on` and `off` are set, repeatedly actuated for `on` ms and released for `off` ms until `dwell`
+ * ms have passed.
+ */
+typedef struct {
+    uint8_t dwell;
+    uint8_t on;
+    uint8_t off;
+} solenoid_pattern_t;
+
 void solenoid_buzz_on(void);
 void solenoid_buzz_off(void);
 void solenoid_set_buzz(int buzz);
 
 void solenoid_set_dwell(uint8_t dwell);
 
-void solenoid_stop(void);
-void solenoid_fire(void);
+void    solenoid_stop(void);
+void    solenoid_fire(void);
+void    solenoid_fire_channel(uint8_t channel);
+bool    solenoid_play(uint8_t channel, const solenoid_pattern_t *pattern);
+bool    solenoid_is_active(uint8_t channel);
+uint8_t solenoid_channel_count(void);
 
 void solenoid_check(void);
 
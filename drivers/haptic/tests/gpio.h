@@ -0,0 +1,37 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Stands in for the platform gpio.h, so that drivers can be tested on the host against mock pins
+ * implemented by the test.
+ */
+typedef uint8_t pin_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void setPinOutput(pin_t pin);
+void writePinHigh(pin_t pin);
+void writePinLow(pin_t pin);
+#ifdef __cplusplus
+}
+#endif
+
+#define writePin(pin, level) ((level) ? writePinHigh(pin) : writePinLow(pin))
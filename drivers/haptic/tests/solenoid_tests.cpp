@@ -0,0 +1,208 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include "solenoid.h"
+#include "gpio.h"
+#include "haptic.h"
+#include "usb_device_state.h"
+#include "timer.h"
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+// Channel 0 is on pin 1, channel 1 on the active low pin 2
+#define PIN_0 1
+#define PIN_1 2
+
+// The level of each pin, and every time it changed
+static struct {
+    bool                                  level[3];
+    std::vector<std::pair<uint16_t, bool>> changes[3];
+} pins;
+
+static void write_pin(pin_t pin, bool level) {
+    if (pins.level[pin] != level) {
+        pins.changes[pin].push_back({timer_read(), level});
+    }
+    pins.level[pin] = level;
+}
+
+extern "C" {
+haptic_config_t           haptic_config;
+enum usb_device_state     usb_device_state = USB_DEVICE_STATE_CONFIGURED;
+
+void haptic_set_buzz(uint8_t buzz) {
+    haptic_config.buzz = buzz;
+}
+
+void setPinOutput(pin_t pin) {}
+
+void writePinHigh(pin_t pin) {
+    write_pin(pin, true);
+}
+
+void writePinLow(pin_t pin) {
+    write_pin(pin, false);
+}
+}
+
+typedef std::vector<std::pair<uint16_t, bool>> changes_t;
+
+class Solenoid : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        set_time(0);
+        solenoid_stop();
+        haptic_config.buzz = 0;
+        solenoid_set_dwell(SOLENOID_DEFAULT_DWELL);
+        for (auto &changes : pins.changes) {
+            changes.clear();
+        }
+    }
+
+    // Runs the haptic task every millisecond
+    void run_for(uint16_t ms) {
+        for (uint16_t i = 0; i < ms; i++) {
+            advance_time(1);
+            solenoid_check();
+        }
+    }
+};
+
+TEST_F(Solenoid, ClickLastsTheDwell) {
+    set_time(100);
+    solenoid_set_dwell(12);
+    solenoid_fire();
+    EXPECT_TRUE(solenoid_is_active(0));
+    run_for(50);
+
+    EXPECT_EQ(pins.changes[PIN_0], (changes_t{{100, true}, {112, false}}));
+    EXPECT_FALSE(solenoid_is_active(0));
+}
+
+TEST_F(Solenoid, BuzzPulseWidths) {
+    haptic_config.buzz = 1;
+    solenoid_set_dwell(20);
+    solenoid_fire();
+    run_for(50);
+
+    // SOLENOID_BUZZ_ACTUATED and SOLENOID_BUZZ_NONACTUATED default to SOLENOID_MIN_DWELL
+    EXPECT_EQ(pins.changes[PIN_0], (changes_t{{0, true}, {4, false}, {8, true}, {12, false}, {16, true}, {20, false}}));
+}
+
+TEST_F(Solenoid, BuzzIsCutAtTheDwell) {
+    const solenoid_pattern_t pattern = {.dwell = 10, .on = 3, .off = 5};
+    EXPECT_TRUE(solenoid_play(0, &pattern));
+    run_for(50);
+
+    EXPECT_EQ(pins.changes[PIN_0], (changes_t{{0, true}, {3, false}, {8, true}, {10, false}}));
+}
+
+TEST_F(Solenoid, ChannelsAreIndependent) {
+    solenoid_set_dwell(12);
+    solenoid_fire_channel(0);
+    run_for(5);
+
+    const solenoid_pattern_t pattern = {.dwell = 20, .on = 2, .off = 8};
+    EXPECT_TRUE(solenoid_play(1, &pattern));
+    run_for(50);
+
+    EXPECT_EQ(pins.changes[PIN_0], (changes_t{{0, true}, {12, false}}));
+    // active low
+    EXPECT_EQ(pins.changes[PIN_1], (changes_t{{5, false}, {7, true}, {15, false}, {17, true}}));
+    EXPECT_FALSE(solenoid_is_active(1));
+}
+
+TEST_F(Solenoid, FiringABusySolenoidIsIgnored) {
+    solenoid_set_dwell(12);
+    solenoid_fire();
+    run_for(6);
+    solenoid_fire();
+    run_for(50);
+
+    EXPECT_EQ(pins.changes[PIN_0], (changes_t{{0, true}, {12, false}}));
+}
+
+TEST_F(Solenoid, QueuedPatternsPlayInTurn) {
+    const solenoid_pattern_t click = {.dwell = 10};
+    const solenoid_pattern_t buzz  = {.dwell = 6, .on = 2, .off = 2};
+    EXPECT_TRUE(solenoid_play(0, &click));
+    EXPECT_TRUE(solenoid_play(0, &buzz));
+    EXPECT_TRUE(solenoid_play(0, &click));
+    EXPECT_TRUE(solenoid_play(0, &click));
+    EXPECT_FALSE(solenoid_play(0, &click)) << "SOLENOID_QUEUE_SIZE patterns fit in the queue";
+    run_for(100);
+
+    // released for SOLENOID_QUEUE_GAP between patterns
+    EXPECT_EQ(pins.changes[PIN_0], (changes_t{{0, true}, {10, false}, {14, true}, {16, false}, {18, true}, {20, false}, {24, true}, {34, false}, {38, true}, {48, false}}));
+}
+
+TEST_F(Solenoid, LateChecksKeepTheDeadlines) {
+    const solenoid_pattern_t buzz = {.dwell = 12, .on = 4, .off = 4};
+    EXPECT_TRUE(solenoid_play(0, &buzz));
+    EXPECT_TRUE(solenoid_play(0, &buzz));
+
+    // a slow scan loop misses a few changes, but the solenoid is released on time
+    advance_time(9);
+    solenoid_check();
+    EXPECT_TRUE(pins.level[PIN_0]) << "the release at 4 ms was missed, the next pulse is due";
+    EXPECT_EQ(pins.changes[PIN_0], (changes_t{{0, true}})) << "the missed release is not written";
+    advance_time(4);
+    solenoid_check();
+    EXPECT_FALSE(pins.level[PIN_0]);
+
+    // the second pattern starts from its deadline, not from when it was noticed
+    pins.changes[PIN_0].clear();
+    run_for(50);
+    EXPECT_EQ(pins.changes[PIN_0], (changes_t{{16, true}, {20, false}, {24, true}, {28, false}}));
+}
+
+TEST_F(Solenoid, TimerWraps) {
+    set_time(UINT16_MAX - 4);
+    solenoid_set_dwell(12);
+    solenoid_fire();
+    run_for(50);
+
+    EXPECT_EQ(pins.changes[PIN_0], (changes_t{{UINT16_MAX - 4, true}, {7, false}}));
+}
+
+TEST_F(Solenoid, StopReleasesEverySolenoid) {
+    solenoid_fire_channel(0);
+    solenoid_fire_channel(1);
+    EXPECT_TRUE(pins.level[PIN_0]);
+    EXPECT_FALSE(pins.level[PIN_1]);
+
+    solenoid_stop();
+    EXPECT_FALSE(pins.level[PIN_0]);
+    EXPECT_TRUE(pins.level[PIN_1]);
+    EXPECT_FALSE(solenoid_is_active(0));
+    EXPECT_FALSE(solenoid_is_active(1));
+}
+
+TEST_F(Solenoid, UnknownChannel) {
+    const solenoid_pattern_t click = {.dwell = 10};
+    EXPECT_EQ(solenoid_channel_count(), 2);
+    EXPECT_FALSE(solenoid_play(2, &click));
+    solenoid_fire_channel(2);
+    EXPECT_FALSE(solenoid_is_active(2));
+}
@@ -15,100 +15,57 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include "apa102.h"
-#include "quantum.h"
-
-#ifndef APA102_NOPS
-#    if defined(__AVR__)
-#        define APA102_NOPS 0 // AVR at 16 MHz already spends 62.5 ns per clock, so no extra delay is needed
-#    elif defined(PROTOCOL_CHIBIOS)
-
-#        include "hal.h"
-#        if defined(STM32F0XX) || defined(STM32F1XX) || defined(STM32F3XX) || defined(STM32F4XX) || defined(STM32L0XX) || defined(GD32VF103)
-#            define APA102_NOPS (100 / (1000000000L / (CPU_CLOCK / 4))) // This calculates how many loops of 4 nops to run to delay 100 ns
-#        else
-#            error("APA102_NOPS configuration required")
-#            define APA102_NOPS 0 // this just pleases the compile so the above error is easier to spot
+
+#if defined(APA102_DRIVER_SPI)
+#    include "spi_master.h"
+#else
+#    include "quantum.h"
+
+#    ifndef APA102_NOPS
+#        if defined(__AVR__)
+#            define APA102_NOPS 0 // AVR at 16 MHz already spends 62.5 ns per clock, so no extra delay is needed
+#        elif defined(PROTOCOL_CHIBIOS)
+
+#            include "hal.h"
+#            if defined(STM32F0XX) || defined(STM32F1XX) || defined(STM32F3XX) || defined(STM32F4XX) || defined(STM32L0XX) || defined(GD32VF103)
+#                define APA102_NOPS (100 / (1000000000L / (CPU_CLOCK / 4))) // This calculates how many loops of 4 nops to run to delay 100 ns
+#            else
+#                error("APA102_NOPS configuration required")
+#                define APA102_NOPS 0 // this just pleases the compile so the above error is easier to spot
+#            endif
 #        endif
 #    endif
-#endif
 
-#define io_wait                                 \
-    do {                                        \
-        for (int i = 0; i < APA102_NOPS; i++) { \
-            __asm__ volatile("nop\n\t"          \
-                             "nop\n\t"          \
-                             "nop\n\t"          \
-                             "nop\n\t");        \
-        }                                       \
-    } while (0)
-
-#define APA102_SEND_BIT(byte, bit)               \
-    do {                                         \
-        writePin(RGB_DI_PIN, (byte >> bit) & 1); \
-        io_wait;                                 \
-        writePinHigh(RGB_CI_PIN);                \
-        io_wait;                                 \
-        writePinLow(RGB_CI_PIN);                 \
-        io_wait;                                 \
-    } while (0)
+#    define io_wait                                 \
+        do {                                        \
+            for (int i = 0; i < APA102_NOPS; i++) { \
+                __asm__ volatile("nop\n\t"          \
+                                 "nop\n\t"          \
+                                 "nop\n\t"          \
+                                 "nop\n\t");        \
+            }                                       \
+        } while (0)
+
+#    define APA102_SEND_BIT(byte, bit)               \
+        do {                                         \
+            writePin(RGB_DI_PIN, (byte >> bit) & 1); \
+            io_wait;                                 \
+            writePinHigh(RGB_CI_PIN);                \
+            io_wait;                                 \
+            writePinLow(RGB_CI_PIN);                 \
+            io_wait;                                 \
+        } while (0)
+#endif
 
 uint8_t apa102_led_brightness = APA102_DEFAULT_BRIGHTNESS;
 
-void static apa102_start_frame(void);
-void static apa102_end_frame(uint16_t num_leds);
-
-void static apa102_send_frame(uint8_t red, uint8_t green, uint8_t blue, uint8_t brightness);
-void static apa102_send_byte(uint8_t byte);
-
-void apa102_setleds(LED_TYPE *start_led, uint16_t num_leds) {
-    LED_TYPE *end = start_led + num_leds;
-
-    apa102_start_frame();
-    for (LED_TYPE *led = start_led; led < end; led++) {
-        apa102_send_frame(led->r, led->g, led->b, apa102_led_brightness);
-    }
-    apa102_end_frame(num_leds);
-}
-
-// Overwrite the default rgblight_call_driver to use apa102 driver
-void rgblight_call_driver(LED_TYPE *start_led, uint8_t num_leds) {
-    apa102_setleds(start_led, num_leds);
-}
-
-void static apa102_init(void) {
-    setPinOutput(RGB_DI_PIN);
-    setPinOutput(RGB_CI_PIN);
+#define APA102_START_FRAME_SIZE 4
+#define APA102_LED_FRAME_SIZE 4
 
-    writePinLow(RGB_DI_PIN);
-    writePinLow(RGB_CI_PIN);
-}
-
-void apa102_set_brightness(uint8_t brightness) {
-    if (brightness > APA102_MAX_BRIGHTNESS) {
-        apa102_led_brightness = APA102_MAX_BRIGHTNESS;
-    } else if (brightness < 0) {
-        apa102_led_brightness = 0;
-    } else {
-        apa102_led_brightness = brightness;
-    }
-}
-
-void static apa102_send_frame(uint8_t red, uint8_t green, uint8_t blue, uint8_t brightness) {
-    apa102_send_byte(0b11100000 | brightness);
-    apa102_send_byte(blue);
-    apa102_send_byte(green);
-    apa102_send_byte(red);
-}
-
-void static apa102_start_frame(void) {
-    apa102_init();
-    for (uint16_t i = 0; i < 4; i++) {
-        apa102_send_byte(0);
-    }
-}
-
-void static apa102_end_frame(uint16_t num_leds) {
+static uint16_t apa102_end_frame_size(uint16_t num_leds) {
     // This function has been taken from: https://github.com/pololu/apa102-arduino/blob/master/APA102.h
     // and adapted. The code is MIT licensed. I think thats compatible?
     //
@@ -133,12 +90,76 @@ void static apa102_end_frame(uint16_t num_leds) {
     // datasheet, which says to send 0xFF four times, because it does not work
     // when you have 66 LEDs or more, and also it results in unwanted white
     // pixels if you try to update fewer LEDs than are on your LED strip.
-    uint16_t iterations = (num_leds + 14) / 16;
-    for (uint16_t i = 0; i < iterations; i++) {
-        apa102_send_byte(0);
+    return (num_leds + 14) / 16;
+}
+
+static uint8_t apa102_led_header(const uint8_t *brightness, uint16_t led) {
+    return 0b11100000 | ((brightness ? brightness[led] : apa102_led_brightness) & APA102_MAX_BRIGHTNESS);
+}
+
+#if defined(APA102_DRIVER_SPI)
+
+#    ifndef APA102_SPI_CS_PIN
+#        error "APA102_SPI_CS_PIN must be set: the LEDs have no chip select, but spi_master needs an otherwise unused pin for one"
+#    endif
+
+#    if defined(APA102_SPI_ASYNC) && !defined(PROTOCOL_CHIBIOS)
+#        error "APA102_SPI_ASYNC is only supported on ChibiOS"
+#    endif
+
+#    ifdef RGBLED_NUM
+#        define APA102_LED_COUNT RGBLED_NUM
+#    else
+#        define APA102_LED_COUNT DRIVER_LED_TOTAL
+#    endif
+
+static uint8_t apa102_frame[APA102_START_FRAME_SIZE + APA102_LED_FRAME_SIZE * APA102_LED_COUNT + (APA102_LED_COUNT + 14) / 16];
+
+void apa102_setleds_brightness(LED_TYPE *start_led, const uint8_t *brightness, uint16_t num_leds) {
+    static bool s_init = false;
+    if (!s_init) {
+        spi_init();
+        s_init = true;
     }
 
-    apa102_init();
+    if (num_leds > APA102_LED_COUNT) {
+        num_leds = APA102_LED_COUNT;
+    }
+
+    // Also waits for an asynchronous previous frame, which is still read from the buffer until then
+    if (!spi_start(APA102_SPI_CS_PIN, false, 0, APA102_SPI_DIVISOR)) {
+        return;
+    }
+
+    uint8_t *frame = apa102_frame;
+    memset(frame, 0, APA102_START_FRAME_SIZE);
+    frame += APA102_START_FRAME_SIZE;
+    for (uint16_t i = 0; i < num_leds; i++) {
+        *frame++ = apa102_led_header(brightness, i);
+        *frame++ = start_led[i].b;
+        *frame++ = start_led[i].g;
+        *frame++ = start_led[i].r;
+    }
+    memset(frame, 0, apa102_end_frame_size(num_leds));
+    frame += apa102_end_frame_size(num_leds);
+
+#    ifdef APA102_SPI_ASYNC
+    // sent by DMA, the bus is released once it is done
+    spi_transmit_async(apa102_frame, frame - apa102_frame);
+#    else
+    spi_transmit(apa102_frame, frame - apa102_frame);
+    spi_stop();
+#    endif
+}
+
+#else
+
+void static apa102_init(void) {
+    setPinOutput(RGB_DI_PIN);
+    setPinOutput(RGB_CI_PIN);
+
+    writePinLow(RGB_DI_PIN);
+    writePinLow(RGB_CI_PIN);
 }
 
 void static apa102_send_byte(uint8_t byte) {
@@ -151,3 +172,44 @@ void static apa102_send_byte(uint8_t byte) {
     APA102_SEND_BIT(byte, 1);
     APA102_SEND_BIT(byte, 0);
 }
+
+void apa102_setleds_brightness(LED_TYPE *start_led, const uint8_t *brightness, uint16_t num_leds) {
+    apa102_init();
+    for (uint16_t i = 0; i < APA102_START_FRAME_SIZE; i++) {
+        apa102_send_byte(0);
+    }
+
+    for (uint16_t i = 0; i < num_leds; i++) {
+        apa102_send_byte(apa102_led_header(brightness, i));
+        apa102_send_byte(start_led[i].b);
+        apa102_send_byte(start_led[i].g);
+        apa102_send_byte(start_led[i].r);
+    }
+
+    uint16_t iterations = apa102_end_frame_size(num_leds);
+    for (uint16_t i = 0; i < iterations; i++) {
+        apa102_send_byte(0);
+    }
+    apa102_init();
+}
+
+#endif
+
+void apa102_setleds(LED_TYPE *start_led, uint16_t num_leds) {
+    apa102_setleds_brightness(start_led, NULL, num_leds);
+}
+
+// Overwrite the default rgblight_call_driver to use apa102 driver
+void rgblight_call_driver(LED_TYPE *start_led, uint8_t num_leds) {
+    apa102_setleds(start_led, num_leds);
+}
+
+void apa102_set_brightness(uint8_t brightness) {
+    if (brightness > APA102_MAX_BRIGHTNESS) {
+        apa102_led_brightness = APA102_MAX_BRIGHTNESS;
+    } else if (brightness < 0) {
+        apa102_led_brightness = 0;
+    } else {
+        apa102_led_brightness = brightness;
+    }
+}
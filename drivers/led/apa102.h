@@ -25,6 +25,11 @@
 
 #define APA102_MAX_BRIGHTNESS 31
 
+// Only used with APA102_DRIVER = spi, where the clock is the SPI peripheral clock divided by this
+#ifndef APA102_SPI_DIVISOR
+#    define APA102_SPI_DIVISOR 8
+#endif
+
 extern uint8_t apa102_led_brightness;
 
 /* User Interface
@@ -39,3 +44,8 @@ extern uint8_t apa102_led_brightness;
  */
 void apa102_setleds(LED_TYPE *start_led, uint16_t num_leds);
 void apa102_set_brightness(uint8_t brightness);
+
+/* Like apa102_setleds(), but with a 5 bit global brightness for every LED, which dims them more
+ * finely than their 8 bit colour alone. A NULL brightness uses apa102_led_brightness for all LEDs.
+ */
+void apa102_setleds_brightness(LED_TYPE *start_led, const uint8_t *brightness, uint16_t num_leds);
@@ -0,0 +1,182 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+extern "C" {
+#include "apa102.h"
+#include "spi_master.h"
+}
+
+// What the mock bus has seen: one entry per frame, completed when the LEDs are deselected
+static std::vector<std::vector<uint8_t>> frames;
+static const uint8_t *                   in_flight;
+static uint16_t                          in_flight_length;
+static bool                              started;
+
+extern "C" {
+void spi_init(void) {}
+
+// The end of an asynchronous transfer, which releases the bus
+static void complete_transfer(void) {
+    // it reads the buffer until now, so it must not have changed
+    frames.push_back(std::vector<uint8_t>(in_flight, in_flight + in_flight_length));
+    in_flight = NULL;
+    started   = false;
+}
+
+bool spi_start(pin_t slavePin, bool lsbFirst, uint8_t mode, uint16_t divisor) {
+    // like spi_master, waits for an asynchronous transfer to finish
+    if (in_flight) {
+        complete_transfer();
+    }
+    EXPECT_FALSE(started);
+    EXPECT_EQ(slavePin, APA102_SPI_CS_PIN);
+    EXPECT_FALSE(lsbFirst);
+    EXPECT_EQ(mode, 0);
+    EXPECT_EQ(divisor, APA102_SPI_DIVISOR);
+    started = true;
+    return true;
+}
+
+spi_status_t spi_transmit(const uint8_t *data, uint16_t length) {
+    EXPECT_TRUE(started);
+    frames.push_back(std::vector<uint8_t>(data, data + length));
+    return SPI_STATUS_SUCCESS;
+}
+
+spi_status_t spi_transmit_async(const uint8_t *data, uint16_t length) {
+    EXPECT_TRUE(started);
+    in_flight        = data;
+    in_flight_length = length;
+    return SPI_STATUS_SUCCESS;
+}
+
+void spi_stop(void) {
+    // an asynchronous transfer releases the bus itself
+    EXPECT_FALSE(in_flight);
+    started = false;
+}
+}
+
+class APA102 : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        frames.clear();
+        in_flight = NULL;
+        started   = false;
+        apa102_set_brightness(APA102_DEFAULT_BRIGHTNESS);
+    }
+
+    // Sends the frame, and completes it if it was sent asynchronously
+    void send(std::vector<LED_TYPE> leds, const uint8_t *brightness = NULL) {
+        apa102_setleds_brightness(leds.data(), brightness, leds.size());
+        if (in_flight) {
+            complete_transfer();
+        }
+    }
+};
+
+static LED_TYPE led(uint8_t r, uint8_t g, uint8_t b) {
+    LED_TYPE led = {};
+    led.r        = r;
+    led.g        = g;
+    led.b        = b;
+    return led;
+}
+
+TEST_F(APA102, FrameLengths) {
+    // the end frame needs a clock edge for each LED after the first, 16 to a byte
+    for (uint16_t count : {0, 1, 2, 16, 17, 18, 33, 64, 100}) {
+        frames.clear();
+        send(std::vector<LED_TYPE>(count, led(1, 2, 3)));
+        ASSERT_EQ(frames.size(), 1u);
+        EXPECT_EQ(frames[0].size(), 4 + 4 * count + (count + 14) / 16) << count << " LEDs";
+    }
+}
+
+TEST_F(APA102, FrameBytes) {
+    send({led(0x11, 0x22, 0x33), led(0x44, 0x55, 0x66)});
+
+    std::vector<uint8_t> expected = {
+        0x00, 0x00, 0x00, 0x00,                             // start frame
+        0xE0 | APA102_DEFAULT_BRIGHTNESS, 0x33, 0x22, 0x11, // blue, green, red
+        0xE0 | APA102_DEFAULT_BRIGHTNESS, 0x66, 0x55, 0x44,
+        0x00, // end frame
+    };
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0], expected);
+}
+
+TEST_F(APA102, GlobalBrightness) {
+    apa102_set_brightness(7);
+    send({led(1, 2, 3)});
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0][4], 0xE0 | 7);
+
+    apa102_set_brightness(200);
+    send({led(1, 2, 3)});
+    EXPECT_EQ(frames[1][4], 0xE0 | APA102_MAX_BRIGHTNESS);
+}
+
+TEST_F(APA102, PerLedBrightness) {
+    uint8_t brightness[] = {0, 1, 16, 31};
+    send({led(1, 2, 3), led(1, 2, 3), led(1, 2, 3), led(1, 2, 3)}, brightness);
+
+    ASSERT_EQ(frames.size(), 1u);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(frames[0][4 + 4 * i], 0xE0 | brightness[i]);
+    }
+}
+
+TEST_F(APA102, ExcessLedsAreDropped) {
+    send(std::vector<LED_TYPE>(RGBLED_NUM + 10, led(1, 2, 3)));
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].size(), 4 + 4 * RGBLED_NUM + (RGBLED_NUM + 14) / 16);
+}
+
+#ifdef APA102_SPI_ASYNC
+TEST_F(APA102, AsyncFrameIsKeptUntilNextOne) {
+    std::vector<LED_TYPE> first = {led(1, 2, 3)}, second = {led(4, 5, 6)};
+
+    apa102_setleds(first.data(), 1);
+    EXPECT_TRUE(started);
+    EXPECT_TRUE(frames.empty());
+
+    // waits for the first frame before encoding the second one
+    apa102_setleds(second.data(), 1);
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0][7], 1);
+
+    complete_transfer();
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[1][7], 4);
+}
+
+TEST_F(APA102, AsyncFrameReleasesTheBus) {
+    std::vector<LED_TYPE> leds = {led(1, 2, 3)};
+
+    apa102_setleds(leds.data(), 1);
+    complete_transfer();
+
+    // another device can use the bus without the LEDs sending again
+    EXPECT_TRUE(spi_start(APA102_SPI_CS_PIN, false, 0, APA102_SPI_DIVISOR));
+    spi_stop();
+    EXPECT_EQ(frames.size(), 1u);
+}
+#endif
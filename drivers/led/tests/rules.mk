@@ -0,0 +1,48 @@
+# Copyright 2022 QMK
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+WS2812_ENCODE_COMMON_INC := $(DRIVER_PATH)/led
+
+WS2812_ENCODE_COMMON_SRC := \
+	$(DRIVER_PATH)/led/tests/ws2812_encode_tests.cpp \
+	$(DRIVER_PATH)/led/ws2812_encode.c
+
+ws2812_encode_grb_DEFS := -DWS2812_BYTE_ORDER=WS2812_BYTE_ORDER_GRB
+ws2812_encode_grb_INC := $(WS2812_ENCODE_COMMON_INC)
+ws2812_encode_grb_SRC := $(WS2812_ENCODE_COMMON_SRC)
+
+ws2812_encode_rgb_DEFS := -DWS2812_BYTE_ORDER=WS2812_BYTE_ORDER_RGB
+ws2812_encode_rgb_INC := $(WS2812_ENCODE_COMMON_INC)
+ws2812_encode_rgb_SRC := $(WS2812_ENCODE_COMMON_SRC)
+
+ws2812_encode_bgr_DEFS := -DWS2812_BYTE_ORDER=WS2812_BYTE_ORDER_BGR
+ws2812_encode_bgr_INC := $(WS2812_ENCODE_COMMON_INC)
+ws2812_encode_bgr_SRC := $(WS2812_ENCODE_COMMON_SRC)
+
+ws2812_encode_rgbw_DEFS := -DRGBW
+ws2812_encode_rgbw_INC := $(WS2812_ENCODE_COMMON_INC)
+ws2812_encode_rgbw_SRC := $(WS2812_ENCODE_COMMON_SRC)
+
+apa102_spi_DEFS := -DAPA102_DRIVER_SPI -DAPA102_SPI_CS_PIN=5 -DRGBLED_NUM=100
+
+apa102_spi_INC := $(DRIVER_PATH)/led/tests $(DRIVER_PATH)/led
+
+apa102_spi_SRC := \
+	$(DRIVER_PATH)/led/tests/apa102_tests.cpp \
+	$(DRIVER_PATH)/led/apa102.c
+
+apa102_spi_async_DEFS := $(apa102_spi_DEFS) -DAPA102_SPI_ASYNC -DPROTOCOL_CHIBIOS
+apa102_spi_async_INC := $(apa102_spi_INC)
+apa102_spi_async_SRC := $(apa102_spi_SRC)
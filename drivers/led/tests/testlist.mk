@@ -0,0 +1 @@
+TEST_LIST += apa102_spi apa102_spi_async ws2812_encode_grb ws2812_encode_rgb ws2812_encode_bgr ws2812_encode_rgbw
@@ -0,0 +1,246 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "ws2812_encode.h"
+}
+
+// The channels in the order they are sent, as the WS2812 datasheets list them
+static uint32_t expected_word(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+#if WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_GRB
+    uint32_t word = (uint32_t)g << 24 | (uint32_t)r << 16 | (uint32_t)b << 8;
+#elif WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_RGB
+    uint32_t word = (uint32_t)r << 24 | (uint32_t)g << 16 | (uint32_t)b << 8;
+#elif WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_BGR
+    uint32_t word = (uint32_t)b << 24 | (uint32_t)g << 16 | (uint32_t)r << 8;
+#endif
+#ifdef RGBW
+    word |= w;
+#endif
+    return word;
+}
+
+static LED_TYPE led(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+    LED_TYPE led;
+    led.r = r;
+    led.g = g;
+    led.b = b;
+#ifdef RGBW
+    led.w = w;
+#endif
+    return led;
+}
+
+TEST(WS2812Encode, ChannelsInWireOrder) {
+    LED_TYPE leds[] = {led(0xFF, 0, 0, 0), led(0, 0xFF, 0, 0), led(0, 0, 0xFF, 0), led(0, 0, 0, 0xFF), led(0x12, 0x34, 0x56, 0x78)};
+    uint32_t words[5];
+
+    ws2812_encode_words(leds, 5, words);
+
+    EXPECT_EQ(words[0], expected_word(0xFF, 0, 0, 0));
+    EXPECT_EQ(words[1], expected_word(0, 0xFF, 0, 0));
+    EXPECT_EQ(words[2], expected_word(0, 0, 0xFF, 0));
+    EXPECT_EQ(words[3], expected_word(0, 0, 0, 0xFF));
+    EXPECT_EQ(words[4], expected_word(0x12, 0x34, 0x56, 0x78));
+}
+
+TEST(WS2812Encode, UnusedBitsAreClear) {
+    LED_TYPE leds[] = {led(0xFF, 0xFF, 0xFF, 0xFF)};
+    uint32_t words[1];
+
+    ws2812_encode_words(leds, 1, words);
+
+    // the state machine shifts out the top WS2812_BITS_PER_LED bits
+    EXPECT_EQ(words[0], 0xFFFFFFFFu << (32 - WS2812_BITS_PER_LED));
+}
+
+TEST(WS2812Encode, OnlyCountIsWritten) {
+    LED_TYPE leds[] = {led(1, 2, 3, 4), led(5, 6, 7, 8)};
+    uint32_t words[3] = {0xDEADBEEF, 0xDEADBEEF, 0xDEADBEEF};
+
+    ws2812_encode_words(leds, 2, words);
+
+    EXPECT_EQ(words[0], expected_word(1, 2, 3, 4));
+    EXPECT_EQ(words[1], expected_word(5, 6, 7, 8));
+    EXPECT_EQ(words[2], 0xDEADBEEF);
+}
+
+// Stands in for the bitbang driver: records the length of each masked window in ns, and holds the
+// line low for too long before the windows listed in late, counted from the start of the frame
+struct WindowModel {
+    uint16_t              bit_ns;
+    std::vector<uint32_t> late;
+    std::vector<uint32_t> windows;
+    uint32_t              calls = 0;
+    uint16_t              sent  = 0; // LEDs of the current attempt that reached the strip
+
+    WindowModel(uint16_t bit_ns, std::vector<uint32_t> late = {}) : bit_ns(bit_ns), late(late) {}
+
+    static bool send(uint16_t start, uint16_t end, void *context) {
+        WindowModel *model = (WindowModel *)context;
+        uint32_t     call  = model->calls++;
+        if (start > 0 && std::find(model->late.begin(), model->late.end(), call) != model->late.end()) {
+            return false;
+        }
+        EXPECT_EQ(start, start > 0 ? model->sent : 0);
+        model->windows.push_back((uint32_t)(end - start) * WS2812_BITS_PER_LED * model->bit_ns);
+        model->sent = end;
+        return true;
+    }
+};
+
+// Splits a frame the way the bitbang driver does, returning the length of each masked window in ns
+static std::vector<uint32_t> masked_windows(uint16_t leds, uint16_t bit_ns, uint16_t max_masked_us) {
+    WindowModel model(bit_ns);
+    EXPECT_TRUE(ws2812_send_windows(leds, ws2812_leds_per_window(bit_ns, max_masked_us), 0, WindowModel::send, &model));
+    return model.windows;
+}
+
+TEST(WS2812Encode, MaskedWindowsStayWithinBound) {
+    for (uint16_t bit_ns : {1000, 1200, 1250}) {
+        uint32_t led_ns = WS2812_BITS_PER_LED * bit_ns;
+        for (uint16_t max_masked_us : {40, 50, 100, 250, 1000}) {
+            if (max_masked_us * 1000 < led_ns) {
+                continue; // rejected at compile time by the driver
+            }
+            for (uint16_t leds : {1, 2, 3, 10, 64, 255, 256, 1000}) {
+                std::vector<uint32_t> windows = masked_windows(leds, bit_ns, max_masked_us);
+                uint32_t              total   = 0;
+                for (uint32_t window : windows) {
+                    EXPECT_LE(window, max_masked_us * 1000u) << bit_ns << "ns bits, " << leds << " LEDs";
+                    total += window;
+                }
+                EXPECT_EQ(total, leds * led_ns);
+                // as few windows as the bound allows
+                uint32_t fitting = max_masked_us * 1000 / led_ns;
+                EXPECT_EQ(windows.size(), (leds + fitting - 1) / fitting);
+            }
+        }
+    }
+}
+
+TEST(WS2812Encode, LedIsNeverSplit) {
+    EXPECT_EQ(ws2812_leds_per_window(1250, 1), 1);
+}
+
+TEST(WS2812Encode, ZeroBoundSendsWholeFrame) {
+    EXPECT_EQ(masked_windows(1000, 1250, 0).size(), 1u);
+}
+
+TEST(WS2812Encode, LateGapsRestartTheFrameWithinBound) {
+    const uint16_t bit_ns = 1250, max_masked_us = 100, leds = 64;
+    uint16_t       per_window = ws2812_leds_per_window(bit_ns, max_masked_us);
+    uint32_t       windows    = (leds + per_window - 1) / per_window;
+
+    // late before the third window, then before the second window of the first restart
+    WindowModel model(bit_ns, {2, 4});
+    EXPECT_TRUE(ws2812_send_windows(leds, per_window, 2, WindowModel::send, &model));
+    EXPECT_EQ(model.sent, leds);
+    // two windows and the late one, one window and the late one, then the whole frame
+    EXPECT_EQ(model.calls, 3 + 2 + windows);
+
+    uint32_t longest = *std::max_element(model.windows.begin(), model.windows.end());
+    EXPECT_LE(longest, max_masked_us * 1000u);
+}
+
+TEST(WS2812Encode, FrameIsDroppedAfterTheRetries) {
+    const uint16_t bit_ns = 1250, max_masked_us = 100, leds = 64;
+    uint16_t       per_window = ws2812_leds_per_window(bit_ns, max_masked_us);
+
+    // every attempt is cut short before its second window
+    WindowModel model(bit_ns, {1, 3, 5, 7});
+    EXPECT_FALSE(ws2812_send_windows(leds, per_window, 2, WindowModel::send, &model));
+    EXPECT_EQ(model.calls, 6u);
+    EXPECT_EQ(model.windows.size(), 3u);
+
+    uint32_t longest = *std::max_element(model.windows.begin(), model.windows.end());
+    EXPECT_LE(longest, max_masked_us * 1000u);
+}
+
+// The bit by bit encoding the SPI driver used before the lookup table
+static uint8_t get_protocol_eq(uint8_t data, int pos) {
+    uint8_t eq = 0;
+    if (data & (1 << (2 * (3 - pos))))
+        eq = 0b1110;
+    else
+        eq = 0b1000;
+    if (data & (2 << (2 * (3 - pos))))
+        eq += 0b11100000;
+    else
+        eq += 0b10000000;
+    return eq;
+}
+
+static std::vector<uint8_t> expected_spi(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+#if WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_GRB
+    std::vector<uint8_t> channels = {g, r, b};
+#elif WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_RGB
+    std::vector<uint8_t> channels = {r, g, b};
+#elif WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_BGR
+    std::vector<uint8_t> channels = {b, g, r};
+#endif
+#ifdef RGBW
+    channels.push_back(w);
+#endif
+    std::vector<uint8_t> bytes;
+    for (uint8_t channel : channels) {
+        for (int j = 0; j < 4; j++) {
+            bytes.push_back(get_protocol_eq(channel, j));
+        }
+    }
+    return bytes;
+}
+
+TEST(WS2812Encode, SpiMatchesBitByBitForAllValues) {
+    for (int value = 0; value < 256; value++) {
+        // each value in a different channel, including the last one of the LED
+        LED_TYPE leds[] = {led(value, 0, 0, 0), led(0, value, 0, 0), led(0, 0, value, 0), led(0, 0, 0, value), led(value, 255 - value, value ^ 0x5A, value)};
+        uint8_t  buffer[5 * WS2812_SPI_BYTES_PER_LED];
+
+        EXPECT_EQ(ws2812_encode_spi(leds, 5, buffer, NULL), 5);
+
+        std::vector<uint8_t> expected;
+        for (auto e : {expected_spi(value, 0, 0, 0), expected_spi(0, value, 0, 0), expected_spi(0, 0, value, 0), expected_spi(0, 0, 0, value), expected_spi(value, 255 - value, value ^ 0x5A, value)}) {
+            expected.insert(expected.end(), e.begin(), e.end());
+        }
+        EXPECT_EQ(std::vector<uint8_t>(buffer, buffer + sizeof(buffer)), expected) << "value " << value;
+    }
+}
+
+TEST(WS2812Encode, SpiSkipsUnchangedLeds) {
+    LED_TYPE leds[]  = {led(1, 2, 3, 4), led(5, 6, 7, 8), led(9, 10, 11, 12)};
+    LED_TYPE encoded[3];
+    uint8_t  buffer[3 * WS2812_SPI_BYTES_PER_LED];
+    uint8_t  reference[3 * WS2812_SPI_BYTES_PER_LED];
+
+    ws2812_encode_spi(leds, 3, buffer, NULL);
+    memcpy(encoded, leds, sizeof(leds));
+
+    leds[1] = led(50, 60, 70, 80);
+    EXPECT_EQ(ws2812_encode_spi(leds, 3, buffer, encoded), 1);
+    EXPECT_EQ(memcmp(encoded, leds, sizeof(leds)), 0);
+
+    ws2812_encode_spi(leds, 3, reference, NULL);
+    EXPECT_EQ(memcmp(buffer, reference, sizeof(buffer)), 0);
+
+    EXPECT_EQ(ws2812_encode_spi(leds, 3, buffer, encoded), 0);
+}
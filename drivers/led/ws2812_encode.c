@@ -0,0 +1,88 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "ws2812_encode.h"
+
+// Two bits of data as one SPI byte: 1000 for a 0, 1110 for a 1, most significant bit first
+#define WS2812_SPI_PAIR(bits) ((((bits)&2) ? 0xE0 : 0x80) | (((bits)&1) ? 0x0E : 0x08))
+#define WS2812_SPI_BYTE(b) \
+    { WS2812_SPI_PAIR((b) >> 6), WS2812_SPI_PAIR((b) >> 4), WS2812_SPI_PAIR((b) >> 2), WS2812_SPI_PAIR(b) }
+#define WS2812_SPI_BYTES_4(b) WS2812_SPI_BYTE(b), WS2812_SPI_BYTE((b) + 1), WS2812_SPI_BYTE((b) + 2), WS2812_SPI_BYTE((b) + 3)
+#define WS2812_SPI_BYTES_16(b) WS2812_SPI_BYTES_4(b), WS2812_SPI_BYTES_4((b) + 4), WS2812_SPI_BYTES_4((b) + 8), WS2812_SPI_BYTES_4((b) + 12)
+#define WS2812_SPI_BYTES_64(b) WS2812_SPI_BYTES_16(b), WS2812_SPI_BYTES_16((b) + 16), WS2812_SPI_BYTES_16((b) + 32), WS2812_SPI_BYTES_16((b) + 48)
+
+static const uint8_t ws2812_spi_table[256][WS2812_SPI_BYTES_PER_BYTE] = {WS2812_SPI_BYTES_64(0), WS2812_SPI_BYTES_64(64), WS2812_SPI_BYTES_64(128), WS2812_SPI_BYTES_64(192)};
+
+void ws2812_encode_words(const LED_TYPE *leds, uint16_t count, uint32_t *words) {
+    for (uint16_t i = 0; i < count; i++) {
+        // LED_TYPE is a packed struct laid out in wire order
+        const uint8_t *channels = (const uint8_t *)&leds[i];
+        uint32_t       word     = 0;
+        for (uint8_t c = 0; c < WS2812_CHANNELS; c++) {
+            word |= (uint32_t)channels[c] << (24 - 8 * c);
+        }
+        words[i] = word;
+    }
+}
+
+uint16_t ws2812_leds_per_window(uint16_t bit_ns, uint16_t max_masked_us) {
+    if (max_masked_us == 0) {
+        return UINT16_MAX;
+    }
+
+    uint32_t leds = (uint32_t)max_masked_us * 1000 / ((uint32_t)bit_ns * WS2812_BITS_PER_LED);
+    if (leds == 0) {
+        return 1;
+    }
+    return leds > UINT16_MAX ? UINT16_MAX : leds;
+}
+
+bool ws2812_send_windows(uint16_t leds, uint16_t leds_per_window, uint8_t retries, ws2812_window_sender_t send_window, void *context) {
+    for (uint16_t start = 0; start < leds;) {
+        uint16_t count = leds - start < leds_per_window ? leds - start : leds_per_window;
+        if (!send_window(start, start + count, context)) {
+            if (retries-- == 0) {
+                return false;
+            }
+            start = 0;
+            continue;
+        }
+        start += count;
+    }
+    return true;
+}
+
+uint16_t ws2812_encode_spi(const LED_TYPE *leds, uint16_t count, uint8_t *buffer, LED_TYPE *encoded) {
+    uint16_t changed = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if (encoded) {
+            if (memcmp(&encoded[i], &leds[i], sizeof(LED_TYPE)) == 0) {
+                continue;
+            }
+            encoded[i] = leds[i];
+        }
+
+        const uint8_t *channels = (const uint8_t *)&leds[i];
+        uint8_t *      out      = &buffer[i * WS2812_SPI_BYTES_PER_LED];
+        for (uint8_t c = 0; c < WS2812_CHANNELS; c++) {
+            memcpy(&out[c * WS2812_SPI_BYTES_PER_BYTE], ws2812_spi_table[channels[c]], WS2812_SPI_BYTES_PER_BYTE);
+        }
+        changed++;
+    }
+    return changed;
+}
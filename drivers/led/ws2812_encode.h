@@ -0,0 +1,76 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "color.h"
+
+#ifdef RGBW
+#    define WS2812_CHANNELS 4
+#else
+#    define WS2812_CHANNELS 3
+#endif
+
+#define WS2812_BITS_PER_LED (8 * WS2812_CHANNELS)
+
+// The SPI driver sends each bit as a nibble
+#define WS2812_SPI_BYTES_PER_BYTE 4
+#define WS2812_SPI_BYTES_PER_LED (WS2812_SPI_BYTES_PER_BYTE * WS2812_CHANNELS)
+
+/* Encoders turning LEDs into the bit stream of the various WS2812 drivers, and the timing model
+ * used to send it in pieces. They are kept apart from the hardware so that the output can be
+ * checked on the host for every WS2812_BYTE_ORDER.
+ */
+
+/** \brief Packs LEDs into one word each, for a shift register clocking out MSB first
+ *
+ * The channels are placed in the upper bytes in wire order (the order of the fields of LED_TYPE,
+ * so WS2812_BYTE_ORDER, followed by white for RGBW); the low byte is 0 unless RGBW is defined.
+ */
+void ws2812_encode_words(const LED_TYPE *leds, uint16_t count, uint32_t *words);
+
+/** \brief Encodes LEDs for an SPI bus clocked at four times the WS2812 bit rate
+ *
+ * Each channel becomes WS2812_SPI_BYTES_PER_BYTE bytes in wire order, looked up a whole byte at
+ * a time. If encoded is not NULL, it holds the LEDs currently encoded in buffer: LEDs equal to
+ * theirs are left alone, and the others are encoded and copied there. Returns the number of LEDs
+ * encoded.
+ */
+uint16_t ws2812_encode_spi(const LED_TYPE *leds, uint16_t count, uint8_t *buffer, LED_TYPE *encoded);
+
+/** \brief Number of LEDs that can be sent within one interrupt masked window
+ *
+ * Bit-banged drivers mask interrupts while clocking out an LED, but may let them run between
+ * LEDs, where the line is held low. Returns the most LEDs whose bits, of bit_ns each, take no
+ * longer than max_masked_us; at least 1, as an LED cannot be split. A max_masked_us of 0 puts the
+ * whole frame in one window.
+ */
+uint16_t ws2812_leds_per_window(uint16_t bit_ns, uint16_t max_masked_us);
+
+/** \brief Sends LEDs start to end in one interrupt masked window
+ *
+ * Returns false, having sent nothing, if the line was held low for too long since the previous
+ * window and the strip latched what was sent so far.
+ */
+typedef bool (*ws2812_window_sender_t)(uint16_t start, uint16_t end, void *context);
+
+/** \brief Sends a frame of LEDs in windows of at most leds_per_window
+ *
+ * When a window cannot carry on the frame, the frame is started over in windows of the same
+ * size, at most retries times. Returns false if the frame was dropped: the LEDs past the last
+ * window sent then keep showing the previous frame until the next one.
+ */
+bool ws2812_send_windows(uint16_t leds, uint16_t leds_per_window, uint8_t retries, ws2812_window_sender_t send_window, void *context);
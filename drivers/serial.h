@@ -25,5 +25,7 @@
 void soft_serial_initiator_init(void);
 // target is interrupt accept side
 void soft_serial_target_init(void);
+// stops accepting transactions, before turning into the initiator
+void soft_serial_target_stop(void);
 
 bool soft_serial_transaction(int sstd_index);
@@ -68,3 +68,9 @@
  *         - Wait 50us to reset the LEDs
  */
 void ws2812_setleds(LED_TYPE *ledarray, uint16_t number_of_leds);
+
+/* Longest time, in microseconds, that interrupts were masked for while sending since the last reset.
+ * Only provided by the ChibiOS bitbang driver, see WS2812_MASKED_US_MAX.
+ */
+uint16_t ws2812_get_max_masked_us(void);
+void     ws2812_reset_max_masked_us(void);
@@ -276,6 +276,11 @@ void soft_serial_target_init(void) {
     EICRx &= EICRx_BIT;
 }
 
+void soft_serial_target_stop(void) {
+    // Disable INT0-INT7
+    EIMSK &= ~EIMSK_BIT;
+}
+
 // Used by the sender to synchronize timing with the reciver.
 static void sync_recv(void) NO_INLINE;
 static void sync_recv(void) {
@@ -77,6 +77,8 @@ inline static void serial_high(void) {
 
 void interrupt_handler(void *arg);
 
+static volatile bool target_stopped = false;
+
 // Use thread + palWaitLineTimeout instead of palSetLineCallback
 //  - Methods like setPinOutput and palEnableLineEvent/palDisableLineEvent
 //    cause the interrupt to lock up, which would limit to only receiving data...
@@ -86,6 +88,7 @@ static THD_FUNCTION(Thread1, arg) {
     chRegSetThreadName("blinker");
     while (true) {
         palWaitLineTimeout(SOFT_SERIAL_PIN, TIME_INFINITE);
+        if (target_stopped) break;
         interrupt_handler(NULL);
     }
 }
@@ -102,6 +105,10 @@ void soft_serial_target_init(void) {
     chThdCreateStatic(waThread1, sizeof(waThread1), HIGHPRIO, Thread1, NULL);
 }
 
+void soft_serial_target_stop(void) {
+    target_stopped = true;
+}
+
 // Used by the master to synchronize timing with the slave.
 static void __attribute__((noinline)) sync_recv(void) {
     serial_input();
@@ -163,11 +163,12 @@ __attribute__((weak, nonnull)) void usart_slave_init(SerialDriver** driver) {
  * by the master.
  */
 static THD_WORKING_AREA(waSlaveThread, 1024);
+static thread_t* slave_thread;
 static THD_FUNCTION(SlaveThread, arg) {
     (void)arg;
     chRegSetThreadName("usart_tx_rx");
 
-    while (true) {
+    while (!chThdShouldTerminateX()) {
         if (!react_to_transactions()) {
             /* Clear the receive queue, to start with a clean slate.
              * Parts of failed transactions or spurious bytes could still be in it. */
@@ -185,7 +186,16 @@ void soft_serial_target_init(void) {
     sdStart(serial_driver, &serial_config);
 
     /* Start transport thread. */
-    chThdCreateStatic(waSlaveThread, sizeof(waSlaveThread), HIGHPRIO, SlaveThread, NULL);
+    slave_thread = chThdCreateStatic(waSlaveThread, sizeof(waSlaveThread), HIGHPRIO, SlaveThread, NULL);
+}
+
+/**
+ * @brief Stops responding to transactions, before turning into the master.
+ */
+void soft_serial_target_stop(void) {
+    chThdTerminate(slave_thread);
+    /* Stopping the driver wakes the higher priority thread from sdGet(), so it exits before we return. */
+    sdStop(serial_driver);
 }
 
 /**
@@ -20,6 +20,9 @@
 
 static pin_t currentSlavePin = NO_PIN;
 
+// Set by spi_transmit_async() until the transfer is done and the bus released
+static volatile bool asyncTransfer = false;
+
 #if defined(K20x) || defined(KL2x)
 static SPIConfig spiConfig = {NULL, 0, 0, 0};
 #else
@@ -50,6 +53,10 @@ __attribute__((weak)) void spi_init(void) {
 }
 
 bool spi_start(pin_t slavePin, bool lsbFirst, uint8_t mode, uint16_t divisor) {
+    while (asyncTransfer) {
+        // the transfer complete callback releases the bus
+    }
+
     if (currentSlavePin != NO_PIN || slavePin == NO_PIN) {
         return false;
     }
@@ -246,12 +253,34 @@ spi_status_t spi_transmit(const uint8_t *data, uint16_t length) {
     return SPI_STATUS_SUCCESS;
 }
 
+// Transfer complete callback of spi_transmit_async(), runs in the SPI interrupt
+static void spi_transmit_async_complete(SPIDriver *spip) {
+    osalSysLockFromISR();
+    spiUnselectI(spip);
+    osalSysUnlockFromISR();
+
+    spiConfig.end_cb = NULL;
+    currentSlavePin  = NO_PIN;
+    asyncTransfer    = false;
+}
+
+spi_status_t spi_transmit_async(const uint8_t *data, uint16_t length) {
+    asyncTransfer    = true;
+    spiConfig.end_cb = spi_transmit_async_complete;
+    spiStartSend(&SPI_DRIVER, length, data);
+    return SPI_STATUS_SUCCESS;
+}
+
 spi_status_t spi_receive(uint8_t *data, uint16_t length) {
     spiReceive(&SPI_DRIVER, length, data);
     return SPI_STATUS_SUCCESS;
 }
 
 void spi_stop(void) {
+    while (asyncTransfer) {
+        // the transfer complete callback releases the bus
+    }
+
     if (currentSlavePin != NO_PIN) {
         spiUnselect(&SPI_DRIVER);
         spiStop(&SPI_DRIVER);
@@ -85,6 +85,9 @@ spi_status_t spi_read(void);
 
 spi_status_t spi_transmit(const uint8_t *data, uint16_t length);
 
+// Starts sending by DMA and returns, releasing the bus when done; data must stay untouched until the next spi_start()
+spi_status_t spi_transmit_async(const uint8_t *data, uint16_t length);
+
 spi_status_t spi_receive(uint8_t *data, uint16_t length);
 
 void spi_stop(void);
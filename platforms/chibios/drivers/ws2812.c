@@ -1,5 +1,6 @@
 #include "quantum.h"
 #include "ws2812.h"
+#include "ws2812_encode.h"
 #include <ch.h>
 #include <hal.h>
 
@@ -28,6 +29,32 @@
 #    define WS2812_RES (1000 * WS2812_TRST_US) // Width of the low gap between bits to cause a frame to latch
 #endif
 
+// Longest time interrupts are masked for while sending. 0, the default, sends the whole frame in
+// one window. Otherwise the frame is split between LEDs into windows no longer than this, letting
+// pending interrupts run in between with the line held low.
+#ifndef WS2812_MASKED_US_MAX
+#    define WS2812_MASKED_US_MAX 0
+#endif
+
+// Longest the line may be held low between two windows. The strip latches, and shows part of the
+// frame, once the gap is longer than its reset time, so it has to stay below that.
+#ifndef WS2812_GAP_US_MAX
+#    define WS2812_GAP_US_MAX 5
+#endif
+
+// How many times a frame is started over after a gap that was too long, before it is dropped
+#ifndef WS2812_SPLIT_RETRIES
+#    define WS2812_SPLIT_RETRIES 2
+#endif
+
+#if WS2812_MASKED_US_MAX > 0 && WS2812_MASKED_US_MAX * 1000L < WS2812_BITS_PER_LED * WS2812_TIMING
+#    error "WS2812_MASKED_US_MAX is shorter than the time it takes to send a single LED"
+#endif
+
+#if WS2812_MASKED_US_MAX > 0 && PORT_SUPPORTS_RT != TRUE
+#    error "WS2812_MASKED_US_MAX needs the realtime counter to time the gaps between windows"
+#endif
+
 #define NUMBER_NOPS 6
 #define CYCLES_PER_SEC (CPU_CLOCK / NUMBER_NOPS * NOP_FUDGE)
 #define NS_PER_SEC (1000000000L) // Note that this has to be SIGNED since we want to be able to check for negative values of derivatives
@@ -71,18 +98,38 @@ void ws2812_init(void) {
     palSetLineMode(RGB_DI_PIN, WS2812_OUTPUT_MODE);
 }
 
-// Setleds for standard RGB
-void ws2812_setleds(LED_TYPE *ledarray, uint16_t leds) {
-    static bool s_init = false;
-    if (!s_init) {
-        ws2812_init();
-        s_init = true;
-    }
+static uint16_t max_masked_us = 0;
 
+uint16_t ws2812_get_max_masked_us(void) {
+    return max_masked_us;
+}
+
+void ws2812_reset_max_masked_us(void) {
+    max_masked_us = 0;
+}
+
+#if WS2812_MASKED_US_MAX > 0
+static rtcnt_t window_end;
+#endif
+
+// Sends LEDs start to end with interrupts masked. Returns false, without sending anything, when
+// the gap since the previous window was too long for the frame to be carried on; what was sent
+// so far has latched by the time it returns.
+static bool ws2812_send_leds(LED_TYPE *ledarray, uint16_t start, uint16_t end) {
     // this code is very time dependent, so we need to disable interrupts
     chSysLock();
+#if PORT_SUPPORTS_RT == TRUE
+    rtcnt_t masked_start = chSysGetRealtimeCounterX();
+#endif
+#if WS2812_MASKED_US_MAX > 0
+    if (start > 0 && masked_start - window_end > US2RTC(CPU_CLOCK, WS2812_GAP_US_MAX)) {
+        chSysUnlock();
+        wait_ns(WS2812_RES);
+        return false;
+    }
+#endif
 
-    for (uint8_t i = 0; i < leds; i++) {
+    for (uint16_t i = start; i < end; i++) {
         // WS2812 protocol dictates grb order
 #if (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_GRB)
         sendByte(ledarray[i].g);
@@ -103,7 +150,49 @@ void ws2812_setleds(LED_TYPE *ledarray, uint16_t leds) {
 #endif
     }
 
-    wait_ns(WS2812_RES);
-
+#if PORT_SUPPORTS_RT == TRUE
+    rtcnt_t  masked_end = chSysGetRealtimeCounterX();
+    uint32_t masked_us  = RTC2US(CPU_CLOCK, masked_end - masked_start);
+#else
+    // no cycle counter, so report the time the window should have taken
+    uint32_t masked_us = (uint32_t)(end - start) * WS2812_BITS_PER_LED * WS2812_TIMING / 1000;
+#endif
+#if WS2812_MASKED_US_MAX > 0
+    window_end = masked_end;
+#endif
     chSysUnlock();
+
+    if (masked_us > max_masked_us) {
+        max_masked_us = MIN(masked_us, UINT16_MAX);
+    }
+    return true;
+}
+
+#if WS2812_MASKED_US_MAX > 0
+static bool ws2812_send_window(uint16_t start, uint16_t end, void *context) {
+    return ws2812_send_leds((LED_TYPE *)context, start, end);
+}
+#endif
+
+// Setleds for standard RGB
+void ws2812_setleds(LED_TYPE *ledarray, uint16_t leds) {
+    static bool s_init = false;
+    if (!s_init) {
+        ws2812_init();
+        s_init = true;
+    }
+
+#if WS2812_MASKED_US_MAX > 0
+    // keep other threads out of the gaps, so that only interrupts can make them longer
+    tprio_t prio = chThdSetPriority(HIGHPRIO);
+
+    ws2812_send_windows(leds, ws2812_leds_per_window(WS2812_TIMING, WS2812_MASKED_US_MAX), WS2812_SPLIT_RETRIES, ws2812_send_window, ledarray);
+
+    chThdSetPriority(prio);
+#else
+    ws2812_send_leds(ledarray, 0, leds);
+#endif
+
+    // the line is held low, so interrupts only make the reset time longer
+    wait_ns(WS2812_RES);
 }
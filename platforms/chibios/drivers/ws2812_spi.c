@@ -1,5 +1,6 @@
 #include "quantum.h"
 #include "ws2812.h"
+#include "ws2812_encode.h"
 
 /* Adapted from https://github.com/gamazeps/ws2812b-chibios-SPIDMA/ */
 
@@ -69,69 +70,57 @@
 #    define WS2812_SCK_OUTPUT_MODE PAL_MODE_ALTERNATE(WS2812_SPI_SCK_PAL_MODE) | PAL_OUTPUT_TYPE_PUSHPULL
 #endif
 
-#define BYTES_FOR_LED_BYTE 4
-#ifdef RGBW
-#    define WS2812_CHANNELS 4
-#else
-#    define WS2812_CHANNELS 3
-#endif
-#define BYTES_FOR_LED (BYTES_FOR_LED_BYTE * WS2812_CHANNELS)
-#define DATA_SIZE (BYTES_FOR_LED * RGBLED_NUM)
+#define DATA_SIZE (WS2812_SPI_BYTES_PER_LED * RGBLED_NUM)
 #define RESET_SIZE (1000 * WS2812_TRST_US / (2 * WS2812_TIMING))
 #define PREAMBLE_SIZE 4
 
-static uint8_t txbuf[PREAMBLE_SIZE + DATA_SIZE + RESET_SIZE] = {0};
+#if defined(WS2812_SPI_USE_CIRCULAR_BUFFER) || defined(WS2812_SPI_SYNC)
+// The DMA reads the buffer continuously, or is done with it on return, so there is only the one
+#    define WS2812_SPI_BUFFERS 1
+#else
+#    define WS2812_SPI_BUFFERS 2
+#endif
 
 /*
  * As the trick here is to use the SPI to send a huge pattern of 0 and 1 to
- * the ws2812b protocol, we use this helper function to translate bytes into
- * 0s and 1s for the LED (with the appropriate timing).
+ * the ws2812b protocol, every LED is encoded into 0s and 1s with the
+ * appropriate timing by ws2812_encode_spi(). Frames are encoded into
+ * whichever buffer is not being sent, and the LEDs each buffer holds are
+ * kept so that only the ones that changed since are encoded again.
  */
-static uint8_t get_protocol_eq(uint8_t data, int pos) {
-    uint8_t eq = 0;
-    if (data & (1 << (2 * (3 - pos))))
-        eq = 0b1110;
-    else
-        eq = 0b1000;
-    if (data & (2 << (2 * (3 - pos))))
-        eq += 0b11100000;
-    else
-        eq += 0b10000000;
-    return eq;
+static uint8_t  txbuf[WS2812_SPI_BUFFERS][PREAMBLE_SIZE + DATA_SIZE + RESET_SIZE] = {0};
+static LED_TYPE txbuf_leds[WS2812_SPI_BUFFERS][RGBLED_NUM] = {0};
+
+#if WS2812_SPI_BUFFERS > 1
+static uint8_t       sending = 0;
+static volatile bool busy    = false; // a buffer is being sent
+static volatile bool pending = false; // the other buffer waits for it
+
+static void ws2812_spi_end_cb(SPIDriver* spip) {
+    chSysLockFromISR();
+    if (pending) {
+        pending = false;
+        sending ^= 1;
+        spiStartSendI(spip, sizeof(txbuf[0]), txbuf[sending]);
+    } else {
+        busy = false;
+    }
+    chSysUnlockFromISR();
 }
-
-static void set_led_color_rgb(LED_TYPE color, int pos) {
-    uint8_t* tx_start = &txbuf[PREAMBLE_SIZE];
-
-#if (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_GRB)
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + j] = get_protocol_eq(color.g, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE + j] = get_protocol_eq(color.r, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 2 + j] = get_protocol_eq(color.b, j);
-#elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_RGB)
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + j] = get_protocol_eq(color.r, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE + j] = get_protocol_eq(color.g, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 2 + j] = get_protocol_eq(color.b, j);
-#elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_BGR)
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + j] = get_protocol_eq(color.b, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE + j] = get_protocol_eq(color.g, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 2 + j] = get_protocol_eq(color.r, j);
-#endif
-#ifdef RGBW
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 4 + j] = get_protocol_eq(color.w, j);
+#    define WS2812_SPI_END_CB ws2812_spi_end_cb
+#else
+#    define WS2812_SPI_END_CB NULL
 #endif
-}
 
 void ws2812_init(void) {
+    // start with every LED off, matching txbuf_leds
+    static const LED_TYPE off = {0};
+    for (uint8_t buffer = 0; buffer < WS2812_SPI_BUFFERS; buffer++) {
+        for (uint16_t i = 0; i < RGBLED_NUM; i++) {
+            ws2812_encode_spi(&off, 1, &txbuf[buffer][PREAMBLE_SIZE + i * WS2812_SPI_BYTES_PER_LED], NULL);
+        }
+    }
+
     palSetLineMode(RGB_DI_PIN, WS2812_MOSI_OUTPUT_MODE);
 
 #ifdef WS2812_SPI_SCK_PIN
@@ -139,16 +128,20 @@ void ws2812_init(void) {
 #endif // WS2812_SPI_SCK_PIN
 
     // TODO: more dynamic baudrate
-    static const SPIConfig spicfg = {WS2812_SPI_BUFFER_MODE, NULL, PAL_PORT(RGB_DI_PIN), PAL_PAD(RGB_DI_PIN), WS2812_SPI_DIVISOR_CR1_BR_X};
+    static const SPIConfig spicfg = {WS2812_SPI_BUFFER_MODE, WS2812_SPI_END_CB, PAL_PORT(RGB_DI_PIN), PAL_PAD(RGB_DI_PIN), WS2812_SPI_DIVISOR_CR1_BR_X};
 
     spiAcquireBus(&WS2812_SPI);     /* Acquire ownership of the bus.    */
     spiStart(&WS2812_SPI, &spicfg); /* Setup transfer parameters.       */
     spiSelect(&WS2812_SPI);         /* Slave Select assertion.          */
 #ifdef WS2812_SPI_USE_CIRCULAR_BUFFER
-    spiStartSend(&WS2812_SPI, sizeof(txbuf) / sizeof(txbuf[0]), txbuf);
+    spiStartSend(&WS2812_SPI, sizeof(txbuf[0]), txbuf[0]);
 #endif
 }
 
+static void ws2812_encode(uint8_t buffer, LED_TYPE* ledarray, uint16_t leds) {
+    ws2812_encode_spi(ledarray, leds, &txbuf[buffer][PREAMBLE_SIZE], txbuf_leds[buffer]);
+}
+
 void ws2812_setleds(LED_TYPE* ledarray, uint16_t leds) {
     static bool s_init = false;
     if (!s_init) {
@@ -156,17 +149,33 @@ void ws2812_setleds(LED_TYPE* ledarray, uint16_t leds) {
         s_init = true;
     }
 
-    for (uint8_t i = 0; i < leds; i++) {
-        set_led_color_rgb(ledarray[i], i);
+    if (leds > RGBLED_NUM) {
+        leds = RGBLED_NUM;
     }
 
-    // Send async - each led takes ~0.03ms, 50 leds ~1.5ms, animations flushing faster than send will cause issues.
-    // Instead spiSend can be used to send synchronously (or the thread logic can be added back).
-#ifndef WS2812_SPI_USE_CIRCULAR_BUFFER
-#    ifdef WS2812_SPI_SYNC
-    spiSend(&WS2812_SPI, sizeof(txbuf) / sizeof(txbuf[0]), txbuf);
-#    else
-    spiStartSend(&WS2812_SPI, sizeof(txbuf) / sizeof(txbuf[0]), txbuf);
-#    endif
+#if defined(WS2812_SPI_USE_CIRCULAR_BUFFER)
+    ws2812_encode(0, ledarray, leds);
+#elif defined(WS2812_SPI_SYNC)
+    ws2812_encode(0, ledarray, leds);
+    spiSend(&WS2812_SPI, sizeof(txbuf[0]), txbuf[0]);
+#else
+    // Send async - each led takes ~0.03ms, 50 leds ~1.5ms. A frame flushed while the previous one
+    // is still being sent replaces any frame already waiting, and is sent as soon as it is done.
+    chSysLock();
+    pending = false;
+    chSysUnlock();
+
+    uint8_t next = busy ? sending ^ 1 : sending;
+    ws2812_encode(next, ledarray, leds);
+
+    chSysLock();
+    if (busy) {
+        pending = true;
+    } else {
+        sending = next;
+        busy    = true;
+        spiStartSendI(&WS2812_SPI, sizeof(txbuf[0]), txbuf[next]);
+    }
+    chSysUnlock();
 #endif
 }
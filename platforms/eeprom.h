@@ -61,8 +61,10 @@ void     eeprom_update_block(const void *__src, void *__dst, size_t __n);
 #    define TOTAL_EEPROM_BYTE_COUNT 4096
 #elif defined(EEPROM_TEST_HARNESS)
 #    ifndef FLASH_STM32_MOCKED
-// Normal tests
-#        define TOTAL_EEPROM_BYTE_COUNT 32
+// Normal tests, a test that stores more can size it with -DTOTAL_EEPROM_BYTE_COUNT
+#        ifndef TOTAL_EEPROM_BYTE_COUNT
+#            define TOTAL_EEPROM_BYTE_COUNT 32
+#        endif
 #    else
 // Flash wear-leveling testing
 #        include "eeprom_stm32_tests.h"
@@ -143,6 +143,11 @@ void soft_serial_target_init(void) {
     irq_set_priority(IO_IRQ_BANK0, PICO_HIGHEST_IRQ_PRIORITY);
 }
 
+// Stop the slave
+void soft_serial_target_stop(void) {
+    gpio_set_irq_enabled(SOFT_SERIAL_PIN, GPIO_IRQ_EDGE_FALL, false);
+}
+
 // Used by the master to synchronize timing with the slave.
 static int __no_inline_not_in_flash_func(sync_recv)(void) {
     serial_input();
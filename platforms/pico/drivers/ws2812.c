@@ -5,15 +5,69 @@
 
 #include "ws2812.h"
 #include "ws2812.pio.h"
+#include "ws2812_encode.h"
 
 #include "atomic_util.h"
 #include "pio_manager.h"
 #include "boards/pico_boards.h"
 
 #include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#ifdef RGBLED_NUM
+#    define WS2812_LED_COUNT RGBLED_NUM
+#else
+#    define WS2812_LED_COUNT DRIVER_LED_TOTAL
+#endif
+
+#ifndef WS2812_DMA_IRQ
+#    define WS2812_DMA_IRQ DMA_IRQ_0
+#endif
+
+// Once the DMA is done, the joined 8 word TX FIFO and the output shift register still hold
+// data, which takes 1.25us per bit to leave the pin before the reset time can start
+#define WS2812_DRAIN_US ((8 + 1) * WS2812_BITS_PER_LED * 5 / 4)
 
 static PIO pio = pio0;
 static int sm  = 0;
+static int dma = -1;
+
+/* Frames are encoded into whichever buffer is not on the wire. If the previous frame is still
+ * being sent, the new one is queued and started from the alarm that ends its reset time, so
+ * the caller never waits for the strip.
+ */
+static uint32_t      ws2812_buffer[2][WS2812_LED_COUNT];
+static uint16_t      ws2812_count[2];
+static uint8_t       ws2812_active  = 0;
+static volatile bool ws2812_busy    = false; // sending, or within the reset time after it
+static volatile bool ws2812_pending = false; // the other buffer waits for the strip
+
+static void ws2812_start(uint8_t buffer) {
+    ws2812_active = buffer;
+    ws2812_busy   = true;
+    dma_channel_transfer_from_buffer_now(dma, ws2812_buffer[buffer], ws2812_count[buffer]);
+}
+
+static int64_t ws2812_reset_done(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+
+    if (ws2812_pending) {
+        ws2812_pending = false;
+        ws2812_start(ws2812_active ^ 1);
+    } else {
+        ws2812_busy = false;
+    }
+    return 0;
+}
+
+static void ws2812_dma_handler(void) {
+    if (dma_irqn_get_channel_status(WS2812_DMA_IRQ - DMA_IRQ_0, dma)) {
+        dma_irqn_acknowledge_channel(WS2812_DMA_IRQ - DMA_IRQ_0, dma);
+        add_alarm_in_us(WS2812_DRAIN_US + WS2812_TRST_US, ws2812_reset_done, NULL, true);
+    }
+}
 
 static int ws2812_init(void) {
     sm = pio_manager_get_empty_sm(pio);
@@ -28,7 +82,27 @@ static int ws2812_init(void) {
         return -1;
     }
 
+#ifdef RGBW
+    ws2812_program_init(pio, sm, offset, RGB_DI_PIN, 800000, true);
+#else
     ws2812_program_init(pio, sm, offset, RGB_DI_PIN, 800000, false);
+#endif
+
+    dma = dma_claim_unused_channel(false);
+    if (dma < 0) {
+        return -1;
+    }
+
+    dma_channel_config config = dma_channel_get_default_config(dma);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, pio_get_dreq(pio, sm, true));
+    dma_channel_configure(dma, &config, &pio->txf[sm], NULL, 0, false);
+
+    dma_irqn_set_channel_enabled(WS2812_DMA_IRQ - DMA_IRQ_0, dma, true);
+    irq_add_shared_handler(WS2812_DMA_IRQ, ws2812_dma_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(WS2812_DMA_IRQ, true);
 
     return 0;
 }
@@ -43,14 +117,24 @@ void ws2812_setleds(LED_TYPE *ledarray, uint16_t number_of_leds) {
         }
     }
 
+    if (number_of_leds > WS2812_LED_COUNT) {
+        number_of_leds = WS2812_LED_COUNT;
+    }
+
+    // A frame still waiting for the strip is replaced by this one
     __interrupt_disable__();
+    ws2812_pending = false;
+    __interrupt_enable__(NULL);
 
-    for (int i = 0; i < number_of_leds; i++) {
-        pio_sm_put_blocking(pio, sm,
-                            (((uint32_t)ledarray[i].r) << 16) |
-                                (((uint32_t)ledarray[i].g) << 24) |
-                                ((uint32_t)ledarray[i].b << 8));
-    }
+    uint8_t next = ws2812_busy ? ws2812_active ^ 1 : ws2812_active;
+    ws2812_encode_words(ledarray, number_of_leds, ws2812_buffer[next]);
+    ws2812_count[next] = number_of_leds;
 
+    __interrupt_disable__();
+    if (ws2812_busy) {
+        ws2812_pending = true;
+    } else {
+        ws2812_start(next);
+    }
     __interrupt_enable__(NULL);
 }
@@ -99,19 +99,17 @@ void action_exec(keyevent_t event) {
 
 #ifndef NO_ACTION_ONESHOT
     if (!keymap_config.oneshot_disable) {
-if (QS_oneshot_timeout > 0) {
         if (has_oneshot_layer_timed_out()) {
             clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
         }
         if (has_oneshot_mods_timed_out()) {
-            clear_oneshot_mods();
+            expire_oneshot_mods();
         }
 #        ifdef SWAP_HANDS_ENABLE
         if (has_oneshot_swaphands_timed_out()) {
             clear_oneshot_swaphands();
         }
 #        endif
-}
     }
 #endif
 
@@ -140,20 +138,46 @@ if (QS_oneshot_timeout > 0) {
 bool swap_hands = false;
 bool swap_held  = false;
 
+#    ifndef __AVR__
+/* RAM copy of hand_swap_config, filled on first use. AVR reads flash as fast
+ * as SRAM and has little of the latter to spare, so it keeps using PROGMEM. */
+static keypos_t hand_swap_map[MATRIX_ROWS][MATRIX_COLS];
+static bool     hand_swap_map_loaded = false;
+
+static void hand_swap_map_load(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            hand_swap_map[row][col].row = pgm_read_byte(&hand_swap_config[row][col].row);
+            hand_swap_map[row][col].col = pgm_read_byte(&hand_swap_config[row][col].col);
+        }
+    }
+    hand_swap_map_loaded = true;
+}
+#    endif
+
 /** \brief Process Hand Swap
  *
- * FIXME: Needs documentation.
+ * Remaps the event position to its mirror when swap hands is active. A key
+ * pressed while swapped stays swapped until released, even if swapping
+ * was turned off in the meantime.
  */
 void process_hand_swap(keyevent_t *event) {
     static swap_state_row_t swap_state[MATRIX_ROWS];
 
-    keypos_t         pos     = event->key;
+    keypos_t pos = event->key;
+    if (pos.row >= MATRIX_ROWS || pos.col >= MATRIX_COLS) return;
+
     swap_state_row_t col_bit = (swap_state_row_t)1 << pos.col;
     bool             do_swap = event->pressed ? swap_hands : swap_state[pos.row] & (col_bit);
 
     if (do_swap) {
+#    ifdef __AVR__
         event->key.row = pgm_read_byte(&hand_swap_config[pos.row][pos.col].row);
         event->key.col = pgm_read_byte(&hand_swap_config[pos.row][pos.col].col);
+#    else
+        if (!hand_swap_map_loaded) hand_swap_map_load();
+        event->key = hand_swap_map[pos.row][pos.col];
+#    endif
         swap_state[pos.row] |= col_bit;
     } else {
         swap_state[pos.row] &= ~(col_bit);
@@ -113,6 +113,16 @@ void action_tapping_process(keyrecord_t record) {
     }
 }
 
+/** \brief Whether no tap key is being resolved
+ *
+ * Events generated outside the matrix can bypass the tapping state machine
+ * when this is true, as there is nothing they could interrupt or be ordered
+ * after.
+ */
+bool action_tapping_is_idle(void) {
+    return IS_NOEVENT(tapping_key.event) && waiting_buffer_head == waiting_buffer_tail;
+}
+
 /** \brief Tapping
  *
  * Rule: Tap key is typed(pressed and released) within TAPPING_TERM.
@@ -59,9 +59,78 @@ void clear_oneshot_locked_mods(void) {
         oneshot_locked_mods_changed_kb(oneshot_locked_mods);
     }
 }
-static uint16_t oneshot_time = 0;
-bool            has_oneshot_mods_timed_out(void) {
-    return QS_oneshot_timeout > 0 && TIMER_DIFF_16(timer_read(), oneshot_time) >= QS_oneshot_timeout;
+
+__attribute__((weak)) uint16_t get_oneshot_mod_timeout(uint8_t mod) {
+    return QS_oneshot_timeout;
+}
+
+__attribute__((weak)) uint16_t get_oneshot_layer_timeout(uint8_t layer) {
+    return QS_oneshot_timeout;
+}
+
+/* Every one-shot mod expires on its own: each bit gets a start time and a timeout
+ * when it is added, and only the one closest to expiring is checked each scan.
+ * Elapsed times rather than absolute deadlines are compared, so that timeouts
+ * of 32768 ms and more do not wrap around.
+ */
+static uint16_t oneshot_mods_time[8];
+static uint16_t oneshot_mods_timeout[8];
+static uint8_t  oneshot_mods_timed = 0; // mods that have a timeout at all
+static uint8_t  oneshot_mods_next  = 0; // mod closest to expiring
+
+static bool oneshot_mod_expired(uint8_t i) {
+    return timer_elapsed(oneshot_mods_time[i]) >= oneshot_mods_timeout[i];
+}
+
+static void oneshot_mods_update_next(void) {
+    uint16_t nearest = UINT16_MAX;
+    for (uint8_t i = 0; i < 8; i++) {
+        if (oneshot_mods & oneshot_mods_timed & (1 << i)) {
+            uint16_t elapsed   = timer_elapsed(oneshot_mods_time[i]);
+            uint16_t remaining = elapsed >= oneshot_mods_timeout[i] ? 0 : oneshot_mods_timeout[i] - elapsed;
+            if (remaining <= nearest) {
+                nearest           = remaining;
+                oneshot_mods_next = i;
+            }
+        }
+    }
+}
+
+static void oneshot_mods_start(uint8_t mods) {
+    uint16_t now = timer_read();
+    for (uint8_t i = 0; i < 8; i++) {
+        if (mods & (1 << i)) {
+#    ifdef ONESHOT_TIMEOUT_PER_KEY
+            uint16_t timeout = get_oneshot_mod_timeout(1 << i);
+#    else
+            uint16_t timeout = QS_oneshot_timeout;
+#    endif
+            if (timeout > 0) {
+                oneshot_mods_time[i]    = now;
+                oneshot_mods_timeout[i] = timeout;
+                oneshot_mods_timed |= 1 << i;
+            } else {
+                oneshot_mods_timed &= ~(1 << i);
+            }
+        }
+    }
+    oneshot_mods_update_next();
+}
+
+bool has_oneshot_mods_timed_out(void) {
+    return (oneshot_mods & oneshot_mods_timed) && oneshot_mod_expired(oneshot_mods_next);
+}
+
+/** \brief Clears the one-shot mods whose timeout has passed, keeping the others
+ */
+void expire_oneshot_mods(void) {
+    uint8_t expired = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        if ((oneshot_mods & oneshot_mods_timed & (1 << i)) && oneshot_mod_expired(i)) {
+            expired |= 1 << i;
+        }
+    }
+    del_oneshot_mods(expired);
 }
 #endif
 
@@ -91,14 +160,15 @@ enum {
 } swap_hands_oneshot = SHO_OFF;
 #    endif
 
-static uint16_t oneshot_layer_time = 0;
+static uint16_t oneshot_layer_time    = 0;
+static uint16_t oneshot_layer_timeout = 0;
 inline bool     has_oneshot_layer_timed_out() {
-    return TIMER_DIFF_16(timer_read(), oneshot_layer_time) >= QS_oneshot_timeout && !(get_oneshot_layer_state() & ONESHOT_TOGGLED);
+    return oneshot_layer_timeout > 0 && get_oneshot_layer_state() && !(get_oneshot_layer_state() & ONESHOT_TOGGLED) && timer_elapsed(oneshot_layer_time) >= oneshot_layer_timeout;
 }
 #        ifdef SWAP_HANDS_ENABLE
 static uint16_t oneshot_swaphands_time = 0;
 inline bool     has_oneshot_swaphands_timed_out() {
-    return TIMER_DIFF_16(timer_read(), oneshot_swaphands_time) >= QS_oneshot_timeout && (swap_hands_oneshot == SHO_ACTIVE);
+    return QS_oneshot_timeout > 0 && (swap_hands_oneshot == SHO_ACTIVE) && timer_elapsed(oneshot_swaphands_time) >= QS_oneshot_timeout;
 }
 #        endif
 
@@ -108,8 +178,8 @@ void set_oneshot_swaphands(void) {
     swap_hands_oneshot = SHO_PRESSED;
     swap_hands         = true;
     oneshot_swaphands_time = timer_read();
-    if (oneshot_layer_time != 0) {
-        oneshot_layer_time = oneshot_swaphands_time;
+    if (get_oneshot_layer_state()) {
+        oneshot_layer_time = timer_read();
     }
 }
 
@@ -134,7 +204,6 @@ void use_oneshot_swaphands(void) {
 void clear_oneshot_swaphands(void) {
     swap_hands_oneshot = SHO_OFF;
     swap_hands         = false;
-    oneshot_swaphands_time = 0;
 }
 
 #    endif
@@ -147,6 +216,11 @@ void set_oneshot_layer(uint8_t layer, uint8_t state) {
     if (!keymap_config.oneshot_disable) {
         oneshot_layer_data = layer << 3 | state;
         layer_on(layer);
+#    ifdef ONESHOT_TIMEOUT_PER_KEY
+        oneshot_layer_timeout = get_oneshot_layer_timeout(layer);
+#    else
+        oneshot_layer_timeout = QS_oneshot_timeout;
+#    endif
         oneshot_layer_time = timer_read();
         oneshot_layer_changed_kb(get_oneshot_layer());
     } else {
@@ -159,7 +233,6 @@ void set_oneshot_layer(uint8_t layer, uint8_t state) {
  */
 void reset_oneshot_layer(void) {
     oneshot_layer_data = 0;
-    oneshot_layer_time = 0;
     oneshot_layer_changed_kb(get_oneshot_layer());
 }
 /** \brief Clear oneshot layer
@@ -235,9 +308,9 @@ void send_keyboard_report(void) {
 
 #ifndef NO_ACTION_ONESHOT
     if (oneshot_mods) {
-        if (QS_oneshot_timeout > 0 && has_oneshot_mods_timed_out()) {
+        if (has_oneshot_mods_timed_out()) {
             dprintf("Oneshot: timeout\n");
-            clear_oneshot_mods();
+            expire_oneshot_mods();
         }
         keyboard_report->mods |= oneshot_mods;
         if (has_anykey(keyboard_report)) {
@@ -373,8 +446,9 @@ uint8_t get_oneshot_mods(void) {
 
 void add_oneshot_mods(uint8_t mods) {
     if ((oneshot_mods & mods) != mods) {
-        oneshot_time = timer_read();
+        uint8_t added = mods & ~oneshot_mods;
         oneshot_mods |= mods;
+        oneshot_mods_start(added);
         oneshot_mods_changed_kb(mods);
     }
 }
@@ -382,7 +456,7 @@ void add_oneshot_mods(uint8_t mods) {
 void del_oneshot_mods(uint8_t mods) {
     if (oneshot_mods & mods) {
         oneshot_mods &= ~mods;
-        oneshot_time = oneshot_mods ? timer_read() : 0;
+        oneshot_mods_update_next();
         oneshot_mods_changed_kb(oneshot_mods);
     }
 }
@@ -394,8 +468,10 @@ void del_oneshot_mods(uint8_t mods) {
 void set_oneshot_mods(uint8_t mods) {
     if (!keymap_config.oneshot_disable) {
         if (oneshot_mods != mods) {
-            oneshot_time = timer_read();
-            oneshot_mods = mods;
+            // mods that were already active keep their start time
+            uint8_t added = mods & ~oneshot_mods;
+            oneshot_mods  = mods;
+            oneshot_mods_start(added);
             oneshot_mods_changed_kb(mods);
         }
     }
@@ -408,7 +484,6 @@ void set_oneshot_mods(uint8_t mods) {
 void clear_oneshot_mods(void) {
     if (oneshot_mods) {
         oneshot_mods = 0;
-        oneshot_time = 0;
         oneshot_mods_changed_kb(oneshot_mods);
     }
 }
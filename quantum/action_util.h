@@ -62,6 +62,7 @@ void    del_oneshot_mods(uint8_t mods);
 void    set_oneshot_mods(uint8_t mods);
 void    clear_oneshot_mods(void);
 bool    has_oneshot_mods_timed_out(void);
+void    expire_oneshot_mods(void);
 
 uint8_t get_oneshot_locked_mods(void);
 void    set_oneshot_locked_mods(uint8_t mods);
@@ -77,6 +78,10 @@ uint8_t get_oneshot_layer_state(void);
 bool    has_oneshot_layer_timed_out(void);
 bool    has_oneshot_swaphands_timed_out(void);
 
+// Timeouts of a single one-shot mod bit and of a one-shot layer, used with ONESHOT_TIMEOUT_PER_KEY. 0 never times out.
+uint16_t get_oneshot_mod_timeout(uint8_t mod);
+uint16_t get_oneshot_layer_timeout(uint8_t layer);
+
 void oneshot_locked_mods_changed_user(uint8_t mods);
 void oneshot_locked_mods_changed_kb(uint8_t mods);
 void oneshot_mods_changed_user(uint8_t mods);
@@ -5,3 +5,5 @@ void backlight_pins_on(void);
 void backlight_pins_off(void);
 
 void breathing_task(void);
+
+void backlight_timer_tick(void);
@@ -1,7 +1,10 @@
-#include "quantum.h"
 #include "backlight.h"
 #include "backlight_driver_common.h"
-#include "debug.h"
+#include "wait.h"
+
+#ifdef PROTOCOL_CHIBIOS
+#    include <hal.h>
+#endif
 
 #ifndef BACKLIGHT_GPT_DRIVER
 #    define BACKLIGHT_GPT_DRIVER GPTD15
@@ -43,12 +46,17 @@ void backlight_init_ports(void) {
 void backlight_set(uint8_t level) {
     if (level > BACKLIGHT_LEVELS) level = BACKLIGHT_LEVELS;
 
-    backlight_pins_off();
+    // Other levels take effect when the next PWM period starts
+    if (level == 0) {
+        backlight_pins_off();
+    }
 
     backlight_timer_set_duty(cie_lightness(0xFFFFU / BACKLIGHT_LEVELS * level));
     backlight_timer_configure(level != 0);
 }
 
+static uint8_t s_compare = 0;
+
 static void backlight_timer_top(void) {
 #ifdef BACKLIGHT_BREATHING
     if (is_breathing()) {
@@ -56,7 +64,9 @@ static void backlight_timer_top(void) {
     }
 #endif
 
-    if (backlight_timer_get_duty() > 256) {
+    // Latch the duty so that a change part way through a period can't cut it short or stretch it
+    s_compare = backlight_timer_get_duty() / 256;
+    if (s_compare) {
         backlight_pins_on();
     }
 }
@@ -65,6 +75,25 @@ static void backlight_timer_cmp(void) {
     backlight_pins_off();
 }
 
+/* Software PWM
+ *
+ * Called from a periodic timer interrupt. Every 256 ticks form one PWM period:
+ * the pins are switched on at the first tick and off after (duty / 256) ticks,
+ * so the duty cycle does not depend on how long the main loop takes.
+ */
+void backlight_timer_tick(void) {
+    static uint8_t count = 0;
+
+    if (count == 0) {
+        // LED on
+        backlight_timer_top();
+    } else if (count == s_compare) {
+        // LED off
+        backlight_timer_cmp();
+    }
+    count++;
+}
+
 void backlight_task(void) {}
 
 #ifdef BACKLIGHT_BREATHING
@@ -105,6 +134,8 @@ void breathing_enable(void) {
 }
 void breathing_disable(void) {
     breathing = false;
+    // Restore backlight level
+    backlight_set(get_backlight_level());
 }
 
 void breathing_pulse(void) {
@@ -114,39 +145,7 @@ void breathing_pulse(void) {
 }
 #endif
 
-#ifdef PROTOCOL_CHIBIOS
-// On Platforms where timers fire every tick and have no capture/top events
-//   - fake event in the normal timer callback
-uint16_t s_duty = 0;
-
-static void timerCallback(void) {
-    /* Software PWM
-     * timer:1111 1111 1111 1111
-     *       \______/| \_______/____  count(0-255)
-     *          \    \______________  unused(1)
-     *           \__________________  index of step table(0-127)
-     */
-
-    // this works for cca 65536 irqs/sec
-    static union {
-        uint16_t raw;
-        struct {
-            uint16_t count : 8;
-            uint8_t  dummy : 1;
-            uint8_t  index : 7;
-        } pwm;
-    } timer = {.raw = 0};
-
-    timer.raw++;
-
-    if (timer.pwm.count == 0) {
-        // LED on
-        backlight_timer_top();
-    } else if (timer.pwm.count == (s_duty / 256)) {
-        // LED off
-        backlight_timer_cmp();
-    }
-}
+static uint16_t s_duty = 0;
 
 static void backlight_timer_set_duty(uint16_t duty) {
     s_duty = duty;
@@ -155,10 +154,12 @@ static uint16_t backlight_timer_get_duty(void) {
     return s_duty;
 }
 
+#if defined(PROTOCOL_CHIBIOS)
 // ChibiOS - Map GPT timer onto Software PWM
 static void gptTimerCallback(GPTDriver *gptp) {
     (void)gptp;
-    timerCallback();
+    // this works for cca 65536 irqs/sec
+    backlight_timer_tick();
 }
 
 static void backlight_timer_configure(bool enable) {
@@ -176,4 +177,11 @@ static void backlight_timer_configure(bool enable) {
         gptStopTimer(&BACKLIGHT_GPT_DRIVER);
     }
 }
+#elif defined(BACKLIGHT_MOCKED)
+// Unit tests call backlight_timer_tick() themselves
+static void backlight_timer_configure(bool enable) {
+    (void)enable;
+}
+#else
+#    error "Timer backlight driver is only available on ChibiOS, AVR can use timer-assisted PWM in the pwm driver"
 #endif
@@ -0,0 +1,53 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "backlight_mock.h"
+#include "backlight.h"
+#include "backlight_driver_common.h"
+
+bool    mock_backlight_pins      = false;
+uint8_t mock_backlight_level     = 0;
+bool    mock_backlight_enabled   = true;
+bool    mock_backlight_breathing = false;
+uint8_t mock_breathing_period    = BREATHING_PERIOD;
+
+void backlight_pins_init(void) {
+    mock_backlight_pins = false;
+}
+
+void backlight_pins_on(void) {
+    mock_backlight_pins = true;
+}
+
+void backlight_pins_off(void) {
+    mock_backlight_pins = false;
+}
+
+uint8_t get_backlight_level(void) {
+    return mock_backlight_level;
+}
+
+bool is_backlight_enabled(void) {
+    return mock_backlight_enabled;
+}
+
+bool is_backlight_breathing(void) {
+    return mock_backlight_breathing;
+}
+
+uint8_t get_breathing_period(void) {
+    return mock_breathing_period;
+}
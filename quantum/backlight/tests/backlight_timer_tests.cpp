@@ -0,0 +1,187 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include "backlight.h"
+#include "backlight_driver_common.h"
+#include "backlight_mock.h"
+}
+
+// Ticks per PWM period
+#define PWM_TICKS 256
+
+// On ticks per period for each level, cie_lightness(0xFFFF / 3 * level) / 256
+static const uint16_t level_duty[BACKLIGHT_LEVELS + 1] = {0, 19, 91, 255};
+
+class BacklightTimerTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        mock_backlight_level     = BACKLIGHT_LEVELS;
+        mock_backlight_enabled   = true;
+        mock_backlight_breathing = false;
+        mock_breathing_period    = 1;
+        breathing_disable();
+        backlight_init_ports();
+    }
+
+    // Tick until the next tick starts a new PWM period. Needs a non zero duty.
+    void sync_to_period() {
+        bool was_on;
+        do {
+            was_on = mock_backlight_pins;
+            backlight_timer_tick();
+        } while (was_on || !mock_backlight_pins);
+        for (int i = 1; i < PWM_TICKS; i++) {
+            backlight_timer_tick();
+        }
+    }
+
+    // Count the ticks the pins spend on during one PWM period
+    uint16_t measure_period() {
+        uint16_t on = 0;
+        for (int i = 0; i < PWM_TICKS; i++) {
+            backlight_timer_tick();
+            on += mock_backlight_pins;
+        }
+        return on;
+    }
+};
+
+TEST_F(BacklightTimerTest, DutyFollowsGammaCurveForEveryLevel) {
+    for (uint8_t level = 1; level <= BACKLIGHT_LEVELS; level++) {
+        mock_backlight_level = level;
+        backlight_set(level);
+        sync_to_period();
+        for (int period = 0; period < 10; period++) {
+            EXPECT_EQ(measure_period(), level_duty[level]) << "level " << (int)level;
+        }
+    }
+}
+
+TEST_F(BacklightTimerTest, LevelZeroKeepsPinsOff) {
+    backlight_set(BACKLIGHT_LEVELS);
+    sync_to_period();
+    backlight_timer_tick();
+    ASSERT_TRUE(mock_backlight_pins);
+
+    backlight_set(0);
+    for (int i = 0; i < PWM_TICKS * 4; i++) {
+        EXPECT_FALSE(mock_backlight_pins);
+        backlight_timer_tick();
+    }
+}
+
+TEST_F(BacklightTimerTest, DutyIsIndependentOfMainLoopDuration) {
+    mock_backlight_level = 1;
+    backlight_set(1);
+    sync_to_period();
+
+    // Simulate main loop iterations of wildly varying length between timer interrupts
+    const uint16_t        loop_ticks[] = {1, 7, 300, 2, 1000, 13, 255, 256, 257, 3, 4000, 1};
+    uint32_t              tick         = 0;
+    uint16_t              on           = 0;
+    std::vector<uint16_t> periods;
+    for (int round = 0; round < 4; round++) {
+        for (uint16_t ticks : loop_ticks) {
+            backlight_task();
+            for (uint16_t i = 0; i < ticks; i++) {
+                backlight_timer_tick();
+                on += mock_backlight_pins;
+                if (++tick % PWM_TICKS == 0) {
+                    periods.push_back(on);
+                    on = 0;
+                }
+            }
+        }
+    }
+
+    ASSERT_GT(periods.size(), 90u);
+    for (uint16_t period : periods) {
+        EXPECT_EQ(period, level_duty[1]);
+    }
+}
+
+TEST_F(BacklightTimerTest, LevelChangeTakesEffectAtNextPeriod) {
+    backlight_set(BACKLIGHT_LEVELS);
+    sync_to_period();
+
+    // Lower the level while the pins are still on, part way into the period
+    uint16_t on = 0;
+    for (int i = 0; i < PWM_TICKS; i++) {
+        if (i == level_duty[1] + 1) {
+            backlight_set(1);
+        }
+        backlight_timer_tick();
+        on += mock_backlight_pins;
+    }
+    EXPECT_EQ(on, level_duty[BACKLIGHT_LEVELS]);
+    EXPECT_EQ(measure_period(), level_duty[1]);
+}
+
+TEST_F(BacklightTimerTest, BreathingCycleLastsBreathingPeriod) {
+    backlight_set(BACKLIGHT_LEVELS);
+    sync_to_period();
+    breathing_enable();
+
+    // Breathing advances once per PWM period, roughly 256 periods per second
+    const int             periods_per_cycle = mock_breathing_period * 256;
+    std::vector<uint16_t> cycle;
+    for (int period = 0; period < periods_per_cycle; period++) {
+        cycle.push_back(measure_period());
+    }
+
+    // Starts dark, peaks half way through
+    EXPECT_EQ(cycle.front(), 0);
+    EXPECT_EQ(*std::max_element(cycle.begin(), cycle.end()), cycle[periods_per_cycle / 2]);
+    EXPECT_GT(cycle[periods_per_cycle / 2], level_duty[BACKLIGHT_LEVELS - 1]);
+
+    // And repeats exactly
+    for (int period = 0; period < periods_per_cycle; period++) {
+        EXPECT_EQ(measure_period(), cycle[period]) << "period " << period;
+    }
+}
+
+TEST_F(BacklightTimerTest, BreathingScalesWithLevel) {
+    mock_backlight_level = 1;
+    backlight_set(1);
+    sync_to_period();
+    breathing_enable();
+
+    const int periods_per_cycle = mock_breathing_period * 256;
+    uint16_t  peak              = 0;
+    for (int period = 0; period < periods_per_cycle; period++) {
+        peak = std::max(peak, measure_period());
+    }
+    EXPECT_EQ(peak, level_duty[1]);
+}
+
+TEST_F(BacklightTimerTest, DisablingBreathingRestoresLevel) {
+    backlight_set(BACKLIGHT_LEVELS);
+    sync_to_period();
+    breathing_enable();
+    measure_period();
+    measure_period();
+
+    breathing_disable();
+    measure_period();
+    EXPECT_EQ(measure_period(), level_duty[BACKLIGHT_LEVELS]);
+}
@@ -0,0 +1,9 @@
+backlight_timer_DEFS := -DNO_DEBUG -DBACKLIGHT_MOCKED -DBACKLIGHT_BREATHING -DBACKLIGHT_LEVELS=3
+
+backlight_timer_INC := $(QUANTUM_PATH)/backlight
+
+backlight_timer_SRC := \
+	$(QUANTUM_PATH)/backlight/tests/backlight_mock.c \
+	$(QUANTUM_PATH)/backlight/tests/backlight_timer_tests.cpp \
+	$(QUANTUM_PATH)/backlight/backlight_timer.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/timer.c
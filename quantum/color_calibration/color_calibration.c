@@ -0,0 +1,170 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+
+#include "color_calibration.h"
+
+// clang-format off
+#define COLOR_CALIBRATION_DEFAULTS { \
+    [COLOR_CALIBRATION_RED]   = {COLOR_CALIBRATION_GAMMA_RED, COLOR_CALIBRATION_GAIN_RED}, \
+    [COLOR_CALIBRATION_GREEN] = {COLOR_CALIBRATION_GAMMA_GREEN, COLOR_CALIBRATION_GAIN_GREEN}, \
+    [COLOR_CALIBRATION_BLUE]  = {COLOR_CALIBRATION_GAMMA_BLUE, COLOR_CALIBRATION_GAIN_BLUE}, \
+}
+// clang-format on
+
+static const uint8_t defaults[COLOR_CALIBRATION_CHANNELS][2] = COLOR_CALIBRATION_DEFAULTS;
+static uint8_t       calibration[COLOR_CALIBRATION_CHANNELS][2] = COLOR_CALIBRATION_DEFAULTS; // gamma, gain
+
+static uint8_t lut[COLOR_CALIBRATION_CHANNELS][256];
+static bool    lut_valid = false;
+static bool    identity  = true;
+
+/* The gamma curves are computed in fixed point, as 2^(gamma * log2(value / 255)), so that AVR
+ * builds do not need floating point. Exponents have FRACTION_BITS fractional bits, which keeps
+ * every table entry within one of the exact curve.
+ */
+#define FRACTION_BITS 12
+
+// 2^(-1 / 2^(i + 1)) in 0.16 fixed point, one factor for each fractional bit of an exponent
+static const uint16_t exp2_bits[FRACTION_BITS] = {46341, 55109, 60097, 62757, 64132, 64830, 65182, 65359, 65447, 65492, 65514, 65525};
+
+// log2(value) of a non zero value, bit by bit from the squares of its mantissa
+static uint16_t log2_fixed(uint8_t value) {
+    uint16_t result = 7 << FRACTION_BITS;
+    while (!(value & 0x80)) {
+        value <<= 1;
+        result -= 1 << FRACTION_BITS;
+    }
+
+    uint32_t mantissa = (uint32_t)value << 8; // 1.15 fixed point, from 1 to 2
+    for (uint16_t bit = 1 << (FRACTION_BITS - 1); bit; bit >>= 1) {
+        mantissa = mantissa * mantissa >> 15;
+        if (mantissa >= 1UL << 16) {
+            mantissa >>= 1;
+            result |= bit;
+        }
+    }
+    return result;
+}
+
+// gain * 2^-exponent, rounded
+static uint8_t scale_exp2(uint8_t gain, uint32_t exponent) {
+    uint8_t integer = exponent >> FRACTION_BITS;
+    if (integer >= 16) return 0;
+
+    uint32_t fraction = 1UL << 16;
+    for (uint8_t bit = 0; bit < FRACTION_BITS; bit++) {
+        if (exponent & (1UL << (FRACTION_BITS - 1 - bit))) {
+            fraction = fraction * exp2_bits[bit] >> 16;
+        }
+    }
+    return (gain * fraction + (1UL << (15 + integer))) >> (16 + integer);
+}
+
+static void build_lut(uint8_t channel) {
+    uint8_t  gamma     = calibration[channel][0];
+    uint8_t  gain      = calibration[channel][1];
+    uint16_t log2_full = log2_fixed(255);
+
+    lut[channel][0] = 0;
+    for (uint16_t value = 1; value < 256; value++) {
+        if (gamma == COLOR_CALIBRATION_GAMMA_LINEAR || gamma == 0) {
+            lut[channel][value] = (value * gain + 127) / 255;
+        } else {
+            lut[channel][value] = scale_exp2(gain, (uint32_t)(log2_full - log2_fixed(value)) * gamma / 10);
+        }
+    }
+}
+
+/* Builds the tables after a change, and returns whether colours need calibrating at all */
+static bool color_calibration_prepare(void) {
+    if (!lut_valid) {
+        identity = true;
+        for (uint8_t channel = 0; channel < COLOR_CALIBRATION_CHANNELS; channel++) {
+            build_lut(channel);
+            identity &= calibration[channel][0] == COLOR_CALIBRATION_GAMMA_LINEAR && calibration[channel][1] == COLOR_CALIBRATION_GAIN_FULL;
+        }
+        lut_valid = true;
+    }
+    return !identity;
+}
+
+/** \brief Calibration a keyboard starts out with, from COLOR_CALIBRATION_GAMMA_* and COLOR_CALIBRATION_GAIN_*
+ */
+void color_calibration_default(uint8_t channel, uint8_t *gamma, uint8_t *gain) {
+    if (channel >= COLOR_CALIBRATION_CHANNELS) return;
+
+    *gamma = defaults[channel][0];
+    *gain  = defaults[channel][1];
+}
+
+void color_calibration_get(uint8_t channel, uint8_t *gamma, uint8_t *gain) {
+    if (channel >= COLOR_CALIBRATION_CHANNELS) return;
+
+    *gamma = calibration[channel][0];
+    *gain  = calibration[channel][1];
+}
+
+/** \brief Change the calibration of a channel
+ *
+ * The tables are built again the next time a colour is calibrated.
+ */
+void color_calibration_set(uint8_t channel, uint8_t gamma, uint8_t gain) {
+    if (channel >= COLOR_CALIBRATION_CHANNELS) return;
+    if (calibration[channel][0] == gamma && calibration[channel][1] == gain) return;
+
+    calibration[channel][0] = gamma;
+    calibration[channel][1] = gain;
+    lut_valid               = false;
+}
+
+uint8_t color_calibration_value(uint8_t channel, uint8_t value) {
+    if (channel >= COLOR_CALIBRATION_CHANNELS || !color_calibration_prepare()) return value;
+    return lut[channel][value];
+}
+
+void color_calibration_apply(uint8_t *red, uint8_t *green, uint8_t *blue) {
+    if (!color_calibration_prepare()) return;
+
+    *red   = lut[COLOR_CALIBRATION_RED][*red];
+    *green = lut[COLOR_CALIBRATION_GREEN][*green];
+    *blue  = lut[COLOR_CALIBRATION_BLUE][*blue];
+}
+
+/** \brief Calibrate an 8.8 fixed point intensity
+ *
+ * The fraction interpolates between the table entries on either side of it, so that dithered
+ * intensities keep their steps in between PWM values.
+ */
+uint16_t color_calibration_value16(uint8_t channel, uint16_t value) {
+    if (channel >= COLOR_CALIBRATION_CHANNELS || !color_calibration_prepare()) return value;
+
+    uint8_t  index    = value >> 8;
+    uint8_t  fraction = value & 0xFF;
+    uint16_t low      = (uint16_t)lut[channel][index] << 8;
+    if (fraction == 0 || index == 255) return low;
+
+    return low + ((int16_t)lut[channel][index + 1] - lut[channel][index]) * fraction;
+}
+
+void color_calibration_apply16(uint16_t *red, uint16_t *green, uint16_t *blue) {
+    if (!color_calibration_prepare()) return;
+
+    *red   = color_calibration_value16(COLOR_CALIBRATION_RED, *red);
+    *green = color_calibration_value16(COLOR_CALIBRATION_GREEN, *green);
+    *blue  = color_calibration_value16(COLOR_CALIBRATION_BLUE, *blue);
+}
@@ -0,0 +1,67 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Per channel calibration of the colours sent to the LED drivers. LEDs whose red, green and blue
+ * dies differ in efficiency show tinted whites, and their hue shifts as they dim. Each channel
+ * gets a gain, scaling full intensity down to match the weakest channel, and a gamma curve,
+ * both folded into one 256 entry lookup table.
+ *
+ * Gamma is in tenths: COLOR_CALIBRATION_GAMMA_LINEAR leaves intensities as they are. With a gain
+ * of COLOR_CALIBRATION_GAIN_FULL as well, the channel is passed through unchanged.
+ */
+#define COLOR_CALIBRATION_GAMMA_LINEAR 10
+#define COLOR_CALIBRATION_GAIN_FULL 255
+
+enum color_calibration_channel {
+    COLOR_CALIBRATION_RED,
+    COLOR_CALIBRATION_GREEN,
+    COLOR_CALIBRATION_BLUE,
+    COLOR_CALIBRATION_CHANNELS,
+};
+
+#ifndef COLOR_CALIBRATION_GAMMA_RED
+#    define COLOR_CALIBRATION_GAMMA_RED COLOR_CALIBRATION_GAMMA_LINEAR
+#endif
+#ifndef COLOR_CALIBRATION_GAMMA_GREEN
+#    define COLOR_CALIBRATION_GAMMA_GREEN COLOR_CALIBRATION_GAMMA_LINEAR
+#endif
+#ifndef COLOR_CALIBRATION_GAMMA_BLUE
+#    define COLOR_CALIBRATION_GAMMA_BLUE COLOR_CALIBRATION_GAMMA_LINEAR
+#endif
+#ifndef COLOR_CALIBRATION_GAIN_RED
+#    define COLOR_CALIBRATION_GAIN_RED COLOR_CALIBRATION_GAIN_FULL
+#endif
+#ifndef COLOR_CALIBRATION_GAIN_GREEN
+#    define COLOR_CALIBRATION_GAIN_GREEN COLOR_CALIBRATION_GAIN_FULL
+#endif
+#ifndef COLOR_CALIBRATION_GAIN_BLUE
+#    define COLOR_CALIBRATION_GAIN_BLUE COLOR_CALIBRATION_GAIN_FULL
+#endif
+
+void color_calibration_default(uint8_t channel, uint8_t *gamma, uint8_t *gain);
+void color_calibration_get(uint8_t channel, uint8_t *gamma, uint8_t *gain);
+void color_calibration_set(uint8_t channel, uint8_t gamma, uint8_t gain);
+
+uint8_t color_calibration_value(uint8_t channel, uint8_t value);
+void    color_calibration_apply(uint8_t *red, uint8_t *green, uint8_t *blue);
+
+uint16_t color_calibration_value16(uint8_t channel, uint16_t value);
+void     color_calibration_apply16(uint16_t *red, uint16_t *green, uint16_t *blue);
@@ -0,0 +1,144 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+extern "C" {
+#include "color_calibration.h"
+}
+
+class ColorCalibration : public ::testing::Test {
+   protected:
+    void TearDown() override {
+        for (uint8_t channel = 0; channel < COLOR_CALIBRATION_CHANNELS; channel++) {
+            color_calibration_set(channel, COLOR_CALIBRATION_GAMMA_LINEAR, COLOR_CALIBRATION_GAIN_FULL);
+        }
+    }
+};
+
+TEST_F(ColorCalibration, DefaultIsIdentity) {
+    for (uint8_t channel = 0; channel < COLOR_CALIBRATION_CHANNELS; channel++) {
+        uint8_t gamma, gain;
+        color_calibration_default(channel, &gamma, &gain);
+        EXPECT_EQ(gamma, COLOR_CALIBRATION_GAMMA_LINEAR);
+        EXPECT_EQ(gain, COLOR_CALIBRATION_GAIN_FULL);
+    }
+}
+
+TEST_F(ColorCalibration, IdentityIsBitExact) {
+    for (uint16_t value = 0; value < 256; value++) {
+        uint8_t red = value, green = 255 - value, blue = value ^ 0x5A;
+        color_calibration_apply(&red, &green, &blue);
+        EXPECT_EQ(red, value);
+        EXPECT_EQ(green, 255 - value);
+        EXPECT_EQ(blue, value ^ 0x5A);
+        for (uint8_t channel = 0; channel < COLOR_CALIBRATION_CHANNELS; channel++) {
+            EXPECT_EQ(color_calibration_value(channel, value), value);
+        }
+    }
+}
+
+TEST_F(ColorCalibration, IdentityTablesAreBitExact) {
+    // the tables are used as soon as one channel is not the identity
+    color_calibration_set(COLOR_CALIBRATION_RED, 22, COLOR_CALIBRATION_GAIN_FULL);
+    for (uint16_t value = 0; value < 256; value++) {
+        EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_GREEN, value), value);
+        EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_BLUE, value), value);
+    }
+}
+
+TEST_F(ColorCalibration, RestoringIdentityIsBitExact) {
+    color_calibration_set(COLOR_CALIBRATION_GREEN, 25, 200);
+    EXPECT_NE(color_calibration_value(COLOR_CALIBRATION_GREEN, 128), 128);
+
+    color_calibration_set(COLOR_CALIBRATION_GREEN, COLOR_CALIBRATION_GAMMA_LINEAR, COLOR_CALIBRATION_GAIN_FULL);
+    for (uint16_t value = 0; value < 256; value++) {
+        EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_GREEN, value), value);
+    }
+}
+
+TEST_F(ColorCalibration, GainScalesFullIntensity) {
+    color_calibration_set(COLOR_CALIBRATION_BLUE, COLOR_CALIBRATION_GAMMA_LINEAR, 200);
+    EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_BLUE, 0), 0);
+    EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_BLUE, 255), 200);
+    EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_BLUE, 128), 100);
+    // the other channels are left alone
+    EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_RED, 255), 255);
+
+    uint8_t gamma, gain;
+    color_calibration_get(COLOR_CALIBRATION_BLUE, &gamma, &gain);
+    EXPECT_EQ(gamma, COLOR_CALIBRATION_GAMMA_LINEAR);
+    EXPECT_EQ(gain, 200);
+}
+
+TEST_F(ColorCalibration, GammaKeepsEndpointsAndIsMonotonic) {
+    color_calibration_set(COLOR_CALIBRATION_RED, 22, COLOR_CALIBRATION_GAIN_FULL);
+    EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_RED, 0), 0);
+    EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_RED, 255), 255);
+    EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_RED, 128), 56);
+
+    for (uint16_t value = 1; value < 256; value++) {
+        EXPECT_GE(color_calibration_value(COLOR_CALIBRATION_RED, value), color_calibration_value(COLOR_CALIBRATION_RED, value - 1));
+    }
+}
+
+TEST_F(ColorCalibration, GammaFollowsTheCurve) {
+    // the fixed point tables stay within one of the exact curve
+    for (uint8_t gamma : {1, 5, 18, 22, 28, 100, 255}) {
+        for (uint8_t gain : {255, 200, 64}) {
+            color_calibration_set(COLOR_CALIBRATION_GREEN, gamma, gain);
+            for (uint16_t value = 0; value < 256; value++) {
+                double expected = std::pow(value / 255.0, gamma / 10.0) * gain;
+                EXPECT_NEAR(color_calibration_value(COLOR_CALIBRATION_GREEN, value), expected, 1.0) << "gamma " << +gamma << ", gain " << +gain << ", value " << value;
+            }
+        }
+    }
+}
+
+TEST_F(ColorCalibration, ApplyCalibratesEachChannel) {
+    color_calibration_set(COLOR_CALIBRATION_RED, COLOR_CALIBRATION_GAMMA_LINEAR, 128);
+    color_calibration_set(COLOR_CALIBRATION_BLUE, 22, COLOR_CALIBRATION_GAIN_FULL);
+
+    uint8_t red = 100, green = 200, blue = 128;
+    color_calibration_apply(&red, &green, &blue);
+    EXPECT_EQ(red, 50);
+    EXPECT_EQ(green, 200);
+    EXPECT_EQ(blue, 56);
+}
+
+TEST_F(ColorCalibration, FractionsInterpolateBetweenEntries) {
+    color_calibration_set(COLOR_CALIBRATION_RED, 22, COLOR_CALIBRATION_GAIN_FULL);
+    for (uint16_t value = 0; value < 256; value++) {
+        uint16_t low  = color_calibration_value(COLOR_CALIBRATION_RED, value) << 8;
+        uint16_t high = color_calibration_value(COLOR_CALIBRATION_RED, value < 255 ? value + 1 : 255) << 8;
+        EXPECT_EQ(color_calibration_value16(COLOR_CALIBRATION_RED, value << 8), low);
+        EXPECT_EQ(color_calibration_value16(COLOR_CALIBRATION_RED, value << 8 | 0x80), value < 255 ? (low + high) / 2 : low) << "value " << value;
+    }
+    // a step between two PWM values is not lost to the table
+    EXPECT_GT(color_calibration_value16(COLOR_CALIBRATION_RED, 0x8040), color_calibration_value16(COLOR_CALIBRATION_RED, 0x8000));
+}
+
+TEST_F(ColorCalibration, IdentityPassesFractionsThrough) {
+    for (uint16_t value : {0x0000, 0x0001, 0x7F80, 0xFF00, 0xFFFF}) {
+        uint16_t red = value, green = value, blue = value;
+        color_calibration_apply16(&red, &green, &blue);
+        EXPECT_EQ(red, value);
+        EXPECT_EQ(green, value);
+        EXPECT_EQ(blue, value);
+    }
+}
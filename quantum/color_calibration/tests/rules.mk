@@ -0,0 +1,7 @@
+color_calibration_DEFS := -DCOLOR_CALIBRATION_ENABLE
+
+color_calibration_INC := $(QUANTUM_PATH)/color_calibration $(QUANTUM_PATH)
+
+color_calibration_SRC := \
+	$(QUANTUM_PATH)/color_calibration/tests/color_calibration_tests.cpp \
+	$(QUANTUM_PATH)/color_calibration/color_calibration.c
@@ -20,6 +20,7 @@
 #include "quantum.h" // for send_string()
 #include "dynamic_keymap.h"
 #include "via.h" // for default VIA_EEPROM_ADDR_END
+#include "eeprom_schema.h"
 #include <string.h>
 
 #ifdef VIAL_ENABLE
@@ -63,12 +64,15 @@
 #define VIAL_ENCODERS_EEPROM_ADDR (DYNAMIC_KEYMAP_EEPROM_ADDR + (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2))
 
 #ifdef VIAL_ENCODERS_ENABLE
+/* boards without encoder pins, such as the tests, can give the count directly */
+#ifndef NUMBER_OF_ENCODERS
 #ifdef SPLIT_KEYBOARD
 #define NUMBER_OF_ENCODERS (2 * sizeof(encoders_pad_a) / sizeof(pin_t))
 #else
 #define NUMBER_OF_ENCODERS (sizeof(encoders_pad_a) / sizeof(pin_t))
 #endif
 static pin_t encoders_pad_a[] = ENCODERS_PAD_A;
+#endif
 #define VIAL_ENCODERS_SIZE (NUMBER_OF_ENCODERS * DYNAMIC_KEYMAP_LAYER_COUNT * 2 * 2)
 #else
 #define VIAL_ENCODERS_SIZE 0
@@ -111,9 +115,18 @@ static pin_t encoders_pad_a[] = ENCODERS_PAD_A;
 #define VIAL_KEY_OVERRIDE_SIZE 0
 #endif
 
+// Per-key tapping terms
+#define VIAL_TAPPING_TERM_EEPROM_ADDR (VIAL_KEY_OVERRIDE_EEPROM_ADDR + VIAL_KEY_OVERRIDE_SIZE)
+
+#ifdef TAPPING_TERM_TABLE_ENABLE
+#define VIAL_TAPPING_TERM_SIZE (MATRIX_ROWS * MATRIX_COLS * 2)
+#else
+#define VIAL_TAPPING_TERM_SIZE 0
+#endif
+
 // Dynamic macro
 #ifndef DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR
-#    define DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR (VIAL_KEY_OVERRIDE_EEPROM_ADDR + VIAL_KEY_OVERRIDE_SIZE)
+#    define DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR (VIAL_TAPPING_TERM_EEPROM_ADDR + VIAL_TAPPING_TERM_SIZE)
 #endif
 
 // Sanity check that dynamic keymaps fit in available EEPROM
@@ -123,12 +136,23 @@ static pin_t encoders_pad_a[] = ENCODERS_PAD_A;
 // more than the default.
 _Static_assert(DYNAMIC_KEYMAP_EEPROM_MAX_ADDR >= DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + 100, "Dynamic keymaps are configured to use more EEPROM than is available.");
 
+// The schema table describing the layout above sits at the very end,
+// so that it stays put when any of the regions change size.
+#define DYNAMIC_KEYMAP_SCHEMA_SIZE EEPROM_SCHEMA_TABLE_SIZE(DYNAMIC_KEYMAP_REGION_COUNT)
+#ifndef DYNAMIC_KEYMAP_SCHEMA_EEPROM_ADDR
+#    define DYNAMIC_KEYMAP_SCHEMA_EEPROM_ADDR (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR + 1 - DYNAMIC_KEYMAP_SCHEMA_SIZE)
+#endif
+
 // Dynamic macros are stored after the keymaps and use what is available
-// up to and including DYNAMIC_KEYMAP_EEPROM_MAX_ADDR.
+// up to the schema table.
 #ifndef DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE
-#    define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + 1)
+#    define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE (DYNAMIC_KEYMAP_SCHEMA_EEPROM_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR)
 #endif
 
+_Static_assert(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE <= DYNAMIC_KEYMAP_SCHEMA_EEPROM_ADDR, "Dynamic macros overlap the EEPROM schema table.");
+
+#define DYNAMIC_KEYMAP_LAYER_SIZE (MATRIX_ROWS * MATRIX_COLS * 2)
+
 uint8_t dynamic_keymap_get_layer_count(void) {
     return DYNAMIC_KEYMAP_LAYER_COUNT;
 }
@@ -162,21 +186,39 @@ void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint
     // Big endian, so we can read/write EEPROM directly from host if we want
     eeprom_update_byte(address, (uint8_t)(keycode >> 8));
     eeprom_update_byte(address + 1, (uint8_t)(keycode & 0xFF));
+#if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_KEYMAP_INDICATORS)
+    rgb_matrix_invalidate_key_classes();
+#endif
 }
 
 #ifdef VIAL_ENCODERS_ENABLE
+/* Encoder keycodes are looked up on every step, keep them in RAM */
+static uint16_t encoder_cache[DYNAMIC_KEYMAP_LAYER_COUNT][NUMBER_OF_ENCODERS][2];
+static bool     encoder_cache_valid = false;
+
 static void *dynamic_keymap_encoder_to_eeprom_address(uint8_t layer, uint8_t idx, uint8_t dir) {
     return ((void *)VIAL_ENCODERS_EEPROM_ADDR) + (layer * NUMBER_OF_ENCODERS * 2 * 2) + (idx * 2 * 2) + dir * 2;
 }
 
+static void dynamic_keymap_encoder_cache_load(void) {
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        for (uint8_t idx = 0; idx < NUMBER_OF_ENCODERS; idx++) {
+            for (uint8_t dir = 0; dir < 2; dir++) {
+                void *address = dynamic_keymap_encoder_to_eeprom_address(layer, idx, dir);
+                encoder_cache[layer][idx][dir] = (eeprom_read_byte(address) << 8) | eeprom_read_byte(address + 1);
+            }
+        }
+    }
+    encoder_cache_valid = true;
+}
+
 uint16_t dynamic_keymap_get_encoder(uint8_t layer, uint8_t idx, uint8_t dir) {
     if (layer >= DYNAMIC_KEYMAP_LAYER_COUNT || idx >= NUMBER_OF_ENCODERS || dir > 1)
         return 0;
 
-    void *address = dynamic_keymap_encoder_to_eeprom_address(layer, idx, dir);
-    uint16_t keycode = eeprom_read_byte(address) << 8;
-    keycode |= eeprom_read_byte(address + 1);
-    return keycode;
+    if (!encoder_cache_valid)
+        dynamic_keymap_encoder_cache_load();
+    return encoder_cache[layer][idx][dir];
 }
 
 void dynamic_keymap_set_encoder(uint8_t layer, uint8_t idx, uint8_t dir, uint16_t keycode) {
@@ -191,6 +233,7 @@ void dynamic_keymap_set_encoder(uint8_t layer, uint8_t idx, uint8_t dir, uint16_
     void *address = dynamic_keymap_encoder_to_eeprom_address(layer, idx, dir);
     eeprom_update_byte(address, (uint8_t)(keycode >> 8));
     eeprom_update_byte(address + 1, (uint8_t)(keycode & 0xFF));
+    encoder_cache[layer][idx][dir] = keycode;
 }
 #endif
 
@@ -199,7 +242,7 @@ uint8_t dynamic_keymap_get_qmk_settings(uint16_t offset) {
     if (offset >= VIAL_QMK_SETTINGS_SIZE)
         return 0;
 
-    void *address = (void*)(VIAL_QMK_SETTINGS_EEPROM_ADDR + offset);
+    void *address = (void*)(uintptr_t)(VIAL_QMK_SETTINGS_EEPROM_ADDR + offset);
     return eeprom_read_byte(address);
 }
 
@@ -207,17 +250,41 @@ void dynamic_keymap_set_qmk_settings(uint16_t offset, uint8_t value) {
     if (offset >= VIAL_QMK_SETTINGS_SIZE)
         return;
 
-    void *address = (void*)(VIAL_QMK_SETTINGS_EEPROM_ADDR + offset);
+    void *address = (void*)(uintptr_t)(VIAL_QMK_SETTINGS_EEPROM_ADDR + offset);
     eeprom_update_byte(address, value);
 }
 #endif
 
+#ifdef TAPPING_TERM_TABLE_ENABLE
+static void *dynamic_keymap_tapping_term_to_eeprom_address(uint8_t row, uint8_t column) {
+    return ((void *)VIAL_TAPPING_TERM_EEPROM_ADDR) + (row * MATRIX_COLS * 2) + (column * 2);
+}
+
+uint16_t dynamic_keymap_get_tapping_term(uint8_t row, uint8_t column) {
+    if (row >= MATRIX_ROWS || column >= MATRIX_COLS)
+        return 0;
+
+    void *address = dynamic_keymap_tapping_term_to_eeprom_address(row, column);
+    return eeprom_read_byte(address) | (eeprom_read_byte(address + 1) << 8);
+}
+
+void dynamic_keymap_set_tapping_term(uint8_t row, uint8_t column, uint16_t entry) {
+    if (row >= MATRIX_ROWS || column >= MATRIX_COLS)
+        return;
+
+    // Little endian, like the rest of the vial entries
+    void *address = dynamic_keymap_tapping_term_to_eeprom_address(row, column);
+    eeprom_update_byte(address, (uint8_t)(entry & 0xFF));
+    eeprom_update_byte(address + 1, (uint8_t)(entry >> 8));
+}
+#endif
+
 #ifdef VIAL_TAP_DANCE_ENABLE
 int dynamic_keymap_get_tap_dance(uint8_t index, vial_tap_dance_entry_t *entry) {
     if (index >= VIAL_TAP_DANCE_ENTRIES)
         return -1;
 
-    void *address = (void*)(VIAL_TAP_DANCE_EEPROM_ADDR + index * sizeof(vial_tap_dance_entry_t));
+    void *address = (void*)(uintptr_t)(VIAL_TAP_DANCE_EEPROM_ADDR + index * sizeof(vial_tap_dance_entry_t));
     eeprom_read_block(entry, address, sizeof(vial_tap_dance_entry_t));
 
     return 0;
@@ -227,7 +294,7 @@ int dynamic_keymap_set_tap_dance(uint8_t index, const vial_tap_dance_entry_t *en
     if (index >= VIAL_TAP_DANCE_ENTRIES)
         return -1;
 
-    void *address = (void*)(VIAL_TAP_DANCE_EEPROM_ADDR + index * sizeof(vial_tap_dance_entry_t));
+    void *address = (void*)(uintptr_t)(VIAL_TAP_DANCE_EEPROM_ADDR + index * sizeof(vial_tap_dance_entry_t));
     eeprom_write_block(entry, address, sizeof(vial_tap_dance_entry_t));
 
     return 0;
@@ -239,7 +306,7 @@ int dynamic_keymap_get_combo(uint8_t index, vial_combo_entry_t *entry) {
     if (index >= VIAL_COMBO_ENTRIES)
         return -1;
 
-    void *address = (void*)(VIAL_COMBO_EEPROM_ADDR + index * sizeof(vial_combo_entry_t));
+    void *address = (void*)(uintptr_t)(VIAL_COMBO_EEPROM_ADDR + index * sizeof(vial_combo_entry_t));
     eeprom_read_block(entry, address, sizeof(vial_combo_entry_t));
 
     return 0;
@@ -249,7 +316,7 @@ int dynamic_keymap_set_combo(uint8_t index, const vial_combo_entry_t *entry) {
     if (index >= VIAL_COMBO_ENTRIES)
         return -1;
 
-    void *address = (void*)(VIAL_COMBO_EEPROM_ADDR + index * sizeof(vial_combo_entry_t));
+    void *address = (void*)(uintptr_t)(VIAL_COMBO_EEPROM_ADDR + index * sizeof(vial_combo_entry_t));
     eeprom_write_block(entry, address, sizeof(vial_combo_entry_t));
 
     return 0;
@@ -261,7 +328,7 @@ int dynamic_keymap_get_key_override(uint8_t index, vial_key_override_entry_t *en
     if (index >= VIAL_KEY_OVERRIDE_ENTRIES)
         return -1;
 
-    void *address = (void*)(VIAL_KEY_OVERRIDE_EEPROM_ADDR + index * sizeof(vial_key_override_entry_t));
+    void *address = (void*)(uintptr_t)(VIAL_KEY_OVERRIDE_EEPROM_ADDR + index * sizeof(vial_key_override_entry_t));
     eeprom_read_block(entry, address, sizeof(vial_key_override_entry_t));
 
     return 0;
@@ -271,7 +338,7 @@ int dynamic_keymap_set_key_override(uint8_t index, const vial_key_override_entry
     if (index >= VIAL_KEY_OVERRIDE_ENTRIES)
         return -1;
 
-    void *address = (void*)(VIAL_KEY_OVERRIDE_EEPROM_ADDR + index * sizeof(vial_key_override_entry_t));
+    void *address = (void*)(uintptr_t)(VIAL_KEY_OVERRIDE_EEPROM_ADDR + index * sizeof(vial_key_override_entry_t));
     eeprom_write_block(entry, address, sizeof(vial_key_override_entry_t));
 
     return 0;
@@ -284,60 +351,106 @@ _Static_assert(sizeof(vial_encoder_default)/sizeof(*vial_encoder_default) == 2 *
     "There should be DYNAMIC_KEYMAP_LAYER_COUNT * NUMBER_OF_ENCODERS * 2 entries in the VIAL_ENCODER_DEFAULT array.");
 #endif
 
-void dynamic_keymap_reset(void) {
-#ifdef VIAL_ENABLE
-    /* temporarily unlock the keyboard so we can set hardcoded RESET keycode */
-    int vial_unlocked_prev = vial_unlocked;
-    vial_unlocked = 1;
-#endif
-
+static void dynamic_keymap_reset_keymap(uint16_t offset) {
     // Reset the keymaps in EEPROM to what is in flash.
     // All keyboards using dynamic keymaps should define a layout
     // for the same number of layers as DYNAMIC_KEYMAP_LAYER_COUNT.
-    for (int layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+    for (int layer = offset / DYNAMIC_KEYMAP_LAYER_SIZE; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
         for (int row = 0; row < MATRIX_ROWS; row++) {
             for (int column = 0; column < MATRIX_COLS; column++) {
                 dynamic_keymap_set_keycode(layer, row, column, pgm_read_word(&keymaps[layer][row][column]));
             }
         }
+    }
+}
 
 #ifdef VIAL_ENCODERS_ENABLE
-    for (int idx = 0; idx < NUMBER_OF_ENCODERS; ++idx) {
+static void dynamic_keymap_reset_encoders(uint16_t offset) {
+    for (int layer = offset / (NUMBER_OF_ENCODERS * 2 * 2); layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        for (int idx = 0; idx < NUMBER_OF_ENCODERS; ++idx) {
 #ifdef VIAL_ENCODER_DEFAULT
-        dynamic_keymap_set_encoder(layer, idx, 0, pgm_read_word(&vial_encoder_default[2 * (layer * NUMBER_OF_ENCODERS + idx)]));
-        dynamic_keymap_set_encoder(layer, idx, 1, pgm_read_word(&vial_encoder_default[2 * (layer * NUMBER_OF_ENCODERS + idx) + 1]));
+            dynamic_keymap_set_encoder(layer, idx, 0, pgm_read_word(&vial_encoder_default[2 * (layer * NUMBER_OF_ENCODERS + idx)]));
+            dynamic_keymap_set_encoder(layer, idx, 1, pgm_read_word(&vial_encoder_default[2 * (layer * NUMBER_OF_ENCODERS + idx) + 1]));
 #else
-        dynamic_keymap_set_encoder(layer, idx, 0, KC_TRNS);
-        dynamic_keymap_set_encoder(layer, idx, 1, KC_TRNS);
+            dynamic_keymap_set_encoder(layer, idx, 0, KC_TRNS);
+            dynamic_keymap_set_encoder(layer, idx, 1, KC_TRNS);
 #endif
+        }
     }
+}
 #endif
-    }
 
-#ifdef QMK_SETTINGS
-    qmk_settings_reset();
+// Offset of each macro in the buffer, found with a single pass over it
+// whenever the buffer is written, and on the first macro sent after boot.
+static uint16_t macro_offsets[DYNAMIC_KEYMAP_MACRO_COUNT];
+static bool     macro_offsets_valid = false;
+
+#define MACRO_OFFSET_NONE 0xFFFF
+
+static void dynamic_keymap_macro_index(void);
+
+/* Resets one region of the dynamic keymap area, starting at byte offset,
+ * which is always a multiple of the region's stride. */
+void dynamic_keymap_reset_region(uint8_t region, uint16_t offset) {
+#ifdef VIAL_ENABLE
+    /* temporarily unlock the keyboard so we can set hardcoded RESET keycode */
+    int vial_unlocked_prev = vial_unlocked;
+    vial_unlocked = 1;
 #endif
 
+    switch (region) {
+        case DYNAMIC_KEYMAP_REGION_KEYMAP:
+            dynamic_keymap_reset_keymap(offset);
+            break;
+#ifdef VIAL_ENCODERS_ENABLE
+        case DYNAMIC_KEYMAP_REGION_ENCODERS:
+            dynamic_keymap_reset_encoders(offset);
+            break;
+#endif
+#ifdef QMK_SETTINGS
+        case DYNAMIC_KEYMAP_REGION_QMK_SETTINGS:
+            qmk_settings_reset();
+            break;
+#endif
 #ifdef VIAL_TAP_DANCE_ENABLE
-    vial_tap_dance_entry_t td = { KC_NO, KC_NO, KC_NO, KC_NO, TAPPING_TERM };
-    for (size_t i = 0; i < VIAL_TAP_DANCE_ENTRIES; ++i) {
-        dynamic_keymap_set_tap_dance(i, &td);
-    }
+        case DYNAMIC_KEYMAP_REGION_TAP_DANCE: {
+            vial_tap_dance_entry_t td = { KC_NO, KC_NO, KC_NO, KC_NO, TAPPING_TERM };
+            for (size_t i = offset / sizeof(td); i < VIAL_TAP_DANCE_ENTRIES; ++i) {
+                dynamic_keymap_set_tap_dance(i, &td);
+            }
+            break;
+        }
 #endif
-
 #ifdef VIAL_COMBO_ENABLE
-    vial_combo_entry_t combo = { 0 };
-    for (size_t i = 0; i < VIAL_COMBO_ENTRIES; ++i)
-        dynamic_keymap_set_combo(i, &combo);
+        case DYNAMIC_KEYMAP_REGION_COMBO: {
+            vial_combo_entry_t combo = { 0 };
+            for (size_t i = offset / sizeof(combo); i < VIAL_COMBO_ENTRIES; ++i)
+                dynamic_keymap_set_combo(i, &combo);
+            break;
+        }
 #endif
-
 #ifdef VIAL_KEY_OVERRIDE_ENABLE
-    vial_key_override_entry_t ko = { 0 };
-    ko.layers = ~0;
-    ko.options = vial_ko_option_activation_negative_mod_up | vial_ko_option_activation_required_mod_down | vial_ko_option_activation_trigger_down;
-    for (size_t i = 0; i < VIAL_KEY_OVERRIDE_ENTRIES; ++i)
-        dynamic_keymap_set_key_override(i, &ko);
+        case DYNAMIC_KEYMAP_REGION_KEY_OVERRIDE: {
+            vial_key_override_entry_t ko = { 0 };
+            ko.layers = ~0;
+            ko.options = vial_ko_option_activation_negative_mod_up | vial_ko_option_activation_required_mod_down | vial_ko_option_activation_trigger_down;
+            for (size_t i = offset / sizeof(ko); i < VIAL_KEY_OVERRIDE_ENTRIES; ++i)
+                dynamic_keymap_set_key_override(i, &ko);
+            break;
+        }
 #endif
+#ifdef TAPPING_TERM_TABLE_ENABLE
+        case DYNAMIC_KEYMAP_REGION_TAPPING_TERM:
+            for (uint16_t i = offset / 2; i < MATRIX_ROWS * MATRIX_COLS; ++i)
+                dynamic_keymap_set_tapping_term(i / MATRIX_COLS, i % MATRIX_COLS, 0);
+            break;
+#endif
+        case DYNAMIC_KEYMAP_REGION_MACRO:
+            for (uint16_t i = offset; i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE; ++i)
+                eeprom_update_byte((uint8_t *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + i), 0);
+            dynamic_keymap_macro_index();
+            break;
+    }
 
 #ifdef VIAL_ENABLE
     /* re-lock the keyboard */
@@ -345,9 +458,130 @@ void dynamic_keymap_reset(void) {
 #endif
 }
 
+void dynamic_keymap_reset(void) {
+    // Macros are reset separately, see eeconfig_init_via()
+    for (uint8_t region = 0; region < DYNAMIC_KEYMAP_REGION_MACRO; region++) {
+        dynamic_keymap_reset_region(region, 0);
+    }
+}
+
+static const eeprom_schema_region_t dynamic_keymap_regions[DYNAMIC_KEYMAP_REGION_COUNT] = {
+    [DYNAMIC_KEYMAP_REGION_KEYMAP]       = {DYNAMIC_KEYMAP_EEPROM_ADDR, DYNAMIC_KEYMAP_LAYER_COUNT * DYNAMIC_KEYMAP_LAYER_SIZE, DYNAMIC_KEYMAP_LAYER_SIZE, DYNAMIC_KEYMAP_KEYMAP_VERSION},
+#ifdef VIAL_ENCODERS_ENABLE
+    [DYNAMIC_KEYMAP_REGION_ENCODERS]     = {VIAL_ENCODERS_EEPROM_ADDR, VIAL_ENCODERS_SIZE, NUMBER_OF_ENCODERS * 2 * 2, DYNAMIC_KEYMAP_ENCODERS_VERSION},
+#else
+    [DYNAMIC_KEYMAP_REGION_ENCODERS]     = {VIAL_ENCODERS_EEPROM_ADDR, 0, 1, DYNAMIC_KEYMAP_ENCODERS_VERSION},
+#endif
+    [DYNAMIC_KEYMAP_REGION_QMK_SETTINGS] = {VIAL_QMK_SETTINGS_EEPROM_ADDR, VIAL_QMK_SETTINGS_SIZE, VIAL_QMK_SETTINGS_SIZE ? VIAL_QMK_SETTINGS_SIZE : 1, DYNAMIC_KEYMAP_QMK_SETTINGS_VERSION},
+#ifdef VIAL_TAP_DANCE_ENABLE
+    [DYNAMIC_KEYMAP_REGION_TAP_DANCE]    = {VIAL_TAP_DANCE_EEPROM_ADDR, VIAL_TAP_DANCE_SIZE, sizeof(vial_tap_dance_entry_t), DYNAMIC_KEYMAP_TAP_DANCE_VERSION},
+#else
+    [DYNAMIC_KEYMAP_REGION_TAP_DANCE]    = {VIAL_TAP_DANCE_EEPROM_ADDR, 0, 1, DYNAMIC_KEYMAP_TAP_DANCE_VERSION},
+#endif
+#ifdef VIAL_COMBO_ENABLE
+    [DYNAMIC_KEYMAP_REGION_COMBO]        = {VIAL_COMBO_EEPROM_ADDR, VIAL_COMBO_SIZE, sizeof(vial_combo_entry_t), DYNAMIC_KEYMAP_COMBO_VERSION},
+#else
+    [DYNAMIC_KEYMAP_REGION_COMBO]        = {VIAL_COMBO_EEPROM_ADDR, 0, 1, DYNAMIC_KEYMAP_COMBO_VERSION},
+#endif
+#ifdef VIAL_KEY_OVERRIDE_ENABLE
+    [DYNAMIC_KEYMAP_REGION_KEY_OVERRIDE] = {VIAL_KEY_OVERRIDE_EEPROM_ADDR, VIAL_KEY_OVERRIDE_SIZE, sizeof(vial_key_override_entry_t), DYNAMIC_KEYMAP_KEY_OVERRIDE_VERSION},
+#else
+    [DYNAMIC_KEYMAP_REGION_KEY_OVERRIDE] = {VIAL_KEY_OVERRIDE_EEPROM_ADDR, 0, 1, DYNAMIC_KEYMAP_KEY_OVERRIDE_VERSION},
+#endif
+#ifdef TAPPING_TERM_TABLE_ENABLE
+    [DYNAMIC_KEYMAP_REGION_TAPPING_TERM] = {VIAL_TAPPING_TERM_EEPROM_ADDR, VIAL_TAPPING_TERM_SIZE, 2, DYNAMIC_KEYMAP_TAPPING_TERM_VERSION},
+#else
+    [DYNAMIC_KEYMAP_REGION_TAPPING_TERM] = {VIAL_TAPPING_TERM_EEPROM_ADDR, 0, 1, DYNAMIC_KEYMAP_TAPPING_TERM_VERSION},
+#endif
+    [DYNAMIC_KEYMAP_REGION_MACRO]        = {DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR, DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE, 1, DYNAMIC_KEYMAP_MACRO_VERSION},
+};
+
+__attribute__((weak)) bool dynamic_keymap_migrate_kb(uint8_t region, uint8_t version, uint16_t stride, uint16_t size) {
+    return false;
+}
+
+static bool dynamic_keymap_convert(uint8_t region, uint8_t version, uint16_t stride, uint16_t size) {
+#ifdef QMK_SETTINGS
+    if (region == DYNAMIC_KEYMAP_REGION_QMK_SETTINGS && version == DYNAMIC_KEYMAP_QMK_SETTINGS_VERSION && size < VIAL_QMK_SETTINGS_SIZE) {
+        qmk_settings_migrate(size);
+        return true;
+    }
+#endif
+    return dynamic_keymap_migrate_kb(region, version, stride, size);
+}
+
+bool dynamic_keymap_migrate(void) {
+#ifdef VIAL_ENCODERS_ENABLE
+    // regions are moved behind the cache's back
+    encoder_cache_valid = false;
+#endif
+    bool migrated = eeprom_schema_migrate((void *)DYNAMIC_KEYMAP_SCHEMA_EEPROM_ADDR, dynamic_keymap_regions, DYNAMIC_KEYMAP_REGION_COUNT, dynamic_keymap_reset_region, dynamic_keymap_convert);
+
+    // the macros may have moved
+    dynamic_keymap_macro_index();
+    return migrated;
+}
+
+void dynamic_keymap_save_schema(void) {
+    eeprom_schema_save((void *)DYNAMIC_KEYMAP_SCHEMA_EEPROM_ADDR, dynamic_keymap_regions, DYNAMIC_KEYMAP_REGION_COUNT);
+}
+
+uint16_t dynamic_keymap_snapshot_size(void) {
+    return DYNAMIC_KEYMAP_EEPROM_MAX_ADDR + 1 - DYNAMIC_KEYMAP_EEPROM_ADDR;
+}
+
+void dynamic_keymap_snapshot_read(uint16_t offset, uint16_t size, uint8_t *data) {
+    eeprom_read_block(data, (void *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset), size);
+}
+
+bool dynamic_keymap_snapshot_write(const uint8_t *data) {
+#if defined(VIAL_ENABLE) && !defined(VIAL_INSECURE)
+    /* a snapshot can hold any keycode, including RESET */
+    if (!vial_unlocked)
+        return false;
+#endif
+
+    uint16_t size  = dynamic_keymap_snapshot_size();
+    uint16_t table = DYNAMIC_KEYMAP_SCHEMA_EEPROM_ADDR - DYNAMIC_KEYMAP_EEPROM_ADDR;
+    uint16_t end   = table + DYNAMIC_KEYMAP_SCHEMA_SIZE;
+
+    // Invalidate the stored table first and write the snapshot's own table last. A restore cut
+    // short is therefore a factory reset on the next boot, rather than data migrated with a table
+    // that does not match it; there is no room to stage a second copy of the area
+    eeprom_schema_invalidate((void *)DYNAMIC_KEYMAP_SCHEMA_EEPROM_ADDR);
+    if (end <= size) {
+        eeprom_update_block(data, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR, table);
+        eeprom_update_block(data + end, (void *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + end), size - end);
+        // Backwards, so the magic of the table goes in after its entries
+        for (uint16_t i = end; i-- > table;) {
+            eeprom_update_byte((void *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + i), data[i]);
+        }
+    } else {
+        // The table is kept outside of the snapshot
+        eeprom_update_block(data, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR, size);
+    }
+
+    // The snapshot carries its own schema table, which may be from an older build
+    if (!dynamic_keymap_migrate()) {
+        dynamic_keymap_reset();
+        dynamic_keymap_macro_reset();
+        dynamic_keymap_save_schema();
+    }
+#ifdef VIAL_ENABLE
+    vial_init();
+#endif
+#ifdef QMK_SETTINGS
+    qmk_settings_init();
+#endif
+#if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_KEYMAP_INDICATORS)
+    rgb_matrix_invalidate_key_classes();
+#endif
+    return true;
+}
+
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   source                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
+    void *   source                     = (void *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
     uint8_t *target                     = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < dynamic_keymap_eeprom_size) {
@@ -362,7 +596,7 @@ void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
 
 void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   target                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
+    void *   target                     = (void *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
     uint8_t *source                     = data;
 
 #ifdef VIAL_ENABLE
@@ -416,6 +650,9 @@ void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
         source++;
         target++;
     }
+#if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_KEYMAP_INDICATORS)
+    rgb_matrix_invalidate_key_classes();
+#endif
 }
 
 extern uint16_t g_vial_magic_keycode_override;
@@ -449,7 +686,7 @@ uint16_t dynamic_keymap_macro_get_buffer_size(void) {
 }
 
 void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   source = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
+    void *   source = (void *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
     uint8_t *target = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
@@ -462,8 +699,31 @@ void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *da
     }
 }
 
+static void dynamic_keymap_macro_index(void) {
+    memset(macro_offsets, 0xFF, sizeof(macro_offsets));
+    macro_offsets_valid = true;
+
+    // Check the last byte of the buffer.
+    // If it's not zero, then we are in the middle
+    // of buffer writing, possibly an aborted buffer
+    // write. So no macro can be sent.
+    if (eeprom_read_byte((uint8_t *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 1)) != 0) {
+        return;
+    }
+
+    // If there are not DYNAMIC_KEYMAP_MACRO_COUNT nulls in the buffer,
+    // the remaining macros stay unset.
+    uint8_t id        = 0;
+    macro_offsets[id] = 0;
+    for (uint16_t offset = 0; offset < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE && id < DYNAMIC_KEYMAP_MACRO_COUNT - 1; offset++) {
+        if (eeprom_read_byte((uint8_t *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset)) == 0) {
+            macro_offsets[++id] = offset + 1;
+        }
+    }
+}
+
 void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   target = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
+    void *   target = (void *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
     uint8_t *source = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
@@ -472,112 +732,204 @@ void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *da
         source++;
         target++;
     }
+    dynamic_keymap_macro_index();
 }
 
 void dynamic_keymap_macro_reset(void) {
-    void *p   = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
-    while (p != end) {
-        eeprom_update_byte(p, 0);
-        ++p;
-    }
+    dynamic_keymap_reset_region(DYNAMIC_KEYMAP_REGION_MACRO, 0);
 }
 
+#ifdef VIAL_ENABLE
 static uint16_t decode_keycode(uint16_t kc) {
     /* map 0xFF01 => 0x0100; 0xFF02 => 0x0200, etc */
     if (kc > 0xFF00)
         return (kc & 0xFF) << 8;
     return kc;
 }
+#endif
+
+// One decoded step of a macro
+typedef enum {
+    MACRO_STEP_END,
+    MACRO_STEP_NONE,
+    MACRO_STEP_CHAR,
+    MACRO_STEP_TAP,
+    MACRO_STEP_DOWN,
+    MACRO_STEP_UP,
+#ifdef VIAL_ENABLE
+    MACRO_STEP_EXT_TAP,
+    MACRO_STEP_EXT_DOWN,
+    MACRO_STEP_EXT_UP,
+#endif
+    MACRO_STEP_DELAY,
+} macro_step_type_t;
+
+typedef struct {
+    uint8_t  type;
+    uint16_t code; // character, keycode or delay in ms
+} macro_step_t;
+
+static inline uint8_t macro_read(uint16_t offset) {
+    // We already checked there was a null at the end of
+    // the buffer, so this cannot go past the end
+    return eeprom_read_byte((uint8_t *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset));
+}
+
+/* Decodes the step at *offset and moves it past the step */
+static macro_step_t macro_decode_step(uint16_t *offset) {
+    macro_step_t step = {MACRO_STEP_END, 0};
+    uint8_t      c    = macro_read((*offset)++);
+
+    // Stop at the null terminator of this macro string
+    if (c == 0) return step;
+    if (c != SS_QMK_PREFIX) {
+        // If the char wasn't magic, just send it
+        step.type = MACRO_STEP_CHAR;
+        step.code = c;
+        return step;
+    }
+
+    // If the char is magic, process it as indicated by the next character
+    // (tap, down, up, delay)
+    uint8_t op = macro_read((*offset)++);
+    switch (op) {
+        case 0:
+            break;
+        case SS_TAP_CODE:
+        case SS_DOWN_CODE:
+        case SS_UP_CODE:
+            step.code = macro_read((*offset)++);
+            if (step.code != 0) step.type = op == SS_TAP_CODE ? MACRO_STEP_TAP : op == SS_DOWN_CODE ? MACRO_STEP_DOWN : MACRO_STEP_UP;
+            break;
+#ifdef VIAL_ENABLE
+        case VIAL_MACRO_EXT_TAP:
+        case VIAL_MACRO_EXT_DOWN:
+        case VIAL_MACRO_EXT_UP: {
+            uint8_t lo = macro_read((*offset)++);
+            if (lo == 0) break;
+            uint8_t hi = macro_read((*offset)++);
+            if (hi == 0) break;
+            step.code = decode_keycode(lo | (hi << 8));
+            step.type = op == VIAL_MACRO_EXT_TAP ? MACRO_STEP_EXT_TAP : op == VIAL_MACRO_EXT_DOWN ? MACRO_STEP_EXT_DOWN : MACRO_STEP_EXT_UP;
+            break;
+        }
+#endif
+        case SS_DELAY_CODE: {
+            uint8_t d0 = macro_read((*offset)++);
+            if (d0 == 0) break;
+            uint8_t d1 = macro_read((*offset)++);
+            if (d1 == 0) break;
+            // we cannot use 0 for these, need to subtract 1 and use 255 instead of 256 for delay calculation
+            step.code = (d0 - 1) + (d1 - 1) * 255;
+            step.type = MACRO_STEP_DELAY;
+            break;
+        }
+        default:
+            // unknown codes are skipped
+            step.type = MACRO_STEP_NONE;
+            break;
+    }
+    return step;
+}
+
+#ifndef DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE
+#    define DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE 4
+#endif
+
+// Macros play back one step per dynamic_keymap_macro_task() call,
+// so the matrix keeps being scanned while they run.
+static uint8_t  macro_queue[DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE];
+static uint8_t  macro_queue_head = 0;
+static uint8_t  macro_queue_tail = 0;
+static bool     macro_playing    = false;
+static uint16_t macro_offset;
+static uint16_t macro_delay;
+static uint16_t macro_delay_timer;
+
+static bool dynamic_keymap_macro_start(uint8_t id) {
+    if (!macro_offsets_valid) {
+        dynamic_keymap_macro_index();
+    }
+    if (macro_offsets[id] == MACRO_OFFSET_NONE) {
+        return false;
+    }
+    macro_offset  = macro_offsets[id];
+    macro_delay   = 0;
+    macro_playing = true;
+    return true;
+}
 
 void dynamic_keymap_macro_send(uint8_t id) {
     if (id >= DYNAMIC_KEYMAP_MACRO_COUNT) {
         return;
     }
 
-    // Check the last byte of the buffer.
-    // If it's not zero, then we are in the middle
-    // of buffer writing, possibly an aborted buffer
-    // write. So do nothing.
-    void *p = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 1);
-    if (eeprom_read_byte(p) != 0) {
+    if (macro_playing || macro_queue_head != macro_queue_tail) {
+        uint8_t next = (macro_queue_head + 1) % DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE;
+        if (next != macro_queue_tail) {
+            macro_queue[macro_queue_head] = id;
+            macro_queue_head              = next;
+        }
         return;
     }
 
-    // Skip N null characters
-    // p will then point to the Nth macro
-    p         = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
-    while (id > 0) {
-        // If we are past the end of the buffer, then the buffer
-        // contents are garbage, i.e. there were not DYNAMIC_KEYMAP_MACRO_COUNT
-        // nulls in the buffer.
-        if (p == end) {
-            return;
-        }
-        if (eeprom_read_byte(p) == 0) {
-            --id;
-        }
-        ++p;
+    // Start right away, so a macro without delays is already under way
+    // before the next matrix scan.
+    if (dynamic_keymap_macro_start(id)) {
+        dynamic_keymap_macro_task();
     }
+}
 
-    // Send the macro string one or three chars at a time
-    // by making temporary 1 or 3 char strings
-    char data[4] = {0, 0, 0, 0};
-    // We already checked there was a null at the end of
-    // the buffer, so this cannot go past the end
-    while (1) {
-        data[0] = eeprom_read_byte(p++);
-        data[1] = 0;
-        // Stop at the null terminator of this macro string
-        if (data[0] == 0) {
+bool dynamic_keymap_macro_is_playing(void) {
+    return macro_playing || macro_queue_head != macro_queue_tail;
+}
+
+void dynamic_keymap_macro_task(void) {
+    while (!macro_playing) {
+        if (macro_queue_head == macro_queue_tail) return;
+        uint8_t id       = macro_queue[macro_queue_tail];
+        macro_queue_tail = (macro_queue_tail + 1) % DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE;
+        dynamic_keymap_macro_start(id);
+    }
+
+    if (macro_delay) {
+        if (timer_elapsed(macro_delay_timer) < macro_delay) return;
+        macro_delay = 0;
+    }
+
+    macro_step_t step = macro_decode_step(&macro_offset);
+    switch (step.type) {
+        case MACRO_STEP_END:
+            macro_playing = false;
+            break;
+        case MACRO_STEP_NONE:
+            break;
+        case MACRO_STEP_CHAR:
+            send_char(step.code);
+            break;
+        case MACRO_STEP_TAP:
+            tap_code(step.code);
+            break;
+        case MACRO_STEP_DOWN:
+            register_code(step.code);
+            break;
+        case MACRO_STEP_UP:
+            unregister_code(step.code);
+            break;
+#ifdef VIAL_ENABLE
+        case MACRO_STEP_EXT_TAP:
+            vial_keycode_tap(step.code);
+            break;
+        case MACRO_STEP_EXT_DOWN:
+            vial_keycode_down(step.code);
+            break;
+        case MACRO_STEP_EXT_UP:
+            vial_keycode_up(step.code);
+            break;
+#endif
+        case MACRO_STEP_DELAY:
+            macro_delay       = step.code;
+            macro_delay_timer = timer_read();
             break;
-        }
-        if (data[0] == SS_QMK_PREFIX) {
-            // If the char is magic, process it as indicated by the next character
-            // (tap, down, up, delay)
-            data[1] = eeprom_read_byte(p++);
-            if (data[1] == 0)
-                break;
-            if (data[1] == SS_TAP_CODE || data[1] == SS_DOWN_CODE || data[1] == SS_UP_CODE) {
-                // For tap, down, up, just stuff it into the array and send_string it
-                data[2] = eeprom_read_byte(p++);
-                if (data[2] != 0)
-                    send_string(data);
-            } else if (data[1] == VIAL_MACRO_EXT_TAP || data[1] == VIAL_MACRO_EXT_DOWN || data[1] == VIAL_MACRO_EXT_UP) {
-                data[2] = eeprom_read_byte(p++);
-                if (data[2] != 0) {
-                    data[3] = eeprom_read_byte(p++);
-                    if (data[3] != 0) {
-                        uint16_t kc;
-                        memcpy(&kc, &data[2], sizeof(kc));
-                        kc = decode_keycode(kc);
-                        switch (data[1]) {
-                        case VIAL_MACRO_EXT_TAP:
-                            vial_keycode_tap(kc);
-                            break;
-                        case VIAL_MACRO_EXT_DOWN:
-                            vial_keycode_down(kc);
-                            break;
-                        case VIAL_MACRO_EXT_UP:
-                            vial_keycode_up(kc);
-                            break;
-                        }
-                    }
-                }
-            } else if (data[1] == SS_DELAY_CODE) {
-                // For delay, decode the delay and wait_ms for that amount
-                uint8_t d0 = eeprom_read_byte(p++);
-                uint8_t d1 = eeprom_read_byte(p++);
-                if (d0 == 0 || d1 == 0)
-                    break;
-                // we cannot use 0 for these, need to subtract 1 and use 255 instead of 256 for delay calculation
-                int ms = (d0 - 1) + (d1 - 1) * 255;
-                while (ms--) wait_ms(1);
-            }
-        } else {
-            // If the char wasn't magic, just send it
-            send_string(data);
-        }
     }
 }
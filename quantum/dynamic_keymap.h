@@ -26,6 +26,46 @@
 #    define DYNAMIC_KEYMAP_LAYER_COUNT 4
 #endif
 
+// Regions of the dynamic keymap area, in the order they are laid out in EEPROM
+enum dynamic_keymap_region {
+    DYNAMIC_KEYMAP_REGION_KEYMAP,
+    DYNAMIC_KEYMAP_REGION_ENCODERS,
+    DYNAMIC_KEYMAP_REGION_QMK_SETTINGS,
+    DYNAMIC_KEYMAP_REGION_TAP_DANCE,
+    DYNAMIC_KEYMAP_REGION_COMBO,
+    DYNAMIC_KEYMAP_REGION_KEY_OVERRIDE,
+    DYNAMIC_KEYMAP_REGION_TAPPING_TERM,
+    DYNAMIC_KEYMAP_REGION_MACRO,
+    DYNAMIC_KEYMAP_REGION_COUNT
+};
+
+// Bump these when the format of a region's records changes,
+// so stored data gets converted (or reset) instead of misread.
+#ifndef DYNAMIC_KEYMAP_KEYMAP_VERSION
+#    define DYNAMIC_KEYMAP_KEYMAP_VERSION 1
+#endif
+#ifndef DYNAMIC_KEYMAP_ENCODERS_VERSION
+#    define DYNAMIC_KEYMAP_ENCODERS_VERSION 1
+#endif
+#ifndef DYNAMIC_KEYMAP_QMK_SETTINGS_VERSION
+#    define DYNAMIC_KEYMAP_QMK_SETTINGS_VERSION 1
+#endif
+#ifndef DYNAMIC_KEYMAP_TAP_DANCE_VERSION
+#    define DYNAMIC_KEYMAP_TAP_DANCE_VERSION 1
+#endif
+#ifndef DYNAMIC_KEYMAP_COMBO_VERSION
+#    define DYNAMIC_KEYMAP_COMBO_VERSION 1
+#endif
+#ifndef DYNAMIC_KEYMAP_KEY_OVERRIDE_VERSION
+#    define DYNAMIC_KEYMAP_KEY_OVERRIDE_VERSION 1
+#endif
+#ifndef DYNAMIC_KEYMAP_TAPPING_TERM_VERSION
+#    define DYNAMIC_KEYMAP_TAPPING_TERM_VERSION 1
+#endif
+#ifndef DYNAMIC_KEYMAP_MACRO_VERSION
+#    define DYNAMIC_KEYMAP_MACRO_VERSION 1
+#endif
+
 uint8_t  dynamic_keymap_get_layer_count(void);
 void *   dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column);
 uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column);
@@ -50,7 +90,33 @@ int dynamic_keymap_set_combo(uint8_t index, const vial_combo_entry_t *entry);
 int dynamic_keymap_get_key_override(uint8_t index, vial_key_override_entry_t *entry);
 int dynamic_keymap_set_key_override(uint8_t index, const vial_key_override_entry_t *entry);
 #endif
+#ifdef TAPPING_TERM_TABLE_ENABLE
+// Per-key tapping settings, one 16-bit entry per matrix position:
+// the tapping term in ms (0 for the global one) plus the flags below
+#    define TAPPING_TERM_TABLE_TERM_MASK 0x3FFF
+#    define TAPPING_TERM_TABLE_PERMISSIVE_HOLD 0x4000
+#    define TAPPING_TERM_TABLE_HOLD_ON_OTHER_KEY_PRESS 0x8000
+uint16_t dynamic_keymap_get_tapping_term(uint8_t row, uint8_t column);
+void     dynamic_keymap_set_tapping_term(uint8_t row, uint8_t column, uint16_t entry);
+#endif
 void     dynamic_keymap_reset(void);
+// Resets a single region, from a byte offset that is a multiple of its record size
+void     dynamic_keymap_reset_region(uint8_t region, uint16_t offset);
+
+// Moves stored regions to where the current firmware expects them, keeping
+// their contents where possible. Returns false if there is no stored layout
+// to migrate from, in which case a full reset is needed.
+bool dynamic_keymap_migrate(void);
+void dynamic_keymap_save_schema(void);
+// Called for a region whose record version or size changed, after the
+// surviving bytes have been moved into place. Return true once converted,
+// or false to have the region reset to defaults.
+bool dynamic_keymap_migrate_kb(uint8_t region, uint8_t version, uint16_t stride, uint16_t size);
+// The whole dynamic keymap area, schema table included, as one blob for backup and restore.
+// Writing returns false if restoring is not allowed right now.
+uint16_t dynamic_keymap_snapshot_size(void);
+void     dynamic_keymap_snapshot_read(uint16_t offset, uint16_t size, uint8_t *data);
+bool     dynamic_keymap_snapshot_write(const uint8_t *data);
 // These get/set the keycodes as stored in the EEPROM buffer
 // Data is big-endian 16-bit values (the keycodes)
 // Order is by layer/row/column
@@ -85,4 +151,8 @@ void     dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t
 void     dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 void     dynamic_keymap_macro_reset(void);
 
+// Macros are played back from the main loop, one step per call to
+// dynamic_keymap_macro_task(); delays no longer block scanning.
 void dynamic_keymap_macro_send(uint8_t id);
+bool dynamic_keymap_macro_is_playing(void);
+void dynamic_keymap_macro_task(void);
@@ -0,0 +1,120 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "eeprom_schema.h"
+#include "eeprom.h"
+
+static inline uint8_t *entry_address(const void *table, uint8_t index) {
+    return (uint8_t *)table + EEPROM_SCHEMA_TABLE_SIZE(index);
+}
+
+static eeprom_schema_region_t read_entry(const void *table, uint8_t index) {
+    uint8_t *const         p = entry_address(table, index);
+    eeprom_schema_region_t entry;
+    entry.addr    = eeprom_read_word((const uint16_t *)p);
+    entry.size    = eeprom_read_word((const uint16_t *)(p + 2));
+    entry.stride  = eeprom_read_word((const uint16_t *)(p + 4));
+    entry.version = eeprom_read_byte(p + 6);
+    return entry;
+}
+
+static void write_entry(void *table, uint8_t index, const eeprom_schema_region_t *entry) {
+    uint8_t *const p = entry_address(table, index);
+    eeprom_update_word((uint16_t *)p, entry->addr);
+    eeprom_update_word((uint16_t *)(p + 2), entry->size);
+    eeprom_update_word((uint16_t *)(p + 4), entry->stride);
+    eeprom_update_byte(p + 6, entry->version);
+}
+
+/* copies the bytes that survive the move, in the direction that is safe for overlapping ranges */
+static void move_region(uint16_t from, uint16_t to, uint16_t len) {
+    if (from == to || len == 0) return;
+    if (to < from) {
+        for (uint16_t i = 0; i < len; i++) {
+            eeprom_update_byte((uint8_t *)(uintptr_t)(to + i), eeprom_read_byte((const uint8_t *)(uintptr_t)(from + i)));
+        }
+    } else {
+        for (uint16_t i = len; i > 0; i--) {
+            eeprom_update_byte((uint8_t *)(uintptr_t)(to + i - 1), eeprom_read_byte((const uint8_t *)(uintptr_t)(from + i - 1)));
+        }
+    }
+}
+
+static inline uint16_t kept_bytes(const eeprom_schema_region_t *stored, const eeprom_schema_region_t *current) {
+    return stored->size < current->size ? stored->size : current->size;
+}
+
+bool eeprom_schema_is_valid(const void *table, uint8_t count) {
+    return eeprom_read_word((const uint16_t *)table) == EEPROM_SCHEMA_MAGIC && eeprom_read_byte((const uint8_t *)table + 2) == count;
+}
+
+void eeprom_schema_invalidate(void *table) {
+    eeprom_update_word((uint16_t *)table, 0xFFFF);
+}
+
+void eeprom_schema_save(void *table, const eeprom_schema_region_t *regions, uint8_t count) {
+    eeprom_schema_invalidate(table);
+    eeprom_update_byte((uint8_t *)table + 2, count);
+    for (uint8_t i = 0; i < count; i++) {
+        write_entry(table, i, &regions[i]);
+    }
+    // Save the magic last, in case saving was interrupted
+    eeprom_update_word((uint16_t *)table, EEPROM_SCHEMA_MAGIC);
+}
+
+/** \brief Brings the stored regions in line with the current layout
+ *
+ * Regions are laid out back to back in a fixed order, so moving the ones that
+ * shift down in ascending order and then the ones that shift up in descending
+ * order never overwrites data that has yet to be moved. Defaults are only
+ * written once every region is in place.
+ *
+ * Returns false if there is no usable table, in which case nothing is touched
+ * and the caller has to fall back to a full reset.
+ */
+bool eeprom_schema_migrate(void *table, const eeprom_schema_region_t *regions, uint8_t count, eeprom_schema_reset_t reset, eeprom_schema_convert_t convert) {
+    if (!eeprom_schema_is_valid(table, count)) return false;
+
+    // an interrupted migration leaves a half moved layout, make sure it gets reset next time
+    eeprom_schema_invalidate(table);
+
+    for (uint8_t i = 0; i < count; i++) {
+        eeprom_schema_region_t const stored = read_entry(table, i);
+        if (regions[i].addr <= stored.addr) move_region(stored.addr, regions[i].addr, kept_bytes(&stored, &regions[i]));
+    }
+    for (uint8_t i = count; i > 0; i--) {
+        eeprom_schema_region_t const stored = read_entry(table, i - 1);
+        if (regions[i - 1].addr > stored.addr) move_region(stored.addr, regions[i - 1].addr, kept_bytes(&stored, &regions[i - 1]));
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        eeprom_schema_region_t const  stored  = read_entry(table, i);
+        eeprom_schema_region_t const *current = &regions[i];
+        if (current->size == 0) continue;
+
+        if (stored.version != current->version || stored.stride != current->stride) {
+            if (!convert || !convert(i, stored.version, stored.stride, stored.size)) reset(i, 0);
+            continue;
+        }
+        // records that did not exist before get their defaults
+        uint16_t kept = kept_bytes(&stored, current);
+        if (current->stride > 1) kept -= kept % current->stride;
+        if (kept < current->size) reset(i, kept);
+    }
+
+    eeprom_schema_save(table, regions, count);
+    return true;
+}
@@ -0,0 +1,54 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* EEPROM schema table
+ *
+ * Records where each EEPROM region lives, how large it is, the size of one
+ * record within it and the version of its record format. On a firmware update
+ * the stored table is compared against the current layout, and only regions
+ * that changed are relocated, converted or reset, instead of wiping everything.
+ *
+ * Table layout: magic (2 bytes), region count (1 byte), then per region
+ * addr (2), size (2), stride (2) and version (1).
+ */
+
+#define EEPROM_SCHEMA_MAGIC 0x5E3A
+#define EEPROM_SCHEMA_TABLE_SIZE(count) (3 + (count)*7)
+
+typedef struct {
+    uint16_t addr;
+    uint16_t size;
+    uint16_t stride;
+    uint8_t  version;
+} eeprom_schema_region_t;
+
+/* Resets the records of region from byte offset onwards to their defaults. */
+typedef void (*eeprom_schema_reset_t)(uint8_t region, uint16_t offset);
+
+/* Converts a region whose stored version or stride differs from the current
+ * one. The first min(old size, new size) bytes have already been copied to the
+ * region's new address. Returns false to have the whole region reset instead. */
+typedef bool (*eeprom_schema_convert_t)(uint8_t region, uint8_t version, uint16_t stride, uint16_t size);
+
+bool eeprom_schema_is_valid(const void *table, uint8_t count);
+bool eeprom_schema_migrate(void *table, const eeprom_schema_region_t *regions, uint8_t count, eeprom_schema_reset_t reset, eeprom_schema_convert_t convert);
+void eeprom_schema_save(void *table, const eeprom_schema_region_t *regions, uint8_t count);
+void eeprom_schema_invalidate(void *table);
@@ -0,0 +1,198 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+extern "C" {
+#include "eeprom.h"
+#include "eeprom_schema.h"
+}
+
+#define TABLE ((void *)900)
+#define FILL 0xEE
+
+static std::vector<std::pair<uint8_t, uint16_t>> resets;
+static std::vector<uint8_t>                      converts;
+static bool                                      convert_result;
+
+static const eeprom_schema_region_t *current_layout;
+
+extern "C" {
+static void reset_region(uint8_t region, uint16_t offset) {
+    resets.push_back({region, offset});
+    const eeprom_schema_region_t *r = &current_layout[region];
+    for (uint16_t i = offset; i < r->size; i++) {
+        eeprom_update_byte((uint8_t *)(uintptr_t)(r->addr + i), FILL);
+    }
+}
+
+static bool convert_region(uint8_t region, uint8_t version, uint16_t stride, uint16_t size) {
+    converts.push_back(region);
+    return convert_result;
+}
+}
+
+class EepromSchema : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        for (uint16_t i = 0; i < TOTAL_EEPROM_BYTE_COUNT; i++) {
+            eeprom_write_byte((uint8_t *)(uintptr_t)i, 0xFF);
+        }
+        resets.clear();
+        converts.clear();
+        convert_result = true;
+    }
+
+    /* Fills every region with bytes that encode the region and position, and stores the table */
+    void install(const eeprom_schema_region_t *layout, uint8_t count) {
+        for (uint8_t r = 0; r < count; r++) {
+            for (uint16_t i = 0; i < layout[r].size; i++) {
+                eeprom_write_byte((uint8_t *)(uintptr_t)(layout[r].addr + i), pattern(r, i));
+            }
+        }
+        eeprom_schema_save(TABLE, layout, count);
+    }
+
+    bool migrate(const eeprom_schema_region_t *layout, uint8_t count) {
+        current_layout = layout;
+        return eeprom_schema_migrate(TABLE, layout, count, reset_region, convert_region);
+    }
+
+    static uint8_t pattern(uint8_t region, uint16_t i) {
+        return (region << 5) ^ (i * 7);
+    }
+
+    static uint8_t at(uint16_t addr) {
+        return eeprom_read_byte((const uint8_t *)(uintptr_t)addr);
+    }
+};
+
+TEST_F(EepromSchema, NoTableIsNotMigrated) {
+    const eeprom_schema_region_t layout[] = {{0, 16, 2, 1}};
+    EXPECT_FALSE(migrate(layout, 1));
+    EXPECT_TRUE(resets.empty());
+    EXPECT_FALSE(eeprom_schema_is_valid(TABLE, 1));
+}
+
+TEST_F(EepromSchema, RegionCountChangeIsNotMigrated) {
+    const eeprom_schema_region_t old_layout[] = {{0, 16, 2, 1}};
+    const eeprom_schema_region_t new_layout[] = {{0, 16, 2, 1}, {16, 8, 1, 1}};
+    install(old_layout, 1);
+    EXPECT_FALSE(migrate(new_layout, 2));
+}
+
+TEST_F(EepromSchema, UnchangedLayoutKeepsEverything) {
+    const eeprom_schema_region_t layout[] = {{0, 16, 2, 1}, {16, 10, 5, 1}, {26, 30, 1, 1}};
+    install(layout, 3);
+    EXPECT_TRUE(migrate(layout, 3));
+    EXPECT_TRUE(resets.empty());
+    EXPECT_TRUE(converts.empty());
+    for (uint8_t r = 0; r < 3; r++) {
+        for (uint16_t i = 0; i < layout[r].size; i++) {
+            EXPECT_EQ(at(layout[r].addr + i), pattern(r, i));
+        }
+    }
+    EXPECT_TRUE(eeprom_schema_is_valid(TABLE, 3));
+}
+
+TEST_F(EepromSchema, GrownRegionShiftsFollowingRegionsUp) {
+    const eeprom_schema_region_t old_layout[] = {{0, 16, 2, 1}, {16, 10, 5, 1}, {26, 30, 1, 1}};
+    const eeprom_schema_region_t new_layout[] = {{0, 24, 2, 1}, {24, 10, 5, 1}, {34, 22, 1, 1}};
+    install(old_layout, 3);
+    EXPECT_TRUE(migrate(new_layout, 3));
+
+    ASSERT_EQ(resets.size(), 1u);
+    EXPECT_EQ(resets[0], std::make_pair((uint8_t)0, (uint16_t)16));
+    for (uint16_t i = 0; i < 16; i++) EXPECT_EQ(at(i), pattern(0, i));
+    for (uint16_t i = 16; i < 24; i++) EXPECT_EQ(at(i), FILL);
+    for (uint16_t i = 0; i < 10; i++) EXPECT_EQ(at(24 + i), pattern(1, i));
+    // the last region is truncated
+    for (uint16_t i = 0; i < 22; i++) EXPECT_EQ(at(34 + i), pattern(2, i));
+}
+
+TEST_F(EepromSchema, ShrunkRegionShiftsFollowingRegionsDown) {
+    const eeprom_schema_region_t old_layout[] = {{0, 24, 2, 1}, {24, 10, 5, 1}, {34, 22, 1, 1}};
+    const eeprom_schema_region_t new_layout[] = {{0, 16, 2, 1}, {16, 10, 5, 1}, {26, 30, 1, 1}};
+    install(old_layout, 3);
+    EXPECT_TRUE(migrate(new_layout, 3));
+
+    ASSERT_EQ(resets.size(), 1u);
+    EXPECT_EQ(resets[0], std::make_pair((uint8_t)2, (uint16_t)22));
+    for (uint16_t i = 0; i < 16; i++) EXPECT_EQ(at(i), pattern(0, i));
+    for (uint16_t i = 0; i < 10; i++) EXPECT_EQ(at(16 + i), pattern(1, i));
+    for (uint16_t i = 0; i < 22; i++) EXPECT_EQ(at(26 + i), pattern(2, i));
+    for (uint16_t i = 22; i < 30; i++) EXPECT_EQ(at(26 + i), FILL);
+}
+
+TEST_F(EepromSchema, MixedMovesDoNotClobberNeighbours) {
+    // first region shrinks, second grows: one moves down while the other moves up
+    const eeprom_schema_region_t old_layout[] = {{0, 20, 2, 1}, {20, 10, 5, 1}, {30, 10, 1, 1}, {40, 20, 1, 1}};
+    const eeprom_schema_region_t new_layout[] = {{0, 10, 2, 1}, {10, 25, 5, 1}, {35, 10, 1, 1}, {45, 15, 1, 1}};
+    install(old_layout, 4);
+    EXPECT_TRUE(migrate(new_layout, 4));
+
+    for (uint16_t i = 0; i < 10; i++) EXPECT_EQ(at(i), pattern(0, i));
+    for (uint16_t i = 0; i < 10; i++) EXPECT_EQ(at(10 + i), pattern(1, i));
+    for (uint16_t i = 10; i < 25; i++) EXPECT_EQ(at(10 + i), FILL);
+    for (uint16_t i = 0; i < 10; i++) EXPECT_EQ(at(35 + i), pattern(2, i));
+    for (uint16_t i = 0; i < 15; i++) EXPECT_EQ(at(45 + i), pattern(3, i));
+}
+
+TEST_F(EepromSchema, PartialRecordIsReset) {
+    const eeprom_schema_region_t old_layout[] = {{0, 12, 4, 1}, {12, 8, 1, 1}};
+    const eeprom_schema_region_t new_layout[] = {{0, 10, 4, 1}, {10, 8, 1, 1}};
+    install(old_layout, 2);
+    EXPECT_TRUE(migrate(new_layout, 2));
+
+    // only two whole records fit, the trailing half record gets defaults
+    ASSERT_EQ(resets.size(), 1u);
+    EXPECT_EQ(resets[0], std::make_pair((uint8_t)0, (uint16_t)8));
+    for (uint16_t i = 0; i < 8; i++) EXPECT_EQ(at(i), pattern(0, i));
+    for (uint16_t i = 0; i < 8; i++) EXPECT_EQ(at(10 + i), pattern(1, i));
+}
+
+TEST_F(EepromSchema, VersionChangeIsConverted) {
+    const eeprom_schema_region_t old_layout[] = {{0, 16, 2, 1}, {16, 10, 5, 1}};
+    const eeprom_schema_region_t new_layout[] = {{0, 16, 2, 1}, {16, 10, 5, 2}};
+    install(old_layout, 2);
+    EXPECT_TRUE(migrate(new_layout, 2));
+
+    ASSERT_EQ(converts.size(), 1u);
+    EXPECT_EQ(converts[0], 1);
+    EXPECT_TRUE(resets.empty());
+}
+
+TEST_F(EepromSchema, FailedConversionResetsOnlyThatRegion) {
+    const eeprom_schema_region_t old_layout[] = {{0, 16, 2, 1}, {16, 10, 5, 1}};
+    const eeprom_schema_region_t new_layout[] = {{0, 16, 2, 1}, {16, 12, 6, 1}};
+    install(old_layout, 2);
+    convert_result = false;
+    EXPECT_TRUE(migrate(new_layout, 2));
+
+    ASSERT_EQ(resets.size(), 1u);
+    EXPECT_EQ(resets[0], std::make_pair((uint8_t)1, (uint16_t)0));
+    for (uint16_t i = 0; i < 16; i++) EXPECT_EQ(at(i), pattern(0, i));
+    for (uint16_t i = 0; i < 12; i++) EXPECT_EQ(at(16 + i), FILL);
+}
+
+TEST_F(EepromSchema, InvalidatedTableIsNotMigrated) {
+    const eeprom_schema_region_t layout[] = {{0, 16, 2, 1}};
+    install(layout, 1);
+    eeprom_schema_invalidate(TABLE);
+    EXPECT_FALSE(migrate(layout, 1));
+}
@@ -0,0 +1,8 @@
+eeprom_schema_DEFS := -DEEPROM_TEST_HARNESS -DTOTAL_EEPROM_BYTE_COUNT=1024 -DNO_PRINT
+
+eeprom_schema_INC := $(QUANTUM_PATH)/eeprom_schema
+
+eeprom_schema_SRC := \
+	$(QUANTUM_PATH)/eeprom_schema/tests/eeprom_schema_tests.cpp \
+	$(QUANTUM_PATH)/eeprom_schema/eeprom_schema.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/eeprom.c
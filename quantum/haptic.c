@@ -315,13 +315,21 @@ void haptic_cont_decrease(void) {
 }
 
 void haptic_play(void) {
+    haptic_play_channel(0);
+}
+
+/** \brief Play the feedback of the haptic settings, on one of several solenoids
+ *
+ * A DRV2605L has a single actuator, and plays it whatever the channel.
+ */
+void haptic_play_channel(uint8_t channel) {
 #ifdef DRV2605L
     uint8_t play_eff = 0;
     play_eff         = haptic_config.mode;
     DRV_pulse(play_eff);
 #endif
 #ifdef SOLENOID_ENABLE
-    solenoid_fire();
+    solenoid_fire_channel(channel);
 #endif
 }
 
@@ -74,6 +74,7 @@ void    haptic_cont_increase(void);
 void    haptic_cont_decrease(void);
 
 void haptic_play(void);
+void haptic_play_channel(uint8_t channel);
 void haptic_shutdown(void);
 void haptic_notify_usb_device_state_change(void);
 
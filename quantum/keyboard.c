@@ -84,6 +84,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef VIA_ENABLE
 #    include "via.h"
 #endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#    include "dynamic_keymap.h"
+#endif
 #ifdef DIP_SWITCH_ENABLE
 #    include "dip_switch.h"
 #endif
@@ -539,7 +542,7 @@ void quantum_task(void) {
     }
 #endif
 
-#if defined(AUDIO_ENABLE) && !defined(NO_MUSIC_MODE)
+#if (defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))) && !defined(NO_MUSIC_MODE)
     music_task();
 #endif
 
@@ -674,5 +677,17 @@ void keyboard_task(void) {
     programmable_button_send();
 #endif
 
+#ifdef VIA_ENABLE
+    via_task();
+#endif
+
+#ifdef VIAL_ENABLE
+    vial_task();
+#endif
+
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    dynamic_keymap_macro_task();
+#endif
+
     led_task();
 }
@@ -23,7 +23,15 @@ extern keymap_config_t keymap_config;
  * This function is used to check a specific keycode against the bootmagic config,
  * and will return the corrected keycode, when appropriate.
  */
-uint16_t keycode_config(uint16_t keycode) {
+/* Basic keycodes as remapped by the magic swaps and any custom remaps. Built on first use
+ * and again whenever keymap_config has changed since, or keycode_config_invalidate()
+ * was called, so each press and release is a single lookup.
+ */
+static uint8_t  keycode_remap[256];
+static uint16_t keycode_remap_config;
+static bool     keycode_remap_valid = false;
+
+static uint8_t keycode_config_magic(uint8_t keycode) {
     switch (keycode) {
         case KC_CAPS_LOCK:
         case KC_LOCKING_CAPS_LOCK:
@@ -113,6 +121,41 @@ uint16_t keycode_config(uint16_t keycode) {
     }
 }
 
+__attribute__((weak)) bool keycode_remap_get(uint8_t index, uint8_t *from, uint8_t *to) {
+    return false;
+}
+
+void keycode_config_invalidate(void) {
+    keycode_remap_valid = false;
+}
+
+static void keycode_remap_build(void) {
+    for (uint16_t keycode = 0; keycode < sizeof(keycode_remap); keycode++) {
+        keycode_remap[keycode] = keycode_config_magic(keycode);
+    }
+
+    // custom remaps take precedence over the magic swaps
+    uint8_t from, to;
+    for (uint8_t i = 0; i < UINT8_MAX && keycode_remap_get(i, &from, &to); i++) {
+        if (from != KC_NO) {
+            keycode_remap[from] = to;
+        }
+    }
+
+    keycode_remap_config = keymap_config.raw;
+    keycode_remap_valid  = true;
+}
+
+uint16_t keycode_config(uint16_t keycode) {
+    if (keycode > 0xFF) {
+        return keycode;
+    }
+    if (!keycode_remap_valid || keycode_remap_config != keymap_config.raw) {
+        keycode_remap_build();
+    }
+    return keycode_remap[keycode];
+}
+
 /** \brief mod_config
  *
  *  This function checks the mods passed to it against the bootmagic config,
@@ -23,6 +23,12 @@
 uint16_t keycode_config(uint16_t keycode);
 uint8_t  mod_config(uint8_t mod);
 
+// Custom basic keycode remaps, applied on top of the magic swaps. Fills in the
+// remap at index and returns true, or returns false past the last one.
+bool keycode_remap_get(uint8_t index, uint8_t *from, uint8_t *to);
+// Has the remap table rebuilt on next use, after the custom remaps changed
+void keycode_config_invalidate(void);
+
 /* NOTE: Not portable. Bit field order depends on implementation */
 typedef union {
     uint16_t raw;
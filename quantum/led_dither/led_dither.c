@@ -0,0 +1,62 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "led_dither.h"
+#include "led_tables.h"
+
+/** \brief Driver value for the next frame
+ *
+ * `error` holds the fraction not shown yet, and must be kept per LED (and per channel) between frames.
+ */
+uint8_t led_dither_step(uint16_t value, uint8_t *error) {
+    if (value >= LED_DITHER_MAX) {
+        *error = 0;
+        return UINT8_MAX;
+    }
+
+    uint16_t sum = value + *error;
+
+    *error = sum & 0xFF;
+    return sum >> 8;
+}
+
+/** \brief Nearest driver value, for when dithering is disabled
+ */
+uint8_t led_dither_round(uint16_t value) {
+    if (value >= LED_DITHER_MAX - 0x80) {
+        return UINT8_MAX;
+    }
+    return (value + 0x80) >> 8;
+}
+
+#ifdef USE_CIE1931_CURVE
+/** \brief Apply the CIE 1931 curve to an 8.8 fixed point intensity
+ *
+ * Interpolates between the table entries, so the steps the 8 bit curve collapses at the low end stay apart.
+ */
+uint16_t led_dither_cie1931(uint16_t value) {
+    if (value >= LED_DITHER_MAX) {
+        return LED_DITHER_MAX;
+    }
+
+    uint8_t index    = value >> 8;
+    uint8_t fraction = value & 0xFF;
+    uint8_t low      = pgm_read_byte(&CIE1931_CURVE[index]);
+    uint8_t high     = pgm_read_byte(&CIE1931_CURVE[index + 1]);
+
+    return ((uint16_t)low << 8) + (high - low) * fraction;
+}
+#endif
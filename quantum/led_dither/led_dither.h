@@ -0,0 +1,39 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * High precision LED intensities are 8.8 fixed point: the high byte is the driver PWM value and
+ * the low byte the fraction of a step in between. LED_DITHER_MAX is full brightness.
+ *
+ * The driver only takes the high byte, so each frame led_dither_step() rounds the intensity up or
+ * down and carries the rounding error over to the next frame. Averaged over the frames, the LED
+ * shows the intensity between the two PWM values.
+ */
+#define LED_DITHER_MAX 0xFF00
+
+// 8 bit value to 8.8 fixed point
+#define LED_DITHER_FROM_8BIT(value) ((uint16_t)(value) << 8)
+
+uint8_t led_dither_step(uint16_t value, uint8_t *error);
+uint8_t led_dither_round(uint16_t value);
+
+#ifdef USE_CIE1931_CURVE
+uint16_t led_dither_cie1931(uint16_t value);
+#endif
@@ -0,0 +1,99 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "led_dither.h"
+#include "led_tables.h"
+}
+
+// Sum of the driver values shown over `frames` frames
+static uint32_t integrate(uint16_t value, uint32_t frames, uint8_t *error) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        sum += led_dither_step(value, error);
+    }
+    return sum;
+}
+
+TEST(LedDither, AverageMatchesValue) {
+    for (uint32_t value = 0; value <= LED_DITHER_MAX; value += 37) {
+        uint8_t error = 0;
+        // 256 frames add up to exactly the 8.8 value
+        EXPECT_EQ(integrate(value, 256, &error), value) << "value " << value;
+        EXPECT_EQ(error, 0);
+    }
+}
+
+TEST(LedDither, AverageMatchesValueOverAnyFrames) {
+    const uint16_t values[] = {1, 0x80, 0x155, 0x3FF, 0x1234, 0x7F01, 0xFEFF};
+    for (auto value : values) {
+        for (uint32_t frames = 1; frames <= 1000; frames += 7) {
+            uint8_t  error = 0;
+            uint32_t sum   = integrate(value, frames, &error);
+            // Within one driver step of the exact intensity, however many frames are integrated
+            EXPECT_LT(abs((int32_t)(sum * 256) - (int32_t)(value * frames)), 256) << "value " << value << " frames " << frames;
+        }
+    }
+}
+
+TEST(LedDither, OnlyTheTwoNearestDriverValues) {
+    for (uint32_t value = 0; value <= LED_DITHER_MAX; value += 101) {
+        uint8_t error = 0;
+        for (int i = 0; i < 300; i++) {
+            uint8_t out = led_dither_step(value, &error);
+            EXPECT_GE(out, value >> 8);
+            EXPECT_LE(out, (value + 0xFF) >> 8);
+        }
+    }
+}
+
+TEST(LedDither, Limits) {
+    uint8_t error = 0;
+    EXPECT_EQ(integrate(0, 100, &error), 0);
+    EXPECT_EQ(integrate(LED_DITHER_MAX, 100, &error), 100 * 255);
+    EXPECT_EQ(integrate(0xFFFF, 100, &error), 100 * 255);
+    EXPECT_EQ(led_dither_round(0), 0);
+    EXPECT_EQ(led_dither_round(0x17F), 1);
+    EXPECT_EQ(led_dither_round(0x180), 2);
+    EXPECT_EQ(led_dither_round(0xFFFF), 255);
+}
+
+TEST(LedDither, SlowFadeIsSmooth) {
+    // Fade the bottom 4 driver steps in over 4096 frames, the average follows the target frame by frame
+    uint8_t error = 0;
+    int64_t shown = 0, target = 0;
+    for (uint32_t frame = 0; frame < 4096; frame++) {
+        uint16_t value = frame / 4;
+        shown += led_dither_step(value, &error) * 256;
+        target += value;
+        EXPECT_LT(llabs(shown - target), 256) << "frame " << frame;
+    }
+}
+
+TEST(LedDither, Cie1931MatchesTable) {
+    for (int i = 0; i < 256; i++) {
+        EXPECT_EQ(led_dither_cie1931(LED_DITHER_FROM_8BIT(i)), pgm_read_byte(&CIE1931_CURVE[i]) << 8);
+    }
+    uint16_t last = 0;
+    for (uint32_t value = 0; value <= LED_DITHER_MAX; value++) {
+        uint16_t curved = led_dither_cie1931(value);
+        EXPECT_GE(curved, last);
+        last = curved;
+    }
+    EXPECT_EQ(led_dither_cie1931(0xFFFF), LED_DITHER_MAX);
+}
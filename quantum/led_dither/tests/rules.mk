@@ -0,0 +1,8 @@
+led_dither_DEFS := -DUSE_CIE1931_CURVE
+
+led_dither_INC := $(QUANTUM_PATH)/led_dither
+
+led_dither_SRC := \
+	$(QUANTUM_PATH)/led_dither/tests/led_dither_tests.cpp \
+	$(QUANTUM_PATH)/led_dither/led_dither.c \
+	$(QUANTUM_PATH)/led_tables.c
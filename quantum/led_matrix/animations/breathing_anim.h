@@ -5,12 +5,13 @@ LED_MATRIX_EFFECT(BREATHING)
 bool BREATHING(effect_params_t* params) {
     LED_MATRIX_USE_LIMITS(led_min, led_max);
 
-    uint8_t  val  = led_matrix_eeconfig.val;
-    uint16_t time = scale16by8(g_led_timer, led_matrix_eeconfig.speed / 8);
-    val           = scale8(abs8(sin8(time) - 128) * 2, val);
+    // Full 16 bit phase and wave, so the dim end of the breath does not step
+    uint16_t time = g_led_timer * (led_matrix_eeconfig.speed / 8);
+    uint16_t wave = abs(sin16(time)) * 2;
+    uint16_t val  = ((uint32_t)wave * led_matrix_eeconfig.val) >> 8;
     for (uint8_t i = led_min; i < led_max; i++) {
         LED_MATRIX_TEST_LED_FLAGS();
-        led_matrix_set_value(i, val);
+        led_matrix_set_value16(i, val);
     }
     return led_matrix_check_finished_leds(led_max);
 }
@@ -24,6 +24,7 @@
 #include <string.h>
 #include <math.h>
 #include "led_tables.h"
+#include "led_dither.h"
 
 #include <lib/lib8tion/lib8tion.h>
 
@@ -96,6 +97,10 @@ uint8_t g_led_frame_buffer[MATRIX_ROWS][MATRIX_COLS] = {{0}};
 #ifdef LED_MATRIX_KEYREACTIVE_ENABLED
 last_hit_t g_last_hit_tracker;
 #endif // LED_MATRIX_KEYREACTIVE_ENABLED
+#ifdef LED_MATRIX_DITHER
+static uint16_t led_dither_value[DRIVER_LED_TOTAL]; // 8.8 fixed point, after the CIE curve
+static uint8_t  led_dither_error[DRIVER_LED_TOTAL];
+#endif // LED_MATRIX_DITHER
 
 // internals
 static bool            suspend_state     = false;
@@ -158,6 +163,11 @@ uint8_t led_matrix_map_row_column_to_led(uint8_t row, uint8_t column, uint8_t *l
 }
 
 void led_matrix_update_pwm_buffers(void) {
+#ifdef LED_MATRIX_DITHER
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        led_matrix_driver.set_value(i, led_dither_step(led_dither_value[i], &led_dither_error[i]));
+    }
+#endif
     led_matrix_driver.flush();
 }
 
@@ -165,11 +175,35 @@ void led_matrix_set_value(int index, uint8_t value) {
 #ifdef USE_CIE1931_CURVE
     value = pgm_read_byte(&CIE1931_CURVE[value]);
 #endif
+#ifdef LED_MATRIX_DITHER
+    if (index >= 0 && index < DRIVER_LED_TOTAL) {
+        led_dither_value[index] = LED_DITHER_FROM_8BIT(value);
+    }
+#else
     led_matrix_driver.set_value(index, value);
+#endif
+}
+
+/** \brief Set an LED to an 8.8 fixed point value
+ *
+ * With LED_MATRIX_DITHER, the fraction is shown by dithering over the following frames. Without it,
+ * the value is rounded.
+ */
+void led_matrix_set_value16(int index, uint16_t value) {
+#ifdef USE_CIE1931_CURVE
+    value = led_dither_cie1931(value);
+#endif
+#ifdef LED_MATRIX_DITHER
+    if (index >= 0 && index < DRIVER_LED_TOTAL) {
+        led_dither_value[index] = value;
+    }
+#else
+    led_matrix_driver.set_value(index, led_dither_round(value));
+#endif
 }
 
 void led_matrix_set_value_all(uint8_t value) {
-#if defined(LED_MATRIX_ENABLE) && defined(LED_MATRIX_SPLIT)
+#if (defined(LED_MATRIX_ENABLE) && defined(LED_MATRIX_SPLIT)) || defined(LED_MATRIX_DITHER)
     for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++)
         led_matrix_set_value(i, value);
 #else
@@ -108,6 +108,7 @@ uint8_t led_matrix_map_row_column_to_led_kb(uint8_t row, uint8_t column, uint8_t
 uint8_t led_matrix_map_row_column_to_led(uint8_t row, uint8_t column, uint8_t *led_i);
 
 void led_matrix_set_value(int index, uint8_t value);
+void led_matrix_set_value16(int index, uint16_t value);
 void led_matrix_set_value_all(uint8_t value);
 
 void process_led_matrix(uint8_t row, uint8_t col, bool pressed);
@@ -32,6 +32,13 @@ inline int8_t times_inv_sqrt2(int8_t x) {
     return (x * 181) >> 8;
 }
 
+#ifdef MK_FIXED_POINT
+static inline uint32_t times_inv_sqrt2_fp(uint32_t x) {
+    // same 181/256 approximation without overflowing large fixed-point speeds
+    return (x >> 8) * 181 + (((x & 0xFF) * 181) >> 8);
+}
+#endif
+
 static report_mouse_t mouse_report = {0};
 static void           mousekey_debug(void);
 static uint8_t        mousekey_accel        = 0;
@@ -41,7 +48,223 @@ static uint8_t        mousekey_wheel_repeat = 0;
 static uint16_t mouse_timer = 0;
 #endif
 
-#ifndef MK_3_SPEED
+#if defined(MK_FIXED_POINT)
+
+/*
+ * Fixed-point motion engine
+ *
+ *  Speeds are kept in MOUSEKEY_FP_SHIFT fixed-point units per millisecond and
+ *  ramp linearly from the initial speed (one step per interval) to the maximum
+ *  speed over time_to_max intervals. The travelled distance is integrated
+ *  exactly from the elapsed time whenever a report is due, and the sub-unit
+ *  remainder of each axis is carried into the next report, so the trajectory
+ *  does not depend on how often mousekey_task() runs.
+ */
+#    define MOUSEKEY_FP_ONE ((uint32_t)1 << MOUSEKEY_FP_SHIFT)
+/* longest gap integrated in one go, keeps the distance math inside 32 bits */
+#    define MOUSEKEY_FP_MAX_STEP 1000
+
+uint8_t mk_delay             = MOUSEKEY_DELAY / 10;
+uint8_t mk_interval          = MOUSEKEY_INTERVAL;
+uint8_t mk_max_speed         = MOUSEKEY_MAX_SPEED;
+uint8_t mk_time_to_max       = MOUSEKEY_TIME_TO_MAX;
+uint8_t mk_wheel_delay       = MOUSEKEY_WHEEL_DELAY / 10;
+uint8_t mk_wheel_interval    = MOUSEKEY_WHEEL_INTERVAL;
+uint8_t mk_wheel_max_speed   = MOUSEKEY_WHEEL_MAX_SPEED;
+uint8_t mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
+
+typedef struct {
+    uint32_t start;  // time at which motion starts, after the initial delay
+    uint32_t last;   // ms since start up to which motion has been integrated
+    uint32_t rem[2]; // sub-unit remainder of each axis
+} mousekey_motion_t;
+
+/* held directions, -1, 0 or 1 per axis */
+static report_mouse_t    mousekey_held = {0};
+static mousekey_motion_t motion_c      = {0};
+static mousekey_motion_t motion_w      = {0};
+static uint32_t          last_report   = 0;
+
+/* speed at time t into a linear ramp from v0 to vmax, floor of the exact value */
+static uint32_t ramp_speed(uint32_t t, uint32_t v0, uint32_t vmax, uint32_t ramp) {
+    uint32_t const dv = vmax - v0;
+    return v0 + (dv / ramp) * t + (dv % ramp) * t / ramp;
+}
+
+/* distance covered between t0 and t1 ms into the motion */
+static uint32_t motion_distance(uint32_t t0, uint32_t t1, uint32_t v0, uint32_t vmax, uint32_t ramp) {
+    uint32_t dist = 0;
+    if (vmax > v0 && t0 < ramp) {
+        uint32_t const end = t1 < ramp ? t1 : ramp;
+        // trapezoid is exact for a linear ramp
+        dist += (ramp_speed(t0, v0, vmax, ramp) + ramp_speed(end, v0, vmax, ramp)) * (end - t0) / 2;
+        t0 = end;
+    }
+    return dist + vmax * (t1 - t0);
+}
+
+static void motion_start(mousekey_motion_t *motion, uint16_t delay) {
+    motion->start  = timer_read32() + delay;
+    motion->last   = 0;
+    motion->rem[0] = 0;
+    motion->rem[1] = 0;
+}
+
+/* integrate motion up to now and move whole units of each held axis into the report */
+static void motion_step(mousekey_motion_t *motion, uint32_t now, int8_t *a, int8_t *b, int8_t held_a, int8_t held_b, uint32_t v0, uint32_t vmax, uint32_t ramp, uint8_t max) {
+    if (!held_a && !held_b) return;
+    if (!timer_expired32(now, motion->start)) return;
+
+    // nothing faster than a full report per millisecond can be delivered anyway
+    if (vmax < v0) vmax = v0;
+    if (vmax > MOUSEKEY_FP_ONE * max) vmax = MOUSEKEY_FP_ONE * max;
+    if (v0 > vmax) v0 = vmax;
+
+    uint32_t t1 = now - motion->start;
+    if (t1 - motion->last > MOUSEKEY_FP_MAX_STEP) motion->last = t1 - MOUSEKEY_FP_MAX_STEP;
+
+    /* diagonal move [1/sqrt(2)] */
+    if (held_a && held_b) {
+        v0   = times_inv_sqrt2_fp(v0);
+        vmax = times_inv_sqrt2_fp(vmax);
+    }
+    uint32_t const dist = motion_distance(motion->last, t1, v0, vmax, ramp);
+    motion->last        = t1;
+
+    int8_t *const out[2]  = {a, b};
+    int8_t const  held[2] = {held_a, held_b};
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!held[i]) continue;
+        uint32_t units = (motion->rem[i] + dist) >> MOUSEKEY_FP_SHIFT;
+        motion->rem[i] += dist - (units << MOUSEKEY_FP_SHIFT);
+        if (units > max) {
+            // cap the backlog at one full report
+            units          = max;
+            motion->rem[i] = MOUSEKEY_FP_ONE * max;
+        }
+        *out[i] = units * held[i];
+    }
+}
+
+static uint32_t move_speed(uint8_t steps) {
+    if (mk_interval == 0) return (uint32_t)MOUSEKEY_MOVE_MAX << MOUSEKEY_FP_SHIFT;
+    return ((uint32_t)QS_mousekey_move_delta * steps << MOUSEKEY_FP_SHIFT) / mk_interval;
+}
+
+static uint32_t wheel_speed(uint8_t steps) {
+    if (mk_wheel_interval == 0) return (uint32_t)MOUSEKEY_WHEEL_MAX << MOUSEKEY_FP_SHIFT;
+    return ((uint32_t)MOUSEKEY_WHEEL_DELTA * steps << MOUSEKEY_FP_SHIFT) / mk_wheel_interval;
+}
+
+/* constant speed picked by the acceleration keys, 0 when none is held */
+static uint32_t accel_speed(uint32_t vmax) {
+    if (mousekey_accel & (1 << 0)) return vmax / 4;
+    if (mousekey_accel & (1 << 1)) return vmax / 2;
+    if (mousekey_accel & (1 << 2)) return vmax;
+    return 0;
+}
+
+void mousekey_task(void) {
+    uint32_t const now = timer_read32();
+    if (TIMER_DIFF_32(now, last_report) < MOUSEKEY_REPORT_INTERVAL) return;
+
+    uint32_t v0   = move_speed(1);
+    uint32_t vmax = move_speed(mk_max_speed);
+    uint32_t ramp = (uint32_t)mk_time_to_max * mk_interval;
+    if (mousekey_accel) v0 = vmax = accel_speed(vmax);
+    motion_step(&motion_c, now, &mouse_report.x, &mouse_report.y, mousekey_held.x, mousekey_held.y, v0, vmax, ramp, MOUSEKEY_MOVE_MAX);
+
+    v0   = wheel_speed(1);
+    vmax = wheel_speed(mk_wheel_max_speed);
+    ramp = (uint32_t)mk_wheel_time_to_max * mk_wheel_interval;
+    if (mousekey_accel) v0 = vmax = accel_speed(vmax);
+    motion_step(&motion_w, now, &mouse_report.v, &mouse_report.h, mousekey_held.v, mousekey_held.h, v0, vmax, ramp, MOUSEKEY_WHEEL_MAX);
+
+    if (mouse_report.x || mouse_report.y || mouse_report.v || mouse_report.h) mousekey_send();
+}
+
+static void mousekey_hold(int8_t *held, int8_t other, int8_t dir, mousekey_motion_t *motion, uint8_t axis, int8_t *out, uint8_t step, uint16_t delay) {
+    if (!*held && !other) motion_start(motion, delay);
+    if (*held != dir) motion->rem[axis] = 0;
+    *held = dir;
+    *out  = step * dir;
+}
+
+void mousekey_on(uint8_t code) {
+    if (code == KC_MS_UP)
+        mousekey_hold(&mousekey_held.y, mousekey_held.x, -1, &motion_c, 1, &mouse_report.y, QS_mousekey_move_delta, mk_delay * 10);
+    else if (code == KC_MS_DOWN)
+        mousekey_hold(&mousekey_held.y, mousekey_held.x, 1, &motion_c, 1, &mouse_report.y, QS_mousekey_move_delta, mk_delay * 10);
+    else if (code == KC_MS_LEFT)
+        mousekey_hold(&mousekey_held.x, mousekey_held.y, -1, &motion_c, 0, &mouse_report.x, QS_mousekey_move_delta, mk_delay * 10);
+    else if (code == KC_MS_RIGHT)
+        mousekey_hold(&mousekey_held.x, mousekey_held.y, 1, &motion_c, 0, &mouse_report.x, QS_mousekey_move_delta, mk_delay * 10);
+    else if (code == KC_MS_WH_UP)
+        mousekey_hold(&mousekey_held.v, mousekey_held.h, 1, &motion_w, 0, &mouse_report.v, MOUSEKEY_WHEEL_DELTA, mk_wheel_delay * 10);
+    else if (code == KC_MS_WH_DOWN)
+        mousekey_hold(&mousekey_held.v, mousekey_held.h, -1, &motion_w, 0, &mouse_report.v, MOUSEKEY_WHEEL_DELTA, mk_wheel_delay * 10);
+    else if (code == KC_MS_WH_LEFT)
+        mousekey_hold(&mousekey_held.h, mousekey_held.v, -1, &motion_w, 1, &mouse_report.h, MOUSEKEY_WHEEL_DELTA, mk_wheel_delay * 10);
+    else if (code == KC_MS_WH_RIGHT)
+        mousekey_hold(&mousekey_held.h, mousekey_held.v, 1, &motion_w, 1, &mouse_report.h, MOUSEKEY_WHEEL_DELTA, mk_wheel_delay * 10);
+    else if (code == KC_MS_BTN1)
+        mouse_report.buttons |= MOUSE_BTN1;
+    else if (code == KC_MS_BTN2)
+        mouse_report.buttons |= MOUSE_BTN2;
+    else if (code == KC_MS_BTN3)
+        mouse_report.buttons |= MOUSE_BTN3;
+    else if (code == KC_MS_BTN4)
+        mouse_report.buttons |= MOUSE_BTN4;
+    else if (code == KC_MS_BTN5)
+        mouse_report.buttons |= MOUSE_BTN5;
+    else if (code == KC_MS_ACCEL0)
+        mousekey_accel |= (1 << 0);
+    else if (code == KC_MS_ACCEL1)
+        mousekey_accel |= (1 << 1);
+    else if (code == KC_MS_ACCEL2)
+        mousekey_accel |= (1 << 2);
+}
+
+void mousekey_off(uint8_t code) {
+    if (code == KC_MS_UP && mousekey_held.y < 0)
+        mousekey_held.y = 0;
+    else if (code == KC_MS_DOWN && mousekey_held.y > 0)
+        mousekey_held.y = 0;
+    else if (code == KC_MS_LEFT && mousekey_held.x < 0)
+        mousekey_held.x = 0;
+    else if (code == KC_MS_RIGHT && mousekey_held.x > 0)
+        mousekey_held.x = 0;
+    else if (code == KC_MS_WH_UP && mousekey_held.v > 0)
+        mousekey_held.v = 0;
+    else if (code == KC_MS_WH_DOWN && mousekey_held.v < 0)
+        mousekey_held.v = 0;
+    else if (code == KC_MS_WH_LEFT && mousekey_held.h < 0)
+        mousekey_held.h = 0;
+    else if (code == KC_MS_WH_RIGHT && mousekey_held.h > 0)
+        mousekey_held.h = 0;
+    else if (code == KC_MS_BTN1)
+        mouse_report.buttons &= ~MOUSE_BTN1;
+    else if (code == KC_MS_BTN2)
+        mouse_report.buttons &= ~MOUSE_BTN2;
+    else if (code == KC_MS_BTN3)
+        mouse_report.buttons &= ~MOUSE_BTN3;
+    else if (code == KC_MS_BTN4)
+        mouse_report.buttons &= ~MOUSE_BTN4;
+    else if (code == KC_MS_BTN5)
+        mouse_report.buttons &= ~MOUSE_BTN5;
+    else if (code == KC_MS_ACCEL0)
+        mousekey_accel &= ~(1 << 0);
+    else if (code == KC_MS_ACCEL1)
+        mousekey_accel &= ~(1 << 1);
+    else if (code == KC_MS_ACCEL2)
+        mousekey_accel &= ~(1 << 2);
+    if (!mousekey_held.x) motion_c.rem[0] = 0;
+    if (!mousekey_held.y) motion_c.rem[1] = 0;
+    if (!mousekey_held.v) motion_w.rem[0] = 0;
+    if (!mousekey_held.h) motion_w.rem[1] = 0;
+}
+
+#elif !defined(MK_3_SPEED)
 
 static uint16_t last_timer_c = 0;
 static uint16_t last_timer_w = 0;
@@ -488,10 +711,20 @@ void mousekey_off(uint8_t code) {
 
 void mousekey_send(void) {
     mousekey_debug();
+#ifdef MK_FIXED_POINT
+    last_report = timer_read32();
+    host_mouse_send(&mouse_report);
+    // motion is consumed by the report, only the buttons are held in it
+    mouse_report.x = 0;
+    mouse_report.y = 0;
+    mouse_report.v = 0;
+    mouse_report.h = 0;
+#else
     uint16_t time = timer_read();
     if (mouse_report.x || mouse_report.y) last_timer_c = time;
     if (mouse_report.v || mouse_report.h) last_timer_w = time;
     host_mouse_send(&mouse_report);
+#endif
 }
 
 void mousekey_clear(void) {
@@ -499,6 +732,9 @@ void mousekey_clear(void) {
     mousekey_repeat       = 0;
     mousekey_wheel_repeat = 0;
     mousekey_accel        = 0;
+#ifdef MK_FIXED_POINT
+    mousekey_held = (report_mouse_t){0};
+#endif
 }
 
 static void mousekey_debug(void) {
@@ -20,6 +20,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdint.h>
 #include "host.h"
 
+#if defined(MK_FIXED_POINT) && (defined(MK_3_SPEED) || defined(MK_KINETIC_SPEED))
+#    error MK_FIXED_POINT cannot be combined with MK_3_SPEED or MK_KINETIC_SPEED
+#endif
+
 #ifndef MK_3_SPEED
 
 /* max value on report descriptor */
@@ -103,6 +107,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #        define MOUSEKEY_WHEEL_DECELERATED_MOVEMENTS 8
 #    endif
 
+#    ifdef MK_FIXED_POINT
+/* fractional bits of the fixed-point motion engine */
+#        ifndef MOUSEKEY_FP_SHIFT
+#            define MOUSEKEY_FP_SHIFT 12
+#        endif
+/* minimum time between motion reports, match it to the host polling rate */
+#        ifndef MOUSEKEY_REPORT_INTERVAL
+#            ifdef USB_POLLING_INTERVAL_MS
+#                define MOUSEKEY_REPORT_INTERVAL USB_POLLING_INTERVAL_MS
+#            else
+#                define MOUSEKEY_REPORT_INTERVAL 1
+#            endif
+#        endif
+#    endif
+
 #else /* #ifndef MK_3_SPEED */
 
 #    ifndef MK_C_OFFSET_UNMOD
@@ -0,0 +1,280 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "music_recording.h"
+#include "timer.h"
+
+#ifdef MUSIC_RECORDING_EEPROM_ADDR
+#    include "eeprom.h"
+#    include "eeconfig.h"
+
+#    define MUSIC_RECORDING_MAGIC 0x4D52
+
+// The dynamic keymap fills the EEPROM up to its max address, the recording has to come after it
+#    ifdef DYNAMIC_KEYMAP_ENABLE
+#        ifndef DYNAMIC_KEYMAP_EEPROM_MAX_ADDR
+#            error "MUSIC_RECORDING_EEPROM_ADDR needs DYNAMIC_KEYMAP_EEPROM_MAX_ADDR to leave room for the recording"
+#        else
+_Static_assert(MUSIC_RECORDING_EEPROM_ADDR > DYNAMIC_KEYMAP_EEPROM_MAX_ADDR, "MUSIC_RECORDING_EEPROM_ADDR overlaps the dynamic keymap");
+#        endif
+#    else
+_Static_assert(MUSIC_RECORDING_EEPROM_ADDR >= EECONFIG_SIZE, "MUSIC_RECORDING_EEPROM_ADDR overlaps the EECONFIG");
+#    endif
+_Static_assert(MUSIC_RECORDING_EEPROM_ADDR + MUSIC_RECORDING_SIZE + 8 <= TOTAL_EEPROM_BYTE_COUNT, "MUSIC_RECORDING_EEPROM_ADDR leaves no room for the recording");
+#endif
+
+#define MUSIC_EVENT_PRESSED 0x80
+#define MUSIC_EVENT_NOTE 0x7F // Notes are MIDI note numbers, 0 to 127
+
+// Longest event: a 32 bit delta takes 5 bytes, plus the note
+#define MUSIC_EVENT_MAX_SIZE 6
+
+static uint8_t  recording_buffer[MUSIC_RECORDING_SIZE];
+static uint16_t recording_head  = 0; // First byte of the oldest event
+static uint16_t recording_count = 0; // Bytes used
+static uint32_t recording_rest  = 0; // Time between the last event and the end of the recording
+static uint32_t recording_last  = 0; // Time of the last event
+static bool     recording       = false;
+
+/**
+ * Playback follows a song clock, advanced from the timer at the playback rate. Event times are
+ * accumulated from the recorded deltas, so events never drift however late music_task runs.
+ */
+static bool     playing           = false;
+static uint16_t playback_offset   = 0; // Offset of the next event from the head
+static uint32_t playback_next     = 0; // Song time of the next event
+static uint32_t playback_time     = 0; // Song time, in ms
+static uint32_t playback_anchor   = 0; // Timer value at which playback_time was last advanced
+static uint8_t  playback_fraction = 0; // Song time left over from the last rate scaling, in 1/100 ms
+static uint16_t playback_rate     = 100;
+
+static inline uint8_t recording_byte(uint16_t offset) {
+    return recording_buffer[(recording_head + offset) % MUSIC_RECORDING_SIZE];
+}
+
+static uint8_t read_delta(uint16_t offset, uint32_t *delta) {
+    uint8_t len   = 0;
+    uint8_t shift = 0;
+    uint8_t byte;
+
+    *delta = 0;
+    do {
+        byte = recording_byte(offset + len++);
+        *delta |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return len;
+}
+
+static uint8_t write_delta(uint8_t *data, uint32_t delta) {
+    uint8_t len = 0;
+    do {
+        data[len] = delta & 0x7F;
+        delta >>= 7;
+        if (delta) {
+            data[len] |= 0x80;
+        }
+        len++;
+    } while (delta);
+    return len;
+}
+
+static void drop_oldest_event(void) {
+    uint32_t delta;
+    uint16_t len = read_delta(0, &delta) + 1;
+
+    recording_head = (recording_head + len) % MUSIC_RECORDING_SIZE;
+    recording_count -= len;
+}
+
+void music_recording_start(void) {
+    playing         = false;
+    recording       = true;
+    recording_head  = 0;
+    recording_count = 0;
+    recording_rest  = 0;
+    recording_last  = timer_read32();
+}
+
+void music_recording_stop(void) {
+    if (!recording) {
+        return;
+    }
+    recording = false;
+
+    // Keep the loop from spinning on a recording of simultaneous events
+    recording_rest = timer_elapsed32(recording_last);
+    if (recording_rest == 0) {
+        recording_rest = 1;
+    }
+
+#ifdef MUSIC_RECORDING_EEPROM_ADDR
+    music_recording_save();
+#endif
+}
+
+void music_recording_add(uint8_t note, bool pressed) {
+    // A note above 127 would not fit next to the pressed bit, and has no MIDI note to play anyway
+    if (!recording || note > MUSIC_EVENT_NOTE) {
+        return;
+    }
+
+    uint8_t  event[MUSIC_EVENT_MAX_SIZE];
+    uint32_t now = timer_read32();
+    uint8_t  len = write_delta(event, now - recording_last);
+
+    event[len++]   = note | (pressed ? MUSIC_EVENT_PRESSED : 0);
+    recording_last = now;
+
+    while (recording_count + len > MUSIC_RECORDING_SIZE) {
+        drop_oldest_event();
+    }
+    for (uint8_t i = 0; i < len; i++) {
+        recording_buffer[(recording_head + recording_count + i) % MUSIC_RECORDING_SIZE] = event[i];
+    }
+    recording_count += len;
+}
+
+bool is_music_recording(void) {
+    return recording;
+}
+
+bool is_music_recorded(void) {
+    return !recording && recording_count > 0;
+}
+
+bool music_playback_start(void) {
+#ifdef MUSIC_RECORDING_EEPROM_ADDR
+    if (!is_music_recorded() && !recording) {
+        music_recording_load();
+    }
+#endif
+    if (!is_music_recorded()) {
+        return false;
+    }
+
+    playing           = true;
+    playback_offset   = 0;
+    playback_next     = 0; // The first event plays right away, its delta is the silence before it was recorded
+    playback_time     = 0;
+    playback_fraction = 0;
+    playback_anchor   = timer_read32();
+    return true;
+}
+
+void music_playback_stop(void) {
+    playing = false;
+}
+
+bool is_music_playing(void) {
+    return playing;
+}
+
+static void playback_advance_time(void) {
+    uint32_t now    = timer_read32();
+    uint32_t scaled = (now - playback_anchor) * playback_rate + playback_fraction;
+
+    playback_time += scaled / 100;
+    playback_fraction = scaled % 100;
+    playback_anchor   = now;
+}
+
+uint16_t music_playback_get_rate(void) {
+    return playback_rate;
+}
+
+void music_playback_set_rate(uint16_t rate) {
+    if (rate < MUSIC_PLAYBACK_RATE_MIN) {
+        rate = MUSIC_PLAYBACK_RATE_MIN;
+    } else if (rate > MUSIC_PLAYBACK_RATE_MAX) {
+        rate = MUSIC_PLAYBACK_RATE_MAX;
+    }
+
+    // Play what was before at the old rate
+    if (playing) {
+        playback_advance_time();
+    }
+    playback_rate = rate;
+}
+
+/** \brief Pop the next due event
+ *
+ * Returns false once no more events are due. Call repeatedly, chords are several events due at once.
+ */
+bool music_playback_next(uint8_t *note, bool *pressed) {
+    if (!playing) {
+        return false;
+    }
+
+    playback_advance_time();
+    if ((int32_t)(playback_time - playback_next) < 0) {
+        return false;
+    }
+
+    uint32_t delta;
+    uint16_t offset = playback_offset + read_delta(playback_offset, &delta);
+    uint8_t  data   = recording_byte(offset);
+
+    *note           = data & MUSIC_EVENT_NOTE;
+    *pressed        = data & MUSIC_EVENT_PRESSED;
+    playback_offset = offset + 1;
+
+    if (playback_offset >= recording_count) {
+        // Loop, after the rest that ended the recording
+        playback_offset = 0;
+        playback_next += recording_rest;
+    } else {
+        read_delta(playback_offset, &delta);
+        playback_next += delta;
+    }
+    return true;
+}
+
+#ifdef MUSIC_RECORDING_EEPROM_ADDR
+/**
+ * EEPROM layout at MUSIC_RECORDING_EEPROM_ADDR, MUSIC_RECORDING_SIZE + 8 bytes:
+ * magic (2 bytes), event bytes used (2), final rest (4), events from the oldest.
+ */
+void music_recording_save(void) {
+    uint8_t *addr = (uint8_t *)(MUSIC_RECORDING_EEPROM_ADDR);
+
+    eeprom_update_word((uint16_t *)addr, MUSIC_RECORDING_MAGIC);
+    eeprom_update_word((uint16_t *)(addr + 2), recording_count);
+    eeprom_update_dword((uint32_t *)(addr + 4), recording_rest);
+    for (uint16_t i = 0; i < recording_count; i++) {
+        eeprom_update_byte(addr + 8 + i, recording_byte(i));
+    }
+}
+
+bool music_recording_load(void) {
+    uint8_t *addr = (uint8_t *)(MUSIC_RECORDING_EEPROM_ADDR);
+
+    if (eeprom_read_word((uint16_t *)addr) != MUSIC_RECORDING_MAGIC) {
+        return false;
+    }
+    uint16_t count = eeprom_read_word((uint16_t *)(addr + 2));
+    if (count > MUSIC_RECORDING_SIZE) {
+        return false;
+    }
+
+    recording       = false;
+    recording_head  = 0;
+    recording_count = count;
+    recording_rest  = eeprom_read_dword((uint32_t *)(addr + 4));
+    eeprom_read_block(recording_buffer, addr + 8, count);
+    return count > 0;
+}
+#endif
@@ -0,0 +1,61 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Music mode recordings are stored as note on/off events in a ring buffer. Each event is the time
+ * since the previous event in ms, as a variable length integer (7 bits per byte, the top bit set
+ * on all bytes but the last), followed by one byte holding the note and, in its top bit, whether
+ * the note was pressed. Once the buffer is full, the oldest events are dropped.
+ */
+#ifndef MUSIC_RECORDING_SIZE
+#    define MUSIC_RECORDING_SIZE 256
+#endif
+
+#if MUSIC_RECORDING_SIZE > 0x7FFF
+#    error "Maximum value of MUSIC_RECORDING_SIZE is 32767"
+#endif
+
+// Playback rate limits, in percent
+#ifndef MUSIC_PLAYBACK_RATE_MIN
+#    define MUSIC_PLAYBACK_RATE_MIN 25
+#endif
+
+#ifndef MUSIC_PLAYBACK_RATE_MAX
+#    define MUSIC_PLAYBACK_RATE_MAX 400
+#endif
+
+void music_recording_start(void);
+void music_recording_stop(void);
+void music_recording_add(uint8_t note, bool pressed);
+bool is_music_recording(void);
+bool is_music_recorded(void);
+
+bool     music_playback_start(void);
+void     music_playback_stop(void);
+bool     is_music_playing(void);
+uint16_t music_playback_get_rate(void);
+void     music_playback_set_rate(uint16_t rate);
+bool     music_playback_next(uint8_t *note, bool *pressed);
+
+#ifdef MUSIC_RECORDING_EEPROM_ADDR
+void music_recording_save(void);
+bool music_recording_load(void);
+#endif
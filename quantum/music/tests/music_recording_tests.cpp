@@ -0,0 +1,191 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+extern "C" {
+#include "music_recording.h"
+#include "eeprom.h"
+}
+
+extern "C" {
+void     set_time(uint32_t t);
+void     advance_time(uint32_t ms);
+uint32_t timer_read32(void);
+}
+
+struct MusicEvent {
+    uint32_t time;
+    uint8_t  note;
+    bool     pressed;
+};
+
+class MusicRecordingTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        set_time(1000);
+        music_playback_stop();
+        music_playback_set_rate(100);
+    }
+
+    // Record the events, relative to the start of the recording, then stop after the rest
+    void record(const std::vector<MusicEvent> &events, uint32_t rest) {
+        uint32_t start = timer_read32();
+        music_recording_start();
+        for (auto &event : events) {
+            set_time(start + event.time);
+            music_recording_add(event.note, event.pressed);
+        }
+        advance_time(rest);
+        music_recording_stop();
+    }
+
+    // Poll playback every `step` ms, returning the events with their time since the playback started
+    std::vector<MusicEvent> play(uint32_t duration, uint32_t step = 1) {
+        std::vector<MusicEvent> played;
+        uint32_t                start = timer_read32();
+
+        EXPECT_TRUE(music_playback_start());
+        for (uint32_t elapsed = 0; elapsed <= duration; elapsed += step) {
+            set_time(start + elapsed);
+
+            uint8_t note;
+            bool    pressed;
+            while (music_playback_next(&note, &pressed)) {
+                played.push_back({elapsed, note, pressed});
+            }
+        }
+        music_playback_stop();
+        return played;
+    }
+};
+
+// C major chord, a rest, then a single note
+static const std::vector<MusicEvent> song = {
+    {0, 60, true}, {0, 64, true}, {0, 67, true}, {250, 60, false}, {251, 64, false}, {251, 67, false}, {700, 62, true}, {800, 62, false},
+};
+
+TEST_F(MusicRecordingTest, ReplaysChordsAndRests) {
+    record(song, 300);
+    EXPECT_TRUE(is_music_recorded());
+
+    auto played = play(1099);
+    ASSERT_EQ(played.size(), song.size());
+    for (size_t i = 0; i < song.size(); i++) {
+        EXPECT_EQ(played[i].note, song[i].note);
+        EXPECT_EQ(played[i].pressed, song[i].pressed);
+        EXPECT_LE(played[i].time - song[i].time, 1) << "event " << i;
+    }
+}
+
+TEST_F(MusicRecordingTest, LoopsAfterTheFinalRest) {
+    record(song, 300);
+
+    const uint32_t loop   = 800 + 300;
+    auto           played = play(loop * 50 - 1, 3);
+    ASSERT_EQ(played.size(), song.size() * 50);
+    for (size_t i = 0; i < played.size(); i++) {
+        uint32_t expected = (i / song.size()) * loop + song[i % song.size()].time;
+        EXPECT_EQ(played[i].note, song[i % song.size()].note);
+        // Polled every 3 ms: late by at most that, but never drifting
+        EXPECT_GE(played[i].time, expected) << "event " << i;
+        EXPECT_LE(played[i].time - expected, 2) << "event " << i;
+    }
+}
+
+TEST_F(MusicRecordingTest, LongDeltas) {
+    record({{0, 40, true}, {100000, 40, false}, {100000 + 127, 41, true}, {100000 + 128, 41, false}}, 1);
+
+    auto played = play(100000 + 128);
+    ASSERT_EQ(played.size(), 4);
+    EXPECT_EQ(played[1].time, 100000);
+    EXPECT_EQ(played[2].time, 100000 + 127);
+    EXPECT_EQ(played[3].time, 100000 + 128);
+}
+
+TEST_F(MusicRecordingTest, DropsOldestEventsWhenFull) {
+    std::vector<MusicEvent> events;
+    // Two bytes per event, so only the newest half fit
+    for (uint32_t i = 0; i < MUSIC_RECORDING_SIZE; i++) {
+        events.push_back({i * 10, (uint8_t)(i % 128), (i % 2) == 0});
+    }
+    record(events, 10);
+
+    auto played = play(MUSIC_RECORDING_SIZE / 2 * 10 - 1);
+    ASSERT_EQ(played.size(), MUSIC_RECORDING_SIZE / 2);
+    for (size_t i = 0; i < played.size(); i++) {
+        auto &event = events[MUSIC_RECORDING_SIZE / 2 + i];
+        EXPECT_EQ(played[i].note, event.note);
+        EXPECT_EQ(played[i].pressed, event.pressed);
+        EXPECT_EQ(played[i].time, i * 10);
+    }
+}
+
+TEST_F(MusicRecordingTest, PlaybackRate) {
+    record(song, 300);
+
+    music_playback_set_rate(200);
+    auto played = play(549);
+    ASSERT_EQ(played.size(), song.size());
+    for (size_t i = 0; i < song.size(); i++) {
+        EXPECT_LE(played[i].time - song[i].time / 2, 1) << "event " << i;
+    }
+
+    music_playback_set_rate(1);
+    EXPECT_EQ(music_playback_get_rate(), MUSIC_PLAYBACK_RATE_MIN);
+    music_playback_set_rate(1000);
+    EXPECT_EQ(music_playback_get_rate(), MUSIC_PLAYBACK_RATE_MAX);
+}
+
+TEST_F(MusicRecordingTest, SavesToEeprom) {
+    record(song, 300);
+
+    // Throw away the recording in RAM
+    music_recording_start();
+    EXPECT_FALSE(is_music_recorded());
+
+    EXPECT_TRUE(music_recording_load());
+    auto played = play(1099);
+    ASSERT_EQ(played.size(), song.size());
+    for (size_t i = 0; i < song.size(); i++) {
+        EXPECT_EQ(played[i].note, song[i].note);
+        EXPECT_LE(played[i].time - song[i].time, 1) << "event " << i;
+    }
+}
+
+TEST_F(MusicRecordingTest, IgnoresEventsWhenNotRecording) {
+    record(song, 300);
+    music_recording_add(30, true);
+
+    auto played = play(1099);
+    EXPECT_EQ(played.size(), song.size());
+}
+
+TEST_F(MusicRecordingTest, RejectsNotesAboveMidiRange) {
+    // 128 and 188 would otherwise be played back as 0 and 60
+    record({{0, 127, true}, {50, 128, true}, {60, 188, true}, {100, 127, false}, {110, 128, false}}, 100);
+
+    auto played = play(209);
+    ASSERT_EQ(played.size(), 2);
+    EXPECT_EQ(played[0].note, 127);
+    EXPECT_TRUE(played[0].pressed);
+    EXPECT_EQ(played[0].time, 0);
+    EXPECT_EQ(played[1].note, 127);
+    EXPECT_FALSE(played[1].pressed);
+    EXPECT_EQ(played[1].time, 100);
+}
@@ -0,0 +1,9 @@
+music_recording_DEFS := -DEEPROM_TEST_HARNESS -DTOTAL_EEPROM_BYTE_COUNT=1024 -DMUSIC_RECORDING_EEPROM_ADDR=64
+
+music_recording_INC := $(QUANTUM_PATH)/music
+
+music_recording_SRC := \
+	$(QUANTUM_PATH)/music/tests/music_recording_tests.cpp \
+	$(QUANTUM_PATH)/music/music_recording.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/eeprom.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/timer.c
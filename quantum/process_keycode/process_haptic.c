@@ -85,6 +85,12 @@ __attribute__((weak)) bool get_haptic_enabled_key(uint16_t keycode, keyrecord_t
     return true;
 }
 
+/* Which solenoid clicks for a key, when there are several. A keymap can pick one by key or by
+   layer, e.g. with get_highest_layer(layer_state). */
+__attribute__((weak)) uint8_t get_haptic_channel(uint16_t keycode, keyrecord_t *record) {
+    return 0;
+}
+
 bool process_haptic(uint16_t keycode, keyrecord_t *record) {
     if (record->event.pressed) {
         switch (keycode) {
@@ -134,12 +140,12 @@ bool process_haptic(uint16_t keycode, keyrecord_t *record) {
         if (record->event.pressed) {
             // keypress
             if (haptic_get_feedback() < 2 && get_haptic_enabled_key(keycode, record)) {
-                haptic_play();
+                haptic_play_channel(get_haptic_channel(keycode, record));
             }
         } else {
             // keyrelease
             if (haptic_get_feedback() > 0 && get_haptic_enabled_key(keycode, record)) {
-                haptic_play();
+                haptic_play_channel(get_haptic_channel(keycode, record));
             }
         }
     }
@@ -18,4 +18,6 @@
 #include <stdbool.h>
 #include "action.h"
 
-bool process_haptic(uint16_t keycode, keyrecord_t *record);
+bool    get_haptic_enabled_key(uint16_t keycode, keyrecord_t *record);
+uint8_t get_haptic_channel(uint16_t keycode, keyrecord_t *record);
+bool    process_haptic(uint16_t keycode, keyrecord_t *record);
@@ -14,6 +14,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "process_music.h"
+#include "music_recording.h"
 
 #ifdef AUDIO_ENABLE
 #    include "process_audio.h"
@@ -30,17 +31,6 @@ uint8_t music_starting_note = 0x0C;
 int     music_offset        = 7;
 uint8_t music_mode          = MUSIC_MODE_MAJOR;
 
-// music sequencer
-static bool    music_sequence_recording = false;
-static bool    music_sequence_recorded  = false;
-static bool    music_sequence_playing   = false;
-static uint8_t music_sequence[16]       = {0};
-static uint8_t music_sequence_count     = 0;
-static uint8_t music_sequence_position  = 0;
-
-static uint16_t music_sequence_timer    = 0;
-static uint16_t music_sequence_interval = 100;
-
 #    ifdef AUDIO_ENABLE
 #        ifndef MUSIC_ON_SONG
 #            define MUSIC_ON_SONG SONG(MUSIC_ON_SOUND)
@@ -148,39 +138,29 @@ bool process_music(uint16_t keycode, keyrecord_t *record) {
         if (record->event.pressed) {
             if (keycode == KC_LEFT_CTRL) { // Start recording
                 music_all_notes_off();
-                music_sequence_recording = true;
-                music_sequence_recorded  = false;
-                music_sequence_playing   = false;
-                music_sequence_count     = 0;
+                music_recording_start();
                 return false;
             }
 
             if (keycode == KC_LEFT_ALT) { // Stop recording/playing
                 music_all_notes_off();
-                if (music_sequence_recording) { // was recording
-                    music_sequence_recorded = true;
-                }
-                music_sequence_recording = false;
-                music_sequence_playing   = false;
+                music_recording_stop();
+                music_playback_stop();
                 return false;
             }
 
-            if (keycode == KC_LEFT_GUI && music_sequence_recorded) { // Start playing
+            if (keycode == KC_LEFT_GUI && !is_music_recording() && music_playback_start()) { // Start playing
                 music_all_notes_off();
-                music_sequence_recording = false;
-                music_sequence_playing   = true;
-                music_sequence_position  = 0;
-                music_sequence_timer     = 0;
                 return false;
             }
 
-            if (keycode == KC_UP) {
-                music_sequence_interval -= 10;
+            if (keycode == KC_UP) { // Play faster
+                music_playback_set_rate(music_playback_get_rate() + 10);
                 return false;
             }
 
-            if (keycode == KC_DOWN) {
-                music_sequence_interval += 10;
+            if (keycode == KC_DOWN) { // Play slower
+                music_playback_set_rate(music_playback_get_rate() - 10);
                 return false;
             }
         }
@@ -208,13 +188,10 @@ bool process_music(uint16_t keycode, keyrecord_t *record) {
 
         if (record->event.pressed) {
             music_noteon(note);
-            if (music_sequence_recording) {
-                music_sequence[music_sequence_count] = note;
-                music_sequence_count++;
-            }
         } else {
             music_noteoff(note);
         }
+        music_recording_add(note, record->event.pressed);
 
         if (music_mask(keycode)) return false;
     }
@@ -305,14 +282,14 @@ void music_mode_cycle(void) {
 }
 
 void music_task(void) {
-    if (music_sequence_playing) {
-        if ((music_sequence_timer == 0) || (timer_elapsed(music_sequence_timer) > music_sequence_interval)) {
-            music_sequence_timer = timer_read();
-            uint8_t prev_note    = music_sequence[(music_sequence_position - 1 < 0) ? (music_sequence_position - 1 + music_sequence_count) : (music_sequence_position - 1)];
-            uint8_t next_note    = music_sequence[music_sequence_position];
-            music_noteoff(prev_note);
-            music_noteon(next_note);
-            music_sequence_position = (music_sequence_position + 1) % music_sequence_count;
+    uint8_t note;
+    bool    pressed;
+
+    while (music_playback_next(&note, &pressed)) {
+        if (pressed) {
+            music_noteon(note);
+        } else {
+            music_noteoff(note);
         }
     }
 }
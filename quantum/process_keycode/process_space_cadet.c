@@ -15,6 +15,9 @@
  */
 #include "process_space_cadet.h"
 #include "action_tapping.h"
+#ifdef QMK_SETTINGS
+#    include "qmk_settings.h"
+#endif
 
 // ********** OBSOLETE DEFINES, STOP USING! (pls?) **********
 // Shift / paren setup
@@ -76,91 +79,180 @@
 #    define SFTENT_KEYS KC_RIGHT_SHIFT, KC_TRANSPARENT, SFTENT_KEY
 #endif
 
-static uint8_t  sc_last  = 0;
-static uint16_t sc_timer = 0;
+#define SC_MOD(code) (IS_MOD(code) ? MOD_BIT(code) : 0)
+#define SC_KEYS(hold, tap, keycode) \
+    { SC_MOD(hold), SC_MOD(tap), keycode }
+#define SC_KEYS_OF(keys) SC_KEYS(keys)
+
+// Hold mods, tap mods and tapped keycode of each of the built-in keys
+static const uint8_t space_cadet_keys[SPACE_CADET_KEY_COUNT][3] = {
+    [SPACE_CADET_LSPO]   = SC_KEYS_OF(LSPO_KEYS),
+    [SPACE_CADET_RSPC]   = SC_KEYS_OF(RSPC_KEYS),
+    [SPACE_CADET_LCPO]   = SC_KEYS_OF(LCPO_KEYS),
+    [SPACE_CADET_RCPC]   = SC_KEYS_OF(RCPC_KEYS),
+    [SPACE_CADET_LAPO]   = SC_KEYS_OF(LAPO_KEYS),
+    [SPACE_CADET_RAPC]   = SC_KEYS_OF(RAPC_KEYS),
+    [SPACE_CADET_SFTENT] = SC_KEYS_OF(SFTENT_KEYS),
+};
+
+/* Every Space Cadet key held down keeps its own state, so overlapping keys, as in a roll
+ * from one paren to the other, each resolve against their own press time. Only keys other
+ * than Space Cadet ones interrupt them and make them a hold.
+ */
+typedef struct {
+    keypos_t key;
+    bool     pressed;
+    bool     interrupted;
+    uint16_t timer;
+    uint8_t  hold_mods;
 #ifdef SPACE_CADET_MODIFIER_CARRYOVER
-static uint8_t sc_mods = 0;
+    uint8_t mods;
 #endif
+} space_cadet_state_t;
 
-void perform_space_cadet(keyrecord_t *record, uint16_t sc_keycode, uint8_t holdMod, uint8_t tapMod, uint8_t keycode) {
-    if (record->event.pressed) {
-        sc_last  = holdMod;
-        sc_timer = timer_read();
-#ifdef SPACE_CADET_MODIFIER_CARRYOVER
-        sc_mods = get_mods();
+static space_cadet_state_t sc_states[SPACE_CADET_MAX_PRESSED];
+
+void space_cadet_default_mods(uint8_t index, uint8_t *hold_mods, uint8_t *tap_mods) {
+    *hold_mods = space_cadet_keys[index][0];
+    *tap_mods  = space_cadet_keys[index][1];
+}
+
+static void space_cadet_mods(uint8_t index, uint8_t *hold_mods, uint8_t *tap_mods) {
+#ifdef QMK_SETTINGS
+    *hold_mods = QS.space_cadet[index][0];
+    *tap_mods  = QS.space_cadet[index][1];
+#else
+    space_cadet_default_mods(index, hold_mods, tap_mods);
 #endif
-        if (IS_MOD(holdMod)) {
-            register_mods(MOD_BIT(holdMod));
+}
+
+static space_cadet_state_t *space_cadet_find(keypos_t key) {
+    for (uint8_t i = 0; i < SPACE_CADET_MAX_PRESSED; i++) {
+        if (sc_states[i].pressed && KEYEQ(sc_states[i].key, key)) {
+            return &sc_states[i];
         }
-    } else {
+    }
+    return NULL;
+}
+
+// Hold mods of the Space Cadet keys still down, or of only those already interrupted
+static uint8_t space_cadet_hold_mods(bool interrupted_only) {
+    uint8_t mods = 0;
+    for (uint8_t i = 0; i < SPACE_CADET_MAX_PRESSED; i++) {
+        if (sc_states[i].pressed && (sc_states[i].interrupted || !interrupted_only)) {
+            mods |= sc_states[i].hold_mods;
+        }
+    }
+    return mods;
+}
+
+static void space_cadet_press(keyrecord_t *record, uint8_t hold_mods) {
+    // with every slot in use, the key can still act as a hold
+    space_cadet_state_t *state = NULL;
+    for (uint8_t i = 0; !state && i < SPACE_CADET_MAX_PRESSED; i++) {
+        if (!sc_states[i].pressed) {
+            state = &sc_states[i];
+        }
+    }
+
+    if (state) {
+        state->key         = record->event.key;
+        state->pressed     = true;
+        state->interrupted = false;
+        state->timer       = timer_read();
+        state->hold_mods   = hold_mods;
+#ifdef SPACE_CADET_MODIFIER_CARRYOVER
+        state->mods = get_mods();
+#endif
+    }
+    register_mods(hold_mods);
+}
+
+static void space_cadet_release(keyrecord_t *record, uint16_t sc_keycode, uint8_t hold_mods, uint8_t tap_mods, uint8_t keycode) {
+    space_cadet_state_t *state  = space_cadet_find(record->event.key);
+    bool                 tapped = false;
+    if (state) {
+        state->pressed = false;
+        // the mods registered on press, should they have been changed since
+        hold_mods = state->hold_mods;
 #ifdef TAPPING_TERM_PER_KEY
-        if (sc_last == holdMod && timer_elapsed(sc_timer) < get_tapping_term(sc_keycode, record))
+        tapped = !state->interrupted && timer_elapsed(state->timer) < get_tapping_term(sc_keycode, record);
 #else
-        if (sc_last == holdMod && timer_elapsed(sc_timer) < TAPPING_TERM)
+        tapped = !state->interrupted && timer_elapsed(state->timer) < TAPPING_TERM;
 #endif
-        {
-            if (holdMod != tapMod) {
-                if (IS_MOD(holdMod)) {
-                    unregister_mods(MOD_BIT(holdMod));
-                }
-                if (IS_MOD(tapMod)) {
-                    register_mods(MOD_BIT(tapMod));
-                }
-            }
+    }
+
+    // a mod another key still holds stays down
+    uint8_t others = space_cadet_hold_mods(false);
+    if (!tapped) {
+        unregister_mods(hold_mods & ~others);
+        return;
+    }
+
+    // The tap leaves out the hold mods of the other keys yet to resolve, but not of the
+    // ones already held, and they all get their mods back once it is sent
+    uint8_t lifted = (hold_mods | others) & ~space_cadet_hold_mods(true);
+    unregister_mods(lifted & ~tap_mods);
+    uint8_t added = tap_mods & ~get_mods();
+    register_mods(added);
 #ifdef SPACE_CADET_MODIFIER_CARRYOVER
-            set_weak_mods(sc_mods);
+    set_weak_mods(state->mods);
 #endif
-            tap_code(keycode);
+    tap_code(keycode);
 #ifdef SPACE_CADET_MODIFIER_CARRYOVER
-            clear_weak_mods();
+    clear_weak_mods();
 #endif
-            if (IS_MOD(tapMod)) {
-                unregister_mods(MOD_BIT(tapMod));
-            }
-        } else {
-            if (IS_MOD(holdMod)) {
-                unregister_mods(MOD_BIT(holdMod));
-            }
-        }
+    register_mods(others & ~get_mods());
+    unregister_mods((added | (hold_mods & tap_mods)) & ~others);
+}
+
+static void space_cadet(keyrecord_t *record, uint16_t sc_keycode, uint8_t hold_mods, uint8_t tap_mods, uint8_t keycode) {
+    if (record->event.pressed) {
+        space_cadet_press(record, hold_mods);
+    } else {
+        space_cadet_release(record, sc_keycode, hold_mods, tap_mods, keycode);
     }
 }
 
+void perform_space_cadet(keyrecord_t *record, uint16_t sc_keycode, uint8_t holdMod, uint8_t tapMod, uint8_t keycode) {
+    space_cadet(record, sc_keycode, SC_MOD(holdMod), SC_MOD(tapMod), keycode);
+}
+
 bool process_space_cadet(uint16_t keycode, keyrecord_t *record) {
+    uint8_t index;
     switch (keycode) {
-        case KC_LSPO: {
-            perform_space_cadet(record, keycode, LSPO_KEYS);
-            return false;
-        }
-        case KC_RSPC: {
-            perform_space_cadet(record, keycode, RSPC_KEYS);
-            return false;
-        }
-        case KC_LCPO: {
-            perform_space_cadet(record, keycode, LCPO_KEYS);
-            return false;
-        }
-        case KC_RCPC: {
-            perform_space_cadet(record, keycode, RCPC_KEYS);
-            return false;
-        }
-        case KC_LAPO: {
-            perform_space_cadet(record, keycode, LAPO_KEYS);
-            return false;
-        }
-        case KC_RAPC: {
-            perform_space_cadet(record, keycode, RAPC_KEYS);
-            return false;
-        }
-        case KC_SFTENT: {
-            perform_space_cadet(record, keycode, SFTENT_KEYS);
-            return false;
-        }
-        default: {
+        case KC_LSPO:
+            index = SPACE_CADET_LSPO;
+            break;
+        case KC_RSPC:
+            index = SPACE_CADET_RSPC;
+            break;
+        case KC_LCPO:
+            index = SPACE_CADET_LCPO;
+            break;
+        case KC_RCPC:
+            index = SPACE_CADET_RCPC;
+            break;
+        case KC_LAPO:
+            index = SPACE_CADET_LAPO;
+            break;
+        case KC_RAPC:
+            index = SPACE_CADET_RAPC;
+            break;
+        case KC_SFTENT:
+            index = SPACE_CADET_SFTENT;
+            break;
+        default:
             if (record->event.pressed) {
-                sc_last = 0;
+                for (uint8_t i = 0; i < SPACE_CADET_MAX_PRESSED; i++) {
+                    sc_states[i].interrupted = true;
+                }
             }
-            break;
-        }
+            return true;
     }
-    return true;
+
+    uint8_t hold_mods, tap_mods;
+    space_cadet_mods(index, &hold_mods, &tap_mods);
+    space_cadet(record, keycode, hold_mods, tap_mods, space_cadet_keys[index][2]);
+    return false;
 }
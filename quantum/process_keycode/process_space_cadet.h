@@ -17,5 +17,23 @@
 
 #include "quantum.h"
 
+// How many Space Cadet keys can be held down at once, each resolving on its own
+#ifndef SPACE_CADET_MAX_PRESSED
+#    define SPACE_CADET_MAX_PRESSED 4
+#endif
+
+// The built-in Space Cadet keys, in the order their mods are stored in
+enum space_cadet_keys {
+    SPACE_CADET_LSPO,
+    SPACE_CADET_RSPC,
+    SPACE_CADET_LCPO,
+    SPACE_CADET_RCPC,
+    SPACE_CADET_LAPO,
+    SPACE_CADET_RAPC,
+    SPACE_CADET_SFTENT,
+    SPACE_CADET_KEY_COUNT,
+};
+
 void perform_space_cadet(keyrecord_t *record, uint16_t sc_keycode, uint8_t holdMod, uint8_t tapMod, uint8_t keycode);
+void space_cadet_default_mods(uint8_t index, uint8_t *hold_mods, uint8_t *tap_mods);
 bool process_space_cadet(uint16_t keycode, keyrecord_t *record);
@@ -9,6 +9,20 @@
 #include "mousekey.h"
 #include "process_combo.h"
 #include "action_tapping.h"
+#include "keycode_config.h"
+#ifdef SPACE_CADET_ENABLE
+#include "process_space_cadet.h"
+
+_Static_assert(sizeof(QS.space_cadet) / sizeof(QS.space_cadet[0]) == SPACE_CADET_KEY_COUNT, "one hold/tap pair of mods per Space Cadet key");
+#endif
+#ifdef COLOR_CALIBRATION_ENABLE
+#include "color_calibration.h"
+#ifdef RGBLIGHT_ENABLE
+#include "rgblight.h"
+#endif
+
+_Static_assert(sizeof(QS.color_gamma) == COLOR_CALIBRATION_CHANNELS, "one gamma per colour channel");
+#endif
 
 qmk_settings_t QS;
 
@@ -32,6 +46,27 @@ static void mousekey_apply(void) {
 }
 #endif
 
+static void usb_polling_apply(void) {
+    for (uint8_t i = 0; i < USB_POLLING_ENDPOINT_COUNT; ++i)
+        usb_polling_set_interval(i, QS.usb_polling[i]);
+}
+
+static void key_remap_apply(void) {
+    keycode_config_invalidate();
+}
+
+#ifdef COLOR_CALIBRATION_ENABLE
+static void color_calibration_apply_settings(void) {
+    for (uint8_t i = 0; i < COLOR_CALIBRATION_CHANNELS; ++i)
+        color_calibration_set(i, QS.color_gamma[i], QS.color_gain[i]);
+#ifdef RGBLIGHT_ENABLE
+    /* rgblight calibrates colours as they are written, so draw the current ones again */
+    if (is_rgblight_initialized && rgblight_is_enabled())
+        rgblight_mode_noeeprom(rgblight_get_mode());
+#endif
+}
+#endif
+
 static const qmk_settings_proto_t protos[] PROGMEM = {
    DECLARE_SETTING(1, grave_esc_override),
    DECLARE_SETTING(2, combo_term),
@@ -55,6 +90,42 @@ static const qmk_settings_proto_t protos[] PROGMEM = {
    DECLARE_SETTING(18, tap_code_delay),
    DECLARE_SETTING(19, tap_hold_caps_delay),
    DECLARE_SETTING(20, tapping_toggle),
+   DECLARE_SETTING_CB(21, usb_polling[USB_POLLING_KEYBOARD], usb_polling_apply),
+   DECLARE_SETTING_CB(22, usb_polling[USB_POLLING_MOUSE], usb_polling_apply),
+   DECLARE_SETTING_CB(23, usb_polling[USB_POLLING_SHARED], usb_polling_apply),
+   DECLARE_SETTING_CB(24, usb_polling[USB_POLLING_JOYSTICK], usb_polling_apply),
+#ifdef SPACE_CADET_ENABLE
+   DECLARE_SETTING(25, space_cadet[SPACE_CADET_LSPO][0]),
+   DECLARE_SETTING(26, space_cadet[SPACE_CADET_LSPO][1]),
+   DECLARE_SETTING(27, space_cadet[SPACE_CADET_RSPC][0]),
+   DECLARE_SETTING(28, space_cadet[SPACE_CADET_RSPC][1]),
+   DECLARE_SETTING(29, space_cadet[SPACE_CADET_LCPO][0]),
+   DECLARE_SETTING(30, space_cadet[SPACE_CADET_LCPO][1]),
+   DECLARE_SETTING(31, space_cadet[SPACE_CADET_RCPC][0]),
+   DECLARE_SETTING(32, space_cadet[SPACE_CADET_RCPC][1]),
+   DECLARE_SETTING(33, space_cadet[SPACE_CADET_LAPO][0]),
+   DECLARE_SETTING(34, space_cadet[SPACE_CADET_LAPO][1]),
+   DECLARE_SETTING(35, space_cadet[SPACE_CADET_RAPC][0]),
+   DECLARE_SETTING(36, space_cadet[SPACE_CADET_RAPC][1]),
+   DECLARE_SETTING(37, space_cadet[SPACE_CADET_SFTENT][0]),
+   DECLARE_SETTING(38, space_cadet[SPACE_CADET_SFTENT][1]),
+#endif
+   DECLARE_SETTING_CB(39, key_remap[0], key_remap_apply),
+   DECLARE_SETTING_CB(40, key_remap[1], key_remap_apply),
+   DECLARE_SETTING_CB(41, key_remap[2], key_remap_apply),
+   DECLARE_SETTING_CB(42, key_remap[3], key_remap_apply),
+   DECLARE_SETTING_CB(43, key_remap[4], key_remap_apply),
+   DECLARE_SETTING_CB(44, key_remap[5], key_remap_apply),
+   DECLARE_SETTING_CB(45, key_remap[6], key_remap_apply),
+   DECLARE_SETTING_CB(46, key_remap[7], key_remap_apply),
+#ifdef COLOR_CALIBRATION_ENABLE
+   DECLARE_SETTING_CB(47, color_gamma[COLOR_CALIBRATION_RED], color_calibration_apply_settings),
+   DECLARE_SETTING_CB(48, color_gamma[COLOR_CALIBRATION_GREEN], color_calibration_apply_settings),
+   DECLARE_SETTING_CB(49, color_gamma[COLOR_CALIBRATION_BLUE], color_calibration_apply_settings),
+   DECLARE_SETTING_CB(50, color_gain[COLOR_CALIBRATION_RED], color_calibration_apply_settings),
+   DECLARE_SETTING_CB(51, color_gain[COLOR_CALIBRATION_GREEN], color_calibration_apply_settings),
+   DECLARE_SETTING_CB(52, color_gain[COLOR_CALIBRATION_BLUE], color_calibration_apply_settings),
+#endif
 };
 
 static const qmk_settings_proto_t *find_setting(uint16_t qsid) {
@@ -93,7 +164,7 @@ void qmk_settings_init(void) {
     }
 }
 
-void qmk_settings_reset(void) {
+static void default_settings(void) {
     QS.grave_esc_override = 0;
     QS.auto_shift = 0;
     QS.auto_shift_timeout = AUTO_SHIFT_TIMEOUT;
@@ -119,11 +190,49 @@ void qmk_settings_reset(void) {
     QS.tap_hold_caps_delay = TAP_HOLD_CAPS_DELAY;
     QS.tapping_toggle = TAPPING_TOGGLE;
 
+    for (uint8_t i = 0; i < USB_POLLING_ENDPOINT_COUNT; ++i)
+        QS.usb_polling[i] = USB_POLLING_DEFAULT;
+
+#ifdef SPACE_CADET_ENABLE
+    for (uint8_t i = 0; i < SPACE_CADET_KEY_COUNT; ++i)
+        space_cadet_default_mods(i, &QS.space_cadet[i][0], &QS.space_cadet[i][1]);
+#endif
+
+    memset(QS.key_remap, 0, sizeof(QS.key_remap));
+
+#ifdef COLOR_CALIBRATION_ENABLE
+    for (uint8_t i = 0; i < COLOR_CALIBRATION_CHANNELS; ++i)
+        color_calibration_default(i, &QS.color_gamma[i], &QS.color_gain[i]);
+#endif
+}
+
+void qmk_settings_reset(void) {
+    default_settings();
     save_settings();
     /* to trigger all callbacks */
     qmk_settings_init();
 }
 
+/* settings saved by an older firmware, which were `size` bytes long: new settings are only ever
+   added at the end, so keep the stored ones and default the rest. The stored layouts are
+   - 36 bytes: up to tapping_toggle, then the unused byte, which is where usb_polling[0] is now
+   - 40 bytes: up to usb_polling and the unused byte, which has stayed where it is
+   - 54 bytes: up to space_cadet
+   - 70 bytes: up to key_remap
+   - 76 bytes: the current layout, up to color_gain
+   a layout from a newer firmware keeps the settings this one knows about */
+void qmk_settings_migrate(uint16_t size) {
+    default_settings();
+    if (size == offsetof(qmk_settings_t, usb_polling) + 1)
+        size = offsetof(qmk_settings_t, usb_polling);
+    for (size_t i = 0; i < size && i < sizeof(qmk_settings_t); ++i) {
+        uint8_t byte;
+        byte = dynamic_keymap_get_qmk_settings(i);
+        memcpy((char*)&QS + i, &byte, 1);
+    }
+    save_settings();
+}
+
 void qmk_settings_query(uint16_t qsid_gt, void *buffer, size_t sz) {
     /* set all FFs, so caller can identify when all settings are retrieved by looking for an 0xFFFF entry */
     memset(buffer, 0xFF, sz);
@@ -164,14 +273,43 @@ int qmk_settings_set(uint16_t qsid, const void *setting, size_t maxsz) {
     return 0;
 }
 
+#ifdef TAPPING_TERM_TABLE_ENABLE
+/* Entry of the per-key table for the key of record, 0 for records that are not
+ * from the matrix, such as the empty ones of tap dance or vial's magic keys */
+static uint16_t tapping_term_entry(keyrecord_t *record) {
+    if (!record || IS_NOEVENT(record->event))
+        return 0;
+    return dynamic_keymap_get_tapping_term(record->event.key.row, record->event.key.col);
+}
+#endif
+
 uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
+#ifdef TAPPING_TERM_TABLE_ENABLE
+    uint16_t term = tapping_term_entry(record) & TAPPING_TERM_TABLE_TERM_MASK;
+    if (term)
+        return term;
+#endif
     return QS.tapping_term;
 }
 
 bool get_permissive_hold(uint16_t keycode, keyrecord_t *record) {
+#ifdef TAPPING_TERM_TABLE_ENABLE
+    if (tapping_term_entry(record) & TAPPING_TERM_TABLE_PERMISSIVE_HOLD)
+        return true;
+#endif
     return QS.tapping & 1;
 }
 
+#ifdef TAPPING_TERM_TABLE_ENABLE
+bool get_hold_on_other_key_press(uint16_t keycode, keyrecord_t *record) {
+#    ifdef HOLD_ON_OTHER_KEY_PRESS
+    return true;
+#    else
+    return tapping_term_entry(record) & TAPPING_TERM_TABLE_HOLD_ON_OTHER_KEY_PRESS;
+#    endif
+}
+#endif
+
 bool get_ignore_mod_tap_interrupt(uint16_t keycode, keyrecord_t *record) {
     return QS.tapping & 2;
 }
@@ -203,6 +341,14 @@ bool get_auto_shifted_key(uint16_t keycode, keyrecord_t *record) {
     return false;
 }
 
+bool keycode_remap_get(uint8_t index, uint8_t *from, uint8_t *to) {
+    if (index >= sizeof(QS.key_remap) / sizeof(QS.key_remap[0]))
+        return false;
+    *from = QS.key_remap[index][0];
+    *to = QS.key_remap[index][1];
+    return true;
+}
+
 bool get_auto_shift_repeat(uint16_t keycode, keyrecord_t *record) {
     return QS_auto_shift_repeat;
 }
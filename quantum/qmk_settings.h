@@ -3,6 +3,8 @@
 #include <inttypes.h>
 #include <stddef.h>
 
+#include "usb_polling_interval.h"
+
 /* take qmk config macros and set up helper variables for default settings */
 
 #ifndef TAP_CODE_DELAY
@@ -121,9 +123,14 @@ typedef struct {
     uint16_t tap_code_delay;
     uint16_t tap_hold_caps_delay;
     uint8_t tapping_toggle;
+    uint8_t usb_polling[USB_POLLING_ENDPOINT_COUNT];
     uint8_t unused;
+    uint8_t space_cadet[7][2]; /* hold and tap mods of KC_LSPO, KC_RSPC, KC_LCPO, KC_RCPC, KC_LAPO, KC_RAPC, KC_SFTENT */
+    uint8_t key_remap[8][2]; /* custom basic keycode remaps, from and to */
+    uint8_t color_gamma[3]; /* red, green and blue, see color_calibration.h */
+    uint8_t color_gain[3];
 } qmk_settings_t;
-_Static_assert(sizeof(qmk_settings_t) == 36, "unexpected size of the qmk_settings_t structure");
+_Static_assert(sizeof(qmk_settings_t) == 76, "unexpected size of the qmk_settings_t structure");
 
 typedef void (*qmk_setting_callback_t)(void);
 
@@ -137,6 +144,7 @@ typedef struct {
 
 void qmk_settings_init(void);
 void qmk_settings_reset(void);
+void qmk_settings_migrate(uint16_t size);
 void qmk_settings_query(uint16_t qsid_gt, void *buffer, size_t sz);
 int qmk_settings_get(uint16_t qsid, void *setting, size_t maxsz);
 int qmk_settings_set(uint16_t qsid, const void *setting, size_t maxsz);
@@ -6,13 +6,23 @@ RGB_MATRIX_EFFECT(BREATHING)
 bool BREATHING(effect_params_t* params) {
     RGB_MATRIX_USE_LIMITS(led_min, led_max);
 
-    HSV      hsv  = rgb_matrix_config.hsv;
-    uint16_t time = scale16by8(g_rgb_timer, rgb_matrix_config.speed / 8);
-    hsv.v         = scale8(abs8(sin8(time) - 128) * 2, hsv.v);
-    RGB rgb       = rgb_matrix_hsv_to_rgb(hsv);
+    // Full 16 bit phase and wave, so the dim end of the breath does not step
+    uint16_t time = g_rgb_timer * (rgb_matrix_config.speed / 8);
+    uint16_t wave = abs(sin16(time)) * 2;
+    uint16_t val  = ((uint32_t)wave * rgb_matrix_config.hsv.v) >> 8;
+#        ifdef USE_CIE1931_CURVE
+    // The curve hsv_to_rgb would apply to the 8 bit value
+    val = led_dither_cie1931(val);
+#        endif
+    // The hue and saturation at full value, scaled down by the breath
+    HSV      hsv = {rgb_matrix_config.hsv.h, rgb_matrix_config.hsv.s, UINT8_MAX};
+    RGB      rgb = rgb_matrix_hsv_to_rgb(hsv);
+    uint16_t r   = (uint32_t)val * rgb.r / UINT8_MAX;
+    uint16_t g   = (uint32_t)val * rgb.g / UINT8_MAX;
+    uint16_t b   = (uint32_t)val * rgb.b / UINT8_MAX;
     for (uint8_t i = led_min; i < led_max; i++) {
         RGB_MATRIX_TEST_LED_FLAGS();
-        rgb_matrix_set_color(i, rgb.r, rgb.g, rgb.b);
+        rgb_matrix_set_color16(i, r, g, b);
     }
     return rgb_matrix_check_finished_leds(led_max);
 }
@@ -22,6 +22,10 @@
 #include "eeprom.h"
 #include <string.h>
 #include <math.h>
+#include "led_dither.h"
+#ifdef COLOR_CALIBRATION_ENABLE
+#    include "color_calibration.h"
+#endif
 
 #include <lib/lib8tion/lib8tion.h>
 
@@ -119,6 +123,10 @@ uint8_t g_rgb_frame_buffer[MATRIX_ROWS][MATRIX_COLS] = {{0}};
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 last_hit_t g_last_hit_tracker;
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
+#ifdef RGB_MATRIX_DITHER
+static uint16_t rgb_dither_value[DRIVER_LED_TOTAL][3]; // 8.8 fixed point red, green, blue
+static uint8_t  rgb_dither_error[DRIVER_LED_TOTAL][3];
+#endif // RGB_MATRIX_DITHER
 
 // internals
 static bool            suspend_state     = false;
@@ -192,20 +200,69 @@ uint8_t rgb_matrix_map_row_column_to_led(uint8_t row, uint8_t column, uint8_t *l
     return led_count;
 }
 
+// Every colour reaches the driver buffers through these or the dithering in
+// rgb_matrix_update_pwm_buffers, so it is calibrated exactly once
+static inline void rgb_matrix_write_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+#ifdef COLOR_CALIBRATION_ENABLE
+    color_calibration_apply(&red, &green, &blue);
+#endif
+    rgb_matrix_driver.set_color(index, red, green, blue);
+}
+
+static inline void rgb_matrix_write_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+#ifdef COLOR_CALIBRATION_ENABLE
+    color_calibration_apply(&red, &green, &blue);
+#endif
+    rgb_matrix_driver.set_color_all(red, green, blue);
+}
+
 void rgb_matrix_update_pwm_buffers(void) {
+#ifdef RGB_MATRIX_DITHER
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        uint16_t red   = rgb_dither_value[i][0];
+        uint16_t green = rgb_dither_value[i][1];
+        uint16_t blue  = rgb_dither_value[i][2];
+#    ifdef COLOR_CALIBRATION_ENABLE
+        // calibrated ahead of the dithering, which would otherwise round the fractions away first
+        color_calibration_apply16(&red, &green, &blue);
+#    endif
+        rgb_matrix_driver.set_color(i, led_dither_step(red, &rgb_dither_error[i][0]), led_dither_step(green, &rgb_dither_error[i][1]), led_dither_step(blue, &rgb_dither_error[i][2]));
+    }
+#endif
     rgb_matrix_driver.flush();
 }
 
 void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
-    rgb_matrix_driver.set_color(index, red, green, blue);
+#ifdef RGB_MATRIX_DITHER
+    rgb_matrix_set_color16(index, LED_DITHER_FROM_8BIT(red), LED_DITHER_FROM_8BIT(green), LED_DITHER_FROM_8BIT(blue));
+#else
+    rgb_matrix_write_color(index, red, green, blue);
+#endif
+}
+
+/** \brief Set an LED to 8.8 fixed point channel values
+ *
+ * With RGB_MATRIX_DITHER, the fractions are shown by dithering over the following frames. Without it,
+ * the values are rounded.
+ */
+void rgb_matrix_set_color16(int index, uint16_t red, uint16_t green, uint16_t blue) {
+#ifdef RGB_MATRIX_DITHER
+    if (index >= 0 && index < DRIVER_LED_TOTAL) {
+        rgb_dither_value[index][0] = red;
+        rgb_dither_value[index][1] = green;
+        rgb_dither_value[index][2] = blue;
+    }
+#else
+    rgb_matrix_write_color(index, led_dither_round(red), led_dither_round(green), led_dither_round(blue));
+#endif
 }
 
 void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
-#if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+#if (defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)) || defined(RGB_MATRIX_DITHER)
     for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++)
         rgb_matrix_set_color(i, red, green, blue);
 #else
-    rgb_matrix_driver.set_color_all(red, green, blue);
+    rgb_matrix_write_color_all(red, green, blue);
 #endif
 }
 
@@ -320,10 +377,69 @@ static void rgb_task_sync(void) {
     if (sync_timer_elapsed32(g_rgb_timer) >= RGB_MATRIX_LED_FLUSH_LIMIT) rgb_task_state = STARTING;
 }
 
+#ifdef RGB_MATRIX_KEYMAP_INDICATORS
+static uint8_t rgb_key_class[DRIVER_LED_TOTAL];
+static uint8_t rgb_key_class_layer = 0xFF;
+
+static uint8_t rgb_matrix_classify_keycode(uint16_t keycode) {
+    if (keycode == KC_NO) return RGB_KEY_NONE;
+    if (keycode == KC_TRNS) return RGB_KEY_TRANSPARENT;
+    if (keycode <= QK_BASIC_MAX) return RGB_KEY_BASIC;
+    if (keycode <= QK_MODS_MAX) return RGB_KEY_MODIFIED;
+    if (keycode >= QK_MOD_TAP && keycode <= QK_MOD_TAP_MAX) return RGB_KEY_MOD_TAP;
+    if ((keycode >= QK_LAYER_TAP && keycode <= QK_LAYER_TAP_MAX) || (keycode >= QK_TO && keycode <= QK_ONE_SHOT_LAYER_MAX) || (keycode >= QK_LAYER_TAP_TOGGLE && keycode <= QK_LAYER_MOD_MAX)) return RGB_KEY_LAYER;
+    return RGB_KEY_OTHER;
+}
+
+/* Reads the keymap only when the highest layer changed since the last frame,
+ * instead of once per LED per frame in the indicator callbacks. */
+static void rgb_matrix_update_key_classes(void) {
+    uint8_t layer = get_highest_layer(layer_state | default_layer_state);
+    if (layer == rgb_key_class_layer) return;
+
+    memset(rgb_key_class, RGB_KEY_NONE, sizeof(rgb_key_class));
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint8_t index = g_led_config.matrix_co[row][col];
+            if (index < DRIVER_LED_TOTAL) {
+                rgb_key_class[index] = rgb_matrix_classify_keycode(keymap_key_to_keycode(layer, (keypos_t){.row = row, .col = col}));
+            }
+        }
+    }
+    rgb_key_class_layer = layer;
+}
+
+uint8_t rgb_matrix_get_key_class(uint8_t index) {
+    return index < DRIVER_LED_TOTAL ? rgb_key_class[index] : RGB_KEY_NONE;
+}
+
+uint8_t rgb_matrix_get_key_class_layer(void) {
+    return rgb_key_class_layer;
+}
+
+void rgb_matrix_set_color_by_key_class(uint8_t classes, uint8_t red, uint8_t green, uint8_t blue, uint8_t led_min, uint8_t led_max) {
+    if (led_max > DRIVER_LED_TOTAL) led_max = DRIVER_LED_TOTAL;
+    for (uint8_t i = led_min; i < led_max; i++) {
+        if (classes & RGB_KEY_CLASS_BIT(rgb_key_class[i])) {
+            rgb_matrix_set_color(i, red, green, blue);
+        }
+    }
+}
+
+// Call after changing the keymap at runtime
+void rgb_matrix_invalidate_key_classes(void) {
+    rgb_key_class_layer = 0xFF;
+}
+#endif
+
 static void rgb_task_start(void) {
     // reset iter
     rgb_effect_params.iter = 0;
 
+#ifdef RGB_MATRIX_KEYMAP_INDICATORS
+    rgb_matrix_update_key_classes();
+#endif
+
     // update double buffers
     g_rgb_timer = rgb_timer_buffer;
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
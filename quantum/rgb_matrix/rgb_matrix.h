@@ -40,6 +40,8 @@
 #    include "aw20216.h"
 #elif defined(WS2812)
 #    include "ws2812.h"
+#elif defined(APA102)
+#    include "apa102.h"
 #endif
 
 #ifndef RGB_MATRIX_LED_FLUSH_LIMIT
@@ -120,8 +122,14 @@ uint8_t rgb_matrix_map_row_column_to_led_kb(uint8_t row, uint8_t column, uint8_t
 uint8_t rgb_matrix_map_row_column_to_led(uint8_t row, uint8_t column, uint8_t *led_i);
 
 void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
+void rgb_matrix_set_color16(int index, uint16_t red, uint16_t green, uint16_t blue);
 void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue);
 
+#ifdef APA102
+// Per LED global brightness, 0 - APA102_MAX_BRIGHTNESS, applied on top of the colour
+void rgb_matrix_set_led_brightness(int index, uint8_t brightness);
+#endif
+
 void process_rgb_matrix(uint8_t row, uint8_t col, bool pressed);
 
 void rgb_matrix_task(void);
@@ -136,6 +144,27 @@ void rgb_matrix_indicators_advanced(effect_params_t *params);
 void rgb_matrix_indicators_advanced_kb(uint8_t led_min, uint8_t led_max);
 void rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max);
 
+#ifdef RGB_MATRIX_KEYMAP_INDICATORS
+// What the key under each LED does on the highest active layer
+enum rgb_matrix_key_class {
+    RGB_KEY_NONE,        // no key, or KC_NO
+    RGB_KEY_TRANSPARENT, // KC_TRNS, falls through to a lower layer
+    RGB_KEY_BASIC,       // basic keycodes and modifiers
+    RGB_KEY_MODIFIED,    // basic keycodes with modifiers, e.g. LCTL(KC_C)
+    RGB_KEY_MOD_TAP,     // MT() and friends
+    RGB_KEY_LAYER,       // MO(), LT(), TG() and the other layer switching keys
+    RGB_KEY_OTHER,       // everything else
+};
+
+#    define RGB_KEY_CLASS_BIT(class) (1 << (class))
+#    define RGB_KEY_DEFINED (0xFF & ~(RGB_KEY_CLASS_BIT(RGB_KEY_NONE) | RGB_KEY_CLASS_BIT(RGB_KEY_TRANSPARENT)))
+
+uint8_t rgb_matrix_get_key_class(uint8_t index);
+uint8_t rgb_matrix_get_key_class_layer(void);
+void    rgb_matrix_set_color_by_key_class(uint8_t classes, uint8_t red, uint8_t green, uint8_t blue, uint8_t led_min, uint8_t led_max);
+void    rgb_matrix_invalidate_key_classes(void);
+#endif
+
 void rgb_matrix_init(void);
 
 void rgb_matrix_reload_from_eeprom(void);
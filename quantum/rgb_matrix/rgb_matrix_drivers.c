@@ -15,6 +15,7 @@
  */
 
 #include "rgb_matrix.h"
+#include <string.h>
 
 /* Each driver needs to define the struct
  *    const rgb_matrix_driver_t rgb_matrix_driver;
@@ -374,6 +375,48 @@ static void setled_all(uint8_t r, uint8_t g, uint8_t b) {
     }
 }
 
+const rgb_matrix_driver_t rgb_matrix_driver = {
+    .init          = init,
+    .flush         = flush,
+    .set_color     = setled,
+    .set_color_all = setled_all,
+};
+
+#elif defined(APA102)
+#    if defined(RGBLIGHT_ENABLE) && !defined(RGBLIGHT_CUSTOM_DRIVER)
+#        pragma message "Cannot use RGBLIGHT and RGB Matrix using APA102 at the same time."
+#    endif
+
+// LED color and global brightness buffers
+LED_TYPE rgb_matrix_apa102_array[DRIVER_LED_TOTAL];
+uint8_t  rgb_matrix_apa102_brightness[DRIVER_LED_TOTAL];
+
+static void init(void) {
+    memset(rgb_matrix_apa102_brightness, APA102_DEFAULT_BRIGHTNESS, sizeof(rgb_matrix_apa102_brightness));
+}
+
+static void flush(void) {
+    apa102_setleds_brightness(rgb_matrix_apa102_array, rgb_matrix_apa102_brightness, DRIVER_LED_TOTAL);
+}
+
+static inline void setled(int i, uint8_t r, uint8_t g, uint8_t b) {
+    rgb_matrix_apa102_array[i].r = r;
+    rgb_matrix_apa102_array[i].g = g;
+    rgb_matrix_apa102_array[i].b = b;
+}
+
+static void setled_all(uint8_t r, uint8_t g, uint8_t b) {
+    for (int i = 0; i < DRIVER_LED_TOTAL; i++) {
+        setled(i, r, g, b);
+    }
+}
+
+void rgb_matrix_set_led_brightness(int index, uint8_t brightness) {
+    if (index >= 0 && index < DRIVER_LED_TOTAL) {
+        rgb_matrix_apa102_brightness[index] = MIN(brightness, APA102_MAX_BRIGHTNESS);
+    }
+}
+
 const rgb_matrix_driver_t rgb_matrix_driver = {
     .init          = init,
     .flush         = flush,
@@ -23,6 +23,9 @@
 #include "color.h"
 #include "debug.h"
 #include "led_tables.h"
+#ifdef COLOR_CALIBRATION_ENABLE
+#    include "color_calibration.h"
+#endif
 #include <lib/lib8tion/lib8tion.h>
 #ifdef EEPROM_ENABLE
 #    include "eeprom.h"
@@ -149,6 +152,12 @@ __attribute__((weak)) RGB rgblight_hsv_to_rgb(HSV hsv) {
     return hsv_to_rgb(hsv);
 }
 
+// The colour sethsv() writes, before it is calibrated, for the functions that pass it on to rgblight_setrgb*()
+static RGB sethsv_color(uint8_t hue, uint8_t sat, uint8_t val) {
+    HSV hsv = {hue, sat, val > RGBLIGHT_LIMIT_VAL ? RGBLIGHT_LIMIT_VAL : val};
+    return rgblight_hsv_to_rgb(hsv);
+}
+
 void sethsv_raw(uint8_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
     HSV hsv = {hue, sat, val};
     RGB rgb = rgblight_hsv_to_rgb(hsv);
@@ -160,6 +169,10 @@ void sethsv(uint8_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
 }
 
 void setrgb(uint8_t r, uint8_t g, uint8_t b, LED_TYPE *led1) {
+#ifdef COLOR_CALIBRATION_ENABLE
+    // calibrated as it is written, so that led[] is sent as it is, however often
+    color_calibration_apply(&r, &g, &b);
+#endif
     led1->r = r;
     led1->g = g;
     led1->b = b;
@@ -518,9 +531,8 @@ void rgblight_decrease_speed_noeeprom(void) {
 
 void rgblight_sethsv_noeeprom_old(uint8_t hue, uint8_t sat, uint8_t val) {
     if (rgblight_config.enable) {
-        LED_TYPE tmp_led;
-        sethsv(hue, sat, val, &tmp_led);
-        rgblight_setrgb(tmp_led.r, tmp_led.g, tmp_led.b);
+        RGB rgb = sethsv_color(hue, sat, val);
+        rgblight_setrgb(rgb.r, rgb.g, rgb.b);
     }
 }
 
@@ -529,9 +541,8 @@ void rgblight_sethsv_eeprom_helper(uint8_t hue, uint8_t sat, uint8_t val, bool w
         rgblight_status.base_mode = mode_base_table[rgblight_config.mode];
         if (rgblight_config.mode == RGBLIGHT_MODE_STATIC_LIGHT) {
             // same static color
-            LED_TYPE tmp_led;
-            sethsv(hue, sat, val, &tmp_led);
-            rgblight_setrgb(tmp_led.r, tmp_led.g, tmp_led.b);
+            RGB rgb = sethsv_color(hue, sat, val);
+            rgblight_setrgb(rgb.r, rgb.g, rgb.b);
         } else {
             // all LEDs in same color
             if (1 == 0) { // dummy
@@ -648,12 +659,7 @@ void rgblight_setrgb(uint8_t r, uint8_t g, uint8_t b) {
     }
 
     for (uint8_t i = rgblight_ranges.effect_start_pos; i < rgblight_ranges.effect_end_pos; i++) {
-        led[i].r = r;
-        led[i].g = g;
-        led[i].b = b;
-#ifdef RGBW
-        led[i].w = 0;
-#endif
+        setrgb(r, g, b, &led[i]);
     }
     rgblight_set();
 }
@@ -663,12 +669,7 @@ void rgblight_setrgb_at(uint8_t r, uint8_t g, uint8_t b, uint8_t index) {
         return;
     }
 
-    led[index].r = r;
-    led[index].g = g;
-    led[index].b = b;
-#ifdef RGBW
-    led[index].w = 0;
-#endif
+    setrgb(r, g, b, &led[index]);
     rgblight_set();
 }
 
@@ -677,9 +678,8 @@ void rgblight_sethsv_at(uint8_t hue, uint8_t sat, uint8_t val, uint8_t index) {
         return;
     }
 
-    LED_TYPE tmp_led;
-    sethsv(hue, sat, val, &tmp_led);
-    rgblight_setrgb_at(tmp_led.r, tmp_led.g, tmp_led.b, index);
+    RGB rgb = sethsv_color(hue, sat, val);
+    rgblight_setrgb_at(rgb.r, rgb.g, rgb.b, index);
 }
 
 #if defined(RGBLIGHT_EFFECT_BREATHING) || defined(RGBLIGHT_EFFECT_RAINBOW_MOOD) || defined(RGBLIGHT_EFFECT_RAINBOW_SWIRL) || defined(RGBLIGHT_EFFECT_SNAKE) || defined(RGBLIGHT_EFFECT_KNIGHT) || defined(RGBLIGHT_EFFECT_TWINKLE)
@@ -700,12 +700,7 @@ void rgblight_setrgb_range(uint8_t r, uint8_t g, uint8_t b, uint8_t start, uint8
     }
 
     for (uint8_t i = start; i < end; i++) {
-        led[i].r = r;
-        led[i].g = g;
-        led[i].b = b;
-#ifdef RGBW
-        led[i].w = 0;
-#endif
+        setrgb(r, g, b, &led[i]);
     }
     rgblight_set();
     wait_ms(1);
@@ -716,9 +711,8 @@ void rgblight_sethsv_range(uint8_t hue, uint8_t sat, uint8_t val, uint8_t start,
         return;
     }
 
-    LED_TYPE tmp_led;
-    sethsv(hue, sat, val, &tmp_led);
-    rgblight_setrgb_range(tmp_led.r, tmp_led.g, tmp_led.b, start, end);
+    RGB rgb = sethsv_color(hue, sat, val);
+    rgblight_setrgb_range(rgb.r, rgb.g, rgb.b, start, end);
 }
 
 #ifndef RGBLIGHT_SPLIT
@@ -1380,9 +1374,7 @@ void rgblight_effect_rgbtest(animation_status_t *anim) {
     uint8_t        b;
 
     if (maxval == 0) {
-        LED_TYPE tmp_led;
-        sethsv(0, 255, RGBLIGHT_LIMIT_VAL, &tmp_led);
-        maxval = tmp_led.r;
+        maxval = sethsv_color(0, 255, RGBLIGHT_LIMIT_VAL).r;
     }
     g = r = b = 0;
     switch (anim->pos) {
@@ -0,0 +1,111 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "rgblight.h"
+#include "color_calibration.h"
+#include "ws2812_mock.h"
+}
+
+static const rgblight_segment_t layer_segments[] = {{1, 2, HSV_CYAN}, RGBLIGHT_END_SEGMENTS};
+static const rgblight_segment_t *const layers[]  = {layer_segments, NULL};
+
+class RgblightColorCalibration : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        rgblight_layers = NULL;
+        rgblight_set_layer_state(0, false);
+        rgblight_enable_noeeprom();
+        rgblight_mode_noeeprom(RGBLIGHT_MODE_STATIC_LIGHT);
+        setleds_count = 0;
+    }
+
+    // what an LED is sent when it is set to this colour, calibrated exactly once
+    static void expect_sent(uint8_t index, uint8_t red, uint8_t green, uint8_t blue) {
+        EXPECT_EQ(sent_leds[index].r, color_calibration_value(COLOR_CALIBRATION_RED, red)) << "LED " << +index;
+        EXPECT_EQ(sent_leds[index].g, color_calibration_value(COLOR_CALIBRATION_GREEN, green)) << "LED " << +index;
+        EXPECT_EQ(sent_leds[index].b, color_calibration_value(COLOR_CALIBRATION_BLUE, blue)) << "LED " << +index;
+    }
+
+    static void expect_sent_hsv(uint8_t index, uint8_t hue, uint8_t sat, uint8_t val) {
+        RGB rgb = hsv_to_rgb((HSV){hue, sat, val});
+        expect_sent(index, rgb.r, rgb.g, rgb.b);
+    }
+};
+
+TEST_F(RgblightColorCalibration, TableIsNotTheIdentity) {
+    EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_RED, 200), 100);
+    EXPECT_EQ(color_calibration_value(COLOR_CALIBRATION_GREEN, 200), 200);
+    EXPECT_LT(color_calibration_value(COLOR_CALIBRATION_BLUE, 200), 200);
+}
+
+TEST_F(RgblightColorCalibration, SetrgbAtIsCalibratedOnce) {
+    rgblight_setrgb_at(200, 100, 150, 2);
+    EXPECT_EQ(setleds_count, 1);
+    EXPECT_EQ(sent_num_leds, RGBLED_NUM);
+    expect_sent(2, 200, 100, 150);
+}
+
+TEST_F(RgblightColorCalibration, SetrgbIsCalibratedOnce) {
+    rgblight_setrgb(200, 100, 150);
+    EXPECT_EQ(setleds_count, 1);
+    for (uint8_t i = 0; i < RGBLED_NUM; i++) {
+        expect_sent(i, 200, 100, 150);
+    }
+
+    rgblight_setrgb_range(20, 40, 60, 1, 3);
+    EXPECT_EQ(setleds_count, 2);
+    expect_sent(0, 200, 100, 150);
+    expect_sent(1, 20, 40, 60);
+    expect_sent(2, 20, 40, 60);
+    expect_sent(3, 200, 100, 150);
+}
+
+TEST_F(RgblightColorCalibration, SethsvAtIsCalibratedOnce) {
+    rgblight_sethsv_at(HSV_ORANGE, 0);
+    EXPECT_EQ(setleds_count, 1);
+    expect_sent_hsv(0, HSV_ORANGE);
+
+    rgblight_sethsv_noeeprom(HSV_PURPLE);
+    for (uint8_t i = 0; i < RGBLED_NUM; i++) {
+        expect_sent_hsv(i, HSV_PURPLE);
+    }
+}
+
+TEST_F(RgblightColorCalibration, SendingAgainDoesNotCalibrateAgain) {
+    rgblight_setrgb(200, 100, 150);
+    rgblight_set();
+    rgblight_set();
+    EXPECT_EQ(setleds_count, 3);
+    for (uint8_t i = 0; i < RGBLED_NUM; i++) {
+        expect_sent(i, 200, 100, 150);
+    }
+}
+
+TEST_F(RgblightColorCalibration, LayersAreCalibratedOnce) {
+    rgblight_layers = layers;
+    rgblight_sethsv_noeeprom(HSV_PURPLE);
+    rgblight_set_layer_state(0, true);
+    rgblight_set();
+
+    // the layer is written over the static colour each time the LEDs are sent
+    expect_sent_hsv(0, HSV_PURPLE);
+    expect_sent_hsv(1, HSV_CYAN);
+    expect_sent_hsv(2, HSV_CYAN);
+    expect_sent_hsv(3, HSV_PURPLE);
+}
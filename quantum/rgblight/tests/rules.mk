@@ -0,0 +1,16 @@
+rgblight_color_calibration_DEFS := -DNO_DEBUG -DRGBLED_NUM=4 -DRGBLIGHT_LAYERS -DCOLOR_CALIBRATION_ENABLE \
+	-DCOLOR_CALIBRATION_GAIN_RED=128 -DCOLOR_CALIBRATION_GAMMA_BLUE=22
+
+rgblight_color_calibration_INC := \
+	$(QUANTUM_PATH)/rgblight \
+	$(QUANTUM_PATH)/color_calibration \
+	$(QUANTUM_PATH)/rgblight/tests
+
+rgblight_color_calibration_SRC := \
+	$(QUANTUM_PATH)/rgblight/tests/ws2812_mock.c \
+	$(QUANTUM_PATH)/rgblight/tests/rgblight_color_calibration_tests.cpp \
+	$(QUANTUM_PATH)/rgblight/rgblight.c \
+	$(QUANTUM_PATH)/color_calibration/color_calibration.c \
+	$(QUANTUM_PATH)/color.c \
+	$(QUANTUM_PATH)/sync_timer.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/timer.c
@@ -0,0 +1 @@
+TEST_LIST += rgblight_color_calibration
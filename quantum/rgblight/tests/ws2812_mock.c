@@ -0,0 +1,37 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "ws2812_mock.h"
+
+LED_TYPE sent_leds[RGBLED_NUM];
+uint16_t sent_num_leds = 0;
+uint32_t setleds_count = 0;
+
+void ws2812_setleds(LED_TYPE *ledarray, uint16_t number_of_leds) {
+    memcpy(sent_leds, ledarray, number_of_leds * sizeof(LED_TYPE));
+    sent_num_leds = number_of_leds;
+    setleds_count++;
+}
+
+/* rgblight_init() is not used, the tests set the configuration up themselves */
+bool eeconfig_is_enabled(void) {
+    return true;
+}
+
+void eeconfig_init(void) {}
@@ -30,9 +30,12 @@ sequencer_config_t sequencer_config = {
     {0},      // track notes
     60,       // tempo
     SQ_RES_4, // resolution
+    0,        // swing
+    {0},      // step velocities
+    {0},      // step gates
 };
 
-sequencer_state_t sequencer_internal_state = {0, 0, 0, 0, SEQUENCER_PHASE_ATTACK};
+sequencer_state_t sequencer_internal_state = {0, 0, 0, 0, SEQUENCER_PHASE_ATTACK, 0};
 
 bool is_sequencer_on(void) {
     return sequencer_config.enabled;
@@ -43,8 +46,9 @@ void sequencer_on(void) {
     sequencer_config.enabled               = true;
     sequencer_internal_state.current_track = 0;
     sequencer_internal_state.current_step  = 0;
-    sequencer_internal_state.timer         = timer_read();
-    sequencer_internal_state.phase         = SEQUENCER_PHASE_ATTACK;
+    sequencer_internal_state.timer          = timer_read();
+    sequencer_internal_state.phase          = SEQUENCER_PHASE_ATTACK;
+    sequencer_internal_state.step_remainder = 0;
 }
 
 void sequencer_off(void) {
@@ -68,14 +72,18 @@ void sequencer_set_track_notes(const uint16_t track_notes[SEQUENCER_TRACKS]) {
 }
 
 bool is_sequencer_track_active(uint8_t track) {
-    return (sequencer_internal_state.active_tracks >> track) & true;
+    return track < SEQUENCER_TRACKS && (sequencer_internal_state.active_tracks >> track) & true;
 }
 
 void sequencer_set_track_activation(uint8_t track, bool value) {
+    if (track >= SEQUENCER_TRACKS) {
+        dprintf("sequencer: track %d is out of range\n", track);
+        return;
+    }
     if (value) {
-        sequencer_internal_state.active_tracks |= (1 << track);
+        sequencer_internal_state.active_tracks |= ((sequencer_tracks_t)1 << track);
     } else {
-        sequencer_internal_state.active_tracks &= ~(1 << track);
+        sequencer_internal_state.active_tracks &= ~((sequencer_tracks_t)1 << track);
     }
     dprintf("sequencer: track %d is %s\n", track, value ? "active" : "inactive");
 }
@@ -88,7 +96,7 @@ void sequencer_toggle_single_active_track(uint8_t track) {
     if (is_sequencer_track_active(track)) {
         sequencer_internal_state.active_tracks = 0;
     } else {
-        sequencer_internal_state.active_tracks = 1 << track;
+        sequencer_internal_state.active_tracks = (sequencer_tracks_t)1 << track;
     }
 }
 
@@ -97,7 +105,7 @@ bool is_sequencer_step_on(uint8_t step) {
 }
 
 bool is_sequencer_step_on_for_track(uint8_t step, uint8_t track) {
-    return step < SEQUENCER_STEPS && (sequencer_config.steps[step] >> track) & true;
+    return step < SEQUENCER_STEPS && track < SEQUENCER_TRACKS && (sequencer_config.steps[step] >> track) & true;
 }
 
 void sequencer_set_step(uint8_t step, bool value) {
@@ -138,7 +146,8 @@ uint8_t sequencer_get_tempo(void) {
 
 void sequencer_set_tempo(uint8_t tempo) {
     if (tempo > 0) {
-        sequencer_config.tempo = tempo;
+        sequencer_config.tempo                  = tempo;
+        sequencer_internal_state.step_remainder = 0;
         dprintf("sequencer: tempo set to %d bpm\n", tempo);
     } else {
         dprintln("sequencer: cannot set tempo to 0");
@@ -164,7 +173,8 @@ sequencer_resolution_t sequencer_get_resolution(void) {
 
 void sequencer_set_resolution(sequencer_resolution_t resolution) {
     if (resolution >= 0 && resolution < SEQUENCER_RESOLUTIONS) {
-        sequencer_config.resolution = resolution;
+        sequencer_config.resolution             = resolution;
+        sequencer_internal_state.step_remainder = 0;
         dprintf("sequencer: resolution set to %d\n", resolution);
     } else {
         dprintf("sequencer: resolution %d is out of range\n", resolution);
@@ -179,25 +189,108 @@ void sequencer_decrease_resolution(void) {
     sequencer_set_resolution(sequencer_config.resolution - 1);
 }
 
+uint8_t sequencer_get_swing(void) {
+    return sequencer_config.swing;
+}
+
+void sequencer_set_swing(uint8_t swing) {
+    if (swing <= SEQUENCER_MAX_SWING) {
+        sequencer_config.swing = swing;
+        dprintf("sequencer: swing set to %d%%\n", swing);
+    } else {
+        dprintf("sequencer: swing %d%% is out of range\n", swing);
+    }
+}
+
+uint8_t sequencer_get_step_velocity(uint8_t step) {
+    if (step >= SEQUENCER_STEPS || sequencer_config.step_velocities[step] == 0) {
+        return SEQUENCER_DEFAULT_VELOCITY;
+    }
+    return sequencer_config.step_velocities[step];
+}
+
+void sequencer_set_step_velocity(uint8_t step, uint8_t velocity) {
+    if (step < SEQUENCER_STEPS && velocity <= 127) {
+        sequencer_config.step_velocities[step] = velocity;
+        dprintf("sequencer: step %d velocity set to %d\n", step, velocity);
+    } else {
+        dprintf("sequencer: step %d velocity %d is out of range\n", step, velocity);
+    }
+}
+
+uint8_t sequencer_get_step_gate(uint8_t step) {
+    return step < SEQUENCER_STEPS ? sequencer_config.step_gates[step] : 0;
+}
+
+void sequencer_set_step_gate(uint8_t step, uint8_t gate) {
+    if (step < SEQUENCER_STEPS && gate <= 100) {
+        sequencer_config.step_gates[step] = gate;
+        dprintf("sequencer: step %d gate set to %d%%\n", step, gate);
+    } else {
+        dprintf("sequencer: step %d gate %d%% is out of range\n", step, gate);
+    }
+}
+
 uint8_t sequencer_get_current_step(void) {
     return sequencer_internal_state.current_step;
 }
 
-void sequencer_phase_attack(void) {
-    dprintf("sequencer: step %d\n", sequencer_internal_state.current_step);
-    dprintf("sequencer: time %d\n", timer_read());
+/**
+ * A bar of 4 beats lasts 240000 / tempo ms and holds `steps_per_bar` steps, so one step lasts
+ * 240000 / (tempo * steps_per_bar) ms. Keeping that fraction exact is what prevents the drift.
+ */
+static uint16_t sequencer_step_divisor(void) {
+    uint8_t  tempo         = sequencer_config.tempo ? sequencer_config.tempo : 60;
+    uint16_t steps_per_bar = 2 << (sequencer_config.resolution / 2);
+    if (sequencer_config.resolution % 2 != 0) {
+        steps_per_bar = steps_per_bar * 3 / 2;
+    }
+    return tempo * steps_per_bar;
+}
 
-    if (sequencer_internal_state.current_track == 0) {
-        sequencer_internal_state.timer = timer_read();
+// Time from the start of the current step to the start of the next one, in ms
+static uint32_t sequencer_next_step_offset(void) {
+    return (sequencer_internal_state.step_remainder + 240000UL) / sequencer_step_divisor();
+}
+
+static void sequencer_advance_step(void) {
+    uint16_t divisor  = sequencer_step_divisor();
+    uint32_t duration = sequencer_internal_state.step_remainder + 240000UL;
+
+    sequencer_internal_state.timer += duration / divisor;
+    sequencer_internal_state.step_remainder = duration % divisor;
+    sequencer_internal_state.current_step   = (sequencer_internal_state.current_step + 1) % SEQUENCER_STEPS;
+}
+
+// Swing delays every odd step by a fraction of its duration
+static uint16_t sequencer_swing_offset(void) {
+    if (sequencer_internal_state.current_step % 2 == 0) {
+        return 0;
     }
+    return sequencer_next_step_offset() * sequencer_config.swing / 100;
+}
+
+static uint16_t sequencer_gate_length(void) {
+    uint8_t gate = sequencer_get_step_gate(sequencer_internal_state.current_step);
+    if (gate == 0) {
+        return SEQUENCER_PHASE_RELEASE_TIMEOUT;
+    }
+    return sequencer_next_step_offset() * gate / 100;
+}
 
-    if (timer_elapsed(sequencer_internal_state.timer) < sequencer_internal_state.current_track * SEQUENCER_TRACK_THROTTLE) {
+void sequencer_phase_attack(void) {
+    if (timer_elapsed(sequencer_internal_state.timer) < sequencer_swing_offset() + sequencer_internal_state.current_track * SEQUENCER_TRACK_THROTTLE) {
         return;
     }
 
+    if (sequencer_internal_state.current_track == 0) {
+        dprintf("sequencer: step %d\n", sequencer_internal_state.current_step);
+        dprintf("sequencer: time %d\n", timer_read());
+    }
+
 #if defined(MIDI_ENABLE) || defined(MIDI_MOCKED)
     if (is_sequencer_step_on_for_track(sequencer_internal_state.current_step, sequencer_internal_state.current_track)) {
-        process_midi_basic_noteon(midi_compute_note(sequencer_config.track_notes[sequencer_internal_state.current_track]));
+        process_midi_basic_noteon_velocity(midi_compute_note(sequencer_config.track_notes[sequencer_internal_state.current_track]), sequencer_get_step_velocity(sequencer_internal_state.current_step));
     }
 #endif
 
@@ -209,7 +302,7 @@ void sequencer_phase_attack(void) {
 }
 
 void sequencer_phase_release(void) {
-    if (timer_elapsed(sequencer_internal_state.timer) < SEQUENCER_PHASE_RELEASE_TIMEOUT + sequencer_internal_state.current_track * SEQUENCER_TRACK_THROTTLE) {
+    if (timer_elapsed(sequencer_internal_state.timer) < sequencer_swing_offset() + sequencer_gate_length() + sequencer_internal_state.current_track * SEQUENCER_TRACK_THROTTLE) {
         return;
     }
 #if defined(MIDI_ENABLE) || defined(MIDI_MOCKED)
@@ -225,12 +318,16 @@ void sequencer_phase_release(void) {
 }
 
 void sequencer_phase_pause(void) {
-    if (timer_elapsed(sequencer_internal_state.timer) < sequencer_get_step_duration()) {
+    if (timer_elapsed(sequencer_internal_state.timer) < sequencer_next_step_offset()) {
         return;
     }
 
-    sequencer_internal_state.current_step = (sequencer_internal_state.current_step + 1) % SEQUENCER_STEPS;
-    sequencer_internal_state.phase        = SEQUENCER_PHASE_ATTACK;
+    // Steps that were missed entirely, e.g. during a long blocking task, are skipped rather than played in a burst
+    do {
+        sequencer_advance_step();
+    } while (timer_elapsed(sequencer_internal_state.timer) >= sequencer_next_step_offset());
+
+    sequencer_internal_state.phase = SEQUENCER_PHASE_ATTACK;
 }
 
 void sequencer_task(void) {
@@ -23,11 +23,23 @@
 // Maximum number of steps: 256
 #ifndef SEQUENCER_STEPS
 #    define SEQUENCER_STEPS 16
+#elif SEQUENCER_STEPS > 256
+#    error "Maximum value of SEQUENCER_STEPS is 256"
 #endif
 
-// Maximum number of tracks: 8
+// Maximum number of tracks: 32
 #ifndef SEQUENCER_TRACKS
 #    define SEQUENCER_TRACKS 8
+#elif SEQUENCER_TRACKS > 32
+#    error "Maximum value of SEQUENCER_TRACKS is 32"
+#endif
+
+#if SEQUENCER_TRACKS <= 8
+typedef uint8_t sequencer_tracks_t;
+#elif SEQUENCER_TRACKS <= 16
+typedef uint16_t sequencer_tracks_t;
+#else
+typedef uint32_t sequencer_tracks_t;
 #endif
 
 #ifndef SEQUENCER_TRACK_THROTTLE
@@ -38,6 +50,16 @@
 #    define SEQUENCER_PHASE_RELEASE_TIMEOUT 30
 #endif
 
+// Velocity of the steps which have none set
+#ifndef SEQUENCER_DEFAULT_VELOCITY
+#    define SEQUENCER_DEFAULT_VELOCITY 127
+#endif
+
+// Maximum swing, in percent of a step
+#ifndef SEQUENCER_MAX_SWING
+#    define SEQUENCER_MAX_SWING 75
+#endif
+
 /**
  * Make sure that the items of this enumeration follow the powers of 2, separated by a ternary variant.
  * Check the implementation of `get_step_duration` for further explanation.
@@ -46,10 +68,13 @@ typedef enum { SQ_RES_2, SQ_RES_2T, SQ_RES_4, SQ_RES_4T, SQ_RES_8, SQ_RES_8T, SQ
 
 typedef struct {
     bool                   enabled;
-    uint8_t                steps[SEQUENCER_STEPS];
+    sequencer_tracks_t     steps[SEQUENCER_STEPS];
     uint16_t               track_notes[SEQUENCER_TRACKS];
     uint8_t                tempo; // Is a maximum tempo of 255 reasonable?
     sequencer_resolution_t resolution;
+    uint8_t                swing;                            // Delay of the odd steps, in percent of a step
+    uint8_t                step_velocities[SEQUENCER_STEPS]; // 0 means SEQUENCER_DEFAULT_VELOCITY
+    uint8_t                step_gates[SEQUENCER_STEPS];      // In percent of a step, 0 means SEQUENCER_PHASE_RELEASE_TIMEOUT
 } sequencer_config_t;
 
 /**
@@ -62,12 +87,18 @@ typedef enum sequencer_phase_t {
     SEQUENCER_PHASE_PAUSE    // t=step duration ms, loop
 } sequencer_phase_t;
 
+/**
+ * `timer` holds the start of the current step on the beat grid, which is never re-read from the clock.
+ * Steps are added to it exactly: `step_remainder` keeps the fraction of a millisecond left over by the
+ * previous steps, so the timing error stays below a millisecond however many beats have been played.
+ */
 typedef struct {
-    uint8_t           active_tracks;
-    uint8_t           current_track;
-    uint8_t           current_step;
-    uint16_t          timer;
-    sequencer_phase_t phase;
+    sequencer_tracks_t active_tracks;
+    uint8_t            current_track;
+    uint8_t            current_step;
+    uint16_t           timer;
+    sequencer_phase_t  phase;
+    uint16_t           step_remainder;
 } sequencer_state_t;
 
 extern sequencer_config_t sequencer_config;
@@ -111,6 +142,14 @@ void                   sequencer_set_resolution(sequencer_resolution_t resolutio
 void                   sequencer_increase_resolution(void);
 void                   sequencer_decrease_resolution(void);
 
+uint8_t sequencer_get_swing(void);
+void    sequencer_set_swing(uint8_t swing);
+
+uint8_t sequencer_get_step_velocity(uint8_t step);
+void    sequencer_set_step_velocity(uint8_t step, uint8_t velocity);
+uint8_t sequencer_get_step_gate(uint8_t step);
+void    sequencer_set_step_gate(uint8_t step, uint8_t gate);
+
 uint8_t sequencer_get_current_step(void);
 
 uint16_t sequencer_get_beat_duration(void);
@@ -20,7 +20,11 @@
 
 extern uint16_t last_noteon;
 extern uint16_t last_noteoff;
+extern uint8_t  last_velocity;
+extern uint32_t noteon_count;
+extern uint32_t noteoff_count;
 
 uint16_t midi_compute_note(uint16_t keycode);
 void     process_midi_basic_noteon(uint16_t note);
+void     process_midi_basic_noteon_velocity(uint16_t note, uint8_t velocity);
 void     process_midi_basic_noteoff(uint16_t note);
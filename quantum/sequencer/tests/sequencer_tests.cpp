@@ -16,6 +16,9 @@
 
 #include "gtest/gtest.h"
 
+#include <random>
+#include <vector>
+
 extern "C" {
 #include "sequencer.h"
 #include "midi_mock.h"
@@ -23,8 +26,9 @@ extern "C" {
 }
 
 extern "C" {
-void set_time(uint32_t t);
-void advance_time(uint32_t ms);
+void     set_time(uint32_t t);
+void     advance_time(uint32_t ms);
+uint32_t timer_read32(void);
 }
 
 class SequencerTest : public ::testing::Test {
@@ -42,14 +46,24 @@ class SequencerTest : public ::testing::Test {
 
         config_copy.tempo      = sequencer_config.tempo;
         config_copy.resolution = sequencer_config.resolution;
+        config_copy.swing      = sequencer_config.swing;
+
+        for (int i = 0; i < SEQUENCER_STEPS; i++) {
+            config_copy.step_velocities[i] = sequencer_config.step_velocities[i];
+            config_copy.step_gates[i]      = sequencer_config.step_gates[i];
+        }
 
-        state_copy.active_tracks = sequencer_internal_state.active_tracks;
-        state_copy.current_track = sequencer_internal_state.current_track;
-        state_copy.current_step  = sequencer_internal_state.current_step;
-        state_copy.timer         = sequencer_internal_state.timer;
+        state_copy.active_tracks  = sequencer_internal_state.active_tracks;
+        state_copy.current_track  = sequencer_internal_state.current_track;
+        state_copy.current_step   = sequencer_internal_state.current_step;
+        state_copy.timer          = sequencer_internal_state.timer;
+        state_copy.step_remainder = sequencer_internal_state.step_remainder;
 
-        last_noteon  = 0;
-        last_noteoff = 0;
+        last_noteon   = 0;
+        last_noteoff  = 0;
+        last_velocity = 0;
+        noteon_count  = 0;
+        noteoff_count = 0;
 
         set_time(0);
     }
@@ -67,11 +81,18 @@ class SequencerTest : public ::testing::Test {
 
         sequencer_config.tempo      = config_copy.tempo;
         sequencer_config.resolution = config_copy.resolution;
+        sequencer_config.swing      = config_copy.swing;
+
+        for (int i = 0; i < SEQUENCER_STEPS; i++) {
+            sequencer_config.step_velocities[i] = config_copy.step_velocities[i];
+            sequencer_config.step_gates[i]      = config_copy.step_gates[i];
+        }
 
-        sequencer_internal_state.active_tracks = state_copy.active_tracks;
-        sequencer_internal_state.current_track = state_copy.current_track;
-        sequencer_internal_state.current_step  = state_copy.current_step;
-        sequencer_internal_state.timer         = state_copy.timer;
+        sequencer_internal_state.active_tracks  = state_copy.active_tracks;
+        sequencer_internal_state.current_track  = state_copy.current_track;
+        sequencer_internal_state.current_step   = state_copy.current_step;
+        sequencer_internal_state.timer          = state_copy.timer;
+        sequencer_internal_state.step_remainder = state_copy.step_remainder;
     }
 
     sequencer_config_t config_copy;
@@ -590,3 +611,213 @@ TEST_F(SequencerTest, TestMatrixScanSequencerShouldLoopOnceSequenceIsOver) {
     EXPECT_EQ(sequencer_internal_state.current_track, 1);
     EXPECT_EQ(sequencer_internal_state.phase, SEQUENCER_PHASE_ATTACK);
 }
+
+TEST_F(SequencerTest, TestSetSwingUpperBound) {
+    sequencer_config.swing = 20;
+
+    sequencer_set_swing(SEQUENCER_MAX_SWING + 1);
+
+    EXPECT_EQ(sequencer_get_swing(), 20);
+}
+
+TEST_F(SequencerTest, TestStepVelocityDefault) {
+    sequencer_set_step_velocity(3, 0);
+    EXPECT_EQ(sequencer_get_step_velocity(3), SEQUENCER_DEFAULT_VELOCITY);
+
+    sequencer_set_step_velocity(3, 64);
+    EXPECT_EQ(sequencer_get_step_velocity(3), 64);
+
+    sequencer_set_step_velocity(3, 128);
+    EXPECT_EQ(sequencer_get_step_velocity(3), 64);
+}
+
+/**
+ * Runs the sequencer with all the steps of the first track on, calling sequencer_task after random
+ * delays of 1 to max_delay ms, and returns the time at which each note on was sent.
+ */
+std::vector<uint32_t> runSequencer(uint32_t steps, uint32_t max_delay, uint32_t seed) {
+    std::mt19937                            rng(seed);
+    std::uniform_int_distribution<uint32_t> delay(1, max_delay);
+    std::vector<uint32_t>                   attacks;
+
+    for (int i = 0; i < SEQUENCER_STEPS; i++) {
+        sequencer_config.steps[i] = 1;
+    }
+    sequencer_on();
+
+    while (attacks.size() < steps) {
+        uint32_t count = noteon_count;
+        sequencer_task();
+        if (noteon_count != count) {
+            attacks.push_back(timer_read32());
+        }
+        advance_time(delay(rng));
+    }
+    sequencer_off();
+    return attacks;
+}
+
+// Start of step n on an ideal beat grid, in ms
+uint32_t idealStepTime(uint32_t n, uint8_t tempo, uint32_t steps_per_bar) {
+    return (uint64_t)n * 240000 / (tempo * steps_per_bar);
+}
+
+TEST_F(SequencerTest, TestTimingDoesNotDriftUnderLoopJitter) {
+    // 1/8T at 119 bpm is 168.07ms per step, which cannot be represented in whole milliseconds
+    sequencer_config.tempo      = 119;
+    sequencer_config.resolution = SQ_RES_8T;
+
+    const uint32_t max_delay = 5;
+    // 2000 beats
+    std::vector<uint32_t> attacks = runSequencer(6000, max_delay, 42);
+
+    for (uint32_t n = 0; n < attacks.size(); n++) {
+        int32_t error = attacks[n] - idealStepTime(n, 119, 12);
+        // Each note is late by at most one loop iteration, whatever the number of beats before it
+        ASSERT_GE(error, 0) << "step " << n;
+        ASSERT_LE(error, (int32_t)max_delay) << "step " << n;
+    }
+}
+
+TEST_F(SequencerTest, TestTimingDoesNotDriftAtAnyTempo) {
+    for (uint8_t tempo : {37, 60, 97, 128, 173, 255}) {
+        sequencer_config.tempo      = tempo;
+        sequencer_config.resolution = SQ_RES_8T;
+
+        std::vector<uint32_t> attacks = runSequencer(3000, 3, tempo);
+        uint32_t              start   = attacks.front();
+
+        int32_t error = attacks.back() - start - idealStepTime(attacks.size() - 1, tempo, 12);
+        EXPECT_GE(error, 0) << "tempo " << (int)tempo;
+        EXPECT_LE(error, 3) << "tempo " << (int)tempo;
+    }
+}
+
+TEST_F(SequencerTest, TestSkipsStepsMissedDuringStall) {
+    sequencer_config.tempo      = 120;
+    sequencer_config.resolution = SQ_RES_16;
+    sequencer_config.steps[0]   = 1;
+    sequencer_config.steps[1]   = 1;
+    sequencer_on();
+
+    sequencer_task();
+    EXPECT_EQ(noteon_count, 1);
+
+    // Block for a bit more than 3 steps, then resume
+    advance_time(3 * 125 + 10);
+    for (int i = 0; i < 100; i++) {
+        sequencer_task();
+        advance_time(1);
+    }
+
+    // Only step 3 was played after the stall, and the grid is unchanged
+    EXPECT_EQ(noteon_count, 1);
+    EXPECT_EQ(sequencer_internal_state.current_step, 3);
+    EXPECT_EQ(sequencer_internal_state.timer, 3 * 125);
+}
+
+TEST_F(SequencerTest, TestSwingDelaysOddSteps) {
+    sequencer_config.tempo      = 120;
+    sequencer_config.resolution = SQ_RES_16;
+    sequencer_set_swing(20);
+
+    std::vector<uint32_t> attacks = runSequencer(8, 1, 0);
+
+    for (uint32_t n = 0; n < attacks.size(); n++) {
+        // One 16th at tempo=120 lasts 125ms, odd steps are delayed by 20% of it
+        EXPECT_EQ(attacks[n], n * 125 + (n % 2 ? 25 : 0)) << "step " << n;
+    }
+}
+
+TEST_F(SequencerTest, TestStepVelocityAndGate) {
+    sequencer_config.tempo      = 120;
+    sequencer_config.resolution = SQ_RES_16;
+    sequencer_config.steps[0]   = 1;
+    sequencer_set_step_velocity(0, 42);
+    sequencer_set_step_gate(0, 80);
+    sequencer_on();
+
+    sequencer_task();
+    EXPECT_EQ(noteon_count, 1);
+    EXPECT_EQ(last_velocity, 42);
+
+    // The note is held for 80% of the 125ms step, the tracks are then released one by one
+    while (noteoff_count == 0) {
+        advance_time(1);
+        sequencer_task();
+    }
+    EXPECT_GE(timer_read32(), 100);
+    EXPECT_LE(timer_read32(), 100 + SEQUENCER_TRACKS * (SEQUENCER_TRACK_THROTTLE + 1));
+}
+
+struct NoteTiming {
+    uint32_t on;
+    uint32_t off;
+};
+
+/**
+ * Runs the sequencer with all the steps of the last track on, calling sequencer_task every ms, and
+ * returns the times at which each note was switched on and off. The last track is the first one
+ * released, so its note off is not delayed by the release of the other tracks.
+ */
+std::vector<NoteTiming> runLastTrack(uint32_t steps) {
+    std::vector<NoteTiming> notes;
+
+    for (int i = 0; i < SEQUENCER_STEPS; i++) {
+        sequencer_config.steps[i] = 1 << (SEQUENCER_TRACKS - 1);
+    }
+    sequencer_on();
+
+    while (notes.size() < steps || notes.back().off == 0) {
+        uint32_t on  = noteon_count;
+        uint32_t off = noteoff_count;
+        sequencer_task();
+        if (noteoff_count != off) {
+            notes.back().off = timer_read32();
+        }
+        if (noteon_count != on) {
+            notes.push_back({timer_read32(), 0});
+        }
+        advance_time(1);
+    }
+    sequencer_off();
+    return notes;
+}
+
+TEST_F(SequencerTest, TestSwungBeatOnAndOffTimes) {
+    sequencer_config.tempo      = 120;
+    sequencer_config.resolution = SQ_RES_16;
+    sequencer_set_swing(20);
+
+    std::vector<NoteTiming> notes = runLastTrack(8);
+    uint32_t                track = (SEQUENCER_TRACKS - 1) * SEQUENCER_TRACK_THROTTLE;
+
+    for (uint32_t n = 0; n < notes.size(); n++) {
+        // Odd steps start 25ms late and keep the default gate, so they end 25ms late too
+        uint32_t swing = n % 2 ? 25 : 0;
+        EXPECT_EQ(notes[n].on, n * 125 + swing + track) << "step " << n;
+        EXPECT_EQ(notes[n].off, n * 125 + swing + track + SEQUENCER_PHASE_RELEASE_TIMEOUT) << "step " << n;
+    }
+}
+
+TEST_F(SequencerTest, TestShortenedGateReleasesEarly) {
+    sequencer_config.tempo      = 120;
+    sequencer_config.resolution = SQ_RES_16;
+    sequencer_set_swing(20);
+    sequencer_set_step_gate(1, 40);
+    sequencer_set_step_gate(2, 80);
+
+    std::vector<NoteTiming> notes = runLastTrack(3);
+    uint32_t                track = (SEQUENCER_TRACKS - 1) * SEQUENCER_TRACK_THROTTLE;
+
+    // The default gate
+    EXPECT_EQ(notes[0].on, track);
+    EXPECT_EQ(notes[0].off, track + SEQUENCER_PHASE_RELEASE_TIMEOUT);
+    // 40% of a 125ms step, after the swing
+    EXPECT_EQ(notes[1].on, 125 + 25 + track);
+    EXPECT_EQ(notes[1].off, 125 + 25 + track + 50);
+    // 80% of a 125ms step, still released before the next step starts
+    EXPECT_EQ(notes[2].on, 250 + track);
+    EXPECT_EQ(notes[2].off, 250 + track + 100);
+    EXPECT_LT(notes[2].off, 375 + track);
+}
@@ -16,7 +16,6 @@
 #include "split_util.h"
 #include "matrix.h"
 #include "keyboard.h"
-#include "config.h"
 #include "timer.h"
 #include "transport.h"
 #include "quantum.h"
@@ -35,10 +34,15 @@
 #    include "rgblight.h"
 #endif
 
+#if defined(USE_I2C) && defined(OLED_ENABLE)
+#    include "oled_driver.h"
+#endif
+
 #ifndef SPLIT_USB_TIMEOUT
 #    define SPLIT_USB_TIMEOUT 2000
 #endif
 
+// Only used while the role is waited for before the handedness is known
 #ifndef SPLIT_USB_TIMEOUT_POLL
 #    define SPLIT_USB_TIMEOUT_POLL 10
 #endif
@@ -93,20 +97,6 @@ static inline bool usbHasActiveConnection(void) { return true; }
 static inline void usbDisable(void) {}
 #    endif
 
-bool usbIsActive(void) {
-    for (uint8_t i = 0; i < (SPLIT_USB_TIMEOUT / SPLIT_USB_TIMEOUT_POLL); i++) {
-        // This will return true if a USB connection has been established
-        if (usb_connected_state()) {
-            return true;
-        }
-        wait_ms(SPLIT_USB_TIMEOUT_POLL);
-    }
-    return false;
-}
-#else
-static inline bool usbIsActive(void) {
-    return usb_vbus_state();
-}
 #endif
 
 #ifdef SPLIT_HAND_MATRIX_GRID
@@ -150,25 +140,95 @@ __attribute__((weak)) bool is_keyboard_left(void) {
     return is_keyboard_master();
 }
 
-__attribute__((weak)) bool is_keyboard_master(void) {
-    static enum { UNKNOWN, MASTER, SLAVE } usbstate = UNKNOWN;
+typedef enum { SPLIT_ROLE_UNKNOWN, SPLIT_ROLE_PENDING, SPLIT_ROLE_MASTER, SPLIT_ROLE_SLAVE } split_role_t;
 
-    // only check once, as this is called often
-    if (usbstate == UNKNOWN) {
-        usbstate = usbIsActive() ? MASTER : SLAVE;
+static split_role_t split_role = SPLIT_ROLE_UNKNOWN;
+// Set once the handedness is known without the role, so negotiation can run alongside matrix scanning
+static bool split_role_deferred   = false;
+static bool split_transport_ready = false;
+static bool split_slave_started   = false;
+
+#if defined(SPLIT_USB_DETECT)
+static uint16_t      split_role_timer;
+static volatile bool split_handshake_received = false;
 
+// Called from the transport when the other half talks to us as its slave
+void split_role_handshake(void) {
+    split_handshake_received = true;
+}
+#endif
+
+static void split_role_set(split_role_t role) {
+    split_role = role;
+
+    if (role == SPLIT_ROLE_SLAVE) {
         // Avoid NO_USB_STARTUP_CHECK - Disable USB as the previous checks seem to enable it somehow
-        if (usbstate == SLAVE) {
-            usb_disconnect();
+        usb_disconnect();
+    } else if (split_transport_ready) {
+        // split_pre_init() saw an undecided role, so the master side of the transport is brought up here
+        if (split_slave_started) {
+            transport_slave_stop();
+            split_slave_started = false;
+        }
+#if defined(USE_I2C) && defined(SSD1306OLED)
+        matrix_master_OLED_init();
+#endif
+        transport_master_init();
+#if defined(USE_I2C) && defined(OLED_ENABLE)
+        oled_init(OLED_ROTATION_0);
+#endif
+    }
+}
+
+// Settles the role from the first of USB enumeration, a handshake from the other half, or the timeout
+static void split_role_task(void) {
+#if defined(SPLIT_USB_DETECT)
+    if (split_role == SPLIT_ROLE_UNKNOWN) {
+        split_role_timer = timer_read();
+        split_role       = SPLIT_ROLE_PENDING;
+    }
+
+    // This will return true if a USB connection has been established
+    if (usb_connected_state()) {
+        split_role_set(SPLIT_ROLE_MASTER);
+    } else if (split_handshake_received || timer_elapsed(split_role_timer) >= SPLIT_USB_TIMEOUT) {
+        split_role_set(SPLIT_ROLE_SLAVE);
+    }
+#else
+    split_role_set(usb_vbus_state() ? SPLIT_ROLE_MASTER : SPLIT_ROLE_SLAVE);
+#endif
+}
+
+__attribute__((weak)) bool is_keyboard_master(void) {
+    if (split_role <= SPLIT_ROLE_PENDING) {
+        split_role_task();
+
+#if defined(SPLIT_USB_DETECT)
+        // The handedness may depend on the role, so wait for it as before
+        while (!split_role_deferred && split_role == SPLIT_ROLE_PENDING) {
+            wait_ms(SPLIT_USB_TIMEOUT_POLL);
+            split_role_task();
         }
+#endif
     }
 
-    return (usbstate == MASTER);
+    return (split_role == SPLIT_ROLE_MASTER);
 }
 
 // this code runs before the keyboard is fully initialized
 void split_pre_init(void) {
+    split_role            = SPLIT_ROLE_UNKNOWN;
+    split_role_deferred   = false;
+    split_transport_ready = false;
+    split_slave_started   = false;
+#if defined(SPLIT_USB_DETECT)
+    split_handshake_received = false;
+#endif
+
     isLeftHand = is_keyboard_left();
+    // If the handedness did not need the role, the role can be settled
+    // later on, while the matrix is already being scanned
+    split_role_deferred = true;
 
 #if defined(RGBLIGHT_ENABLE) && defined(RGBLED_SPLIT)
     uint8_t num_rgb_leds_split[2] = RGBLED_SPLIT;
@@ -186,6 +246,7 @@ void split_pre_init(void) {
 #endif
         transport_master_init();
     }
+    split_transport_ready = true;
 }
 
 // this code runs after the keyboard is fully initialized
@@ -193,7 +254,9 @@ void split_pre_init(void) {
 //     receiving before the init process has completed
 void split_post_init(void) {
     if (!is_keyboard_master()) {
+        // Undecided halves listen as slaves, so the other half can tell them their role
         transport_slave_init();
+        split_slave_started = true;
     }
 }
 
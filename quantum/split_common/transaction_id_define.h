@@ -37,6 +37,10 @@ enum serial_transaction_id {
     PUT_SYNC_TIMER,
 #endif // DISABLE_SYNC_TIMER
 
+#ifdef SPLIT_USB_DETECT
+    PUT_SPLIT_ROLE,
+#endif // SPLIT_USB_DETECT
+
 #if !defined(NO_ACTION_LAYER) && defined(SPLIT_LAYER_STATE_ENABLE)
     PUT_LAYER_STATE,
     PUT_DEFAULT_LAYER_STATE,
@@ -26,8 +26,6 @@
 #include "split_util.h"
 #include "transaction_id_define.h"
 
-#define SYNC_TIMER_OFFSET 2
-
 #ifndef FORCED_SYNC_THROTTLE_MS
 #    define FORCED_SYNC_THROTTLE_MS 100
 #endif // FORCED_SYNC_THROTTLE_MS
@@ -222,26 +220,36 @@ static bool sync_timer_handlers_master(matrix_row_t master_matrix[], matrix_row_
 
     bool okay = true;
     if (timer_elapsed32(last_update) >= FORCED_SYNC_THROTTLE_MS) {
-        uint32_t sync_timer = sync_timer_read32() + SYNC_TIMER_OFFSET;
+        uint32_t start      = timer_read32();
+        uint32_t sync_timer = start + sync_timer_latency();
         okay &= transport_write(PUT_SYNC_TIMER, &sync_timer, sizeof(sync_timer));
         if (okay) {
             last_update = timer_read32();
+            sync_timer_latency_sample(last_update - start);
         }
     }
     return okay;
 }
 
+// Local time at which the last sync arrived, taken in the transport callback
+// rather than the next matrix scan, so the scan rate does not add to the latency
+static volatile uint32_t sync_timer_received;
+
+static void sync_timer_callback(uint8_t initiator2target_buffer_size, const void *initiator2target_buffer, uint8_t target2initiator_buffer_size, void *target2initiator_buffer) {
+    sync_timer_received = timer_read32();
+}
+
 static void sync_timer_handlers_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
     static uint32_t last_sync_timer = 0;
     if (last_sync_timer != split_shmem->sync_timer) {
         last_sync_timer = split_shmem->sync_timer;
-        sync_timer_update(last_sync_timer);
+        sync_timer_update_at(last_sync_timer, sync_timer_received);
     }
 }
 
 #    define TRANSACTIONS_SYNC_TIMER_MASTER() TRANSACTION_HANDLER_MASTER(sync_timer)
 #    define TRANSACTIONS_SYNC_TIMER_SLAVE() TRANSACTION_HANDLER_SLAVE(sync_timer)
-#    define TRANSACTIONS_SYNC_TIMER_REGISTRATIONS [PUT_SYNC_TIMER] = trans_initiator2target_initializer(sync_timer),
+#    define TRANSACTIONS_SYNC_TIMER_REGISTRATIONS [PUT_SYNC_TIMER] = trans_initiator2target_initializer_cb(sync_timer, sync_timer_callback),
 
 #else // DISABLE_SYNC_TIMER
 
@@ -251,6 +259,38 @@ static void sync_timer_handlers_slave(matrix_row_t master_matrix[], matrix_row_t
 
 #endif // DISABLE_SYNC_TIMER
 
+////////////////////////////////////////////////////
+// Split role
+
+#ifdef SPLIT_USB_DETECT
+
+static bool split_role_handlers_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    static uint32_t last_update = 0;
+    static bool     sent        = false;
+    uint8_t         role        = 1;
+
+    // Tell a slave that is still waiting for USB that it will not get it
+    bool okay = send_if_condition(PUT_SPLIT_ROLE, &last_update, !sent, &role, sizeof(role));
+    sent |= okay;
+    return okay;
+}
+
+static void split_role_handshake_callback(uint8_t initiator2target_buffer_size, const void *initiator2target_buffer, uint8_t target2initiator_buffer_size, void *target2initiator_buffer) {
+    split_role_handshake();
+}
+
+#    define TRANSACTIONS_SPLIT_ROLE_MASTER() TRANSACTION_HANDLER_MASTER(split_role)
+#    define TRANSACTIONS_SPLIT_ROLE_SLAVE()
+#    define TRANSACTIONS_SPLIT_ROLE_REGISTRATIONS [PUT_SPLIT_ROLE] = trans_initiator2target_initializer_cb(split_role, split_role_handshake_callback),
+
+#else // SPLIT_USB_DETECT
+
+#    define TRANSACTIONS_SPLIT_ROLE_MASTER()
+#    define TRANSACTIONS_SPLIT_ROLE_SLAVE()
+#    define TRANSACTIONS_SPLIT_ROLE_REGISTRATIONS
+
+#endif // SPLIT_USB_DETECT
+
 ////////////////////////////////////////////////////
 // Layer state
 
@@ -679,6 +719,7 @@ split_transaction_desc_t split_transaction_table[NUM_TOTAL_TRANSACTIONS] = {
     TRANSACTIONS_MASTER_MATRIX_REGISTRATIONS
     TRANSACTIONS_ENCODERS_REGISTRATIONS
     TRANSACTIONS_SYNC_TIMER_REGISTRATIONS
+    TRANSACTIONS_SPLIT_ROLE_REGISTRATIONS
     TRANSACTIONS_LAYER_STATE_REGISTRATIONS
     TRANSACTIONS_LED_STATE_REGISTRATIONS
     TRANSACTIONS_MODS_REGISTRATIONS
@@ -705,6 +746,7 @@ bool transactions_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix
     TRANSACTIONS_MASTER_MATRIX_MASTER();
     TRANSACTIONS_ENCODERS_MASTER();
     TRANSACTIONS_SYNC_TIMER_MASTER();
+    TRANSACTIONS_SPLIT_ROLE_MASTER();
     TRANSACTIONS_LAYER_STATE_MASTER();
     TRANSACTIONS_LED_STATE_MASTER();
     TRANSACTIONS_MODS_MASTER();
@@ -724,6 +766,7 @@ void transactions_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[
     TRANSACTIONS_MASTER_MATRIX_SLAVE();
     TRANSACTIONS_ENCODERS_SLAVE();
     TRANSACTIONS_SYNC_TIMER_SLAVE();
+    TRANSACTIONS_SPLIT_ROLE_SLAVE();
     TRANSACTIONS_LAYER_STATE_SLAVE();
     TRANSACTIONS_LED_STATE_SLAVE();
     TRANSACTIONS_MODS_SLAVE();
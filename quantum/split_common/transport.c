@@ -46,6 +46,9 @@ void transport_master_init(void) {
 void transport_slave_init(void) {
     i2c_slave_init(SLAVE_I2C_ADDRESS);
 }
+void transport_slave_stop(void) {
+    i2c_slave_stop();
+}
 
 i2c_status_t transport_trigger_callback(int8_t id) {
     // If there's no callback, indicate that we were successful
@@ -99,6 +102,9 @@ void transport_master_init(void) {
 void transport_slave_init(void) {
     soft_serial_target_init();
 }
+void transport_slave_stop(void) {
+    soft_serial_target_stop();
+}
 
 bool transport_execute_transaction(int8_t id, const void *initiator2target_buf, uint16_t initiator2target_length, void *target2initiator_buf, uint16_t target2initiator_length) {
     split_transaction_desc_t *trans = &split_transaction_table[id];
@@ -33,6 +33,7 @@
 
 void transport_master_init(void);
 void transport_slave_init(void);
+void transport_slave_stop(void);
 
 // returns false if valid data not received from slave
 bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]);
@@ -142,6 +143,10 @@ typedef struct _split_shared_memory_t {
     uint32_t sync_timer;
 #endif // DISABLE_SYNC_TIMER
 
+#ifdef SPLIT_USB_DETECT
+    uint8_t split_role;
+#endif // SPLIT_USB_DETECT
+
 #if !defined(NO_ACTION_LAYER) && defined(SPLIT_LAYER_STATE_ENABLE)
     split_layers_sync_t layers;
 #endif // !defined(NO_ACTION_LAYER) && defined(SPLIT_LAYER_STATE_ENABLE)
@@ -27,15 +27,125 @@ SOFTWARE.
 #include "keyboard.h"
 
 #if defined(SPLIT_KEYBOARD) && !defined(DISABLE_SYNC_TIMER)
-volatile int32_t sync_timer_ms;
+// The slave follows the master clock with a phase-locked loop: each sync
+// nudges the phase by a fraction of the error and the rate by a smaller
+// fraction, so the two crystals' frequency difference is tracked without
+// the reading jumping around whenever a sync arrives.
+
+// Errors larger than this (first sync, master reset) step the clock instead
+#    ifndef SYNC_TIMER_STEP_THRESHOLD
+#        define SYNC_TIMER_STEP_THRESHOLD 50
+#    endif
+
+// Loop gains, as shifts: the phase error is corrected by 1/2^PHASE per
+// sync and the rate by 1/2^RATE of the error per elapsed millisecond
+#    ifndef SYNC_TIMER_PHASE_SHIFT
+#        define SYNC_TIMER_PHASE_SHIFT 3
+#    endif
+#    ifndef SYNC_TIMER_RATE_SHIFT
+#        define SYNC_TIMER_RATE_SHIFT 7
+#    endif
+
+// Rates are fractions of a millisecond per millisecond, in 1/2^24 units;
+// the limit (about 1.5%) and the anchor span keep dt * rate within 32 bits
+#    define SYNC_TIMER_FRAC_BITS 24
+#    define SYNC_TIMER_FRAC_MASK ((1UL << SYNC_TIMER_FRAC_BITS) - 1)
+#    define SYNC_TIMER_RATE_LIMIT (1L << 18)
+#    define SYNC_TIMER_ANCHOR_SPAN 4096
+
+// The master adds the one-way link latency to each sync it sends, taken as
+// half the smoothed round trip of the syncs. Round trips are read in whole
+// ms, but start at a random point within a ms, so their average resolves a
+// fraction of a ms; the estimate is kept in 1/256 ms and rounded when used.
+#    ifndef SYNC_TIMER_LATENCY_SHIFT
+#        define SYNC_TIMER_LATENCY_SHIFT 3
+#    endif
+#    define SYNC_TIMER_ROUND_TRIP_MAX 1000
+
+static int32_t sync_latency_q8;
+
+static bool     sync_locked;
+static uint32_t sync_local;  // local time of the anchor
+static uint32_t sync_master; // master time at the anchor, whole ms
+static uint32_t sync_frac;   // and the fraction of a ms
+static int32_t  sync_rate;   // master ms per local ms, minus one
+static uint32_t sync_last_sample;
+static uint32_t sync_last_read;
 
 void sync_timer_init(void) {
-    sync_timer_ms = 0;
+    sync_locked     = false;
+    sync_rate       = 0;
+    sync_last_read  = 0;
+    sync_latency_q8 = 0;
 }
 
-void sync_timer_update(uint32_t time) {
+void sync_timer_latency_sample(uint32_t round_trip) {
+    if (round_trip > SYNC_TIMER_ROUND_TRIP_MAX) return;
+
+    // half the round trip, in 1/256 ms
+    int32_t error = (int32_t)(round_trip << 7) - sync_latency_q8;
+    sync_latency_q8 += error / (1 << SYNC_TIMER_LATENCY_SHIFT);
+}
+
+uint32_t sync_timer_latency(void) {
+    return (sync_latency_q8 + 128) >> 8;
+}
+
+/* Moves the anchor to local time `local`, along the current rate */
+static void sync_timer_advance(uint32_t local) {
+    while (local != sync_local) {
+        uint32_t dt = local - sync_local;
+        if (dt > SYNC_TIMER_ANCHOR_SPAN) dt = SYNC_TIMER_ANCHOR_SPAN;
+
+        int32_t corr = (int32_t)dt * sync_rate + (int32_t)sync_frac;
+        sync_master += dt + (corr >> SYNC_TIMER_FRAC_BITS);
+        sync_frac = corr & SYNC_TIMER_FRAC_MASK;
+        sync_local += dt;
+    }
+}
+
+static void sync_timer_step(uint32_t time, uint32_t local) {
+    sync_local       = local;
+    sync_master      = time;
+    sync_frac        = 1UL << (SYNC_TIMER_FRAC_BITS - 1); // the sample was truncated to whole ms
+    sync_last_sample = local;
+    sync_last_read   = time;
+    sync_locked      = true;
+}
+
+void sync_timer_update_at(uint32_t time, uint32_t local) {
     if (is_keyboard_master()) return;
-    sync_timer_ms = time - timer_read32();
+
+    if (!sync_locked) {
+        sync_timer_step(time, local);
+        return;
+    }
+
+    sync_timer_advance(local);
+    int32_t error = time - sync_master;
+    if (error > SYNC_TIMER_STEP_THRESHOLD || error < -SYNC_TIMER_STEP_THRESHOLD) {
+        sync_timer_step(time, local);
+        return;
+    }
+
+    // error in 1/256 ms, against the middle of the sampled millisecond
+    int32_t error_q8 = error * 256 + 128 - (int32_t)(sync_frac >> (SYNC_TIMER_FRAC_BITS - 8));
+
+    int32_t frac = (int32_t)sync_frac + (error_q8 << (SYNC_TIMER_FRAC_BITS - 8 - SYNC_TIMER_PHASE_SHIFT));
+    sync_master += frac >> SYNC_TIMER_FRAC_BITS;
+    sync_frac = frac & SYNC_TIMER_FRAC_MASK;
+
+    uint32_t interval = local - sync_last_sample;
+    sync_last_sample  = local;
+    if (interval > 0 && interval <= UINT16_MAX) {
+        sync_rate += (error_q8 << (SYNC_TIMER_FRAC_BITS - 8 - SYNC_TIMER_RATE_SHIFT)) / (int32_t)interval;
+        if (sync_rate > SYNC_TIMER_RATE_LIMIT) sync_rate = SYNC_TIMER_RATE_LIMIT;
+        if (sync_rate < -SYNC_TIMER_RATE_LIMIT) sync_rate = -SYNC_TIMER_RATE_LIMIT;
+    }
+}
+
+void sync_timer_update(uint32_t time) {
+    sync_timer_update_at(time, timer_read32());
 }
 
 uint16_t sync_timer_read(void) {
@@ -45,7 +155,21 @@ uint16_t sync_timer_read(void) {
 
 uint32_t sync_timer_read32(void) {
     if (is_keyboard_master()) return timer_read32();
-    return sync_timer_ms + timer_read32();
+    if (!sync_locked) return timer_read32();
+
+    uint32_t now = timer_read32();
+    if (now - sync_local >= SYNC_TIMER_ANCHOR_SPAN) {
+        sync_timer_advance(now);
+    }
+    int32_t  dt   = now - sync_local;
+    uint32_t time = sync_master + dt + ((dt * sync_rate + (int32_t)sync_frac) >> SYNC_TIMER_FRAC_BITS);
+
+    // Phase corrections may pull the estimate back a little; hold until it catches up
+    if ((int32_t)(time - sync_last_read) < 0) {
+        return sync_last_read;
+    }
+    sync_last_read = time;
+    return time;
 }
 
 uint16_t sync_timer_elapsed(uint16_t last) {
@@ -35,18 +35,24 @@ extern "C" {
 #if defined(SPLIT_KEYBOARD) && !defined(DISABLE_SYNC_TIMER)
 void     sync_timer_init(void);
 void     sync_timer_update(uint32_t time);
+void     sync_timer_update_at(uint32_t time, uint32_t local);
 uint16_t sync_timer_read(void);
 uint32_t sync_timer_read32(void);
 uint16_t sync_timer_elapsed(uint16_t last);
 uint32_t sync_timer_elapsed32(uint32_t last);
+void     sync_timer_latency_sample(uint32_t round_trip);
+uint32_t sync_timer_latency(void);
 #else
 #    define sync_timer_init()
 #    define sync_timer_clear()
 #    define sync_timer_update(t)
+#    define sync_timer_update_at(t, l)
 #    define sync_timer_read() timer_read()
 #    define sync_timer_read32() timer_read32()
 #    define sync_timer_elapsed(t) timer_elapsed(t)
 #    define sync_timer_elapsed32(t) timer_elapsed32(t)
+#    define sync_timer_latency_sample(r)
+#    define sync_timer_latency() 0
 #endif
 
 #ifdef __cplusplus
@@ -38,6 +38,8 @@
 #    define VIA_QMK_RGBLIGHT_ENABLE
 #endif
 
+#include <string.h>
+
 #include "quantum.h"
 
 #include "via.h"
@@ -56,6 +58,10 @@
 #include "vialrgb.h"
 #endif
 
+#ifdef QMK_SETTINGS
+#include "qmk_settings.h"
+#endif
+
 // Forward declare some helpers.
 #if defined(VIA_QMK_BACKLIGHT_ENABLE)
 void via_qmk_backlight_set_value(uint8_t *data);
@@ -121,7 +127,20 @@ void via_init(void) {
     // If the EEPROM has the magic, the data is good.
     // OK to load from EEPROM.
     if (!via_eeprom_is_valid()) {
-        eeconfig_init_via();
+        // A new firmware build: carry over whatever the stored layout
+        // allows, and only fall back to defaults when there is none.
+        if (dynamic_keymap_migrate()) {
+            via_eeprom_set_valid(true);
+            // settings were loaded before the regions were moved into place
+#ifdef VIAL_ENABLE
+            vial_init();
+#endif
+#ifdef QMK_SETTINGS
+            qmk_settings_init();
+#endif
+        } else {
+            eeconfig_init_via();
+        }
     }
 }
 
@@ -134,6 +153,8 @@ void eeconfig_init_via(void) {
     dynamic_keymap_reset();
     // This resets the macros in EEPROM to nothing.
     dynamic_keymap_macro_reset();
+    // Record the layout the regions were written with, for later migrations
+    dynamic_keymap_save_schema();
     // Save the magic number last, in case saving was interrupted
     via_eeprom_set_valid(true);
 }
@@ -212,257 +233,379 @@ __attribute__((weak)) void raw_hid_receive_kb(uint8_t *data, uint8_t length) {
     *command_id         = id_unhandled;
 }
 
-// VIA handles received HID messages first, and will route to
-// raw_hid_receive_kb() for command IDs that are not handled here.
-// This gives the keyboard code level the ability to handle the command
-// specifically.
-//
-// raw_hid_send() is called at the end, with the same buffer, which was
-// possibly modified with returned values.
-void raw_hid_receive(uint8_t *data, uint8_t length) {
-    uint8_t *command_id   = &(data[0]);
-    uint8_t *command_data = &(data[1]);
+// Commands that write large parts of the EEPROM are acknowledged right away
+// and carried out by via_task(), one region or buffer write per call, so the
+// USB receive path never blocks on them.
+enum via_deferred_op {
+    via_deferred_eeprom_reset      = (1 << 0),
+    via_deferred_keymap_reset      = (1 << 1),
+    via_deferred_macro_reset       = (1 << 2),
+    via_deferred_keymap_set_buffer = (1 << 3),
+    via_deferred_macro_set_buffer  = (1 << 4),
+};
+
+static uint8_t via_deferred        = 0;
+static uint8_t via_deferred_region = 0;
+
+// A buffer write keeps its offset, size and data here until via_task() gets to it
+#define VIA_COMMAND_SIZE 32
+static uint8_t via_deferred_write[VIA_COMMAND_SIZE];
+
+// A command arriving while a deferred one is still being carried out waits
+// here, and is answered once that is done, so that it sees its result. Hosts
+// wait for each answer before sending the next command, so one is enough;
+// any further one is answered with id_busy.
+static uint8_t via_queued_command[VIA_COMMAND_SIZE];
+static uint8_t via_queued_length = 0;
+
+static void via_process_command(uint8_t *data, uint8_t length);
+
+void via_task(void) {
+    if (via_deferred & via_deferred_eeprom_reset) {
+        // covers everything else that may be pending
+        eeconfig_init_via();
+        via_deferred = 0;
+    } else if (via_deferred & via_deferred_keymap_reset) {
+        // the same regions as dynamic_keymap_reset()
+        dynamic_keymap_reset_region(via_deferred_region++, 0);
+        if (via_deferred_region == DYNAMIC_KEYMAP_REGION_MACRO) {
+            via_deferred &= ~via_deferred_keymap_reset;
+        }
+    } else if (via_deferred & via_deferred_macro_reset) {
+        dynamic_keymap_macro_reset();
+        via_deferred &= ~via_deferred_macro_reset;
+    } else if (via_deferred & via_deferred_keymap_set_buffer) {
+        uint8_t *command_data = &(via_deferred_write[1]);
+        dynamic_keymap_set_buffer((command_data[0] << 8) | command_data[1], command_data[2], &command_data[3]);
+        via_deferred &= ~via_deferred_keymap_set_buffer;
+    } else if (via_deferred & via_deferred_macro_set_buffer) {
+        uint8_t *command_data = &(via_deferred_write[1]);
+        dynamic_keymap_macro_set_buffer((command_data[0] << 8) | command_data[1], command_data[2], &command_data[3]);
+        via_deferred &= ~via_deferred_macro_set_buffer;
+    } else if (via_queued_length) {
+        uint8_t length    = via_queued_length;
+        via_queued_length = 0;
+        via_process_command(via_queued_command, length);
+    }
+}
 
-#ifdef VIAL_ENABLE
-    /* When unlock is in progress, we can only react to a subset of commands */
-    if (vial_unlock_in_progress) {
-        if (data[0] != id_vial_prefix)
-            goto skip;
-        uint8_t cmd = data[1];
-        if (cmd != vial_get_keyboard_id && cmd != vial_get_size && cmd != vial_get_def && cmd != vial_get_unlock_status && cmd != vial_unlock_start && cmd != vial_unlock_poll)
-            goto skip;
+static void via_defer(uint8_t op) {
+    if (op == via_deferred_keymap_reset) {
+        via_deferred_region = 0;
     }
-#endif
+    via_deferred |= op;
+}
+
+static void via_defer_write(uint8_t op, const uint8_t *data, uint8_t length) {
+    memcpy(via_deferred_write, data, length < sizeof(via_deferred_write) ? length : sizeof(via_deferred_write));
+    via_defer(op);
+}
 
-    switch (*command_id) {
-        case id_get_protocol_version: {
-            command_data[0] = VIA_PROTOCOL_VERSION >> 8;
-            command_data[1] = VIA_PROTOCOL_VERSION & 0xFF;
+static void via_cmd_get_protocol_version(uint8_t *data, uint8_t length) {
+    uint8_t *command_data = &(data[1]);
+    command_data[0]       = VIA_PROTOCOL_VERSION >> 8;
+    command_data[1]       = VIA_PROTOCOL_VERSION & 0xFF;
+}
+
+static void via_cmd_get_keyboard_value(uint8_t *data, uint8_t length) {
+    uint8_t *command_data = &(data[1]);
+    switch (command_data[0]) {
+        case id_uptime: {
+            uint32_t value  = timer_read32();
+            command_data[1] = (value >> 24) & 0xFF;
+            command_data[2] = (value >> 16) & 0xFF;
+            command_data[3] = (value >> 8) & 0xFF;
+            command_data[4] = value & 0xFF;
+            break;
+        }
+        case id_layout_options: {
+            uint32_t value  = via_get_layout_options();
+            command_data[1] = (value >> 24) & 0xFF;
+            command_data[2] = (value >> 16) & 0xFF;
+            command_data[3] = (value >> 8) & 0xFF;
+            command_data[4] = value & 0xFF;
             break;
         }
-        case id_get_keyboard_value: {
-            switch (command_data[0]) {
-                case id_uptime: {
-                    uint32_t value  = timer_read32();
-                    command_data[1] = (value >> 24) & 0xFF;
-                    command_data[2] = (value >> 16) & 0xFF;
-                    command_data[3] = (value >> 8) & 0xFF;
-                    command_data[4] = value & 0xFF;
-                    break;
-                }
-                case id_layout_options: {
-                    uint32_t value  = via_get_layout_options();
-                    command_data[1] = (value >> 24) & 0xFF;
-                    command_data[2] = (value >> 16) & 0xFF;
-                    command_data[3] = (value >> 8) & 0xFF;
-                    command_data[4] = value & 0xFF;
-                    break;
-                }
-                case id_switch_matrix_state: {
+        case id_switch_matrix_state: {
 #ifdef VIAL_ENABLE
-                    /* Disable wannabe keylogger unless unlocked */
-                    if (!vial_unlocked)
-                        goto skip;
+            /* Disable wannabe keylogger unless unlocked */
+            if (!vial_unlocked)
+                return;
 #endif
 
 #if ((MATRIX_COLS / 8 + 1) * MATRIX_ROWS <= 28)
-                    uint8_t i = 1;
-                    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-                        matrix_row_t value = matrix_get_row(row);
+            uint8_t i = 1;
+            for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                matrix_row_t value = matrix_get_row(row);
 #    if (MATRIX_COLS > 24)
-                        command_data[i++] = (value >> 24) & 0xFF;
+                command_data[i++] = (value >> 24) & 0xFF;
 #    endif
 #    if (MATRIX_COLS > 16)
-                        command_data[i++] = (value >> 16) & 0xFF;
+                command_data[i++] = (value >> 16) & 0xFF;
 #    endif
 #    if (MATRIX_COLS > 8)
-                        command_data[i++] = (value >> 8) & 0xFF;
+                command_data[i++] = (value >> 8) & 0xFF;
 #    endif
-                        command_data[i++] = value & 0xFF;
-                    }
-#endif
-                    break;
-                }
-                default: {
-                    raw_hid_receive_kb(data, length);
-                    break;
-                }
-            }
-            break;
-        }
-        case id_set_keyboard_value: {
-            switch (command_data[0]) {
-                case id_layout_options: {
-                    uint32_t value = ((uint32_t)command_data[1] << 24) | ((uint32_t)command_data[2] << 16) | ((uint32_t)command_data[3] << 8) | (uint32_t)command_data[4];
-                    via_set_layout_options(value);
-                    break;
-                }
-                default: {
-                    raw_hid_receive_kb(data, length);
-                    break;
-                }
+                command_data[i++] = value & 0xFF;
             }
+#endif
             break;
         }
-        case id_dynamic_keymap_get_keycode: {
-            uint16_t keycode = dynamic_keymap_get_keycode(command_data[0], command_data[1], command_data[2]);
-            command_data[3]  = keycode >> 8;
-            command_data[4]  = keycode & 0xFF;
+        default: {
+            raw_hid_receive_kb(data, length);
             break;
         }
-        case id_dynamic_keymap_set_keycode: {
-            dynamic_keymap_set_keycode(command_data[0], command_data[1], command_data[2], (command_data[3] << 8) | command_data[4]);
+    }
+}
+
+static void via_cmd_set_keyboard_value(uint8_t *data, uint8_t length) {
+    uint8_t *command_data = &(data[1]);
+    switch (command_data[0]) {
+        case id_layout_options: {
+            uint32_t value = ((uint32_t)command_data[1] << 24) | ((uint32_t)command_data[2] << 16) | ((uint32_t)command_data[3] << 8) | (uint32_t)command_data[4];
+            via_set_layout_options(value);
             break;
         }
-        case id_dynamic_keymap_reset: {
-            dynamic_keymap_reset();
+        default: {
+            raw_hid_receive_kb(data, length);
             break;
         }
-        case id_lighting_set_value: {
+    }
+}
+
+static void via_cmd_dynamic_keymap_get_keycode(uint8_t *data, uint8_t length) {
+    uint8_t *command_data = &(data[1]);
+    uint16_t keycode      = dynamic_keymap_get_keycode(command_data[0], command_data[1], command_data[2]);
+    command_data[3]       = keycode >> 8;
+    command_data[4]       = keycode & 0xFF;
+}
+
+static void via_cmd_dynamic_keymap_set_keycode(uint8_t *data, uint8_t length) {
+    uint8_t *command_data = &(data[1]);
+    dynamic_keymap_set_keycode(command_data[0], command_data[1], command_data[2], (command_data[3] << 8) | command_data[4]);
+}
+
+static void via_cmd_dynamic_keymap_reset(uint8_t *data, uint8_t length) {
+    via_defer(via_deferred_keymap_reset);
+}
+
+static void via_cmd_lighting_set_value(uint8_t *data, uint8_t length) {
 #if defined(VIA_QMK_BACKLIGHT_ENABLE)
-            via_qmk_backlight_set_value(command_data);
+    via_qmk_backlight_set_value(&(data[1]));
 #endif
 #if defined(VIA_QMK_RGBLIGHT_ENABLE)
-            via_qmk_rgblight_set_value(command_data);
+    via_qmk_rgblight_set_value(&(data[1]));
 #endif
 #if defined(VIALRGB_ENABLE)
-            vialrgb_set_value(data, length);
+    vialrgb_set_value(data, length);
 #endif
 #if defined(VIA_CUSTOM_LIGHTING_ENABLE)
-            raw_hid_receive_kb(data, length);
+    raw_hid_receive_kb(data, length);
 #endif
 #if !defined(VIA_QMK_BACKLIGHT_ENABLE) && !defined(VIA_QMK_RGBLIGHT_ENABLE) && !defined(VIALRGB_ENABLE) && !defined(VIA_CUSTOM_LIGHTING_ENABLE)
-            // Return the unhandled state
-            *command_id = id_unhandled;
+    // Return the unhandled state
+    data[0] = id_unhandled;
 #endif
-            break;
-        }
-        case id_lighting_get_value: {
+}
+
+static void via_cmd_lighting_get_value(uint8_t *data, uint8_t length) {
 #if defined(VIA_QMK_BACKLIGHT_ENABLE)
-            via_qmk_backlight_get_value(command_data);
+    via_qmk_backlight_get_value(&(data[1]));
 #endif
 #if defined(VIA_QMK_RGBLIGHT_ENABLE)
-            via_qmk_rgblight_get_value(command_data);
+    via_qmk_rgblight_get_value(&(data[1]));
 #endif
 #if defined(VIALRGB_ENABLE)
-            vialrgb_get_value(data, length);
+    vialrgb_get_value(data, length);
 #endif
 #if defined(VIA_CUSTOM_LIGHTING_ENABLE)
-            raw_hid_receive_kb(data, length);
+    raw_hid_receive_kb(data, length);
 #endif
 #if !defined(VIA_QMK_BACKLIGHT_ENABLE) && !defined(VIA_QMK_RGBLIGHT_ENABLE) && !defined(VIALRGB_ENABLE) && !defined(VIA_CUSTOM_LIGHTING_ENABLE)
-            // Return the unhandled state
-            *command_id = id_unhandled;
+    // Return the unhandled state
+    data[0] = id_unhandled;
 #endif
-            break;
-        }
-        case id_lighting_save: {
+}
+
+static void via_cmd_lighting_save(uint8_t *data, uint8_t length) {
 #if defined(VIA_QMK_BACKLIGHT_ENABLE)
-            eeconfig_update_backlight_current();
+    eeconfig_update_backlight_current();
 #endif
 #if defined(VIA_QMK_RGBLIGHT_ENABLE)
-            eeconfig_update_rgblight_current();
+    eeconfig_update_rgblight_current();
 #endif
 #if defined(VIALRGB_ENABLE)
-            vialrgb_save(data, length);
+    vialrgb_save(data, length);
 #endif
 #if defined(VIA_CUSTOM_LIGHTING_ENABLE)
-            raw_hid_receive_kb(data, length);
+    raw_hid_receive_kb(data, length);
 #endif
 #if !defined(VIA_QMK_BACKLIGHT_ENABLE) && !defined(VIA_QMK_RGBLIGHT_ENABLE) && !defined(VIALRGB_ENABLE) && !defined(VIA_CUSTOM_LIGHTING_ENABLE)
-            // Return the unhandled state
-            *command_id = id_unhandled;
+    // Return the unhandled state
+    data[0] = id_unhandled;
 #endif
-            break;
-        }
+}
+
 #ifdef VIA_EEPROM_ALLOW_RESET
-        case id_eeprom_reset: {
-            via_eeprom_set_valid(false);
-            eeconfig_init_via();
-            break;
-        }
+static void via_cmd_eeprom_reset(uint8_t *data, uint8_t length) {
+    // invalidate right away, so the reset still happens on the next boot if power is lost first
+    via_eeprom_set_valid(false);
+    via_defer(via_deferred_eeprom_reset);
+}
 #endif
-        case id_dynamic_keymap_macro_get_count: {
-            command_data[0] = dynamic_keymap_macro_get_count();
-            break;
-        }
-        case id_dynamic_keymap_macro_get_buffer_size: {
-            uint16_t size   = dynamic_keymap_macro_get_buffer_size();
-            command_data[0] = size >> 8;
-            command_data[1] = size & 0xFF;
-            break;
-        }
-        case id_dynamic_keymap_macro_get_buffer: {
-            uint16_t offset = (command_data[0] << 8) | command_data[1];
-            uint16_t size   = command_data[2]; // size <= 28
-            if (size <= 28)
-                dynamic_keymap_macro_get_buffer(offset, size, &command_data[3]);
-            break;
-        }
-        case id_dynamic_keymap_macro_set_buffer: {
+
+#if defined(VIAL_ENABLE) && !defined(VIAL_INSECURE)
+/* As VIA removed bootloader jump entirely, we shall only keep it for secure builds */
+static void via_cmd_bootloader_jump(uint8_t *data, uint8_t length) {
+    /* Until keyboard is unlocked, don't allow jumping to bootloader */
+    if (!vial_unlocked)
+        return;
+    // Need to send data back before the jump
+    // Informs host that the command is handled
+    raw_hid_send(data, length);
+    // Give host time to read it
+    wait_ms(100);
+    bootloader_jump();
+}
+#endif
+
+static void via_cmd_dynamic_keymap_macro_get_count(uint8_t *data, uint8_t length) {
+    data[1] = dynamic_keymap_macro_get_count();
+}
+
+static void via_cmd_dynamic_keymap_macro_get_buffer_size(uint8_t *data, uint8_t length) {
+    uint16_t size = dynamic_keymap_macro_get_buffer_size();
+    data[1]       = size >> 8;
+    data[2]       = size & 0xFF;
+}
+
+static void via_cmd_dynamic_keymap_macro_get_buffer(uint8_t *data, uint8_t length) {
+    uint8_t *command_data = &(data[1]);
+    uint16_t offset       = (command_data[0] << 8) | command_data[1];
+    uint16_t size         = command_data[2]; // size <= 28
+    if (size <= 28)
+        dynamic_keymap_macro_get_buffer(offset, size, &command_data[3]);
+}
+
+static void via_cmd_dynamic_keymap_macro_set_buffer(uint8_t *data, uint8_t length) {
 #ifdef VIAL_ENABLE
-            /* Until keyboard is unlocked, don't allow changing macros */
-            if (!vial_unlocked)
-                goto skip;
+    /* Until keyboard is unlocked, don't allow changing macros */
+    if (!vial_unlocked)
+        return;
 #endif
-            uint16_t offset = (command_data[0] << 8) | command_data[1];
-            uint16_t size   = command_data[2]; // size <= 28
-            if (size <= 28)
-                dynamic_keymap_macro_set_buffer(offset, size, &command_data[3]);
-            break;
-        }
-        case id_dynamic_keymap_macro_reset: {
-            dynamic_keymap_macro_reset();
-            break;
-        }
-        case id_dynamic_keymap_get_layer_count: {
-            command_data[0] = dynamic_keymap_get_layer_count();
-            break;
-        }
-        case id_dynamic_keymap_get_buffer: {
-            uint16_t offset = (command_data[0] << 8) | command_data[1];
-            uint16_t size   = command_data[2]; // size <= 28
-            if (size <= 28)
-                dynamic_keymap_get_buffer(offset, size, &command_data[3]);
-            break;
-        }
-        case id_dynamic_keymap_set_buffer: {
-            uint16_t offset = (command_data[0] << 8) | command_data[1];
-            uint16_t size   = command_data[2]; // size <= 28
-            if (size <= 28)
-                dynamic_keymap_set_buffer(offset, size, &command_data[3]);
-            break;
-        }
-#if defined(VIAL_ENABLE) && !defined(VIAL_INSECURE)
-        /* As VIA removed bootloader jump entirely, we shall only keep it for secure builds */
-        case id_bootloader_jump: {
-            /* Until keyboard is unlocked, don't allow jumping to bootloader */
-            if (!vial_unlocked)
-                goto skip;
-            // Need to send data back before the jump
-            // Informs host that the command is handled
-            raw_hid_send(data, length);
-            // Give host time to read it
-            wait_ms(100);
-            bootloader_jump();
-            break;
-        }
+    uint8_t *command_data = &(data[1]);
+    uint16_t size         = command_data[2]; // size <= 28
+    if (size <= 28)
+        via_defer_write(via_deferred_macro_set_buffer, data, length);
+}
+
+static void via_cmd_dynamic_keymap_macro_reset(uint8_t *data, uint8_t length) {
+    via_defer(via_deferred_macro_reset);
+}
+
+static void via_cmd_dynamic_keymap_get_layer_count(uint8_t *data, uint8_t length) {
+    data[1] = dynamic_keymap_get_layer_count();
+}
+
+static void via_cmd_dynamic_keymap_get_buffer(uint8_t *data, uint8_t length) {
+    uint8_t *command_data = &(data[1]);
+    uint16_t offset       = (command_data[0] << 8) | command_data[1];
+    uint16_t size         = command_data[2]; // size <= 28
+    if (size <= 28)
+        dynamic_keymap_get_buffer(offset, size, &command_data[3]);
+}
+
+static void via_cmd_dynamic_keymap_set_buffer(uint8_t *data, uint8_t length) {
+    uint8_t *command_data = &(data[1]);
+    uint16_t size         = command_data[2]; // size <= 28
+    if (size <= 28)
+        via_defer_write(via_deferred_keymap_set_buffer, data, length);
+}
+
+typedef void (*via_command_handler_t)(uint8_t *data, uint8_t length);
+
+// Handlers by command ID. Commands without one are passed to raw_hid_receive_kb().
+static const via_command_handler_t PROGMEM via_command_handlers[] = {
+    [id_get_protocol_version]                 = via_cmd_get_protocol_version,
+    [id_get_keyboard_value]                   = via_cmd_get_keyboard_value,
+    [id_set_keyboard_value]                   = via_cmd_set_keyboard_value,
+    [id_dynamic_keymap_get_keycode]           = via_cmd_dynamic_keymap_get_keycode,
+    [id_dynamic_keymap_set_keycode]           = via_cmd_dynamic_keymap_set_keycode,
+    [id_dynamic_keymap_reset]                 = via_cmd_dynamic_keymap_reset,
+    [id_lighting_set_value]                   = via_cmd_lighting_set_value,
+    [id_lighting_get_value]                   = via_cmd_lighting_get_value,
+    [id_lighting_save]                        = via_cmd_lighting_save,
+#ifdef VIA_EEPROM_ALLOW_RESET
+    [id_eeprom_reset]                         = via_cmd_eeprom_reset,
 #endif
+#if defined(VIAL_ENABLE) && !defined(VIAL_INSECURE)
+    [id_bootloader_jump]                      = via_cmd_bootloader_jump,
+#endif
+    [id_dynamic_keymap_macro_get_count]       = via_cmd_dynamic_keymap_macro_get_count,
+    [id_dynamic_keymap_macro_get_buffer_size] = via_cmd_dynamic_keymap_macro_get_buffer_size,
+    [id_dynamic_keymap_macro_get_buffer]      = via_cmd_dynamic_keymap_macro_get_buffer,
+    [id_dynamic_keymap_macro_set_buffer]      = via_cmd_dynamic_keymap_macro_set_buffer,
+    [id_dynamic_keymap_macro_reset]           = via_cmd_dynamic_keymap_macro_reset,
+    [id_dynamic_keymap_get_layer_count]       = via_cmd_dynamic_keymap_get_layer_count,
+    [id_dynamic_keymap_get_buffer]            = via_cmd_dynamic_keymap_get_buffer,
+    [id_dynamic_keymap_set_buffer]            = via_cmd_dynamic_keymap_set_buffer,
+};
+
+// VIA handles received HID messages first, and will route to
+// raw_hid_receive_kb() for command IDs that are not handled here.
+// This gives the keyboard code level the ability to handle the command
+// specifically.
+//
+// raw_hid_send() is called at the end, with the same buffer, which was
+// possibly modified with returned values. While a deferred command is being
+// carried out, the command is queued and answered by via_task() instead.
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    if (via_deferred || via_queued_length) {
+        if (!via_queued_length && length <= sizeof(via_queued_command)) {
+            memcpy(via_queued_command, data, length);
+            via_queued_length = length;
+            return;
+        }
+        // the host did not wait for the queued command to be answered
+        data[0] = id_busy;
+        raw_hid_send(data, length);
+        return;
+    }
+
+    via_process_command(data, length);
+}
+
+static void via_process_command(uint8_t *data, uint8_t length) {
+    uint8_t command_id = data[0];
+
 #ifdef VIAL_ENABLE
-        case id_vial_prefix: {
-            vial_handle_cmd(data, length);
-            break;
-        }
+    /* When unlock is in progress, we can only react to a subset of commands */
+    if (vial_unlock_in_progress) {
+        if (command_id != id_vial_prefix)
+            goto skip;
+        uint8_t cmd = data[1];
+        if (cmd != vial_get_keyboard_id && cmd != vial_get_size && cmd != vial_get_def && cmd != vial_get_unlock_status && cmd != vial_unlock_start && cmd != vial_unlock_poll)
+            goto skip;
+    }
 #endif
-        default: {
-            // The command ID is not known let the keyboard implement it
-            raw_hid_receive_kb(data, length);
-            break;
+
+    if (command_id < sizeof(via_command_handlers) / sizeof(via_command_handlers[0])) {
+        via_command_handler_t handler = (via_command_handler_t)pgm_read_ptr(&via_command_handlers[command_id]);
+        if (handler) {
+            handler(data, length);
+            goto skip;
         }
     }
 #ifdef VIAL_ENABLE
-skip:
+    if (command_id == id_vial_prefix) {
+        vial_handle_cmd(data, length);
+        goto skip;
+    }
 #endif
+    // The command ID is not known let the keyboard implement it
+    raw_hid_receive_kb(data, length);
+
+skip:
     // Return the same buffer, optionally with values changed
     // (i.e. returning state to the host, or the unhandled state).
     raw_hid_send(data, length);
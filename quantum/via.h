@@ -78,6 +78,7 @@ enum via_command_id {
     id_dynamic_keymap_get_layer_count       = 0x11,
     id_dynamic_keymap_get_buffer            = 0x12,
     id_dynamic_keymap_set_buffer            = 0x13,
+    id_busy                                 = 0xFD, // in reply, while an earlier command is still being carried out
     id_vial_prefix                          = 0xFE,
     id_unhandled                            = 0xFF,
 };
@@ -156,6 +157,8 @@ void via_eeprom_set_valid(bool valid);
 // Called by QMK core to initialize dynamic keymaps etc.
 void eeconfig_init_via(void);
 void via_init(void);
+// Called by QMK core to carry out deferred EEPROM writes.
+void via_task(void);
 
 // Used by VIA to store and retrieve the layout options.
 uint32_t via_get_layout_options(void);
@@ -44,10 +44,6 @@ _Static_assert(VIAL_UNLOCK_NUM_KEYS < 15, "Max 15 unlock keys");
 _Static_assert(sizeof(vial_unlock_combo_rows) == sizeof(vial_unlock_combo_cols), "The number of unlock cols and rows should be the same");
 #endif
 
-#ifndef VIAL_ENCODER_KEYCODE_DELAY
-#define VIAL_ENCODER_KEYCODE_DELAY 10
-#endif
-
 #include "qmk_settings.h"
 
 #ifdef VIAL_TAP_DANCE_ENABLE
@@ -74,211 +70,284 @@ void vial_init(void) {
 #endif
 }
 
-void vial_handle_cmd(uint8_t *msg, uint8_t length) {
-    /* All packets must be fixed 32 bytes */
-    if (length != VIAL_RAW_EPSIZE)
-        return;
+#if defined(VIAL_ENCODERS_ENABLE) && VIAL_ENCODER_KEYCODE_DELAY > 0
+static void encoder_tap_task(void);
+#endif
 
-    /* msg[0] is 0xFE -- prefix vial magic */
-    switch (msg[1]) {
-        /* Get keyboard ID and Vial protocol version */
-        case vial_get_keyboard_id: {
-            uint8_t keyboard_uid[] = VIAL_KEYBOARD_UID;
-
-            memset(msg, 0, length);
-            msg[0] = VIAL_PROTOCOL_VERSION & 0xFF;
-            msg[1] = (VIAL_PROTOCOL_VERSION >> 8) & 0xFF;
-            msg[2] = (VIAL_PROTOCOL_VERSION >> 16) & 0xFF;
-            msg[3] = (VIAL_PROTOCOL_VERSION >> 24) & 0xFF;
-            memcpy(&msg[4], keyboard_uid, 8);
+void vial_task(void) {
+#if defined(VIAL_ENCODERS_ENABLE) && VIAL_ENCODER_KEYCODE_DELAY > 0
+    encoder_tap_task();
+#endif
+}
+
+/* Get keyboard ID and Vial protocol version */
+static void vial_cmd_get_keyboard_id(uint8_t *msg, uint8_t length) {
+    uint8_t keyboard_uid[] = VIAL_KEYBOARD_UID;
+
+    memset(msg, 0, length);
+    msg[0] = VIAL_PROTOCOL_VERSION & 0xFF;
+    msg[1] = (VIAL_PROTOCOL_VERSION >> 8) & 0xFF;
+    msg[2] = (VIAL_PROTOCOL_VERSION >> 16) & 0xFF;
+    msg[3] = (VIAL_PROTOCOL_VERSION >> 24) & 0xFF;
+    memcpy(&msg[4], keyboard_uid, 8);
 #ifdef VIALRGB_ENABLE
-            msg[12] = 1; /* bit flag to indicate vialrgb is supported - so third-party apps don't have to query json */
+    msg[12] = 1; /* bit flag to indicate vialrgb is supported - so third-party apps don't have to query json */
 #endif
-            break;
-        }
-        /* Retrieve keyboard definition size */
-        case vial_get_size: {
-            uint32_t sz = sizeof(keyboard_definition);
-            msg[0] = sz & 0xFF;
-            msg[1] = (sz >> 8) & 0xFF;
-            msg[2] = (sz >> 16) & 0xFF;
-            msg[3] = (sz >> 24) & 0xFF;
-            break;
-        }
-        /* Retrieve 32-bytes block of the definition, page ID encoded within 2 bytes */
-        case vial_get_def: {
-            uint32_t page = msg[2] + (msg[3] << 8);
-            uint32_t start = page * VIAL_RAW_EPSIZE;
-            uint32_t end = start + VIAL_RAW_EPSIZE;
-            if (end < start || start >= sizeof(keyboard_definition))
-                return;
-            if (end > sizeof(keyboard_definition))
-                end = sizeof(keyboard_definition);
-            memcpy_P(msg, &keyboard_definition[start], end - start);
-            break;
-        }
+}
+
+/* Retrieve keyboard definition size */
+static void vial_cmd_get_size(uint8_t *msg, uint8_t length) {
+    uint32_t sz = sizeof(keyboard_definition);
+    msg[0] = sz & 0xFF;
+    msg[1] = (sz >> 8) & 0xFF;
+    msg[2] = (sz >> 16) & 0xFF;
+    msg[3] = (sz >> 24) & 0xFF;
+}
+
+/* Retrieve 32-bytes block of the definition, page ID encoded within 2 bytes */
+static void vial_cmd_get_def(uint8_t *msg, uint8_t length) {
+    uint32_t page = msg[2] + (msg[3] << 8);
+    uint32_t start = page * VIAL_RAW_EPSIZE;
+    uint32_t end = start + VIAL_RAW_EPSIZE;
+    if (end < start || start >= sizeof(keyboard_definition))
+        return;
+    if (end > sizeof(keyboard_definition))
+        end = sizeof(keyboard_definition);
+    memcpy_P(msg, &keyboard_definition[start], end - start);
+}
+
 #ifdef VIAL_ENCODERS_ENABLE
-        case vial_get_encoder: {
-            uint8_t layer = msg[2];
-            uint8_t idx = msg[3];
-            uint16_t keycode = dynamic_keymap_get_encoder(layer, idx, 0);
-            msg[0]  = keycode >> 8;
-            msg[1]  = keycode & 0xFF;
-            keycode = dynamic_keymap_get_encoder(layer, idx, 1);
-            msg[2] = keycode >> 8;
-            msg[3] = keycode & 0xFF;
-            break;
-        }
-        case vial_set_encoder: {
-            dynamic_keymap_set_encoder(msg[2], msg[3], msg[4], (msg[5] << 8) | msg[6]);
-            break;
-        }
+static void vial_cmd_get_encoder(uint8_t *msg, uint8_t length) {
+    uint8_t layer = msg[2];
+    uint8_t idx = msg[3];
+    uint16_t keycode = dynamic_keymap_get_encoder(layer, idx, 0);
+    msg[0]  = keycode >> 8;
+    msg[1]  = keycode & 0xFF;
+    keycode = dynamic_keymap_get_encoder(layer, idx, 1);
+    msg[2] = keycode >> 8;
+    msg[3] = keycode & 0xFF;
+}
+
+static void vial_cmd_set_encoder(uint8_t *msg, uint8_t length) {
+    dynamic_keymap_set_encoder(msg[2], msg[3], msg[4], (msg[5] << 8) | msg[6]);
+}
 #endif
-        case vial_get_unlock_status: {
-            /* Reset message to all FF's */
-            memset(msg, 0xFF, length);
-            /* First byte of message contains the status: whether board is unlocked */
-            msg[0] = vial_unlocked;
-            /* Second byte is whether unlock is in progress */
-            msg[1] = vial_unlock_in_progress;
+
+static void vial_cmd_get_unlock_status(uint8_t *msg, uint8_t length) {
+    /* Reset message to all FF's */
+    memset(msg, 0xFF, length);
+    /* First byte of message contains the status: whether board is unlocked */
+    msg[0] = vial_unlocked;
+    /* Second byte is whether unlock is in progress */
+    msg[1] = vial_unlock_in_progress;
 #ifndef VIAL_INSECURE
-            /* Rest of the message are keys in the matrix that should be held to unlock the board */
-            for (size_t i = 0; i < VIAL_UNLOCK_NUM_KEYS; ++i) {
-                msg[2 + i * 2] = vial_unlock_combo_rows[i];
-                msg[2 + i * 2 + 1] = vial_unlock_combo_cols[i];
-            }
+    /* Rest of the message are keys in the matrix that should be held to unlock the board */
+    for (size_t i = 0; i < VIAL_UNLOCK_NUM_KEYS; ++i) {
+        msg[2 + i * 2] = vial_unlock_combo_rows[i];
+        msg[2 + i * 2 + 1] = vial_unlock_combo_cols[i];
+    }
 #endif
-            break;
-        }
-        case vial_unlock_start: {
-            vial_unlock_in_progress = 1;
-            vial_unlock_counter = VIAL_UNLOCK_COUNTER_MAX;
-            vial_unlock_timer = timer_read();
-            break;
-        }
-        case vial_unlock_poll: {
+}
+
+static void vial_cmd_unlock_start(uint8_t *msg, uint8_t length) {
+    vial_unlock_in_progress = 1;
+    vial_unlock_counter = VIAL_UNLOCK_COUNTER_MAX;
+    vial_unlock_timer = timer_read();
+}
+
+static void vial_cmd_unlock_poll(uint8_t *msg, uint8_t length) {
 #ifndef VIAL_INSECURE
-            if (vial_unlock_in_progress) {
-                int holding = 1;
-                for (size_t i = 0; i < VIAL_UNLOCK_NUM_KEYS; ++i)
-                    holding &= matrix_is_on(vial_unlock_combo_rows[i], vial_unlock_combo_cols[i]);
-
-                if (timer_elapsed(vial_unlock_timer) > 100 && holding) {
-                    vial_unlock_timer = timer_read();
-
-                    vial_unlock_counter--;
-                    if (vial_unlock_counter == 0) {
-                        /* ok unlock succeeded */
-                        vial_unlock_in_progress = 0;
-                        vial_unlocked = 1;
-                    }
-                } else {
-                    vial_unlock_counter = VIAL_UNLOCK_COUNTER_MAX;
-                }
+    if (vial_unlock_in_progress) {
+        int holding = 1;
+        for (size_t i = 0; i < VIAL_UNLOCK_NUM_KEYS; ++i)
+            holding &= matrix_is_on(vial_unlock_combo_rows[i], vial_unlock_combo_cols[i]);
+
+        if (timer_elapsed(vial_unlock_timer) > 100 && holding) {
+            vial_unlock_timer = timer_read();
+
+            vial_unlock_counter--;
+            if (vial_unlock_counter == 0) {
+                /* ok unlock succeeded */
+                vial_unlock_in_progress = 0;
+                vial_unlocked = 1;
             }
-#endif
-            msg[0] = vial_unlocked;
-            msg[1] = vial_unlock_in_progress;
-            msg[2] = vial_unlock_counter;
-            break;
+        } else {
+            vial_unlock_counter = VIAL_UNLOCK_COUNTER_MAX;
         }
-        case vial_lock: {
+    }
+#endif
+    msg[0] = vial_unlocked;
+    msg[1] = vial_unlock_in_progress;
+    msg[2] = vial_unlock_counter;
+}
+
+static void vial_cmd_lock(uint8_t *msg, uint8_t length) {
 #ifndef VIAL_INSECURE
-            vial_unlocked = 0;
+    vial_unlocked = 0;
 #endif
-            break;
-        }
-        case vial_qmk_settings_query: {
+}
+
+static void vial_cmd_qmk_settings_query(uint8_t *msg, uint8_t length) {
 #ifdef QMK_SETTINGS
-            uint16_t qsid_greater_than = msg[2] | (msg[3] << 8);
-            qmk_settings_query(qsid_greater_than, msg, length);
+    uint16_t qsid_greater_than = msg[2] | (msg[3] << 8);
+    qmk_settings_query(qsid_greater_than, msg, length);
 #else
-            memset(msg, 0xFF, length); /* indicate that we don't support any qsid */
+    memset(msg, 0xFF, length); /* indicate that we don't support any qsid */
 #endif
-            break;
-        }
+}
+
 #ifdef QMK_SETTINGS
-        case vial_qmk_settings_get: {
-            uint16_t qsid = msg[2] | (msg[3] << 8);
-            msg[0] = qmk_settings_get(qsid, &msg[1], length - 1);
+static void vial_cmd_qmk_settings_get(uint8_t *msg, uint8_t length) {
+    uint16_t qsid = msg[2] | (msg[3] << 8);
+    msg[0] = qmk_settings_get(qsid, &msg[1], length - 1);
+}
 
-            break;
-        }
-        case vial_qmk_settings_set: {
-            uint16_t qsid = msg[2] | (msg[3] << 8);
-            msg[0] = qmk_settings_set(qsid, &msg[4], length - 4);
+static void vial_cmd_qmk_settings_set(uint8_t *msg, uint8_t length) {
+    uint16_t qsid = msg[2] | (msg[3] << 8);
+    msg[0] = qmk_settings_set(qsid, &msg[4], length - 4);
+}
 
-            break;
-        }
-        case vial_qmk_settings_reset: {
-            qmk_settings_reset();
-            break;
-        }
+static void vial_cmd_qmk_settings_reset(uint8_t *msg, uint8_t length) {
+    qmk_settings_reset();
+}
 #endif
-        case vial_dynamic_entry_op: {
-            switch (msg[2]) {
-            case dynamic_vial_get_number_of_entries: {
-                memset(msg, 0, length);
-                msg[0] = VIAL_TAP_DANCE_ENTRIES;
-                msg[1] = VIAL_COMBO_ENTRIES;
-                msg[2] = VIAL_KEY_OVERRIDE_ENTRIES;
-                break;
-            }
+
+static void vial_entry_get_number_of_entries(uint8_t *msg, uint8_t length) {
+    memset(msg, 0, length);
+    msg[0] = VIAL_TAP_DANCE_ENTRIES;
+    msg[1] = VIAL_COMBO_ENTRIES;
+    msg[2] = VIAL_KEY_OVERRIDE_ENTRIES;
+}
+
 #ifdef VIAL_TAP_DANCE_ENABLE
-            case dynamic_vial_tap_dance_get: {
-                uint8_t idx = msg[3];
-                vial_tap_dance_entry_t td = { 0 };
-                msg[0] = dynamic_keymap_get_tap_dance(idx, &td);
-                memcpy(&msg[1], &td, sizeof(td));
-                break;
-            }
-            case dynamic_vial_tap_dance_set: {
-                uint8_t idx = msg[3];
-                vial_tap_dance_entry_t td;
-                memcpy(&td, &msg[4], sizeof(td));
-                msg[0] = dynamic_keymap_set_tap_dance(idx, &td);
-                reload_tap_dance();
-                break;
-            }
+static void vial_entry_tap_dance_get(uint8_t *msg, uint8_t length) {
+    uint8_t idx = msg[3];
+    vial_tap_dance_entry_t td = { 0 };
+    msg[0] = dynamic_keymap_get_tap_dance(idx, &td);
+    memcpy(&msg[1], &td, sizeof(td));
+}
+
+static void vial_entry_tap_dance_set(uint8_t *msg, uint8_t length) {
+    uint8_t idx = msg[3];
+    vial_tap_dance_entry_t td;
+    memcpy(&td, &msg[4], sizeof(td));
+    msg[0] = dynamic_keymap_set_tap_dance(idx, &td);
+    reload_tap_dance();
+}
 #endif
+
 #ifdef VIAL_COMBO_ENABLE
-            case dynamic_vial_combo_get: {
-                uint8_t idx = msg[3];
-                vial_combo_entry_t entry = { 0 };
-                msg[0] = dynamic_keymap_get_combo(idx, &entry);
-                memcpy(&msg[1], &entry, sizeof(entry));
-                break;
-            }
-            case dynamic_vial_combo_set: {
-                uint8_t idx = msg[3];
-                vial_combo_entry_t entry;
-                memcpy(&entry, &msg[4], sizeof(entry));
-                msg[0] = dynamic_keymap_set_combo(idx, &entry);
-                reload_combo();
-                break;
-            }
+static void vial_entry_combo_get(uint8_t *msg, uint8_t length) {
+    uint8_t idx = msg[3];
+    vial_combo_entry_t entry = { 0 };
+    msg[0] = dynamic_keymap_get_combo(idx, &entry);
+    memcpy(&msg[1], &entry, sizeof(entry));
+}
+
+static void vial_entry_combo_set(uint8_t *msg, uint8_t length) {
+    uint8_t idx = msg[3];
+    vial_combo_entry_t entry;
+    memcpy(&entry, &msg[4], sizeof(entry));
+    msg[0] = dynamic_keymap_set_combo(idx, &entry);
+    reload_combo();
+}
 #endif
+
 #ifdef VIAL_KEY_OVERRIDE_ENABLE
-            case dynamic_vial_key_override_get: {
-                uint8_t idx = msg[3];
-                vial_key_override_entry_t entry = { 0 };
-                msg[0] = dynamic_keymap_get_key_override(idx, &entry);
-                memcpy(&msg[1], &entry, sizeof(entry));
-                break;
-            }
-            case dynamic_vial_key_override_set: {
-                uint8_t idx = msg[3];
-                vial_key_override_entry_t entry;
-                memcpy(&entry, &msg[4], sizeof(entry));
-                msg[0] = dynamic_keymap_set_key_override(idx, &entry);
-                reload_key_override();
-                break;
-            }
+static void vial_entry_key_override_get(uint8_t *msg, uint8_t length) {
+    uint8_t idx = msg[3];
+    vial_key_override_entry_t entry = { 0 };
+    msg[0] = dynamic_keymap_get_key_override(idx, &entry);
+    memcpy(&msg[1], &entry, sizeof(entry));
+}
+
+static void vial_entry_key_override_set(uint8_t *msg, uint8_t length) {
+    uint8_t idx = msg[3];
+    vial_key_override_entry_t entry;
+    memcpy(&entry, &msg[4], sizeof(entry));
+    msg[0] = dynamic_keymap_set_key_override(idx, &entry);
+    reload_key_override();
+}
 #endif
-            }
 
-            break;
-        }
+#ifdef TAPPING_TERM_TABLE_ENABLE
+/* row, col, then the 16-bit entry, little endian */
+static void vial_entry_tapping_term_get(uint8_t *msg, uint8_t length) {
+    uint16_t entry = dynamic_keymap_get_tapping_term(msg[3], msg[4]);
+    msg[0] = (msg[3] < MATRIX_ROWS && msg[4] < MATRIX_COLS) ? 0 : -1;
+    msg[1] = entry & 0xFF;
+    msg[2] = entry >> 8;
+}
+
+static void vial_entry_tapping_term_set(uint8_t *msg, uint8_t length) {
+    msg[0] = (msg[3] < MATRIX_ROWS && msg[4] < MATRIX_COLS) ? 0 : -1;
+    dynamic_keymap_set_tapping_term(msg[3], msg[4], msg[5] | (msg[6] << 8));
+}
+#endif
+
+typedef void (*vial_command_handler_t)(uint8_t *msg, uint8_t length);
+
+/* Handlers of the operations on tapdance, combos, etc, by msg[2] */
+static const vial_command_handler_t PROGMEM vial_entry_handlers[] = {
+    [dynamic_vial_get_number_of_entries] = vial_entry_get_number_of_entries,
+#ifdef VIAL_TAP_DANCE_ENABLE
+    [dynamic_vial_tap_dance_get]         = vial_entry_tap_dance_get,
+    [dynamic_vial_tap_dance_set]         = vial_entry_tap_dance_set,
+#endif
+#ifdef VIAL_COMBO_ENABLE
+    [dynamic_vial_combo_get]             = vial_entry_combo_get,
+    [dynamic_vial_combo_set]             = vial_entry_combo_set,
+#endif
+#ifdef VIAL_KEY_OVERRIDE_ENABLE
+    [dynamic_vial_key_override_get]      = vial_entry_key_override_get,
+    [dynamic_vial_key_override_set]      = vial_entry_key_override_set,
+#endif
+#ifdef TAPPING_TERM_TABLE_ENABLE
+    [dynamic_vial_tapping_term_get]      = vial_entry_tapping_term_get,
+    [dynamic_vial_tapping_term_set]      = vial_entry_tapping_term_set,
+#endif
+};
+
+static void vial_cmd_dynamic_entry_op(uint8_t *msg, uint8_t length) {
+    if (msg[2] < sizeof(vial_entry_handlers) / sizeof(vial_entry_handlers[0])) {
+        vial_command_handler_t handler = (vial_command_handler_t)pgm_read_ptr(&vial_entry_handlers[msg[2]]);
+        if (handler)
+            handler(msg, length);
+    }
+}
+
+/* Handlers by Vial command ID, msg[1]. The packet is answered unchanged for IDs without one. */
+static const vial_command_handler_t PROGMEM vial_command_handlers[] = {
+    [vial_get_keyboard_id]    = vial_cmd_get_keyboard_id,
+    [vial_get_size]           = vial_cmd_get_size,
+    [vial_get_def]            = vial_cmd_get_def,
+#ifdef VIAL_ENCODERS_ENABLE
+    [vial_get_encoder]        = vial_cmd_get_encoder,
+    [vial_set_encoder]        = vial_cmd_set_encoder,
+#endif
+    [vial_get_unlock_status]  = vial_cmd_get_unlock_status,
+    [vial_unlock_start]       = vial_cmd_unlock_start,
+    [vial_unlock_poll]        = vial_cmd_unlock_poll,
+    [vial_lock]               = vial_cmd_lock,
+    [vial_qmk_settings_query] = vial_cmd_qmk_settings_query,
+#ifdef QMK_SETTINGS
+    [vial_qmk_settings_get]   = vial_cmd_qmk_settings_get,
+    [vial_qmk_settings_set]   = vial_cmd_qmk_settings_set,
+    [vial_qmk_settings_reset] = vial_cmd_qmk_settings_reset,
+#endif
+    [vial_dynamic_entry_op]   = vial_cmd_dynamic_entry_op,
+};
+
+void vial_handle_cmd(uint8_t *msg, uint8_t length) {
+    /* All packets must be fixed 32 bytes */
+    if (length != VIAL_RAW_EPSIZE)
+        return;
+
+    /* msg[0] is 0xFE -- prefix vial magic */
+    if (msg[1] < sizeof(vial_command_handlers) / sizeof(vial_command_handlers[0])) {
+        vial_command_handler_t handler = (vial_command_handler_t)pgm_read_ptr(&vial_command_handlers[msg[1]]);
+        if (handler)
+            handler(msg, length);
     }
 }
 
@@ -315,23 +384,84 @@ void vial_keycode_tap(uint16_t keycode) {
 }
 
 #ifdef VIAL_ENCODERS_ENABLE
-static void exec_keycode(uint16_t keycode) {
-    vial_keycode_down(keycode);
+/* Runs an encoder keycode straight through process_record(), as a tap of the
+ * magic matrix position. Only when a tap key is still being resolved does it go
+ * through action_exec(), so it is ordered after that key as before. */
+static void exec_encoder_event(uint16_t keycode, bool pressed) {
+    keyrecord_t record = {
+        .event = {.key = (keypos_t){.row = VIAL_MATRIX_MAGIC, .col = VIAL_MATRIX_MAGIC}, .pressed = pressed, .time = (timer_read() | 1) /* time should not be 0 */},
+#ifndef NO_ACTION_TAPPING
+        .tap = {.count = 1},
+#endif
+    };
 
-#if VIAL_ENCODER_KEYCODE_DELAY > 0
-    wait_ms(VIAL_ENCODER_KEYCODE_DELAY);
+    g_vial_magic_keycode_override = keycode;
+#ifndef NO_ACTION_TAPPING
+    if (!action_tapping_is_idle()) {
+        action_exec(record.event);
+        return;
+    }
 #endif
+    process_record(&record);
+}
 
-    vial_keycode_up(keycode);
+static void encoder_keycode_event(uint16_t keycode, bool pressed) {
+    if (keycode <= QK_MODS_MAX) {
+        if (pressed)
+            register_code16(keycode);
+        else
+            unregister_code16(keycode);
+    } else {
+        exec_encoder_event(keycode, pressed);
+    }
+}
+
+#if VIAL_ENCODER_KEYCODE_DELAY > 0
+/* Encoder taps are held for VIAL_ENCODER_KEYCODE_DELAY without waiting: the
+ * release is sent by vial_task() once the time is up. Steps arriving in the
+ * meantime queue up behind it, and are dropped once the queue is full. */
+static uint16_t encoder_tap_queue[VIAL_ENCODER_TAP_QUEUE_SIZE];
+static uint8_t  encoder_tap_head  = 0;
+static uint8_t  encoder_tap_count = 0;
+static uint16_t encoder_tap_start;
+
+static void encoder_tap_press_head(void) {
+    encoder_tap_start = timer_read();
+    encoder_keycode_event(encoder_tap_queue[encoder_tap_head], true);
+}
+
+static void encoder_tap_task(void) {
+    if (encoder_tap_count == 0 || timer_elapsed(encoder_tap_start) < VIAL_ENCODER_KEYCODE_DELAY)
+        return;
+
+    encoder_keycode_event(encoder_tap_queue[encoder_tap_head], false);
+    encoder_tap_head = (encoder_tap_head + 1) % VIAL_ENCODER_TAP_QUEUE_SIZE;
+    if (--encoder_tap_count > 0)
+        encoder_tap_press_head();
 }
 
+static void exec_keycode(uint16_t keycode) {
+    if (encoder_tap_count == VIAL_ENCODER_TAP_QUEUE_SIZE)
+        return;
+
+    encoder_tap_queue[(encoder_tap_head + encoder_tap_count) % VIAL_ENCODER_TAP_QUEUE_SIZE] = keycode;
+    if (encoder_tap_count++ == 0)
+        encoder_tap_press_head();
+}
+#else
+static void exec_keycode(uint16_t keycode) {
+    encoder_keycode_event(keycode, true);
+    encoder_keycode_event(keycode, false);
+}
+#endif
+
 bool vial_encoder_update(uint8_t index, bool clockwise) {
     uint16_t code;
 
     layer_state_t layers = layer_state | default_layer_state;
-    /* check top layer first */
-    for (int8_t i = MAX_LAYER - 1; i >= 0; i--) {
-        if (layers & (1UL << i)) {
+    /* check top layer first, layers above the dynamic keymap have no encoder keycodes */
+    for (int8_t i = DYNAMIC_KEYMAP_LAYER_COUNT - 1; i > 0; i--) {
+        if (layers & ((layer_state_t)1 << i)) {
             code = dynamic_keymap_get_encoder(i, index, clockwise);
             if (code != KC_TRNS) {
                 exec_keycode(code);
@@ -22,14 +22,30 @@
 #include "eeprom.h"
 #include "action.h"
 
+#ifdef __cplusplus
+/* C++ spells it static_assert, the tests include this header from there */
+#    define _Static_assert static_assert
+extern "C" {
+#endif
+
 #define VIAL_PROTOCOL_VERSION ((uint32_t)0x00000005)
 #define VIAL_RAW_EPSIZE 32
 
 void vial_init(void);
+void vial_task(void);
 void vial_handle_cmd(uint8_t *data, uint8_t length);
 bool process_record_vial(uint16_t keycode, keyrecord_t *record);
 
 #ifdef VIAL_ENCODERS_ENABLE
+/* How long an encoder step holds its keycode, and how many steps can wait behind it */
+#ifndef VIAL_ENCODER_KEYCODE_DELAY
+#define VIAL_ENCODER_KEYCODE_DELAY 10
+#endif
+
+#ifndef VIAL_ENCODER_TAP_QUEUE_SIZE
+#define VIAL_ENCODER_TAP_QUEUE_SIZE 8
+#endif
+
 bool vial_encoder_update(uint8_t index, bool clockwise);
 #endif
 
@@ -61,6 +77,8 @@ enum {
     dynamic_vial_combo_set = 0x04,
     dynamic_vial_key_override_get = 0x05,
     dynamic_vial_key_override_set = 0x06,
+    dynamic_vial_tapping_term_get = 0x07,
+    dynamic_vial_tapping_term_set = 0x08,
 };
 
 #define VIAL_MACRO_EXT_TAP 5
@@ -184,3 +202,8 @@ enum {
 #undef VIAL_KEY_OVERRIDE_ENTRIES
 #define VIAL_KEY_OVERRIDE_ENTRIES 0
 #endif
+
+#ifdef __cplusplus
+}
+#    undef _Static_assert
+#endif
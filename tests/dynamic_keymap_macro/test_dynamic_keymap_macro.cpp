@@ -0,0 +1,173 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "eeprom.h"
+#include "eeprom_schema.h"
+#include "send_string.h"
+}
+
+using testing::_;
+using testing::InSequence;
+
+class DynamicKeymapMacro : public TestFixture {
+   protected:
+    /* Writes the macros to the buffer, padding the unused macros and the rest of the buffer with nulls */
+    void set_macros(const std::vector<std::string>& macros) {
+        std::vector<uint8_t> buffer(dynamic_keymap_macro_get_buffer_size(), 0);
+        size_t               offset = 0;
+        for (const auto& macro : macros) {
+            std::copy(macro.begin(), macro.end(), buffer.begin() + offset);
+            offset += macro.size() + 1;
+        }
+        dynamic_keymap_macro_set_buffer(0, buffer.size(), buffer.data());
+    }
+
+    /* Vial stores delays in binary, unlike SS_DELAY() */
+    static std::string delay(uint16_t ms) {
+        return {SS_QMK_PREFIX, SS_DELAY_CODE, char(ms % 255 + 1), char(ms / 255 + 1)};
+    }
+
+    void play_until_done() {
+        while (dynamic_keymap_macro_is_playing()) {
+            idle_for(1);
+        }
+    }
+};
+
+TEST_F(DynamicKeymapMacro, first_and_last_macro_start_in_the_same_call) {
+    TestDriver driver;
+    InSequence s;
+
+    std::vector<std::string> macros(dynamic_keymap_macro_get_count(), std::string(8, 'x'));
+    macros.front() = "a";
+    macros.back()  = "b";
+    set_macros(macros);
+
+    /* The first step goes out before the send call returns, wherever the macro is */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(0);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    play_until_done();
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(dynamic_keymap_macro_get_count() - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    play_until_done();
+}
+
+TEST_F(DynamicKeymapMacro, last_macro_is_found_without_reading_the_ones_before) {
+    TestDriver driver;
+    InSequence s;
+
+    std::vector<std::string> macros(dynamic_keymap_macro_get_count(), std::string(8, 'x'));
+    macros.back() = "b";
+    set_macros(macros);
+
+    /* Overwrite every macro but the last one, nulls included, behind the index's back:
+       walking the buffer would no longer find where the last macro starts */
+    const uintptr_t table_addr = TOTAL_EEPROM_BYTE_COUNT - EEPROM_SCHEMA_TABLE_SIZE(DYNAMIC_KEYMAP_REGION_COUNT);
+    dynamic_keymap_save_schema();
+    uintptr_t            macro_addr = eeprom_read_word((uint16_t *)(table_addr + EEPROM_SCHEMA_TABLE_SIZE(DYNAMIC_KEYMAP_REGION_MACRO)));
+    std::vector<uint8_t> garbage((macros.size() - 1) * 9, 'x');
+    eeprom_update_block(garbage.data(), (void *)macro_addr, garbage.size());
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(dynamic_keymap_macro_get_count() - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    play_until_done();
+}
+
+TEST_F(DynamicKeymapMacro, rewritten_buffer_is_reindexed) {
+    TestDriver driver;
+    InSequence s;
+
+    set_macros({"a", "b"});
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(1);
+    play_until_done();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    set_macros({"abc", "d"});
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(1);
+    play_until_done();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(DynamicKeymapMacro, keys_are_scanned_during_a_delay) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_c = KeymapKey(0, 0, 0, KC_C);
+
+    set_keymap({key_c});
+    set_macros({SS_TAP(X_A) + delay(100) + SS_TAP(X_B)});
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_TRUE(dynamic_keymap_macro_is_playing());
+
+    /* The key goes out while the macro is still waiting */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    key_c.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    key_c.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_TRUE(dynamic_keymap_macro_is_playing());
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    play_until_done();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(DynamicKeymapMacro, macros_sent_while_playing_are_queued) {
+    TestDriver driver;
+    InSequence s;
+
+    set_macros({delay(50) + "a", "b"});
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(0);
+    dynamic_keymap_macro_send(1);
+    play_until_done();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
@@ -0,0 +1,212 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_report_util.hpp"
+#include "test_common.hpp"
+#include "keycode_config.h"
+
+using testing::_;
+using testing::InSequence;
+
+static uint8_t remaps[2][2];
+
+extern "C" {
+bool keycode_remap_get(uint8_t index, uint8_t *from, uint8_t *to) {
+    if (index >= sizeof(remaps) / sizeof(remaps[0])) {
+        return false;
+    }
+    *from = remaps[index][0];
+    *to   = remaps[index][1];
+    return true;
+}
+}
+
+// keycode_config() as it was before the remap table
+static uint16_t reference_keycode_config(uint16_t keycode) {
+    switch (keycode) {
+        case KC_CAPS_LOCK:
+        case KC_LOCKING_CAPS_LOCK:
+            if (keymap_config.swap_control_capslock || keymap_config.capslock_to_control) {
+                return KC_LEFT_CTRL;
+            }
+            return keycode;
+        case KC_LEFT_CTRL:
+            if (keymap_config.swap_control_capslock) {
+                return KC_CAPS_LOCK;
+            }
+            if (keymap_config.swap_lctl_lgui) {
+                if (keymap_config.no_gui) {
+                    return KC_NO;
+                }
+                return KC_LEFT_GUI;
+            }
+            return KC_LEFT_CTRL;
+        case KC_LEFT_ALT:
+            if (keymap_config.swap_lalt_lgui) {
+                if (keymap_config.no_gui) {
+                    return KC_NO;
+                }
+                return KC_LEFT_GUI;
+            }
+            return KC_LEFT_ALT;
+        case KC_LEFT_GUI:
+            if (keymap_config.swap_lalt_lgui) {
+                return KC_LEFT_ALT;
+            }
+            if (keymap_config.swap_lctl_lgui) {
+                return KC_LEFT_CTRL;
+            }
+            if (keymap_config.no_gui) {
+                return KC_NO;
+            }
+            return KC_LEFT_GUI;
+        case KC_RIGHT_CTRL:
+            if (keymap_config.swap_rctl_rgui) {
+                if (keymap_config.no_gui) {
+                    return KC_NO;
+                }
+                return KC_RIGHT_GUI;
+            }
+            return KC_RIGHT_CTRL;
+        case KC_RIGHT_ALT:
+            if (keymap_config.swap_ralt_rgui) {
+                if (keymap_config.no_gui) {
+                    return KC_NO;
+                }
+                return KC_RIGHT_GUI;
+            }
+            return KC_RIGHT_ALT;
+        case KC_RIGHT_GUI:
+            if (keymap_config.swap_ralt_rgui) {
+                return KC_RIGHT_ALT;
+            }
+            if (keymap_config.swap_rctl_rgui) {
+                return KC_RIGHT_CTRL;
+            }
+            if (keymap_config.no_gui) {
+                return KC_NO;
+            }
+            return KC_RIGHT_GUI;
+        case KC_GRAVE:
+            if (keymap_config.swap_grave_esc) {
+                return KC_ESCAPE;
+            }
+            return KC_GRAVE;
+        case KC_ESCAPE:
+            if (keymap_config.swap_grave_esc) {
+                return KC_GRAVE;
+            }
+            return KC_ESCAPE;
+        case KC_BACKSLASH:
+            if (keymap_config.swap_backslash_backspace) {
+                return KC_BACKSPACE;
+            }
+            return KC_BACKSLASH;
+        case KC_BACKSPACE:
+            if (keymap_config.swap_backslash_backspace) {
+                return KC_BACKSLASH;
+            }
+            return KC_BACKSPACE;
+        default:
+            return keycode;
+    }
+}
+
+class KeycodeConfig : public TestFixture {
+   protected:
+    void SetUp() override {
+        TestFixture::SetUp();
+        memset(remaps, 0, sizeof(remaps));
+        keycode_config_invalidate();
+    }
+
+    void TearDown() override {
+        keymap_config.raw = 0;
+        memset(remaps, 0, sizeof(remaps));
+        keycode_config_invalidate();
+        TestFixture::TearDown();
+    }
+};
+
+TEST_F(KeycodeConfig, EveryMagicSwapCombinationMatches) {
+    static const keymap_config_t flags[] = {
+        {.swap_control_capslock = true}, {.capslock_to_control = true}, {.swap_lalt_lgui = true}, {.swap_ralt_rgui = true}, {.no_gui = true}, {.swap_grave_esc = true}, {.swap_backslash_backspace = true}, {.swap_lctl_lgui = true}, {.swap_rctl_rgui = true},
+    };
+    const uint16_t combinations = 1 << (sizeof(flags) / sizeof(flags[0]));
+
+    for (uint16_t combination = 0; combination < combinations; combination++) {
+        keymap_config.raw = 0;
+        for (uint8_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+            if (combination & (1 << i)) {
+                keymap_config.raw |= flags[i].raw;
+            }
+        }
+
+        for (uint16_t keycode = 0; keycode <= 0x1FF; keycode++) {
+            ASSERT_EQ(keycode_config(keycode), reference_keycode_config(keycode)) << "keycode 0x" << std::hex << keycode << " with keymap_config 0x" << keymap_config.raw;
+        }
+    }
+}
+
+TEST_F(KeycodeConfig, CustomRemapTakesPrecedence) {
+    keymap_config.swap_grave_esc = true;
+    EXPECT_EQ(keycode_config(KC_GRAVE), KC_ESCAPE);
+
+    remaps[1][0] = KC_GRAVE;
+    remaps[1][1] = KC_TAB;
+    keycode_config_invalidate();
+    EXPECT_EQ(keycode_config(KC_GRAVE), KC_TAB);
+    EXPECT_EQ(keycode_config(KC_ESCAPE), KC_GRAVE);
+
+    /* a change to keymap_config alone rebuilds the table too */
+    keymap_config.swap_grave_esc = false;
+    EXPECT_EQ(keycode_config(KC_GRAVE), KC_TAB);
+    EXPECT_EQ(keycode_config(KC_ESCAPE), KC_ESCAPE);
+}
+
+TEST_F(KeycodeConfig, CustomRemapAppliesToPressAndRelease) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_a    = KeymapKey(0, 0, 0, KC_A);
+    auto       key_caps = KeymapKey(0, 1, 0, KC_CAPS);
+
+    set_keymap({key_a, key_caps});
+    remaps[0][0] = KC_A;
+    remaps[0][1] = KC_B;
+    remaps[1][0] = KC_CAPS;
+    remaps[1][1] = KC_LCTL;
+    keycode_config_invalidate();
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    key_a.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    key_a.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    key_caps.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    key_caps.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
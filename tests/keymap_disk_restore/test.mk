@@ -0,0 +1,28 @@
+# Copyright 2022 QMK
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# --------------------------------------------------------------------------------
+# Keep this file, even if it is empty, as a marker that this folder contains tests
+# --------------------------------------------------------------------------------
+
+DYNAMIC_KEYMAP_ENABLE = yes
+
+# The dynamic keymap does not fit in the default test EEPROM
+OPT_DEFS += -DTOTAL_EEPROM_BYTE_COUNT=1024
+
+# The restore path of the keymap backup disk, with the Vial lock but without the rest of Vial
+OPT_DEFS += -DVIAL_ENABLE
+VPATH += $(TMK_PATH)/protocol/pico
+SRC += $(TMK_PATH)/protocol/pico/keymap_disk.c
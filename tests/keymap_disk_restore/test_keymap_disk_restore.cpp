@@ -0,0 +1,192 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "eeprom.h"
+#include "eeprom_schema.h"
+#include "keymap_disk.h"
+
+void advance_time(uint32_t ms);
+}
+
+using testing::_;
+using testing::InSequence;
+
+/* Stands in for the rest of Vial */
+static int vial_init_count = 0;
+
+extern "C" {
+int      vial_unlocked           = 1;
+int      vial_unlock_in_progress = 0;
+uint16_t g_vial_magic_keycode_override;
+
+void vial_init(void) {
+    vial_init_count++;
+}
+
+void vial_task(void) {}
+
+bool process_record_vial(uint16_t keycode, keyrecord_t *record) {
+    return true;
+}
+
+void vial_keycode_down(uint16_t keycode) {}
+void vial_keycode_up(uint16_t keycode) {}
+void vial_keycode_tap(uint16_t keycode) {}
+}
+
+static const uintptr_t table_addr = TOTAL_EEPROM_BYTE_COUNT - EEPROM_SCHEMA_TABLE_SIZE(DYNAMIC_KEYMAP_REGION_COUNT);
+
+class KeymapDiskRestore : public TestFixture {
+   protected:
+    void SetUp() override {
+        dynamic_keymap_reset();
+        dynamic_keymap_macro_reset();
+        dynamic_keymap_save_schema();
+        vial_unlocked   = 1;
+        vial_init_count = 0;
+    }
+
+    /* KEYMAP.BIN, as the host would copy it off the disk */
+    std::vector<uint8_t> backup() {
+        std::vector<uint8_t> file(keymap_disk_snapshot_file_size());
+        EXPECT_FALSE(file.empty());
+        keymap_disk_read(KEYMAP_DISK_SNAPSHOT_SECTOR, 0, file.data(), file.size());
+        return file;
+    }
+
+    uint32_t snapshot_crc_of_block(uint16_t block) {
+        uint8_t             sector[KEYMAP_DISK_SECTOR_SIZE];
+        keymap_disk_block_t header;
+        keymap_disk_read_sector(KEYMAP_DISK_SNAPSHOT_SECTOR + block, sector);
+        memcpy(&header, sector, sizeof(header));
+        return header.snapshot_crc;
+    }
+
+    void restore(const std::vector<uint8_t> &file) {
+        keymap_disk_write(100, 0, file.data(), file.size());
+    }
+
+    void set_macros(const std::vector<std::string> &macros) {
+        std::vector<uint8_t> buffer(dynamic_keymap_macro_get_buffer_size(), 0);
+        size_t               offset = 0;
+        for (const auto &macro : macros) {
+            std::copy(macro.begin(), macro.end(), buffer.begin() + offset);
+            offset += macro.size() + 1;
+        }
+        dynamic_keymap_macro_set_buffer(0, buffer.size(), buffer.data());
+    }
+};
+
+TEST_F(KeymapDiskRestore, restore_brings_back_the_keymap) {
+    dynamic_keymap_set_keycode(1, 2, 3, KC_B);
+    std::vector<uint8_t> file = backup();
+    dynamic_keymap_set_keycode(1, 2, 3, KC_C);
+
+    restore(file);
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_RESTORED);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 2, 3), KC_B);
+    EXPECT_TRUE(eeprom_schema_is_valid((void *)table_addr, DYNAMIC_KEYMAP_REGION_COUNT));
+    EXPECT_EQ(vial_init_count, 1);
+}
+
+TEST_F(KeymapDiskRestore, locked_keyboard_keeps_its_keymap) {
+    dynamic_keymap_set_keycode(1, 2, 3, KC_B);
+    std::vector<uint8_t> file = backup();
+    dynamic_keymap_set_keycode(1, 2, 3, KC_C);
+
+    vial_unlocked = 0;
+    restore(file);
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_REJECTED);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 2, 3), KC_C);
+    EXPECT_EQ(vial_init_count, 0);
+}
+
+TEST_F(KeymapDiskRestore, restored_macros_are_reindexed) {
+    TestDriver driver;
+    InSequence s;
+
+    set_macros({"a", "b"});
+    std::vector<uint8_t> file = backup();
+    set_macros({"xyz", "c"});
+
+    restore(file);
+    ASSERT_EQ(keymap_disk_get_status(), KEYMAP_DISK_RESTORED);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(1);
+    while (dynamic_keymap_macro_is_playing()) {
+        idle_for(1);
+    }
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(KeymapDiskRestore, snapshot_with_an_older_table_is_migrated) {
+    /* The layout of a build with one layer fewer: the regions after the keymap start a layer earlier */
+    const uint16_t                      layer_size = MATRIX_ROWS * MATRIX_COLS * 2;
+    std::vector<eeprom_schema_region_t> regions;
+    for (uint8_t i = 0; i < DYNAMIC_KEYMAP_REGION_COUNT; i++) {
+        uintptr_t entry = table_addr + EEPROM_SCHEMA_TABLE_SIZE(i);
+        regions.push_back({eeprom_read_word((uint16_t *)entry), eeprom_read_word((uint16_t *)(entry + 2)), eeprom_read_word((uint16_t *)(entry + 4)), eeprom_read_byte((uint8_t *)(entry + 6))});
+    }
+    regions[DYNAMIC_KEYMAP_REGION_KEYMAP].size -= layer_size;
+    for (uint8_t i = DYNAMIC_KEYMAP_REGION_KEYMAP + 1; i < DYNAMIC_KEYMAP_REGION_COUNT; i++) {
+        regions[i].addr -= layer_size;
+    }
+    regions[DYNAMIC_KEYMAP_REGION_MACRO].size += layer_size;
+    eeprom_update_block("abc", (void *)(uintptr_t)regions[DYNAMIC_KEYMAP_REGION_MACRO].addr, 4);
+    eeprom_schema_save((void *)table_addr, regions.data(), regions.size());
+
+    dynamic_keymap_set_keycode(1, 2, 3, KC_B);
+    std::vector<uint8_t> file = backup();
+    dynamic_keymap_set_keycode(1, 2, 3, KC_C);
+
+    restore(file);
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_RESTORED);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 2, 3), KC_B);
+    uint8_t macros[4];
+    dynamic_keymap_macro_get_buffer(0, sizeof(macros), macros);
+    EXPECT_STREQ((const char *)macros, "abc");
+    EXPECT_TRUE(eeprom_schema_is_valid((void *)table_addr, DYNAMIC_KEYMAP_REGION_COUNT));
+}
+
+TEST_F(KeymapDiskRestore, snapshot_checksum_is_computed_once_per_read) {
+    uint32_t first = snapshot_crc_of_block(0);
+    dynamic_keymap_set_keycode(1, 2, 3, KC_B);
+
+    /* the rest of the file carries the checksum its first block had */
+    EXPECT_EQ(snapshot_crc_of_block(1), first);
+
+    /* reading the file again starts from its first block */
+    uint32_t second = snapshot_crc_of_block(0);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(snapshot_crc_of_block(1), second);
+
+    /* a host that only reads the later blocks again gets a fresh checksum after a while */
+    dynamic_keymap_set_keycode(1, 2, 3, KC_C);
+    advance_time(KEYMAP_DISK_READ_SESSION_TIMEOUT + 1);
+    EXPECT_NE(snapshot_crc_of_block(1), second);
+}
@@ -0,0 +1,214 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+extern "C" {
+#include "mousekey.h"
+#include "timer.h"
+void advance_time(uint32_t ms);
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+struct MouseSample {
+    uint32_t       time;
+    report_mouse_t report;
+};
+
+class Mousekey : public TestFixture {
+   protected:
+    std::vector<MouseSample> samples;
+
+    void record(TestDriver& driver) {
+        EXPECT_CALL(driver, send_mouse_mock(_)).Times(AnyNumber()).WillRepeatedly(Invoke([this](report_mouse_t& report) { samples.push_back({timer_read32(), report}); }));
+    }
+
+    int total_x() const {
+        int sum = 0;
+        for (auto& s : samples) sum += s.report.x;
+        return sum;
+    }
+};
+
+/* Reports carry whole units and keep the remainder, so they trail the exact position by less than one unit. */
+#define EXPECT_TRACKS(actual, exact) EXPECT_NEAR(actual, (exact)-0.5, 0.6)
+
+/* Exact distance after t ms of motion for a linear ramp from v0 to vmax over ramp ms. */
+static double ramp_distance(double t, double v0, double vmax, double ramp) {
+    if (t <= 0) return 0;
+    if (t <= ramp) return v0 * t + (vmax - v0) * t * t / (2 * ramp);
+    return ramp_distance(ramp, v0, vmax, ramp) + vmax * (t - ramp);
+}
+
+static double cursor_position(double t) {
+    double const v0   = (double)MOUSEKEY_MOVE_DELTA / MOUSEKEY_INTERVAL;
+    double const vmax = v0 * MOUSEKEY_MAX_SPEED;
+    return MOUSEKEY_MOVE_DELTA + ramp_distance(t - MOUSEKEY_DELAY, v0, vmax, MOUSEKEY_TIME_TO_MAX * MOUSEKEY_INTERVAL);
+}
+
+TEST_F(Mousekey, cursor_follows_trajectory) {
+    TestDriver driver;
+    auto       mouse_right = KeymapKey(0, 0, 0, KC_MS_RIGHT);
+    set_keymap({mouse_right});
+    record(driver);
+
+    mouse_right.press();
+    uint32_t const pressed = timer_read32();
+    idle_for(2000);
+
+    ASSERT_GT(samples.size(), 1u);
+    int      x    = 0;
+    uint32_t prev = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        auto& s = samples[i];
+        x += s.report.x;
+        EXPECT_EQ(s.report.y, 0);
+        EXPECT_LE(s.report.x, MOUSEKEY_MOVE_MAX);
+        if (i > 0) {
+            EXPECT_GE(s.time - prev, (uint32_t)MOUSEKEY_REPORT_INTERVAL);
+        }
+        prev = s.time;
+        EXPECT_TRACKS(x, cursor_position(s.time - pressed)) << "at " << s.time - pressed << " ms";
+    }
+    mouse_right.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(Mousekey, slow_motion_is_not_stair_stepped) {
+    TestDriver driver;
+    auto       mouse_right = KeymapKey(0, 0, 0, KC_MS_RIGHT);
+    set_keymap({mouse_right});
+    record(driver);
+
+    mouse_right.press();
+    uint32_t const pressed = timer_read32();
+    idle_for(100);
+
+    /* every report early in the ramp carries a fraction of the step, instead of one step per interval */
+    size_t moving = 0;
+    for (auto& s : samples) {
+        if (s.time - pressed > MOUSEKEY_DELAY + MOUSEKEY_REPORT_INTERVAL) {
+            EXPECT_GT(s.report.x, 0);
+            EXPECT_LT(s.report.x, MOUSEKEY_MOVE_DELTA);
+            moving++;
+        }
+    }
+    EXPECT_GE(moving, (100 - MOUSEKEY_DELAY) / MOUSEKEY_REPORT_INTERVAL - 2);
+    mouse_right.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(Mousekey, trajectory_is_independent_of_loop_timing) {
+    TestDriver driver;
+    auto       mouse_right = KeymapKey(0, 0, 0, KC_MS_RIGHT);
+    set_keymap({mouse_right});
+    record(driver);
+
+    mouse_right.press();
+    uint32_t const pressed = timer_read32();
+    run_one_scan_loop();
+    srand(42);
+    while (timer_read32() - pressed < 1500) {
+        advance_time(rand() % 15);
+        run_one_scan_loop();
+    }
+
+    EXPECT_TRACKS(total_x(), cursor_position(samples.back().time - pressed));
+    mouse_right.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(Mousekey, diagonal_is_scaled_per_axis) {
+    TestDriver driver;
+    auto       mouse_right = KeymapKey(0, 0, 0, KC_MS_RIGHT);
+    auto       mouse_down  = KeymapKey(0, 1, 0, KC_MS_DOWN);
+    set_keymap({mouse_right, mouse_down});
+    record(driver);
+
+    mouse_right.press();
+    mouse_down.press();
+    run_one_scan_loop();
+    uint32_t const pressed = timer_read32() - 1;
+    idle_for(1000);
+
+    int x = 0, y = 0;
+    for (auto& s : samples) {
+        x += s.report.x;
+        y += s.report.y;
+    }
+    double const expected = MOUSEKEY_MOVE_DELTA + (cursor_position(samples.back().time - pressed) - MOUSEKEY_MOVE_DELTA) * 181 / 256;
+    EXPECT_EQ(x, y);
+    EXPECT_NEAR(x, expected, 2.0);
+    mouse_right.release();
+    mouse_down.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(Mousekey, release_stops_motion) {
+    TestDriver driver;
+    auto       mouse_right = KeymapKey(0, 0, 0, KC_MS_RIGHT);
+    set_keymap({mouse_right});
+    record(driver);
+
+    mouse_right.press();
+    idle_for(300);
+    mouse_right.release();
+    run_one_scan_loop();
+    size_t const reports = samples.size();
+    idle_for(300);
+
+    for (size_t i = reports; i < samples.size(); i++) {
+        EXPECT_EQ(samples[i].report.x, 0);
+    }
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(Mousekey, wheel_scrolls_fractional_notch_rates) {
+    TestDriver driver;
+    auto       wheel_down = KeymapKey(0, 0, 0, KC_MS_WH_DOWN);
+    set_keymap({wheel_down});
+    record(driver);
+
+    wheel_down.press();
+    uint32_t const pressed = timer_read32();
+    idle_for(4000);
+
+    double const v0   = (double)MOUSEKEY_WHEEL_DELTA / MOUSEKEY_WHEEL_INTERVAL;
+    double const vmax = v0 * MOUSEKEY_WHEEL_MAX_SPEED;
+    int          v    = 0;
+    for (auto& s : samples) {
+        v += s.report.v;
+        EXPECT_LE(s.report.v, 0);
+        double const expected = MOUSEKEY_WHEEL_DELTA + ramp_distance((double)(s.time - pressed) - MOUSEKEY_WHEEL_DELAY, v0, vmax, MOUSEKEY_WHEEL_TIME_TO_MAX * MOUSEKEY_WHEEL_INTERVAL);
+        EXPECT_TRACKS(-v, expected) << "at " << s.time - pressed << " ms";
+    }
+    wheel_down.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
@@ -0,0 +1,163 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "action_util.h"
+#include "keyboard_report_util.hpp"
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+
+/* more than half the range of the 16 bit timer */
+#define LONG_TIMEOUT 40000
+
+extern "C" {
+uint16_t get_oneshot_mod_timeout(uint8_t mod) {
+    switch (mod) {
+        case MOD_BIT(KC_LSFT):
+            return 200;
+        case MOD_BIT(KC_LCTL):
+            return 600;
+        case MOD_BIT(KC_LALT):
+            return 0;
+        case MOD_BIT(KC_RCTL):
+            return LONG_TIMEOUT;
+        default:
+            return ONESHOT_TIMEOUT;
+    }
+}
+
+uint16_t get_oneshot_layer_timeout(uint8_t layer) {
+    switch (layer) {
+        case 1:
+            return 400;
+        case 2:
+            return LONG_TIMEOUT;
+        default:
+            return ONESHOT_TIMEOUT;
+    }
+}
+}
+
+class OneShotTimeout : public TestFixture {
+   protected:
+    KeymapKey shift_key   = KeymapKey(0, 0, 0, OSM(MOD_LSFT));
+    KeymapKey ctrl_key    = KeymapKey(0, 1, 0, OSM(MOD_LCTL));
+    KeymapKey alt_key     = KeymapKey(0, 2, 0, OSM(MOD_LALT));
+    KeymapKey gui_key     = KeymapKey(0, 3, 0, OSM(MOD_LGUI));
+    KeymapKey layer_key   = KeymapKey(0, 4, 0, OSL(1));
+    KeymapKey regular_key = KeymapKey(0, 5, 0, KC_A);
+    KeymapKey rctl_key    = KeymapKey(0, 6, 0, OSM(MOD_RCTL));
+    KeymapKey layer2_key  = KeymapKey(0, 7, 0, OSL(2));
+
+    void SetUp() override {
+        TestFixture::SetUp();
+        set_keymap({shift_key, ctrl_key, alt_key, gui_key, layer_key, regular_key, rctl_key, layer2_key, KeymapKey(1, 5, 0, KC_B), KeymapKey(2, 5, 0, KC_C)});
+    }
+
+    void tap(KeymapKey &key) {
+        key.press();
+        run_one_scan_loop();
+        key.release();
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(OneShotTimeout, StaggeredModsExpireIndependently) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    tap(ctrl_key); // expires at 600
+    idle_for(98);
+    tap(shift_key); // expires at 300
+    EXPECT_EQ(get_oneshot_mods(), MOD_BIT(KC_LCTL) | MOD_BIT(KC_LSFT));
+
+    idle_for(190);
+    EXPECT_EQ(get_oneshot_mods(), MOD_BIT(KC_LCTL) | MOD_BIT(KC_LSFT));
+    idle_for(20);
+    EXPECT_EQ(get_oneshot_mods(), MOD_BIT(KC_LCTL));
+
+    idle_for(280);
+    EXPECT_EQ(get_oneshot_mods(), MOD_BIT(KC_LCTL));
+    idle_for(20);
+    EXPECT_EQ(get_oneshot_mods(), 0);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(OneShotTimeout, LaterModDoesNotExtendEarlierOne) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    tap(shift_key); // expires at 200
+    idle_for(148);
+    tap(gui_key); // expires at 1150
+    idle_for(60);
+    EXPECT_EQ(get_oneshot_mods(), MOD_BIT(KC_LGUI));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* the remaining mod still applies to the next key */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LGUI, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).Times(AnyNumber());
+    regular_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    regular_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(OneShotTimeout, ZeroTimeoutNeverExpires) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    tap(alt_key);
+    tap(shift_key);
+    idle_for(ONESHOT_TIMEOUT * 2);
+    EXPECT_EQ(get_oneshot_mods(), MOD_BIT(KC_LALT));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(OneShotTimeout, LayerUsesItsOwnTimeout) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    tap(ctrl_key);
+    tap(layer_key);
+    idle_for(390);
+    EXPECT_TRUE(layer_state_is(1));
+    idle_for(20);
+    EXPECT_FALSE(layer_state_is(1));
+    EXPECT_EQ(get_oneshot_mods(), MOD_BIT(KC_LCTL));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(OneShotTimeout, LongTimeoutDoesNotWrapAround) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    tap(rctl_key);
+    tap(layer2_key);
+    idle_for(LONG_TIMEOUT - 10);
+    EXPECT_EQ(get_oneshot_mods(), MOD_BIT(KC_RCTL));
+    EXPECT_TRUE(layer_state_is(2));
+
+    idle_for(20);
+    EXPECT_EQ(get_oneshot_mods(), 0);
+    EXPECT_FALSE(layer_state_is(2));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
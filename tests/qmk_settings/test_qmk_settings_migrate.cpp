@@ -0,0 +1,125 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include "test_common.hpp"
+#include "test_keymap_key.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "usb_polling_interval.h"
+
+/* qmk_settings.h itself does not build as C++ */
+void qmk_settings_reset(void);
+void qmk_settings_migrate(uint16_t size);
+int  qmk_settings_get(uint16_t qsid, void *setting, size_t maxsz);
+}
+
+/* the current layout, and where the settings added since the first one start */
+#define SETTINGS_SIZE 76
+#define USB_POLLING_OFFSET 35
+#define KEY_REMAP_OFFSET 54
+
+class QmkSettingsMigrate : public TestFixture {
+   protected:
+    std::vector<uint8_t> defaults;
+
+    void SetUp() override {
+        /* the per-key tapping settings look the idle tapping key up at (0,0) */
+        set_keymap({KeymapKey(0, 0, 0, KC_NO)});
+        qmk_settings_reset();
+        for (uint16_t i = 0; i < SETTINGS_SIZE; i++) {
+            defaults.push_back(dynamic_keymap_get_qmk_settings(i));
+        }
+    }
+
+    static uint8_t stored(uint16_t offset) {
+        return 0x40 + offset;
+    }
+
+    /* what an older firmware left in the EEPROM, the bytes past its layout are whatever was there before */
+    void store(uint16_t size) {
+        for (uint16_t i = 0; i < SETTINGS_SIZE; i++) {
+            dynamic_keymap_set_qmk_settings(i, i < size ? stored(i) : 0xEE);
+        }
+    }
+
+    /* the first `kept` bytes are migrated, the others are back to their defaults */
+    void expect_kept(uint16_t kept) {
+        for (uint16_t i = 0; i < SETTINGS_SIZE; i++) {
+            EXPECT_EQ(dynamic_keymap_get_qmk_settings(i), i < kept ? stored(i) : defaults[i]) << "offset " << i;
+        }
+    }
+};
+
+TEST_F(QmkSettingsMigrate, UnusedByteOfTheFirstLayoutIsNotMigrated) {
+    store(36);
+    qmk_settings_migrate(36);
+    expect_kept(USB_POLLING_OFFSET);
+
+    uint16_t osk_timeout = 0;
+    EXPECT_EQ(qmk_settings_get(6, &osk_timeout, sizeof(osk_timeout)), 0);
+    EXPECT_EQ(osk_timeout, stored(2) | stored(3) << 8);
+
+    uint8_t polling = 0xFF;
+    EXPECT_EQ(qmk_settings_get(21, &polling, sizeof(polling)), 0);
+    EXPECT_EQ(polling, USB_POLLING_DEFAULT);
+}
+
+TEST_F(QmkSettingsMigrate, UsbPollingLayoutIsMigrated) {
+    store(40);
+    qmk_settings_migrate(40);
+    expect_kept(40);
+
+    uint8_t polling = 0;
+    EXPECT_EQ(qmk_settings_get(21, &polling, sizeof(polling)), 0);
+    EXPECT_EQ(polling, stored(USB_POLLING_OFFSET));
+}
+
+TEST_F(QmkSettingsMigrate, SpaceCadetLayoutIsMigrated) {
+    store(54);
+    qmk_settings_migrate(54);
+    expect_kept(54);
+
+    uint8_t remap[2] = {0xFF, 0xFF};
+    EXPECT_EQ(qmk_settings_get(39, remap, sizeof(remap)), 0);
+    EXPECT_EQ(remap[0], 0);
+    EXPECT_EQ(remap[1], 0);
+}
+
+TEST_F(QmkSettingsMigrate, KeyRemapLayoutIsMigrated) {
+    store(70);
+    qmk_settings_migrate(70);
+    expect_kept(70);
+
+    uint8_t remap[2] = {0, 0};
+    EXPECT_EQ(qmk_settings_get(39, remap, sizeof(remap)), 0);
+    EXPECT_EQ(remap[0], stored(KEY_REMAP_OFFSET));
+    EXPECT_EQ(remap[1], stored(KEY_REMAP_OFFSET + 1));
+}
+
+TEST_F(QmkSettingsMigrate, CurrentLayoutIsKept) {
+    store(SETTINGS_SIZE);
+    qmk_settings_migrate(SETTINGS_SIZE);
+    expect_kept(SETTINGS_SIZE);
+}
+
+TEST_F(QmkSettingsMigrate, NewerLayoutKeepsTheKnownSettings) {
+    store(SETTINGS_SIZE);
+    qmk_settings_migrate(SETTINGS_SIZE + 8);
+    expect_kept(SETTINGS_SIZE);
+}
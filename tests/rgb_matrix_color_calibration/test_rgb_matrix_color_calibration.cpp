@@ -0,0 +1,118 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "rgb_matrix.h"
+#include "color_calibration.h"
+#include "led_dither.h"
+
+/* sends the buffers to the driver, rgb_matrix_task() does this once per frame */
+void rgb_matrix_update_pwm_buffers(void);
+}
+
+struct SentColor {
+    int     index;
+    uint8_t r, g, b;
+
+    SentColor(int index, uint8_t r, uint8_t g, uint8_t b) : index(index), r(r), g(g), b(b) {}
+};
+
+static std::vector<SentColor> sent;
+static uint32_t               set_color_all_count;
+
+extern "C" {
+static void mock_init(void) {}
+
+static void mock_set_color(int index, uint8_t r, uint8_t g, uint8_t b) {
+    sent.emplace_back(index, r, g, b);
+}
+
+static void mock_set_color_all(uint8_t r, uint8_t g, uint8_t b) {
+    set_color_all_count++;
+}
+
+static void mock_flush(void) {}
+
+const rgb_matrix_driver_t rgb_matrix_driver = {mock_init, mock_set_color, mock_set_color_all, mock_flush};
+
+led_config_t g_led_config = {};
+}
+
+class RgbMatrixColorCalibration : public TestFixture {
+   protected:
+    void SetUp() override {
+        sent.clear();
+        set_color_all_count = 0;
+    }
+
+    // one frame: every LED is written to the driver once, by the dithering
+    void send_frame() {
+        sent.clear();
+        rgb_matrix_update_pwm_buffers();
+        ASSERT_EQ(sent.size(), DRIVER_LED_TOTAL);
+        EXPECT_EQ(set_color_all_count, 0);
+    }
+};
+
+TEST_F(RgbMatrixColorCalibration, SetColorIsCalibratedOnce) {
+    rgb_matrix_set_color(2, 200, 100, 150);
+    send_frame();
+
+    EXPECT_EQ(sent[2].index, 2);
+    EXPECT_EQ(sent[2].r, 100);
+    EXPECT_EQ(sent[2].g, 100);
+    EXPECT_EQ(sent[2].b, color_calibration_value(COLOR_CALIBRATION_BLUE, 150));
+
+    // sending the buffers again does not calibrate them again
+    send_frame();
+    EXPECT_EQ(sent[2].r, 100);
+    EXPECT_EQ(sent[2].b, color_calibration_value(COLOR_CALIBRATION_BLUE, 150));
+}
+
+TEST_F(RgbMatrixColorCalibration, SetColorAllIsCalibratedOnce) {
+    rgb_matrix_set_color_all(200, 100, 150);
+    send_frame();
+
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        EXPECT_EQ(sent[i].r, 100) << "LED " << +i;
+        EXPECT_EQ(sent[i].g, 100) << "LED " << +i;
+        EXPECT_EQ(sent[i].b, color_calibration_value(COLOR_CALIBRATION_BLUE, 150)) << "LED " << +i;
+    }
+}
+
+TEST_F(RgbMatrixColorCalibration, FractionIsCalibratedBeforeDithering) {
+    // where the table steps by more than one, dithering the uncalibrated value would flicker
+    // between the two entries instead of showing the PWM value in between
+    uint8_t low  = color_calibration_value(COLOR_CALIBRATION_BLUE, 254);
+    uint8_t high = color_calibration_value(COLOR_CALIBRATION_BLUE, 255);
+    ASSERT_GE(high - low, 2);
+
+    uint16_t value      = LED_DITHER_FROM_8BIT(254) + 0x80;
+    uint16_t calibrated = color_calibration_value16(COLOR_CALIBRATION_BLUE, value);
+    rgb_matrix_set_color16(0, 0, 0, value);
+
+    uint32_t total = 0;
+    for (uint8_t frame = 0; frame < 16; frame++) {
+        send_frame();
+        EXPECT_LT(std::abs(sent[0].b * 256 - calibrated), 256) << "frame " << +frame;
+        total += sent[0].b;
+    }
+    EXPECT_NEAR(total * 256 / 16, calibrated, 16);
+}
@@ -0,0 +1,225 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_report_util.hpp"
+#include "test_common.hpp"
+#include "action_tapping.h"
+
+using testing::_;
+using testing::InSequence;
+
+class SpaceCadet : public TestFixture {
+   protected:
+    KeymapKey lspo_key    = KeymapKey(0, 0, 0, KC_LSPO);
+    KeymapKey rspc_key    = KeymapKey(0, 1, 0, KC_RSPC);
+    KeymapKey sftent_key  = KeymapKey(0, 2, 0, KC_SFTENT);
+    KeymapKey regular_key = KeymapKey(0, 3, 0, KC_A);
+
+    void SetUp() override {
+        TestFixture::SetUp();
+        set_keymap({lspo_key, rspc_key, sftent_key, regular_key});
+    }
+
+    void press(KeymapKey &key) {
+        key.press();
+        run_one_scan_loop();
+    }
+
+    void release(KeymapKey &key) {
+        key.release();
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(SpaceCadet, TapSendsParen) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    press(lspo_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_9)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(lspo_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SpaceCadet, OverlappingRollSendsBothParens) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
+    press(lspo_key);
+    press(rspc_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* the pending right shift is left out of the open paren, then comes back */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_9)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT)));
+    release(lspo_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT, KC_0)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(rspc_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SpaceCadet, OverlappingKeysResolveInReleaseOrder) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
+    press(lspo_key);
+    press(rspc_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT, KC_0)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    release(rspc_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_9)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(lspo_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SpaceCadet, RegularKeyInterruptsEveryPressedKey) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
+    press(lspo_key);
+    press(rspc_key);
+    press(regular_key);
+    release(regular_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* both are holds now, so no paren is sent */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(lspo_key);
+    release(rspc_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SpaceCadet, RegularKeyOnlyInterruptsKeysAlreadyPressed) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
+    press(lspo_key);
+    press(regular_key);
+    release(regular_key);
+    press(rspc_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* the held left shift applies to the close paren, which is not interrupted */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT, KC_0)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(rspc_key);
+    release(lspo_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SpaceCadet, TapTermEdges) {
+    TestDriver driver;
+    InSequence s;
+
+    /* released one millisecond before the tapping term */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_9)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press(lspo_key);
+    idle_for(TAPPING_TERM - 2);
+    release(lspo_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* released at the tapping term */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press(lspo_key);
+    idle_for(TAPPING_TERM - 1);
+    release(lspo_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SpaceCadet, OverlappingKeysHaveTheirOwnTerm) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
+    press(lspo_key);
+    idle_for(TAPPING_TERM / 2);
+    press(rspc_key);
+    idle_for(TAPPING_TERM / 2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* the open paren key was held past its term, the close paren one was not */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT, KC_0)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(lspo_key);
+    release(rspc_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SpaceCadet, SharedHoldModStaysDownUntilLastRelease) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT)));
+    press(rspc_key);
+    press(sftent_key);
+    press(regular_key);
+    release(regular_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* right shift is still held by the other key */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    release(rspc_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(sftent_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
@@ -0,0 +1,148 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+extern "C" {
+#include "keyboard.h"
+#include "split_util.h"
+#include "timer.h"
+#include "transport.h"
+
+/* Mocked USB */
+static bool usb_connected   = false;
+static int  usb_disconnects = 0;
+
+bool usb_connected_state(void) {
+    return usb_connected;
+}
+void usb_disconnect(void) {
+    usb_disconnects++;
+}
+
+/* Mocked split transport */
+static int master_inits = 0;
+static int slave_inits  = 0;
+static int slave_stops  = 0;
+
+void transport_master_init(void) {
+    master_inits++;
+}
+void transport_slave_init(void) {
+    slave_inits++;
+}
+void transport_slave_stop(void) {
+    slave_stops++;
+}
+bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    return true;
+}
+void transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {}
+}
+
+class SplitRole : public TestFixture {
+   protected:
+    /* Restarts the keyboard, returning how long it took before the first scan */
+    uint32_t boot(bool usb_up) {
+        usb_connected   = usb_up;
+        usb_disconnects = 0;
+        master_inits    = 0;
+        slave_inits     = 0;
+        slave_stops     = 0;
+
+        keyboard_init();
+        uint32_t boot_time = timer_read32();
+        run_one_scan_loop();
+        return boot_time;
+    }
+};
+
+TEST_F(SplitRole, first_scan_does_not_wait_for_the_timeout) {
+    TestDriver driver;
+
+    EXPECT_EQ(boot(false), 0u);
+    EXPECT_FALSE(is_keyboard_master());
+    EXPECT_EQ(slave_inits, 1);
+    EXPECT_EQ(usb_disconnects, 0);
+}
+
+TEST_F(SplitRole, enumerated_usb_at_boot_makes_master) {
+    TestDriver driver;
+
+    EXPECT_EQ(boot(true), 0u);
+    EXPECT_TRUE(is_keyboard_master());
+    EXPECT_EQ(master_inits, 1);
+    EXPECT_EQ(slave_inits, 0);
+}
+
+TEST_F(SplitRole, usb_enumerating_first_makes_master) {
+    TestDriver driver;
+
+    boot(false);
+    idle_for(500);
+    EXPECT_FALSE(is_keyboard_master());
+
+    usb_connected = true;
+    run_one_scan_loop();
+    EXPECT_TRUE(is_keyboard_master());
+    EXPECT_EQ(slave_stops, 1);
+    EXPECT_EQ(master_inits, 1);
+    EXPECT_EQ(usb_disconnects, 0);
+
+    /* Still master after the timeout */
+    idle_for(SPLIT_USB_TIMEOUT);
+    EXPECT_TRUE(is_keyboard_master());
+}
+
+TEST_F(SplitRole, handshake_first_makes_slave) {
+    TestDriver driver;
+
+    boot(false);
+    idle_for(500);
+
+    split_role_handshake();
+    run_one_scan_loop();
+    EXPECT_FALSE(is_keyboard_master());
+    EXPECT_EQ(usb_disconnects, 1);
+
+    /* USB showing up afterwards does not change the role */
+    usb_connected = true;
+    run_one_scan_loop();
+    EXPECT_FALSE(is_keyboard_master());
+    EXPECT_EQ(master_inits, 0);
+    EXPECT_EQ(slave_stops, 0);
+}
+
+TEST_F(SplitRole, timeout_first_makes_slave) {
+    TestDriver driver;
+
+    boot(false);
+    idle_for(SPLIT_USB_TIMEOUT - 10);
+    EXPECT_EQ(usb_disconnects, 0);
+
+    idle_for(10);
+    EXPECT_FALSE(is_keyboard_master());
+    EXPECT_EQ(usb_disconnects, 1);
+
+    usb_connected = true;
+    run_one_scan_loop();
+    EXPECT_FALSE(is_keyboard_master());
+    EXPECT_EQ(master_inits, 0);
+}
@@ -0,0 +1,161 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+/* Mirror the columns of every row */
+#define MIRROR_ROW(r) \
+    { {9, r}, {8, r}, {7, r}, {6, r}, {5, r}, {4, r}, {3, r}, {2, r}, {1, r}, {0, r} }
+
+extern "C" const keypos_t PROGMEM hand_swap_config[MATRIX_ROWS][MATRIX_COLS] = {MIRROR_ROW(0), MIRROR_ROW(1), MIRROR_ROW(2), MIRROR_ROW(3)};
+
+class SwapHands : public TestFixture {
+   protected:
+    void TearDown() override {
+        swap_hands = false;
+        TestFixture::TearDown();
+    }
+};
+
+TEST_F(SwapHands, unswapped_key_is_not_remapped) {
+    TestDriver driver;
+    InSequence s;
+    auto       left_key  = KeymapKey(0, 1, 0, KC_A);
+    auto       right_key = KeymapKey(0, 8, 0, KC_B);
+
+    set_keymap({left_key, right_key});
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    left_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    left_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SwapHands, swapped_key_sends_mirrored_keycode) {
+    TestDriver driver;
+    InSequence s;
+    auto       left_key  = KeymapKey(0, 1, 0, KC_A);
+    auto       right_key = KeymapKey(0, 8, 0, KC_B);
+
+    set_keymap({left_key, right_key});
+    swap_hands = true;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    left_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    left_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SwapHands, key_pressed_while_swapped_releases_mirrored_key) {
+    TestDriver driver;
+    InSequence s;
+    auto       left_key  = KeymapKey(0, 1, 0, KC_A);
+    auto       right_key = KeymapKey(0, 8, 0, KC_B);
+
+    set_keymap({left_key, right_key});
+    swap_hands = true;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    left_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* Turning swapping off must not leave the mirrored key stuck */
+    swap_hands = false;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    left_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SwapHands, momentary_swap_key) {
+    TestDriver driver;
+    InSequence s;
+    auto       swap_key  = KeymapKey(0, 0, 1, SH_MON);
+    auto       left_key  = KeymapKey(0, 1, 0, KC_A);
+    auto       right_key = KeymapKey(0, 8, 0, KC_B);
+
+    set_keymap({swap_key, left_key, right_key});
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    swap_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    left_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    left_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    swap_key.release();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SwapHands, every_position_swaps_to_its_mirror) {
+    TestDriver             driver;
+    InSequence             s;
+    std::vector<KeymapKey> keys;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            keys.push_back(KeymapKey(0, col, row, KC_A + row * MATRIX_COLS + col));
+        }
+    }
+    for (auto &key : keys) {
+        add_key(key);
+    }
+    swap_hands = true;
+
+    for (auto &key : keys) {
+        uint16_t mirrored = KC_A + key.position.row * MATRIX_COLS + (MATRIX_COLS - 1 - key.position.col);
+
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(mirrored)));
+        key.press();
+        run_one_scan_loop();
+        testing::Mock::VerifyAndClearExpectations(&driver);
+
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+        key.release();
+        run_one_scan_loop();
+        testing::Mock::VerifyAndClearExpectations(&driver);
+    }
+}
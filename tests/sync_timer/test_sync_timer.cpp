@@ -0,0 +1,174 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <deque>
+
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+
+extern "C" {
+#include "keyboard.h"
+#include "sync_timer.h"
+#include "timer.h"
+#include "transport.h"
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+
+/* This half never sees USB, so it is the slave */
+bool usb_vbus_state(void) {
+    return false;
+}
+
+/* Mocked split transport */
+void transport_master_init(void) {}
+void transport_slave_init(void) {}
+void transport_slave_stop(void) {}
+bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    return true;
+}
+void transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {}
+}
+
+class SyncTimer : public TestFixture {
+   protected:
+    /* Master clock, running `ppm` faster than the local one and `offset` ms ahead */
+    double   ppm    = 0;
+    double   offset = 0;
+    uint32_t seed   = 1;
+
+    struct sync_t {
+        uint32_t arrival;
+        uint32_t master_time;
+    };
+    std::deque<sync_t> link;
+
+    void SetUp() override {
+        set_time(0);
+        sync_timer_init();
+        link.clear();
+    }
+
+    double master_time(uint32_t local) {
+        return offset + local * (1.0 + ppm / 1e6);
+    }
+
+    uint32_t random() {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 16;
+    }
+
+    /* Link latency between 0 and 4 ms each way */
+    uint32_t latency() {
+        return random() % 5;
+    }
+
+    /* A round trip of `ms`, read off a millisecond clock that ticks at a random point of it */
+    uint32_t round_trip_reading(double ms) {
+        double phase = (random() % 1000) / 1000.0;
+        return (uint32_t)std::floor(phase + ms);
+    }
+
+    /* Runs for `duration` local ms, sending a sync every 100 ms if `syncing`.
+     * Returns the largest error seen after `settle` ms, and checks the reading never goes backwards. */
+    double run(uint32_t duration, uint32_t settle, bool syncing = true) {
+        double   max_error = 0;
+        uint32_t last      = sync_timer_read32();
+        for (uint32_t t = 0; t < duration; t++) {
+            uint32_t now = timer_read32();
+            if (syncing && now % 100 == 0) {
+                /* the master makes up for the latency it measured on earlier syncs */
+                uint32_t there = latency(), back = latency();
+                link.push_back({now + there, (uint32_t)master_time(now) + sync_timer_latency()});
+                sync_timer_latency_sample(there + back);
+            }
+            while (!link.empty() && link.front().arrival <= now) {
+                sync_timer_update_at(link.front().master_time, link.front().arrival);
+                link.pop_front();
+            }
+
+            uint32_t read = sync_timer_read32();
+            EXPECT_GE((int32_t)(read - last), 0) << "went backwards at " << now;
+            last = read;
+            if (t >= settle) {
+                max_error = std::max(max_error, std::fabs(read - master_time(now)));
+            }
+            advance_time(1);
+        }
+        return max_error;
+    }
+};
+
+TEST_F(SyncTimer, follows_a_faster_master_clock) {
+    ppm    = 500;
+    offset = 123456;
+    EXPECT_LE(run(60000, 3000), 3.0);
+}
+
+TEST_F(SyncTimer, follows_a_slower_master_clock) {
+    ppm    = -500;
+    offset = 5000;
+    EXPECT_LE(run(60000, 3000), 3.0);
+}
+
+TEST_F(SyncTimer, keeps_the_rate_while_syncs_stop) {
+    ppm    = 2000;
+    offset = 1000;
+    run(30000, 0);
+    /* Without rate tracking the error would grow to 20 ms here */
+    EXPECT_LE(run(10000, 0, false), 3.0);
+}
+
+TEST_F(SyncTimer, steps_to_a_restarted_master) {
+    ppm    = 100;
+    offset = 100000;
+    run(5000, 0);
+
+    /* The master rebooted: time goes back once, then is tracked again */
+    offset -= 100000;
+    link.clear();
+    sync_timer_update_at(master_time(timer_read32()), timer_read32());
+    EXPECT_NEAR(sync_timer_read32(), master_time(timer_read32()), 1.0);
+    EXPECT_LE(run(10000, 3000), 3.0);
+}
+
+TEST_F(SyncTimer, latency_is_half_the_average_round_trip) {
+    /* whole-ms readings of round trips with a fraction of a ms */
+    const struct {
+        double   round_trip;
+        uint32_t latency;
+    } cases[] = {{0.6, 0}, {1.4, 1}, {3.2, 2}, {6.4, 3}, {8.6, 4}};
+
+    for (auto &c : cases) {
+        sync_timer_init();
+        for (int i = 0; i < 200; i++) {
+            sync_timer_latency_sample(round_trip_reading(c.round_trip));
+        }
+        EXPECT_EQ(sync_timer_latency(), c.latency) << "round trip of " << c.round_trip << " ms";
+    }
+}
+
+TEST_F(SyncTimer, latency_converges_within_a_few_syncs) {
+    for (int i = 0; i < 30; i++) {
+        sync_timer_latency_sample(6);
+    }
+    EXPECT_EQ(sync_timer_latency(), 3);
+
+    /* and ignores a transfer that stalled */
+    sync_timer_latency_sample(60000);
+    EXPECT_EQ(sync_timer_latency(), 3);
+}
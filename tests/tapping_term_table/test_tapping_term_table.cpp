@@ -0,0 +1,257 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include "keyboard_report_util.hpp"
+#include "test_common.hpp"
+#include "action_tapping.h"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "eeprom.h"
+#include "eeprom_schema.h"
+
+/* qmk_settings.h itself does not build as C++ */
+void qmk_settings_reset(void);
+int  qmk_settings_set(uint16_t qsid, const void *setting, size_t maxsz);
+}
+
+using testing::_;
+using testing::InSequence;
+
+#define FAST_TERM 100
+#define SLOW_TERM 300
+
+class TappingTermTable : public TestFixture {
+   protected:
+    KeymapKey fast_key    = KeymapKey(0, 0, 0, LSFT_T(KC_A));
+    KeymapKey slow_key    = KeymapKey(0, 1, 0, LCTL_T(KC_B));
+    KeymapKey regular_key = KeymapKey(0, 2, 0, KC_C);
+
+    void SetUp() override {
+        TestFixture::SetUp();
+        qmk_settings_reset();
+        /* ignore mod-tap interrupt, so that keys are only decided by their own term and flags */
+        uint8_t tapping = 2;
+        qmk_settings_set(8, &tapping, sizeof(tapping));
+        dynamic_keymap_reset_region(DYNAMIC_KEYMAP_REGION_TAPPING_TERM, 0);
+        dynamic_keymap_set_tapping_term(fast_key.position.row, fast_key.position.col, FAST_TERM);
+        dynamic_keymap_set_tapping_term(slow_key.position.row, slow_key.position.col, SLOW_TERM);
+        set_keymap({fast_key, slow_key, regular_key});
+    }
+
+    void press(KeymapKey &key) {
+        key.press();
+        run_one_scan_loop();
+    }
+
+    void release(KeymapKey &key) {
+        key.release();
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(TappingTermTable, KeysUseTheirOwnTerm) {
+    TestDriver driver;
+    InSequence s;
+
+    /* held past its own term, but not past the global one */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    press(fast_key);
+    idle_for(FAST_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(fast_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* held past the global term, but not past its own */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press(slow_key);
+    idle_for(TAPPING_TERM + 50);
+    release(slow_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(TappingTermTable, UnsetEntryFallsBackToGlobalTerm) {
+    TestDriver driver;
+    InSequence s;
+
+    dynamic_keymap_set_tapping_term(slow_key.position.row, slow_key.position.col, 0);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press(slow_key);
+    idle_for(TAPPING_TERM);
+    release(slow_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(TappingTermTable, RollFromSlowToFastKey) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press(slow_key);
+    idle_for(10);
+    press(fast_key);
+    idle_for(TAPPING_TERM + 30);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* the slow key is still within its term, the fast key was pressed long before that of its own */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    release(slow_key);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(fast_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(TappingTermTable, RollFromFastToSlowKey) {
+    TestDriver driver;
+    InSequence s;
+
+    /* the fast key turns into a hold before the slow one is looked at */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    press(fast_key);
+    idle_for(50);
+    press(slow_key);
+    idle_for(FAST_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* the modifier is held back until the slow key is decided */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    release(fast_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* past the global term since it was pressed, but within its own */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(TAPPING_TERM - FAST_TERM);
+    release(slow_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(TappingTermTable, PermissiveHoldOnlyForFlaggedKey) {
+    TestDriver driver;
+    InSequence s;
+
+    dynamic_keymap_set_tapping_term(fast_key.position.row, fast_key.position.col, FAST_TERM | TAPPING_TERM_TABLE_PERMISSIVE_HOLD);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press(fast_key);
+    press(regular_key);
+    release(regular_key);
+    release(fast_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* the same sequence on a key without the flag is two taps */
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press(slow_key);
+    press(regular_key);
+    release(regular_key);
+    release(slow_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(TappingTermTable, HoldOnOtherKeyPressOnlyForFlaggedKey) {
+    TestDriver driver;
+    InSequence s;
+
+    dynamic_keymap_set_tapping_term(slow_key.position.row, slow_key.position.col, SLOW_TERM | TAPPING_TERM_TABLE_HOLD_ON_OTHER_KEY_PRESS);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_C)));
+    press(slow_key);
+    press(regular_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(regular_key);
+    release(slow_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* without the flag, nothing is decided until a release */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press(fast_key);
+    press(regular_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release(fast_key);
+    release(regular_key);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+/* Reads the current layout back from the stored schema table */
+static std::vector<eeprom_schema_region_t> current_layout(uintptr_t table) {
+    std::vector<eeprom_schema_region_t> regions;
+    for (uint8_t i = 0; i < DYNAMIC_KEYMAP_REGION_COUNT; i++) {
+        uintptr_t entry = table + EEPROM_SCHEMA_TABLE_SIZE(i);
+        regions.push_back({eeprom_read_word((uint16_t *)entry), eeprom_read_word((uint16_t *)(entry + 2)), eeprom_read_word((uint16_t *)(entry + 4)), eeprom_read_byte((uint8_t *)(entry + 6))});
+    }
+    return regions;
+}
+
+TEST_F(TappingTermTable, EnablingTheTableIsAResize) {
+    const uintptr_t table_addr = TOTAL_EEPROM_BYTE_COUNT - EEPROM_SCHEMA_TABLE_SIZE(DYNAMIC_KEYMAP_REGION_COUNT);
+    dynamic_keymap_save_schema();
+    std::vector<eeprom_schema_region_t> regions = current_layout(table_addr);
+
+    /* the layout of a build without TAPPING_TERM_TABLE_ENABLE: the region is empty, and macros start where it is now */
+    std::vector<eeprom_schema_region_t> disabled = regions;
+    disabled[DYNAMIC_KEYMAP_REGION_TAPPING_TERM].size   = 0;
+    disabled[DYNAMIC_KEYMAP_REGION_TAPPING_TERM].stride = 1;
+    disabled[DYNAMIC_KEYMAP_REGION_MACRO].addr          = regions[DYNAMIC_KEYMAP_REGION_TAPPING_TERM].addr;
+    disabled[DYNAMIC_KEYMAP_REGION_MACRO].size          = table_addr - disabled[DYNAMIC_KEYMAP_REGION_MACRO].addr;
+
+    std::vector<uint8_t> garbage(table_addr - regions[DYNAMIC_KEYMAP_REGION_TAPPING_TERM].addr, 0xFF);
+    eeprom_update_block(garbage.data(), (void *)(uintptr_t)regions[DYNAMIC_KEYMAP_REGION_TAPPING_TERM].addr, garbage.size());
+    eeprom_update_block("abc", (void *)(uintptr_t)disabled[DYNAMIC_KEYMAP_REGION_MACRO].addr, 4);
+    eeprom_update_byte((uint8_t *)(table_addr - 1), 0);
+    eeprom_schema_save((void *)table_addr, disabled.data(), disabled.size());
+    dynamic_keymap_set_keycode(1, 2, 3, KC_Z);
+
+    ASSERT_TRUE(dynamic_keymap_migrate());
+
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 2, 3), KC_Z);
+    uint8_t macros[4];
+    dynamic_keymap_macro_get_buffer(0, sizeof(macros), macros);
+    EXPECT_STREQ((const char *)macros, "abc");
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            EXPECT_EQ(dynamic_keymap_get_tapping_term(row, col), 0);
+        }
+    }
+    EXPECT_TRUE(eeprom_schema_is_valid((void *)table_addr, DYNAMIC_KEYMAP_REGION_COUNT));
+}
@@ -22,6 +22,11 @@ extern "C" {
 #include "eeconfig.h"
 #include "keyboard.h"
 #include "keymap.h"
+#ifdef VIAL_ENABLE
+#    include "vial.h"
+
+extern uint16_t g_vial_magic_keycode_override;
+#endif
 
 void set_time(uint32_t t);
 void advance_time(uint32_t ms);
@@ -35,6 +40,12 @@ TestFixture* TestFixture::m_this = nullptr;
 /* Override weak QMK function to allow the usage of isolated per-test keymaps in unit-tests.
  * The actual call is dynamicaly dispatched to the current active test fixture, which in turn has it's own keymap. */
 extern "C" uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t position) {
+#ifdef VIAL_ENABLE
+    /* Vial runs keycodes through a position outside the matrix, as the dynamic keymap does */
+    if (position.row == VIAL_MATRIX_MAGIC && position.col == VIAL_MATRIX_MAGIC) {
+        return g_vial_magic_keycode_override;
+    }
+#endif
     uint16_t keycode;
     TestFixture::m_this->get_keycode(layer, position, &keycode);
     return keycode;
@@ -0,0 +1,28 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "test_common.h"
+
+#define VIAL_KEYBOARD_UID \
+    { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }
+
+/* the test fixture provides its own keymap */
+#define OVERRIDE_KEYMAP_KEY_TO_KEYCODE
+
+/* encoder steps are fed straight to vial_encoder_update() */
+#define NUMBER_OF_ENCODERS 1
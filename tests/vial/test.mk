@@ -0,0 +1,34 @@
+# Copyright 2022 QMK
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# --------------------------------------------------------------------------------
+# Keep this file, even if it is empty, as a marker that this folder contains tests
+# --------------------------------------------------------------------------------
+
+VIA_ENABLE = yes
+VIAL_ENABLE = yes
+VIAL_INSECURE = yes
+VIAL_ENCODERS_ENABLE = yes
+
+# The keyboard definition is generated from this folder's vial.json
+KEYMAP_PATH = $(TEST_PATH)
+KEYMAP_OUTPUT = $(TEST_OBJ)/$(TEST)
+VPATH += $(KEYMAP_OUTPUT)
+
+# The dynamic keymap does not fit in the default test EEPROM
+OPT_DEFS += -DTOTAL_EEPROM_BYTE_COUNT=1024
+
+# via.c reads the build date and ID from version.h, which only keyboard builds generate
+$(shell mkdir -p $(KEYMAP_OUTPUT) && printf '#define QMK_BUILDDATE "2022-01-01-00:00:00"\n#define BUILD_ID ((uint32_t)0x00000000)\n' > $(KEYMAP_OUTPUT)/version.h)
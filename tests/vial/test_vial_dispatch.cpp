@@ -0,0 +1,158 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "via.h"
+#include "vial.h"
+
+void raw_hid_receive(uint8_t *data, uint8_t length);
+}
+
+typedef std::vector<uint8_t> packet_t;
+
+static std::vector<packet_t> answers;
+
+extern "C" void raw_hid_send(uint8_t *data, uint8_t length) {
+    answers.push_back(packet_t(data, data + length));
+}
+
+class VialDispatch : public TestFixture {
+   protected:
+    void SetUp() override {
+        /* the per-key tapping settings look the idle tapping key up at (0,0) */
+        set_keymap({KeymapKey(0, 0, 0, KC_NO)});
+        answers.clear();
+    }
+
+    static packet_t packet(std::initializer_list<uint8_t> bytes) {
+        packet_t data(bytes);
+        data.resize(VIAL_RAW_EPSIZE);
+        return data;
+    }
+
+    static void send(packet_t data) {
+        raw_hid_receive(data.data(), data.size());
+    }
+
+    static packet_t get_keycode(uint8_t layer, uint8_t row, uint8_t col) {
+        return packet({id_dynamic_keymap_get_keycode, layer, row, col});
+    }
+};
+
+TEST_F(VialDispatch, via_command_is_answered_right_away) {
+    send(packet({id_get_protocol_version}));
+
+    ASSERT_EQ(answers.size(), 1);
+    EXPECT_EQ(answers[0][0], id_get_protocol_version);
+    EXPECT_EQ(answers[0][1], VIA_PROTOCOL_VERSION >> 8);
+    EXPECT_EQ(answers[0][2], VIA_PROTOCOL_VERSION & 0xFF);
+}
+
+TEST_F(VialDispatch, unknown_command_is_unhandled) {
+    send(packet({0x7F, 0x12}));
+
+    ASSERT_EQ(answers.size(), 1);
+    EXPECT_EQ(answers[0][0], id_unhandled);
+    EXPECT_EQ(answers[0][1], 0x12);
+}
+
+TEST_F(VialDispatch, vial_command_goes_to_its_handler) {
+    send(packet({id_vial_prefix, vial_get_keyboard_id}));
+
+    ASSERT_EQ(answers.size(), 1);
+    EXPECT_EQ(answers[0][0], VIAL_PROTOCOL_VERSION & 0xFF);
+    EXPECT_EQ(answers[0][4], 0x00);
+    EXPECT_EQ(answers[0][11], 0x07);
+}
+
+TEST_F(VialDispatch, unknown_vial_command_is_echoed) {
+    packet_t data = packet({id_vial_prefix, 0x7F, 0x01, 0x02});
+
+    send(data);
+
+    ASSERT_EQ(answers.size(), 1);
+    EXPECT_EQ(answers[0], data);
+}
+
+TEST_F(VialDispatch, vial_encoder_commands) {
+    send(packet({id_vial_prefix, vial_set_encoder, 1, 0, 1, KC_B >> 8, KC_B & 0xFF}));
+    send(packet({id_vial_prefix, vial_get_encoder, 1, 0}));
+
+    ASSERT_EQ(answers.size(), 2);
+    EXPECT_EQ(dynamic_keymap_get_encoder(1, 0, 1), KC_B);
+    EXPECT_EQ(answers[1][2], KC_B >> 8);
+    EXPECT_EQ(answers[1][3], KC_B & 0xFF);
+}
+
+TEST_F(VialDispatch, buffer_write_is_deferred_to_the_main_loop) {
+    TestDriver driver;
+
+    dynamic_keymap_set_keycode(0, 0, 1, KC_A);
+
+    /* the second key of layer 0 */
+    send(packet({id_dynamic_keymap_set_buffer, 0, 2, 2, KC_B >> 8, KC_B & 0xFF}));
+    ASSERT_EQ(answers.size(), 1);
+    EXPECT_EQ(answers[0][0], id_dynamic_keymap_set_buffer);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 1), KC_A);
+
+    run_one_scan_loop();
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 1), KC_B);
+}
+
+TEST_F(VialDispatch, command_after_a_reset_is_answered_once_it_is_done) {
+    TestDriver driver;
+
+    dynamic_keymap_set_keycode(0, 0, 1, KC_A);
+
+    send(packet({id_dynamic_keymap_reset}));
+    ASSERT_EQ(answers.size(), 1);
+    EXPECT_EQ(answers[0][0], id_dynamic_keymap_reset);
+
+    /* queued, then answered with the reset keymap */
+    send(get_keycode(0, 0, 1));
+    EXPECT_EQ(answers.size(), 1);
+
+    idle_for(DYNAMIC_KEYMAP_REGION_COUNT);
+    ASSERT_EQ(answers.size(), 2);
+    EXPECT_EQ(answers[1][0], id_dynamic_keymap_get_keycode);
+    EXPECT_EQ((answers[1][4] << 8) | answers[1][5], dynamic_keymap_get_keycode(0, 0, 1));
+    EXPECT_NE(dynamic_keymap_get_keycode(0, 0, 1), KC_A);
+}
+
+TEST_F(VialDispatch, command_beyond_the_queue_is_busy) {
+    TestDriver driver;
+
+    send(packet({id_dynamic_keymap_reset}));
+    send(get_keycode(0, 0, 1));
+    send(get_keycode(0, 0, 2));
+
+    ASSERT_EQ(answers.size(), 2);
+    EXPECT_EQ(answers[1][0], id_busy);
+    EXPECT_EQ(answers[1][3], 2);
+
+    idle_for(DYNAMIC_KEYMAP_REGION_COUNT);
+    ASSERT_EQ(answers.size(), 3);
+    EXPECT_EQ(answers[2][0], id_dynamic_keymap_get_keycode);
+    EXPECT_EQ(answers[2][3], 1);
+}
@@ -0,0 +1,136 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "vial.h"
+}
+
+using testing::_;
+using testing::InSequence;
+
+#define ENCODER_CCW 0
+#define ENCODER_CW 1
+
+class VialEncoder : public TestFixture {
+   protected:
+    void SetUp() override {
+        /* the per-key tapping settings look the idle tapping key up at (0,0) */
+        set_keymap({KeymapKey(0, 0, 0, KC_NO)});
+        dynamic_keymap_set_encoder(0, 0, ENCODER_CCW, KC_A);
+        dynamic_keymap_set_encoder(0, 0, ENCODER_CW, KC_B);
+    }
+};
+
+TEST_F(VialEncoder, step_is_held_without_waiting) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    uint16_t start = timer_read();
+    vial_encoder_update(0, true);
+    EXPECT_EQ(timer_read(), start);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(VIAL_ENCODER_KEYCODE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(VialEncoder, steps_queue_behind_the_held_one) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    vial_encoder_update(0, true);
+    vial_encoder_update(0, false);
+    vial_encoder_update(0, true);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* each step is released and the next one pressed once its time is up */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(VIAL_ENCODER_KEYCODE_DELAY);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* the next step was pressed during the last scan */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(VIAL_ENCODER_KEYCODE_DELAY - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(VIAL_ENCODER_KEYCODE_DELAY + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(VialEncoder, steps_beyond_the_queue_are_dropped) {
+    TestDriver driver;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B))).Times(VIAL_ENCODER_TAP_QUEUE_SIZE);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(VIAL_ENCODER_TAP_QUEUE_SIZE);
+    for (int i = 0; i < VIAL_ENCODER_TAP_QUEUE_SIZE + 2; i++) {
+        vial_encoder_update(0, true);
+    }
+    idle_for((VIAL_ENCODER_KEYCODE_DELAY + 1) * (VIAL_ENCODER_TAP_QUEUE_SIZE + 2));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(VialEncoder, quantum_keycode_is_processed) {
+    TestDriver driver;
+
+    dynamic_keymap_set_encoder(0, 0, ENCODER_CW, TG(1));
+
+    /* the layer toggles on release, which the step still sends */
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    vial_encoder_update(0, true);
+    EXPECT_TRUE(layer_state_is(0));
+    idle_for(VIAL_ENCODER_KEYCODE_DELAY + 1);
+    EXPECT_TRUE(layer_state_is(1));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(VialEncoder, higher_layer_overrides_the_step) {
+    TestDriver driver;
+    InSequence s;
+
+    dynamic_keymap_set_encoder(1, 0, ENCODER_CW, KC_C);
+    layer_on(1);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    vial_encoder_update(0, true);
+    idle_for(VIAL_ENCODER_KEYCODE_DELAY + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
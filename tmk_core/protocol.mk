@@ -4,6 +4,7 @@ TMK_COMMON_SRC +=	\
 	$(PROTOCOL_COMMON_DIR)/host.c \
 	$(PROTOCOL_COMMON_DIR)/report.c \
 	$(PROTOCOL_COMMON_DIR)/usb_device_state.c \
+	$(PROTOCOL_COMMON_DIR)/usb_polling_interval.c \
 	$(PROTOCOL_COMMON_DIR)/usb_util.c \
 
 SHARED_EP_ENABLE = no
@@ -10,6 +10,12 @@ SRC += $(PICO_DIR)/iusb.c
 SRC += $(PICO_DIR)/pio_manager.c
 SRC += $(PICO_DIR)/usb_util.c
 
+ifeq ($(strip $(KEYMAP_DISK_ENABLE)), yes)
+    SRC += $(PICO_DIR)/msc_disk.c
+    SRC += $(PICO_DIR)/keymap_disk.c
+    CFLAGS += -DKEYMAP_DISK_ENABLE
+endif
+
 VPATH += $(TMK_PATH)/$(PROTOCOL_DIR)
 VPATH += $(TMK_PATH)/$(PICO_DIR)
 VPATH += $(TMK_PATH)/$(PICO_DIR)/lufa_utils
@@ -0,0 +1,339 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keymap_disk.h"
+#include "dynamic_keymap.h"
+#include "timer.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// Snapshots only restore onto a keyboard with the same matrix and layer count
+#ifndef KEYMAP_DISK_LAYOUT
+#    define KEYMAP_DISK_LAYOUT ((uint32_t)MATRIX_ROWS << 16 | (uint32_t)MATRIX_COLS << 8 | DYNAMIC_KEYMAP_LAYER_COUNT)
+#endif
+
+// 2022-01-01 00:00, for all directory entries
+#define KEYMAP_DISK_FAT_DATE ((42 << 9) | (1 << 5) | 1)
+#define KEYMAP_DISK_FAT_TIME 0
+
+#define KEYMAP_DISK_ROOT_ENTRIES 16
+#define KEYMAP_DISK_DATA_SECTOR 3
+// Clusters are one sector, and cluster 2 is the first data sector
+#define KEYMAP_DISK_CLUSTER(sector) ((sector)-KEYMAP_DISK_DATA_SECTOR + 2)
+
+_Static_assert(KEYMAP_DISK_BLOCK_COUNT_MAX <= 32, "KEYMAP_DISK_SNAPSHOT_MAX_SIZE is too large");
+
+static keymap_disk_status_t status = KEYMAP_DISK_IDLE;
+
+// Snapshot being collected from the host
+static uint8_t  staging[KEYMAP_DISK_BLOCK_COUNT_MAX * KEYMAP_DISK_BLOCK_PAYLOAD];
+static uint32_t staging_blocks   = 0; // one bit per received block
+static uint32_t staging_crc      = 0;
+static uint16_t staging_size     = 0;
+static uint8_t  staging_sector[KEYMAP_DISK_SECTOR_SIZE];
+
+// Checksum of the whole snapshot, which every block of KEYMAP.BIN carries
+static uint32_t read_crc       = 0;
+static uint32_t read_time      = 0;
+static bool     read_crc_valid = false;
+
+__attribute__((weak)) void keymap_disk_restored_user(void) {}
+
+__attribute__((weak)) void keymap_disk_restored_kb(void) {
+    keymap_disk_restored_user();
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, uint16_t size) {
+    crc = ~crc;
+    while (size--) {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t snapshot_crc(uint16_t size) {
+    uint8_t  chunk[64];
+    uint32_t crc = 0;
+    for (uint16_t offset = 0; offset < size; offset += sizeof(chunk)) {
+        uint16_t length = size - offset < sizeof(chunk) ? size - offset : sizeof(chunk);
+        dynamic_keymap_snapshot_read(offset, length, chunk);
+        crc = crc32_update(crc, chunk, length);
+    }
+    return crc;
+}
+
+// A host reads the file from its first block, which starts a new read session
+static uint32_t snapshot_crc_cached(uint16_t block, uint16_t size) {
+    if (block == 0 || !read_crc_valid || timer_elapsed32(read_time) > KEYMAP_DISK_READ_SESSION_TIMEOUT) {
+        read_crc       = snapshot_crc(size);
+        read_crc_valid = true;
+    }
+    read_time = timer_read32();
+    return read_crc;
+}
+
+static uint16_t snapshot_size(void) {
+    uint16_t size = dynamic_keymap_snapshot_size();
+    // Too large to be restored, so not offered at all
+    return size <= KEYMAP_DISK_SNAPSHOT_MAX_SIZE ? size : 0;
+}
+
+static uint16_t snapshot_block_count(uint16_t size) {
+    return (size + KEYMAP_DISK_BLOCK_PAYLOAD - 1) / KEYMAP_DISK_BLOCK_PAYLOAD;
+}
+
+// The staging_blocks bits of a complete snapshot
+static uint32_t snapshot_block_mask(uint16_t count) {
+    return count < 32 ? ((uint32_t)1 << count) - 1 : UINT32_MAX;
+}
+
+uint32_t keymap_disk_snapshot_file_size(void) {
+    return (uint32_t)snapshot_block_count(snapshot_size()) * KEYMAP_DISK_SECTOR_SIZE;
+}
+
+static uint16_t readme(char *text, uint16_t size) {
+    static const char *const results[] = {
+        [KEYMAP_DISK_IDLE]     = "none",
+        [KEYMAP_DISK_PENDING]  = "in progress",
+        [KEYMAP_DISK_RESTORED] = "restored",
+        [KEYMAP_DISK_REJECTED] = "rejected",
+    };
+    int length = snprintf(text, size,
+                          "KEYMAP.BIN is a backup of the keymap, macros and settings.\r\n"
+                          "Copy a backup onto this disk to restore it.\r\n"
+                          "\r\n"
+                          "Last restore: %s\r\n",
+                          results[status]);
+    return length < size ? length : size - 1;
+}
+
+static void fat12_set(uint8_t *fat, uint16_t cluster, uint16_t value) {
+    uint16_t i = cluster + cluster / 2;
+    if (cluster & 1) {
+        fat[i]     = (fat[i] & 0x0F) | (value << 4);
+        fat[i + 1] = value >> 4;
+    } else {
+        fat[i]     = value;
+        fat[i + 1] = (fat[i + 1] & 0xF0) | ((value >> 8) & 0x0F);
+    }
+}
+
+static void write16(uint8_t *p, uint16_t value) {
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+static void write32(uint8_t *p, uint32_t value) {
+    write16(p, value);
+    write16(p + 2, value >> 16);
+}
+
+static void boot_sector(uint8_t *sector) {
+    static const uint8_t jump[] = {0xEB, 0x3C, 0x90, 'M', 'S', 'D', 'O', 'S', '5', '.', '0'};
+    memcpy(sector, jump, sizeof(jump));
+    write16(sector + 11, KEYMAP_DISK_SECTOR_SIZE);
+    sector[13] = 1; // sectors per cluster
+    write16(sector + 14, 1); // reserved sectors
+    sector[16] = 1; // FATs
+    write16(sector + 17, KEYMAP_DISK_ROOT_ENTRIES);
+    write16(sector + 19, KEYMAP_DISK_SECTOR_COUNT);
+    sector[21] = 0xF8; // media: fixed disk
+    write16(sector + 22, 1); // sectors per FAT
+    write16(sector + 24, 1); // sectors per track
+    write16(sector + 26, 1); // heads
+    sector[36] = 0x80; // drive number
+    sector[38] = 0x29; // extended boot signature
+    write32(sector + 39, KEYMAP_DISK_MAGIC);
+    memcpy(sector + 43, KEYMAP_DISK_VOLUME_LABEL, 11);
+    memcpy(sector + 54, "FAT12   ", 8);
+    sector[510] = 0x55;
+    sector[511] = 0xAA;
+}
+
+static void fat_sector(uint8_t *sector) {
+    fat12_set(sector, 0, 0xFF8);
+    fat12_set(sector, 1, 0xFFF);
+    fat12_set(sector, KEYMAP_DISK_CLUSTER(KEYMAP_DISK_README_SECTOR), 0xFFF);
+
+    uint16_t first = KEYMAP_DISK_CLUSTER(KEYMAP_DISK_SNAPSHOT_SECTOR);
+    uint16_t count = snapshot_block_count(snapshot_size());
+    for (uint16_t i = 0; i < count; i++) {
+        fat12_set(sector, first + i, i + 1 < count ? first + i + 1 : 0xFFF);
+    }
+}
+
+static void directory_entry(uint8_t *entry, const char *name, uint8_t attributes, uint16_t cluster, uint32_t size) {
+    memcpy(entry, name, 11);
+    entry[11] = attributes;
+    write16(entry + 14, KEYMAP_DISK_FAT_TIME); // created
+    write16(entry + 16, KEYMAP_DISK_FAT_DATE);
+    write16(entry + 18, KEYMAP_DISK_FAT_DATE); // accessed
+    write16(entry + 22, KEYMAP_DISK_FAT_TIME); // modified
+    write16(entry + 24, KEYMAP_DISK_FAT_DATE);
+    write16(entry + 26, cluster);
+    write32(entry + 28, size);
+}
+
+static void root_directory_sector(uint8_t *sector) {
+    char text[KEYMAP_DISK_SECTOR_SIZE];
+
+    directory_entry(sector, KEYMAP_DISK_VOLUME_LABEL, 0x08, 0, 0);
+    directory_entry(sector + 32, "README  TXT", 0x01, KEYMAP_DISK_CLUSTER(KEYMAP_DISK_README_SECTOR), readme(text, sizeof(text)));
+    uint32_t size = keymap_disk_snapshot_file_size();
+    if (size) {
+        directory_entry(sector + 64, "KEYMAP  BIN", 0x20, KEYMAP_DISK_CLUSTER(KEYMAP_DISK_SNAPSHOT_SECTOR), size);
+    }
+}
+
+static void snapshot_sector(uint16_t block, uint8_t *sector) {
+    uint16_t size = snapshot_size();
+    if (block >= snapshot_block_count(size)) {
+        return;
+    }
+
+    keymap_disk_block_t header = {
+        .magic        = KEYMAP_DISK_MAGIC,
+        .vendor_id    = VENDOR_ID,
+        .product_id   = PRODUCT_ID,
+        .layout       = KEYMAP_DISK_LAYOUT,
+        .block        = block,
+        .block_count  = snapshot_block_count(size),
+        .size         = size,
+        .snapshot_crc = snapshot_crc_cached(block, size),
+    };
+    uint16_t offset  = block * KEYMAP_DISK_BLOCK_PAYLOAD;
+    uint16_t length  = size - offset < KEYMAP_DISK_BLOCK_PAYLOAD ? size - offset : KEYMAP_DISK_BLOCK_PAYLOAD;
+    uint8_t *payload = sector + sizeof(header);
+    dynamic_keymap_snapshot_read(offset, length, payload);
+
+    header.block_crc = crc32_update(crc32_update(0, (const uint8_t *)&header, offsetof(keymap_disk_block_t, block_crc)), payload, KEYMAP_DISK_BLOCK_PAYLOAD);
+    memcpy(sector, &header, sizeof(header));
+}
+
+void keymap_disk_read_sector(uint32_t lba, uint8_t *sector) {
+    memset(sector, 0, KEYMAP_DISK_SECTOR_SIZE);
+
+    if (lba == 0) {
+        boot_sector(sector);
+    } else if (lba == 1) {
+        fat_sector(sector);
+    } else if (lba == 2) {
+        root_directory_sector(sector);
+    } else if (lba == KEYMAP_DISK_README_SECTOR) {
+        readme((char *)sector, KEYMAP_DISK_SECTOR_SIZE);
+    } else if (lba >= KEYMAP_DISK_SNAPSHOT_SECTOR && lba < KEYMAP_DISK_SECTOR_COUNT) {
+        snapshot_sector(lba - KEYMAP_DISK_SNAPSHOT_SECTOR, sector);
+    }
+}
+
+static void staging_reset(void) {
+    staging_blocks = 0;
+    staging_crc    = 0;
+    staging_size   = 0;
+}
+
+static void reject(void) {
+    staging_reset();
+    status = KEYMAP_DISK_REJECTED;
+}
+
+void keymap_disk_write_sector(uint32_t lba, const uint8_t *sector) {
+    // The host's own bookkeeping (FAT, directory) is ignored, the disk is regenerated on every read
+    if (lba < KEYMAP_DISK_DATA_SECTOR) {
+        return;
+    }
+
+    keymap_disk_block_t header;
+    memcpy(&header, sector, sizeof(header));
+    if (header.magic != KEYMAP_DISK_MAGIC) {
+        return;
+    }
+
+    const uint8_t *payload = sector + sizeof(header);
+    uint16_t       size    = snapshot_size();
+    if (header.block_crc != crc32_update(crc32_update(0, sector, offsetof(keymap_disk_block_t, block_crc)), payload, KEYMAP_DISK_BLOCK_PAYLOAD)) {
+        reject();
+        return;
+    }
+    if (header.vendor_id != VENDOR_ID || header.product_id != PRODUCT_ID || header.layout != KEYMAP_DISK_LAYOUT || header.size != size || header.block_count != snapshot_block_count(size) || header.block >= header.block_count) {
+        reject();
+        return;
+    }
+
+    // A block of a different snapshot starts over
+    if (staging_blocks && header.snapshot_crc != staging_crc) {
+        staging_reset();
+    }
+    staging_crc  = header.snapshot_crc;
+    staging_size = header.size;
+    memcpy(staging + header.block * KEYMAP_DISK_BLOCK_PAYLOAD, payload, KEYMAP_DISK_BLOCK_PAYLOAD);
+    staging_blocks |= (uint32_t)1 << header.block;
+    status = KEYMAP_DISK_PENDING;
+
+    if (staging_blocks != snapshot_block_mask(header.block_count)) {
+        return;
+    }
+
+    if (crc32_update(0, staging, staging_size) != staging_crc || !dynamic_keymap_snapshot_write(staging)) {
+        reject();
+        return;
+    }
+    staging_reset();
+    read_crc_valid = false;
+    status         = KEYMAP_DISK_RESTORED;
+    keymap_disk_restored_kb();
+}
+
+void keymap_disk_read(uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t size) {
+    uint8_t sector[KEYMAP_DISK_SECTOR_SIZE];
+
+    lba += offset / KEYMAP_DISK_SECTOR_SIZE;
+    offset %= KEYMAP_DISK_SECTOR_SIZE;
+    while (size) {
+        uint32_t length = KEYMAP_DISK_SECTOR_SIZE - offset < size ? KEYMAP_DISK_SECTOR_SIZE - offset : size;
+        keymap_disk_read_sector(lba, sector);
+        memcpy(buffer, sector + offset, length);
+        buffer += length;
+        size -= length;
+        offset = 0;
+        lba++;
+    }
+}
+
+void keymap_disk_write(uint32_t lba, uint32_t offset, const uint8_t *buffer, uint32_t size) {
+    // Sectors can arrive in several pieces, only complete ones are looked at
+    lba += offset / KEYMAP_DISK_SECTOR_SIZE;
+    offset %= KEYMAP_DISK_SECTOR_SIZE;
+    while (size) {
+        uint32_t length = KEYMAP_DISK_SECTOR_SIZE - offset < size ? KEYMAP_DISK_SECTOR_SIZE - offset : size;
+        memcpy(staging_sector + offset, buffer, length);
+        if (offset + length == KEYMAP_DISK_SECTOR_SIZE) {
+            keymap_disk_write_sector(lba, staging_sector);
+        }
+        buffer += length;
+        size -= length;
+        offset = 0;
+        lba++;
+    }
+}
+
+keymap_disk_status_t keymap_disk_get_status(void) {
+    return status;
+}
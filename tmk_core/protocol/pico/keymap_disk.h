@@ -0,0 +1,97 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * A virtual FAT12 disk holding README.TXT and KEYMAP.BIN, a snapshot of the whole dynamic keymap
+ * area (keymaps, encoders, QMK settings, tap dance, combos, key overrides and macros). Nothing is
+ * stored: every sector is generated when the host reads it.
+ *
+ * KEYMAP.BIN is a sequence of 512 byte blocks, each a keymap_disk_block_t header followed by up to
+ * KEYMAP_DISK_BLOCK_PAYLOAD bytes of the snapshot. Since every block carries its own position and
+ * checksums, a copy of the file is recognised in whatever sectors the host chooses to write it to.
+ * Blocks are collected in RAM, and the snapshot is only written to EEPROM once all of them have
+ * arrived and the whole snapshot checks out.
+ */
+#define KEYMAP_DISK_SECTOR_SIZE 512
+
+#ifndef KEYMAP_DISK_SECTOR_COUNT
+#    define KEYMAP_DISK_SECTOR_COUNT 128
+#endif
+
+// Largest snapshot that can be restored, which is also the size of the RAM staging buffer
+#ifndef KEYMAP_DISK_SNAPSHOT_MAX_SIZE
+#    define KEYMAP_DISK_SNAPSHOT_MAX_SIZE 4096
+#endif
+
+// The snapshot checksum is computed once per read of KEYMAP.BIN, and again after this many ms without a read
+#ifndef KEYMAP_DISK_READ_SESSION_TIMEOUT
+#    define KEYMAP_DISK_READ_SESSION_TIMEOUT 1000
+#endif
+
+#ifndef KEYMAP_DISK_VOLUME_LABEL
+#    define KEYMAP_DISK_VOLUME_LABEL "QMK KEYMAP "
+#endif
+
+#define KEYMAP_DISK_MAGIC 0x534B4D51 // "QMKS"
+#define KEYMAP_DISK_BLOCK_PAYLOAD (KEYMAP_DISK_SECTOR_SIZE - sizeof(keymap_disk_block_t))
+#define KEYMAP_DISK_BLOCK_COUNT_MAX ((KEYMAP_DISK_SNAPSHOT_MAX_SIZE + KEYMAP_DISK_BLOCK_PAYLOAD - 1) / KEYMAP_DISK_BLOCK_PAYLOAD)
+
+// Sectors 0 - 2 hold the boot sector, FAT and root directory, followed by one cluster for the README
+#define KEYMAP_DISK_README_SECTOR 3
+#define KEYMAP_DISK_SNAPSHOT_SECTOR 4
+
+#if KEYMAP_DISK_SECTOR_COUNT > 340
+#    error "KEYMAP_DISK_SECTOR_COUNT must fit in a single FAT12 sector (340 sectors)"
+#endif
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t vendor_id;
+    uint16_t product_id;
+    uint32_t layout;      // matrix size and layer count of the keyboard the snapshot was taken on
+    uint16_t block;       // index of this block
+    uint16_t block_count; // blocks in the snapshot
+    uint16_t size;        // snapshot size in bytes
+    uint16_t reserved;
+    uint32_t snapshot_crc; // CRC-32 of the whole snapshot
+    uint32_t block_crc;    // CRC-32 of this block's header, up to this field, and payload
+} keymap_disk_block_t;
+
+typedef enum {
+    KEYMAP_DISK_IDLE,     // nothing written yet
+    KEYMAP_DISK_PENDING,  // some blocks of a snapshot have been received
+    KEYMAP_DISK_RESTORED, // the last snapshot was written to EEPROM
+    KEYMAP_DISK_REJECTED, // the last snapshot was corrupt, or for another keyboard
+} keymap_disk_status_t;
+
+uint32_t keymap_disk_snapshot_file_size(void);
+void     keymap_disk_read_sector(uint32_t lba, uint8_t *sector);
+void     keymap_disk_write_sector(uint32_t lba, const uint8_t *sector);
+
+// Byte ranges starting at offset within lba, as handed over by the MSC read/write callbacks
+void keymap_disk_read(uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t size);
+void keymap_disk_write(uint32_t lba, uint32_t offset, const uint8_t *buffer, uint32_t size);
+
+keymap_disk_status_t keymap_disk_get_status(void);
+
+// Called with a validated snapshot right after it has been written
+void keymap_disk_restored_kb(void);
+void keymap_disk_restored_user(void);
@@ -97,7 +97,11 @@
 
 //------------- CLASS -------------//
 #define CFG_TUD_CDC              1
+#ifdef KEYMAP_DISK_ENABLE
+#define CFG_TUD_MSC              1
+#else
 #define CFG_TUD_MSC              0
+#endif
 #define CFG_TUD_HID              5
 #define CFG_TUD_MIDI             1
 #define CFG_TUD_VENDOR           0
@@ -112,6 +116,9 @@
 // HID buffer size Should be sufficient to hold ID (if any) + Data
 #define CFG_TUD_HID_EP_BUFSIZE   64
 
+// MSC buffer size, one whole sector per transfer
+#define CFG_TUD_MSC_EP_BUFSIZE   512
+
 #define CFG_TUD_MIDI_RX_BUFSIZE   64
 #define CFG_TUD_MIDI_TX_BUFSIZE   64
 
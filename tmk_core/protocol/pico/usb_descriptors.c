@@ -84,9 +84,15 @@ uint8_t const* tud_descriptor_device_cb(void) {
 #    define MIDI_DESC_LEN 0
 #endif
 
+#ifdef KEYMAP_DISK_ENABLE
+#    define MSC_DESC_LEN TUD_MSC_DESC_LEN
+#else
+#    define MSC_DESC_LEN 0
+#endif
+
 #define CONFIG_TOTAL_LEN                                             \
     (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_HID_DESC_LEN * 4 + \
-     TUD_HID_INOUT_DESC_LEN + MIDI_DESC_LEN)
+     TUD_HID_INOUT_DESC_LEN + MIDI_DESC_LEN + MSC_DESC_LEN)
 
 #define EPNUM_HID_KEYBOARD_IN 0x81
 #define EPNUM_HID_MOUSE_IN 0x82
@@ -104,6 +110,11 @@ uint8_t const* tud_descriptor_device_cb(void) {
 #    define EPNUM_MIDI_OUT 0x08
 #endif
 
+#ifdef KEYMAP_DISK_ENABLE
+#    define EPNUM_MSC_IN 0x89
+#    define EPNUM_MSC_OUT 0x09
+#endif
+
 static uint8_t const desc_keyboard[] = {TUD_HID_REPORT_DESC_KEYBOARD()};
 
 static uint8_t const desc_mouse[] = {TUD_HID_REPORT_DESC_MOUSE()};
@@ -163,6 +174,11 @@ uint8_t const desc_fs_configuration[] = {
     TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 2, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT,
                        EPNUM_CDC_IN, 64),
 
+#ifdef KEYMAP_DISK_ENABLE
+    // Interface number, string index, EP Out & EP In address, EP size
+    TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 0, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+#endif
+
 #ifdef MIDI_ENABLE
     TUD_MIDI_DESCRIPTOR(ITF_NUM_MIDI, 2, EPNUM_MIDI_OUT, EPNUM_MIDI_IN, 64)
 #endif
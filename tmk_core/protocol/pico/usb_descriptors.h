@@ -14,6 +14,9 @@ enum {
     ITF_NUM_HID_CONSOLE,
     ITF_NUM_CDC,
     ITF_NUM_CDC_DATA,
+#ifdef KEYMAP_DISK_ENABLE
+    ITF_NUM_MSC,
+#endif
 #ifdef MIDI_ENABLE
     ITF_NUM_MIDI,
     ITF_NUM_MIDI_STREAMING,
@@ -0,0 +1,260 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "keymap_disk.h"
+}
+
+// Stands in for the dynamic keymap area in EEPROM
+static std::vector<uint8_t> storage;
+static bool                 storage_locked;
+static int                  restored_count;
+
+extern "C" {
+uint16_t dynamic_keymap_snapshot_size(void) {
+    return storage.size();
+}
+
+void dynamic_keymap_snapshot_read(uint16_t offset, uint16_t size, uint8_t *data) {
+    memcpy(data, storage.data() + offset, size);
+}
+
+bool dynamic_keymap_snapshot_write(const uint8_t *data) {
+    if (storage_locked) {
+        return false;
+    }
+    memcpy(storage.data(), data, storage.size());
+    return true;
+}
+
+void keymap_disk_restored_kb(void) {
+    restored_count++;
+}
+}
+
+static uint16_t read16(const uint8_t *p) {
+    return p[0] | p[1] << 8;
+}
+
+static uint32_t read32(const uint8_t *p) {
+    return read16(p) | (uint32_t)read16(p + 2) << 16;
+}
+
+// Reads the disk the way a host's FAT12 driver would
+class Volume {
+   public:
+    Volume() {
+        uint8_t boot[KEYMAP_DISK_SECTOR_SIZE];
+        keymap_disk_read(0, 0, boot, sizeof(boot));
+        EXPECT_EQ(boot[510], 0x55);
+        EXPECT_EQ(boot[511], 0xAA);
+        EXPECT_EQ(std::string((char *)boot + 54, 8), "FAT12   ");
+
+        sector_size         = read16(boot + 11);
+        sectors_per_cluster = boot[13];
+        fat_sector          = read16(boot + 14);
+        fat_count           = boot[16];
+        root_entries        = read16(boot + 17);
+        sector_count        = read16(boot + 19);
+        sectors_per_fat     = read16(boot + 22);
+        root_sector         = fat_sector + fat_count * sectors_per_fat;
+        data_sector         = root_sector + root_entries * 32 / sector_size;
+
+        fat.resize(sectors_per_fat * sector_size);
+        keymap_disk_read(fat_sector, 0, fat.data(), fat.size());
+        root.resize(root_entries * 32);
+        keymap_disk_read(root_sector, 0, root.data(), root.size());
+    }
+
+    uint16_t next_cluster(uint16_t cluster) {
+        uint16_t value = read16(&fat[cluster + cluster / 2]);
+        return cluster & 1 ? value >> 4 : value & 0xFFF;
+    }
+
+    bool find(const char *name, std::vector<uint8_t> &contents) {
+        for (uint16_t i = 0; i < root_entries; i++) {
+            const uint8_t *entry = &root[i * 32];
+            if (memcmp(entry, name, 11) != 0 || (entry[11] & 0x08)) {
+                continue;
+            }
+            uint16_t cluster = read16(entry + 26);
+            uint32_t size    = read32(entry + 28);
+            contents.clear();
+            while (contents.size() < size) {
+                EXPECT_GE(cluster, 2);
+                EXPECT_LT(cluster, 0xFF8);
+                std::vector<uint8_t> data(sector_size * sectors_per_cluster);
+                keymap_disk_read(data_sector + (cluster - 2) * sectors_per_cluster, 0, data.data(), data.size());
+                contents.insert(contents.end(), data.begin(), data.begin() + std::min<size_t>(data.size(), size - contents.size()));
+                cluster = next_cluster(cluster);
+            }
+            EXPECT_GE(cluster, 0xFF8);
+            return true;
+        }
+        return false;
+    }
+
+    uint16_t sector_size, sectors_per_cluster, fat_sector, fat_count, root_entries, sector_count, sectors_per_fat, root_sector, data_sector;
+    std::vector<uint8_t> fat, root;
+};
+
+// Writes a file into free sectors past the generated files, in pieces as small as USB transfers
+static void copy_to_disk(const std::vector<uint8_t> &file, uint32_t lba = 64) {
+    for (size_t offset = 0; offset < file.size(); offset += 64) {
+        keymap_disk_write(lba, offset, file.data() + offset, std::min<size_t>(64, file.size() - offset));
+    }
+}
+
+class KeymapDisk : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        storage.resize(1000);
+        for (size_t i = 0; i < storage.size(); i++) {
+            storage[i] = i * 7;
+        }
+        storage_locked = false;
+        restored_count = 0;
+    }
+
+    std::vector<uint8_t> backup(void) {
+        Volume               volume;
+        std::vector<uint8_t> file;
+        EXPECT_TRUE(volume.find("KEYMAP  BIN", file));
+        return file;
+    }
+};
+
+TEST_F(KeymapDisk, MountsAsFat12) {
+    Volume volume;
+    EXPECT_EQ(volume.sector_size, KEYMAP_DISK_SECTOR_SIZE);
+    EXPECT_EQ(volume.sector_count, KEYMAP_DISK_SECTOR_COUNT);
+
+    std::vector<uint8_t> readme;
+    ASSERT_TRUE(volume.find("README  TXT", readme));
+    EXPECT_NE(std::string(readme.begin(), readme.end()).find("Last restore: "), std::string::npos);
+
+    std::vector<uint8_t> file;
+    ASSERT_TRUE(volume.find("KEYMAP  BIN", file));
+    // three blocks of payload for 1000 bytes
+    EXPECT_EQ(file.size(), 3 * KEYMAP_DISK_SECTOR_SIZE);
+}
+
+TEST_F(KeymapDisk, SnapshotHoldsStorage) {
+    std::vector<uint8_t> file = backup();
+    std::vector<uint8_t> payload;
+    for (size_t offset = 0; offset < file.size(); offset += KEYMAP_DISK_SECTOR_SIZE) {
+        keymap_disk_block_t header;
+        memcpy(&header, &file[offset], sizeof(header));
+        EXPECT_EQ(header.magic, KEYMAP_DISK_MAGIC);
+        EXPECT_EQ(header.block, offset / KEYMAP_DISK_SECTOR_SIZE);
+        EXPECT_EQ(header.size, storage.size());
+        payload.insert(payload.end(), file.begin() + offset + sizeof(header), file.begin() + offset + KEYMAP_DISK_SECTOR_SIZE);
+    }
+    payload.resize(storage.size());
+    EXPECT_EQ(payload, storage);
+}
+
+TEST_F(KeymapDisk, RoundTrip) {
+    std::vector<uint8_t> file     = backup();
+    std::vector<uint8_t> original = storage;
+    std::fill(storage.begin(), storage.end(), 0);
+
+    // blocks may be written in any order
+    copy_to_disk(std::vector<uint8_t>(file.begin() + KEYMAP_DISK_SECTOR_SIZE, file.end()), 100);
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_PENDING);
+    EXPECT_EQ(restored_count, 0);
+    copy_to_disk(std::vector<uint8_t>(file.begin(), file.begin() + KEYMAP_DISK_SECTOR_SIZE), 99);
+
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_RESTORED);
+    EXPECT_EQ(restored_count, 1);
+    EXPECT_EQ(storage, original);
+
+    Volume               volume;
+    std::vector<uint8_t> readme;
+    ASSERT_TRUE(volume.find("README  TXT", readme));
+    EXPECT_NE(std::string(readme.begin(), readme.end()).find("Last restore: restored"), std::string::npos);
+}
+
+TEST_F(KeymapDisk, CorruptSnapshotIsRejected) {
+    std::vector<uint8_t> file     = backup();
+    std::vector<uint8_t> original = storage;
+    std::fill(storage.begin(), storage.end(), 0);
+
+    std::vector<uint8_t> corrupt = file;
+    corrupt[corrupt.size() - KEYMAP_DISK_SECTOR_SIZE + 30] ^= 0x01;
+    copy_to_disk(corrupt);
+
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_REJECTED);
+    EXPECT_EQ(restored_count, 0);
+    EXPECT_EQ(storage, std::vector<uint8_t>(storage.size(), 0));
+
+    // copying it again intact works
+    copy_to_disk(file);
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_RESTORED);
+    EXPECT_EQ(storage, original);
+}
+
+TEST_F(KeymapDisk, TruncatedSnapshotIsRejected) {
+    std::vector<uint8_t> file = backup();
+    std::fill(storage.begin(), storage.end(), 0);
+
+    // missing the last block: never committed
+    copy_to_disk(std::vector<uint8_t>(file.begin(), file.end() - KEYMAP_DISK_SECTOR_SIZE));
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_PENDING);
+
+    // the last block cut short
+    std::fill(file.end() - KEYMAP_DISK_SECTOR_SIZE + 40, file.end(), 0);
+    copy_to_disk(file);
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_REJECTED);
+
+    EXPECT_EQ(restored_count, 0);
+    EXPECT_EQ(storage, std::vector<uint8_t>(storage.size(), 0));
+}
+
+TEST_F(KeymapDisk, SnapshotForOtherLayoutIsRejected) {
+    std::vector<uint8_t> file = backup();
+    storage.resize(1200);
+
+    copy_to_disk(file);
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_REJECTED);
+    EXPECT_EQ(restored_count, 0);
+}
+
+TEST_F(KeymapDisk, LockedKeyboardRejectsRestore) {
+    std::vector<uint8_t> file = backup();
+    storage_locked            = true;
+
+    copy_to_disk(file);
+    EXPECT_EQ(keymap_disk_get_status(), KEYMAP_DISK_REJECTED);
+    EXPECT_EQ(restored_count, 0);
+}
+
+TEST_F(KeymapDisk, HostBookkeepingIsIgnored) {
+    std::vector<uint8_t> file = backup();
+    std::vector<uint8_t> zeros(KEYMAP_DISK_SECTOR_SIZE, 0);
+
+    // the host rewriting the FAT and directory, or writing other files
+    keymap_disk_write(1, 0, zeros.data(), zeros.size());
+    keymap_disk_write(2, 0, zeros.data(), zeros.size());
+    keymap_disk_write(80, 0, zeros.data(), zeros.size());
+
+    EXPECT_EQ(backup(), file);
+}
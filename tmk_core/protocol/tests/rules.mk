@@ -0,0 +1,22 @@
+keymap_disk_DEFS := -DVENDOR_ID=0xFEED -DPRODUCT_ID=0x0000 -DMATRIX_ROWS=4 -DMATRIX_COLS=6
+
+keymap_disk_INC := $(TMK_PATH)/protocol/pico
+
+keymap_disk_SRC := \
+	$(TMK_PATH)/protocol/tests/keymap_disk_tests.cpp \
+	$(TMK_PATH)/protocol/pico/keymap_disk.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/timer.c
+
+usb_polling_interval_DEFS := -DUSB_POLLING_INTERVAL_MS=10 \
+	-DVENDOR_ID=0xFEED -DPRODUCT_ID=0x0000 -DDEVICE_VER=0x0001 -DMANUFACTURER=QMK -DPRODUCT=Test \
+	-DFIXED_CONTROL_ENDPOINT_SIZE=64 -DFIXED_NUM_CONFIGURATIONS=1 -DMAX_ENDPOINTS=16 \
+	-DRAW_ENABLE -DMOUSE_ENABLE -DEXTRAKEY_ENABLE -DSHARED_EP_ENABLE
+
+usb_polling_interval_INC := \
+	$(TMK_PATH)/protocol \
+	$(TMK_PATH)/protocol/chibios/lufa_utils
+
+usb_polling_interval_SRC := \
+	$(TMK_PATH)/protocol/tests/usb_polling_interval_tests.cpp \
+	$(TMK_PATH)/protocol/usb_polling_interval.c \
+	$(TMK_PATH)/protocol/usb_descriptor.c
@@ -0,0 +1 @@
+TEST_LIST += keymap_disk usb_polling_interval
@@ -0,0 +1,119 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <stddef.h>
+#include <string.h>
+
+extern "C" {
+#include "usb_descriptor.h"
+#include "usb_polling_interval.h"
+
+extern const USB_Descriptor_Configuration_t ConfigurationDescriptor;
+}
+
+// The configuration descriptor usb_descriptor.c sends to the host, for the keyboard, raw HID,
+// mouse and shared interfaces enabled in rules.mk
+static const USB_Descriptor_Configuration_t *configuration_descriptor(void) {
+    const void *address = NULL;
+    EXPECT_EQ(get_usb_descriptor(DTYPE_Configuration << 8, 0, &address), sizeof(USB_Descriptor_Configuration_t));
+    return (const USB_Descriptor_Configuration_t *)address;
+}
+
+static const size_t binterval_keyboard = offsetof(USB_Descriptor_Configuration_t, Keyboard_INEndpoint.PollingIntervalMS);
+static const size_t binterval_mouse    = offsetof(USB_Descriptor_Configuration_t, Mouse_INEndpoint.PollingIntervalMS);
+static const size_t binterval_shared   = offsetof(USB_Descriptor_Configuration_t, Shared_INEndpoint.PollingIntervalMS);
+
+class UsbPollingInterval : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        for (uint8_t i = 0; i < USB_POLLING_ENDPOINT_COUNT; i++) {
+            usb_polling_set_interval(i, USB_POLLING_DEFAULT);
+        }
+    }
+};
+
+TEST_F(UsbPollingInterval, FullSpeedBInterval) {
+    EXPECT_EQ(usb_polling_binterval(USB_POLLING_DEFAULT, false), USB_POLLING_INTERVAL_MS);
+    EXPECT_EQ(usb_polling_binterval(USB_POLLING_125US, false), 1);
+    EXPECT_EQ(usb_polling_binterval(USB_POLLING_250US, false), 1);
+    EXPECT_EQ(usb_polling_binterval(USB_POLLING_500US, false), 1);
+    EXPECT_EQ(usb_polling_binterval(USB_POLLING_1MS, false), 1);
+    EXPECT_EQ(usb_polling_binterval(USB_POLLING_2MS, false), 2);
+    EXPECT_EQ(usb_polling_binterval(USB_POLLING_4MS, false), 4);
+    EXPECT_EQ(usb_polling_binterval(USB_POLLING_8MS, false), 8);
+    EXPECT_EQ(usb_polling_binterval(USB_POLLING_8MS + 1, false), USB_POLLING_INTERVAL_MS);
+}
+
+TEST_F(UsbPollingInterval, HighSpeedBInterval) {
+    // 2^(bInterval - 1) microframes of 125 us
+    for (uint8_t interval = USB_POLLING_125US; interval <= USB_POLLING_8MS; interval++) {
+        uint8_t binterval = usb_polling_binterval(interval, true);
+        EXPECT_EQ(125u << (binterval - 1), 125u << (interval - USB_POLLING_125US));
+    }
+}
+
+TEST_F(UsbPollingInterval, DefaultDescriptorIsUnchanged) {
+    auto descriptor = configuration_descriptor();
+    EXPECT_EQ(memcmp(descriptor, &ConfigurationDescriptor, sizeof(USB_Descriptor_Configuration_t)), 0);
+}
+
+TEST_F(UsbPollingInterval, PatchesEachSetting) {
+    for (uint8_t interval = USB_POLLING_DEFAULT; interval <= USB_POLLING_8MS; interval++) {
+        for (uint8_t ep = 0; ep < USB_POLLING_ENDPOINT_COUNT; ep++) {
+            SetUp();
+            usb_polling_set_interval(ep, interval);
+
+            auto descriptor = configuration_descriptor();
+            auto original   = (const uint8_t *)&ConfigurationDescriptor;
+
+            uint8_t expected = usb_polling_binterval(interval, false);
+            EXPECT_EQ(descriptor->Keyboard_INEndpoint.PollingIntervalMS, ep == USB_POLLING_KEYBOARD ? expected : USB_POLLING_INTERVAL_MS);
+            EXPECT_EQ(descriptor->Mouse_INEndpoint.PollingIntervalMS, ep == USB_POLLING_MOUSE ? expected : USB_POLLING_INTERVAL_MS);
+            EXPECT_EQ(descriptor->Shared_INEndpoint.PollingIntervalMS, ep == USB_POLLING_SHARED ? expected : USB_POLLING_INTERVAL_MS);
+            // Raw HID has no setting, and there is no joystick interface to patch
+            EXPECT_EQ(descriptor->Raw_INEndpoint.PollingIntervalMS, 1);
+            EXPECT_EQ(descriptor->Raw_OUTEndpoint.PollingIntervalMS, 1);
+
+            // Nothing but bInterval changes, so every descriptor keeps its length
+            for (size_t i = 0; i < sizeof(USB_Descriptor_Configuration_t); i++) {
+                if (i == binterval_keyboard || i == binterval_mouse || i == binterval_shared) continue;
+                EXPECT_EQ(((const uint8_t *)descriptor)[i], original[i]) << "byte " << i;
+            }
+        }
+    }
+}
+
+TEST_F(UsbPollingInterval, StopsAtMalformedDescriptor) {
+    USB_Descriptor_Configuration_t descriptor = ConfigurationDescriptor;
+    // Zero length descriptor where the mouse interface starts
+    descriptor.Mouse_Interface.Header.Size = 0;
+    usb_polling_set_interval(USB_POLLING_KEYBOARD, USB_POLLING_8MS);
+    usb_polling_set_interval(USB_POLLING_MOUSE, USB_POLLING_8MS);
+    EXPECT_EQ(usb_polling_patch_descriptor((uint8_t *)&descriptor, false, [](uint8_t epnum) -> uint8_t { return epnum == KEYBOARD_IN_EPNUM ? USB_POLLING_KEYBOARD : USB_POLLING_MOUSE; }), offsetof(USB_Descriptor_Configuration_t, Mouse_Interface));
+    EXPECT_EQ(descriptor.Keyboard_INEndpoint.PollingIntervalMS, 8);
+    EXPECT_EQ(descriptor.Mouse_INEndpoint.PollingIntervalMS, USB_POLLING_INTERVAL_MS);
+}
+
+TEST_F(UsbPollingInterval, RejectsUnknownSettings) {
+    usb_polling_set_interval(USB_POLLING_KEYBOARD, 42);
+    EXPECT_EQ(usb_polling_get_interval(USB_POLLING_KEYBOARD), USB_POLLING_DEFAULT);
+    usb_polling_set_interval(USB_POLLING_ENDPOINT_COUNT, USB_POLLING_2MS);
+    EXPECT_EQ(usb_polling_get_interval(USB_POLLING_ENDPOINT_COUNT), USB_POLLING_DEFAULT);
+    usb_polling_set_interval(USB_POLLING_MOUSE, USB_POLLING_2MS);
+    EXPECT_EQ(usb_polling_get_interval(USB_POLLING_MOUSE), USB_POLLING_2MS);
+}
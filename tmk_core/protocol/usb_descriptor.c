@@ -36,10 +36,12 @@
     this software.
 */
 
+#include <string.h>
 #include "util.h"
 #include "report.h"
 #include "usb_descriptor.h"
 #include "usb_descriptor_common.h"
+#include "usb_polling_interval.h"
 
 #ifdef JOYSTICK_ENABLE
 #    include "joystick.h"
@@ -453,10 +455,6 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor = {
 #    define USB_MAX_POWER_CONSUMPTION 500
 #endif
 
-#ifndef USB_POLLING_INTERVAL_MS
-#    define USB_POLLING_INTERVAL_MS 1
-#endif
-
 /*
  * Configuration descriptors
  */
@@ -1080,6 +1078,43 @@ const USB_Descriptor_String_t PROGMEM SerialNumberString = {
  * is called so that the descriptor details can be passed back and the appropriate descriptor sent back to the
  * USB host.
  */
+#ifndef PROTOCOL_LUFA
+/*
+ * LUFA reads the descriptors straight from flash, everywhere else the configuration
+ * descriptor is served from RAM so the polling intervals can be changed at runtime.
+ */
+static USB_Descriptor_Configuration_t RuntimeConfigurationDescriptor;
+
+static uint8_t usb_polling_endpoint(uint8_t epnum) {
+#    ifndef KEYBOARD_SHARED_EP
+    if (epnum == KEYBOARD_IN_EPNUM) return USB_POLLING_KEYBOARD;
+#    endif
+#    if defined(MOUSE_ENABLE) && !defined(MOUSE_SHARED_EP)
+    if (epnum == MOUSE_IN_EPNUM) return USB_POLLING_MOUSE;
+#    endif
+#    if defined(DIGITIZER_ENABLE) && !defined(DIGITIZER_SHARED_EP)
+    if (epnum == DIGITIZER_IN_EPNUM) return USB_POLLING_MOUSE;
+#    endif
+#    ifdef SHARED_EP_ENABLE
+#        ifdef KEYBOARD_SHARED_EP
+    if (epnum == SHARED_IN_EPNUM) return USB_POLLING_KEYBOARD;
+#        else
+    if (epnum == SHARED_IN_EPNUM) return USB_POLLING_SHARED;
+#        endif
+#    endif
+#    ifdef JOYSTICK_ENABLE
+    if (epnum == JOYSTICK_IN_EPNUM) return USB_POLLING_JOYSTICK;
+#    endif
+    return USB_POLLING_NONE;
+}
+
+#    ifdef USB_HIGH_SPEED
+#        define USB_POLLING_HIGH_SPEED true
+#    else
+#        define USB_POLLING_HIGH_SPEED false
+#    endif
+#endif
+
 uint16_t get_usb_descriptor(const uint16_t wValue, const uint16_t wIndex, const void** const DescriptorAddress) {
     const uint8_t DescriptorType  = (wValue >> 8);
     const uint8_t DescriptorIndex = (wValue & 0xFF);
@@ -1093,7 +1128,13 @@ uint16_t get_usb_descriptor(const uint16_t wValue, const uint16_t wIndex, const
 
             break;
         case DTYPE_Configuration:
+#ifdef PROTOCOL_LUFA
             Address = &ConfigurationDescriptor;
+#else
+            memcpy(&RuntimeConfigurationDescriptor, &ConfigurationDescriptor, sizeof(USB_Descriptor_Configuration_t));
+            usb_polling_patch_descriptor((uint8_t*)&RuntimeConfigurationDescriptor, USB_POLLING_HIGH_SPEED, usb_polling_endpoint);
+            Address = &RuntimeConfigurationDescriptor;
+#endif
             Size    = sizeof(USB_Descriptor_Configuration_t);
 
             break;
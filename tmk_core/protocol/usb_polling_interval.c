@@ -0,0 +1,87 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "usb_polling_interval.h"
+
+#define USB_DTYPE_ENDPOINT 0x05
+#define USB_ENDPOINT_DIR_IN 0x80
+#define USB_ENDPOINT_TYPE_MASK 0x03
+#define USB_ENDPOINT_TYPE_INTERRUPT 0x03
+
+static uint8_t usb_polling_intervals[USB_POLLING_ENDPOINT_COUNT];
+
+uint8_t usb_polling_get_interval(uint8_t endpoint) {
+    if (endpoint >= USB_POLLING_ENDPOINT_COUNT) {
+        return USB_POLLING_DEFAULT;
+    }
+    return usb_polling_intervals[endpoint];
+}
+
+void usb_polling_set_interval(uint8_t endpoint, uint8_t interval) {
+    if (endpoint >= USB_POLLING_ENDPOINT_COUNT) {
+        return;
+    }
+    usb_polling_intervals[endpoint] = interval > USB_POLLING_8MS ? USB_POLLING_DEFAULT : interval;
+}
+
+/** \brief bInterval of an interrupt endpoint for a polling interval setting
+ *
+ * Full speed bInterval is in 1 ms frames, high speed bInterval is an exponent: 2^(bInterval - 1) microframes.
+ */
+uint8_t usb_polling_binterval(uint8_t interval, bool high_speed) {
+    if (interval == USB_POLLING_DEFAULT || interval > USB_POLLING_8MS) {
+        return USB_POLLING_INTERVAL_MS;
+    }
+    if (high_speed) {
+        return interval;
+    }
+    if (interval <= USB_POLLING_1MS) {
+        return 1;
+    }
+    return 1 << (interval - USB_POLLING_1MS);
+}
+
+/** \brief Apply the polling interval settings to a configuration descriptor
+ *
+ * Walks the descriptors within wTotalLength and rewrites bInterval of the interrupt IN endpoints
+ * `endpoint` maps to a setting. Returns the number of bytes walked, which is wTotalLength unless the
+ * descriptor is malformed.
+ */
+uint16_t usb_polling_patch_descriptor(uint8_t *descriptor, bool high_speed, usb_polling_endpoint_t endpoint) {
+    uint16_t total  = descriptor[2] | (descriptor[3] << 8);
+    uint16_t offset = 0;
+
+    while (offset < total) {
+        uint8_t *header = &descriptor[offset];
+        uint8_t  length = header[0];
+
+        if (length < 2 || offset + length > total) {
+            break;
+        }
+        if (header[1] == USB_DTYPE_ENDPOINT && length >= 7) {
+            uint8_t address = header[2];
+            uint8_t type    = header[3] & USB_ENDPOINT_TYPE_MASK;
+            if ((address & USB_ENDPOINT_DIR_IN) && type == USB_ENDPOINT_TYPE_INTERRUPT) {
+                uint8_t setting = endpoint(address & ~USB_ENDPOINT_DIR_IN);
+                if (setting < USB_POLLING_ENDPOINT_COUNT) {
+                    header[6] = usb_polling_binterval(usb_polling_intervals[setting], high_speed);
+                }
+            }
+        }
+        offset += length;
+    }
+    return offset;
+}
@@ -0,0 +1,60 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef USB_POLLING_INTERVAL_MS
+#    define USB_POLLING_INTERVAL_MS 1
+#endif
+
+/* Polling interval settings for the HID interrupt IN endpoints. Each step doubles the interval,
+ * starting from one 125 us high speed microframe; at full speed, anything below 1 ms polls every
+ * 1 ms frame. USB_POLLING_DEFAULT keeps USB_POLLING_INTERVAL_MS.
+ *
+ * The configuration descriptor is patched when the host asks for it, so a new setting applies on
+ * the next enumeration.
+ */
+enum usb_polling_interval {
+    USB_POLLING_DEFAULT,
+    USB_POLLING_125US,
+    USB_POLLING_250US,
+    USB_POLLING_500US,
+    USB_POLLING_1MS,
+    USB_POLLING_2MS,
+    USB_POLLING_4MS,
+    USB_POLLING_8MS,
+};
+
+// Endpoints with a setting of their own
+enum usb_polling_endpoint {
+    USB_POLLING_KEYBOARD, // Keyboard, or the shared endpoint when it carries the keyboard
+    USB_POLLING_MOUSE,    // Mouse and digitizer
+    USB_POLLING_SHARED,   // Extra keys, NKRO and whatever else is on the shared endpoint
+    USB_POLLING_JOYSTICK,
+    USB_POLLING_ENDPOINT_COUNT,
+    USB_POLLING_NONE = 0xFF,
+};
+
+// Maps an endpoint number to its usb_polling_endpoint, or USB_POLLING_NONE to leave it alone
+typedef uint8_t (*usb_polling_endpoint_t)(uint8_t epnum);
+
+uint8_t  usb_polling_get_interval(uint8_t endpoint);
+void     usb_polling_set_interval(uint8_t endpoint, uint8_t interval);
+uint8_t  usb_polling_binterval(uint8_t interval, bool high_speed);
+uint16_t usb_polling_patch_descriptor(uint8_t *descriptor, bool high_speed, usb_polling_endpoint_t endpoint);